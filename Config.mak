@@ -31,7 +31,8 @@ FCLIB = -lgfortran
 # Local body storage (yes/no)
 #
 # If 'no' all bodies all stored on all processors; this implies less communication during parallel balancing;
-# When 'yes' bodies are only stored locally in parallel; this is more suitable for larger simulations;
+# When 'yes' bodies are only stored locally in parallel (created round-robin on their owner processors,
+# with ghost copies on neighbouring processors); this is more suitable for larger simulations;
 #
 LOCAL_BODIES = no
 
@@ -63,7 +64,7 @@ TIMERS = yes
 POSIX = yes
 
 #
-# HDF5
+# HDF5 (MPI runs write a single shared file when linked against a parallel HDF5)
 #
 
 HDF5 = no
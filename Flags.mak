@@ -32,8 +32,10 @@ endif
 
 ifeq ($(POSIX),yes)
   STD = -std=c99 -DPOSIX
+  THREADLIB = -lpthread
 else
   STD = -std=c99
+  THREADLIB =
 endif
 
 ifneq ($(HDF5),yes)
@@ -97,7 +99,7 @@ ifeq ($(DEBUG),yes)
   endif
 else
   DBG = no
-  DEBUG =  -w -pedantic -O3 -funroll-loops
+  DEBUG =  -w -pedantic -O3 -funroll-loops -fno-math-errno -fno-trapping-math
   PROFILE =
   MEMDEBUG =
   GEOMDEBUG =
@@ -28,12 +28,15 @@
 #include "pes.h"
 #include "err.h"
 #include "mrf.h"
+#include "red.h"
 #include "sol.h"
 
 #if MPI
 #include "tag.h"
 #include "com.h"
 #include "lis.h"
+#include "map.h"
+#include "thr.h"
 #endif
 
 /* timers */
@@ -177,23 +180,23 @@ static void receive_middle_reactions (DOM *dom, COMDATA *recv, int nrecv, MEM *s
   }
 }
 
-/* a single row Gauss-Seidel step */
-static int gauss_seidel (GAUSS_SEIDEL *gs, short dynamic, double step, DIAB *dia, double *errup, double *errlo)
+/* a single row Gauss-Seidel step; err [0] and err [1] output the relative error components */
+static int gauss_seidel (GAUSS_SEIDEL *gs, short dynamic, double step, DIAB *dia, double *err)
 {
   double R0 [3], B [3], *R, *W;
-  int diagiters;
+  int diagiters, n;
   OFFB *blk;
   CON *con;
 
   /* compute local velocity */
   COPY (dia->B, B);
-  for (blk = dia->adj; blk; blk = blk->n)
+  for (n = 1, blk = dia->adj; blk; blk = blk->n, n ++)
   {
     W = blk->W;
     R = blk->dia->R;
     NVADDMUL (B, W, R, B);
   }
-  for (blk = dia->adjext; blk; blk = blk->n)
+  for (blk = dia->adjext; blk; blk = blk->n, n ++)
   {
     con = (CON*) blk->dia;
     W = blk->W;
@@ -209,6 +212,8 @@ static int gauss_seidel (GAUSS_SEIDEL *gs, short dynamic, double step, DIAB *dia
   diagiters = DIAGONAL_BLOCK_Solver (gs->diagsolver, gs->diagepsilon, gs->diagmaxiter, dynamic,
                     step, con->kind, &con->mat, con->gap, con->area, con->Z, con->base, dia, B);
 
+  con->work += (double) (n + MAX (diagiters, 0)); /* load balancing work units: row blocks and diagonal solver iterations */
+
   if (diagiters >= gs->diagmaxiter || diagiters < 0) /* failed */
   {
     if (con->kind == CONTACT)
@@ -235,22 +240,171 @@ static int gauss_seidel (GAUSS_SEIDEL *gs, short dynamic, double step, DIAB *dia
     }
   }
 
-  /* accumulate relative
-   * error components */
+  /* relative error components */
   SUB (R, R0, R0);
-  *errup += DOT (R0, R0);
-  *errlo += DOT (R, R);
+  err [0] = DOT (R0, R0);
+  err [1] = DOT (R, R);
 
   return diagiters;
 }
 
+/* accumulate relative error components */
+static void error_add (RED_SUM *err, double *e)
+{
+  RED_Add (&err [0], e [0]);
+  RED_Add (&err [1], e [1]);
+}
+
+/* multicolor ordering of a block set used by threaded sweeps */
+typedef struct block_colors BLOCK_COLORS;
+
+struct block_colors
+{
+  DIAB **dia; /* blocks ordered by colors */
+
+  int *first; /* first block index of each color; first [ncol] = n */
+
+  int ncol, n;
+
+  double *err; /* per block error components */
+
+  int *its; /* per block diagonal iterations */
+
+  GAUSS_SEIDEL *gs; /* current sweep data */
+  short dynamic;
+  double step;
+  int offset;
+};
+
+/* color a block set so that adjacent blocks have distinct colors; return NULL if the sweep is serial */
+static BLOCK_COLORS* block_colors_create (SET *set)
+{
+  int n, i, j, k, *col, ncol, *used;
+  BLOCK_COLORS *bc;
+  MAP *map, *node;
+  OFFB *blk;
+  DIAB *dia;
+  MEM mem;
+
+  n = SET_Size (set);
+
+  if (THREAD_Count () == 1 || n == 0) return NULL;
+
+  ERRMEM (bc = MEM_CALLOC (sizeof (BLOCK_COLORS)));
+  ERRMEM (bc->dia = malloc (sizeof (DIAB*) * n));
+  ERRMEM (bc->err = malloc (sizeof (double [2]) * n));
+  ERRMEM (bc->its = malloc (sizeof (int) * n));
+  ERRMEM (col = malloc (sizeof (int) * n));
+  ERRMEM (used = MEM_CALLOC (sizeof (int) * (n + 1)));
+  MEM_Init (&mem, sizeof (MAP), 256);
+  map = NULL;
+
+  /* greedy coloring in the set order */
+  ncol = i = 0;
+  for (SET *item = SET_First (set); item; item = SET_Next (item), i ++)
+  {
+    dia = item->data;
+
+    for (blk = dia->adj; blk; blk = blk->n) /* mark colors of already colored neighbours */
+    {
+      if ((node = MAP_Find_Node (map, blk->dia, NULL))) used [(int) (long) node->data] = i + 1;
+    }
+
+    for (k = 0; used [k] == i + 1; k ++); /* smallest free color */
+
+    MAP_Insert (&mem, &map, dia, (void*) (long) k, NULL);
+    col [i] = k;
+    ncol = MAX (ncol, k + 1);
+  }
+
+  /* order blocks by colors, preserving the set order within each color */
+  ERRMEM (bc->first = MEM_CALLOC (sizeof (int) * (ncol + 1)));
+  for (i = 0; i < n; i ++) bc->first [col [i] + 1] ++;
+  for (k = 0; k < ncol; k ++) bc->first [k + 1] += bc->first [k];
+  for (k = 0; k < ncol; k ++) used [k] = bc->first [k];
+  i = 0;
+  for (SET *item = SET_First (set); item; item = SET_Next (item), i ++)
+  {
+    j = used [col [i]] ++;
+    bc->dia [j] = item->data;
+  }
+
+  bc->ncol = ncol;
+  bc->n = n;
+
+  MEM_Release (&mem);
+  free (used);
+  free (col);
+
+  return bc;
+}
+
+/* free block coloring */
+static void block_colors_destroy (BLOCK_COLORS *bc)
+{
+  if (bc)
+  {
+    free (bc->dia);
+    free (bc->first);
+    free (bc->err);
+    free (bc->its);
+    free (bc);
+  }
+}
+
+/* a single row Gauss-Seidel step of a colored block */
+static void colored_gauss_seidel (BLOCK_COLORS *bc, int i)
+{
+  int j = bc->offset + i;
+
+  bc->its [j] = gauss_seidel (bc->gs, bc->dynamic, bc->step, bc->dia [j], &bc->err [2*j]);
+}
+
+/* a threaded Gauss-Seidel sweep over colors; blocks of one color are not adjacent and get updated concurrently */
+static int colored_sweep (BLOCK_COLORS *bc, int reverse, GAUSS_SEIDEL *gs, short dynamic, double step, RED_SUM *err)
+{
+  int i, k, dimax;
+
+  bc->gs = gs;
+  bc->dynamic = dynamic;
+  bc->step = step;
+
+  for (i = 0; i < bc->ncol; i ++)
+  {
+    k = reverse ? bc->ncol - 1 - i : i;
+    bc->offset = bc->first [k];
+    THREAD_Loop (bc->first [k+1] - bc->first [k], (THREAD_Job) colored_gauss_seidel, bc);
+  }
+
+  for (dimax = i = 0; i < bc->n; i ++) /* sum up in a fixed order so that the result does not depend on threads */
+  {
+    if (err) error_add (err, &bc->err [2*i]);
+    dimax = MAX (dimax, bc->its [i]);
+  }
+
+  return dimax;
+}
+
 /* a Guss-Seidel sweep over a set of blocks */
-static int gauss_seidel_sweep (SET *set, int reverse, GAUSS_SEIDEL *gs, short dynamic, double step, int loops, double *errup, double *errlo)
+static int gauss_seidel_sweep (SET *set, BLOCK_COLORS *bc, int reverse, GAUSS_SEIDEL *gs, short dynamic, double step, int loops, RED_SUM *err)
 {
   SET* (*first) (SET*);
   SET* (*next) (SET*);
   int di, dimax, n;
-  double up, lo;
+  double e [2];
+
+  if (bc) /* threaded multicolor sweep */
+  {
+    dimax = colored_sweep (bc, reverse, gs, dynamic, step, err);
+
+    for (n = 0; n < loops-1; n ++)
+    {
+      di = colored_sweep (bc, reverse, gs, dynamic, step, NULL);
+      dimax = MAX (dimax, di);
+    }
+
+    return dimax;
+  }
 
   if (reverse) first = SET_Last, next = SET_Prev;
   else first = SET_First, next = SET_Next;
@@ -259,15 +413,16 @@ static int gauss_seidel_sweep (SET *set, int reverse, GAUSS_SEIDEL *gs, short dy
 
   for (SET *item = first (set); item; item = next (item)) /* first loop contributes to the outputed error components */
   {
-    di = gauss_seidel (gs, dynamic, step, item->data, errup, errlo);
+    di = gauss_seidel (gs, dynamic, step, item->data, e);
+    error_add (err, e);
     dimax = MAX (dimax, di);
   }
 
-  for (n = 0, up = lo = 0.0; n < loops-1; n ++)  /* remaining inner loops do not contribute to the outputed error components */
+  for (n = 0; n < loops-1; n ++)  /* remaining inner loops do not contribute to the outputed error components */
   {
     for (SET *item = first (set); item; item = next (item))
     {
-      di = gauss_seidel (gs, dynamic, step, item->data, &up, &lo);
+      di = gauss_seidel (gs, dynamic, step, item->data, e);
       dimax = MAX (dimax, di);
     }
   }
@@ -275,6 +430,134 @@ static int gauss_seidel_sweep (SET *set, int reverse, GAUSS_SEIDEL *gs, short dy
   return dimax;
 }
 
+/* pipelined boundary block set */
+typedef struct boundary BOUNDARY;
+
+struct boundary
+{
+  DIAB **dia; /* blocks in the set order */
+
+  int n;
+
+  int *fwd, *fwdrank; /* ranks fwdrank [fwd [i] ... fwd [i+1]-1] have all their reactions updated after the i-th block of a forward sweep */
+
+  int *bwd, *bwdrank; /* the same for a backward sweep */
+
+  void *pattern; /* send pattern of the set */
+
+  LOCDYN *ldy; /* local dynamics (timers) */
+};
+
+/* map ranks to their completion block indices */
+static void boundary_ranks (MAP *map, int n, int **first, int **rank)
+{
+  int i, *pos;
+  MAP *item;
+
+  ERRMEM (*first = MEM_CALLOC (sizeof (int) * (n + 1)));
+  ERRMEM (*rank = malloc (sizeof (int) * (MAP_Size (map) + 1)));
+  ERRMEM (pos = malloc (sizeof (int) * (n + 1)));
+
+  for (item = MAP_First (map); item; item = MAP_Next (item)) (*first) [(int) (long) item->data + 1] ++;
+  for (i = 0; i < n; i ++) (*first) [i+1] += (*first) [i];
+  for (i = 0; i < n; i ++) pos [i] = (*first) [i];
+  for (item = MAP_First (map); item; item = MAP_Next (item)) (*rank) [pos [(int) (long) item->data] ++] = (int) (long) item->key;
+
+  free (pos);
+}
+
+/* create pipelined boundary set */
+static BOUNDARY* boundary_create (SET *set, void *pattern, LOCDYN *ldy)
+{
+  MAP *first, *last, *node;
+  BOUNDARY *bd;
+  OFFB *blk;
+  MEM mem;
+  int i;
+
+  ERRMEM (bd = MEM_CALLOC (sizeof (BOUNDARY)));
+  bd->n = SET_Size (set);
+  bd->pattern = pattern;
+  bd->ldy = ldy;
+  ERRMEM (bd->dia = malloc (sizeof (DIAB*) * (bd->n + 1)));
+  MEM_Init (&mem, sizeof (MAP), 128);
+  first = last = NULL;
+
+  i = 0;
+  for (SET *item = SET_First (set); item; item = SET_Next (item), i ++)
+  {
+    bd->dia [i] = item->data;
+
+    for (blk = bd->dia [i]->adjext; blk; blk = blk->n)
+    {
+      void *rank = (void*) (long) ((CON*) blk->dia)->rank;
+
+      if ((node = MAP_Find_Node (last, rank, NULL))) node->data = (void*) (long) i; /* last block of a forward sweep */
+      else MAP_Insert (&mem, &last, rank, (void*) (long) i, NULL);
+
+      if (!MAP_Find_Node (first, rank, NULL)) MAP_Insert (&mem, &first, rank, (void*) (long) i, NULL); /* last block of a backward sweep */
+    }
+  }
+
+  boundary_ranks (last, bd->n, &bd->fwd, &bd->fwdrank);
+  boundary_ranks (first, bd->n, &bd->bwd, &bd->bwdrank);
+
+  MEM_Release (&mem);
+
+  return bd;
+}
+
+/* destroy pipelined boundary set */
+static void boundary_destroy (BOUNDARY *bd)
+{
+  free (bd->dia);
+  free (bd->fwd);
+  free (bd->fwdrank);
+  free (bd->bwd);
+  free (bd->bwdrank);
+  free (bd);
+}
+
+/* a Gauss-Seidel sweep over a boundary set; reactions are sent to each rank as soon as all its blocks are updated */
+static int boundary_sweep (BOUNDARY *bd, SET *set, BLOCK_COLORS *bc, int reverse, GAUSS_SEIDEL *gs,
+                           short dynamic, double step, int loops, RED_SUM *err)
+{
+  int di, dimax, i, j, k, *first, *rank;
+  double e [2];
+#if TIMERS
+  LOCDYN *ldy = bd->ldy; /* used by S and E */
+#endif
+
+  if (bc || loops > 1) /* threaded or repeated sweeps: send after the sweep */
+  {
+    S("GSRUN"); dimax = gauss_seidel_sweep (set, bc, reverse, gs, dynamic, step, loops, err); E("GSRUN");
+    S("GSCOM"); COM_Send (bd->pattern); E("GSCOM");
+    return dimax;
+  }
+
+  first = reverse ? bd->bwd : bd->fwd;
+  rank = reverse ? bd->bwdrank : bd->fwdrank;
+
+  S("GSRUN");
+  for (dimax = k = 0; k < bd->n; k ++)
+  {
+    i = reverse ? bd->n - 1 - k : k;
+    di = gauss_seidel (gs, dynamic, step, bd->dia [i], e);
+    error_add (err, e);
+    dimax = MAX (dimax, di);
+
+    if (first [i] < first [i+1]) /* some ranks can already be sent their reactions */
+    {
+      E("GSRUN");
+      S("GSCOM"); for (j = first [i]; j < first [i+1]; j ++) COM_Send_To (bd->pattern, rank [j]); E("GSCOM");
+      S("GSRUN");
+    }
+  }
+  E("GSRUN");
+
+  return dimax;
+}
+
 /* middle node list needs score-based sorting */
 typedef struct middle_list MIDDLE_NODE;
 
@@ -291,10 +574,11 @@ IMPLEMENT_LIST_SORT (SINGLE_LINKED, middle_list_sort, MIDDLE_NODE, prev, next, M
 
 /* perform a Guss-Seidel loop over a set of blocks */
 static int gauss_seidel_loop (SET *middle, SET *midupd, int reverse, MEM *setmem, int mycolor, int *color,
-                   GAUSS_SEIDEL *gs, LOCDYN *ldy, short dynamic, double step, double *errup, double *errlo)
+                   GAUSS_SEIDEL *gs, LOCDYN *ldy, short dynamic, double step, RED_SUM *err)
 {
   SET *requs, *ranks, *item, *jtem;
   MIDDLE_NODE *list, *cur;
+  double e [2];
   int di, dimax;
   DIAB *dia;
   OFFB *blk;
@@ -357,7 +641,8 @@ static int gauss_seidel_loop (SET *middle, SET *midupd, int reverse, MEM *setmem
       SET_Insert (setmem, &ranks, (void*) (long) con->rank, NULL); /* schedule for sending to this rank after the reaction is coputed */
     }
 
-    S("GSRUN"); di = gauss_seidel (gs, dynamic, step, dia, errup, errlo); E("GSRUN"); /* compute reaction */
+    S("GSRUN"); di = gauss_seidel (gs, dynamic, step, dia, e); E("GSRUN"); /* compute reaction */
+    error_add (err, e);
     dimax = MAX (dimax, di);
 
     con = dia->con;
@@ -493,6 +778,16 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
       *int2      = NULL,
       *all       = NULL;
 
+  BOUNDARY *bbottom = NULL, /* pipelined boundary sets */
+           *btop = NULL;
+
+  BLOCK_COLORS *cbottom = NULL, /* multicolor orderings used by threaded sweeps */
+               *ctop    = NULL,
+               *cmiddle = NULL,
+               *cint1   = NULL,
+               *cint2   = NULL,
+               *call    = NULL;
+
   int size1 = 0,
       size2 = 0,
       size3 = 0,
@@ -649,6 +944,8 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
 
     bot_pattern = COM_Pattern (MPI_COMM_WORLD, TAG_GAUSS_SEIDEL_BOTTOM, send_bot, nsend_bot, &recv_bot, &nrecv_bot);
     top_pattern = COM_Pattern (MPI_COMM_WORLD, TAG_GAUSS_SEIDEL_TOP, send_top, nsend_top, &recv_top, &nrecv_top);
+    bbottom = boundary_create (bottom, bot_pattern, ldy);
+    btop = boundary_create (top, top_pattern, ldy);
 
     if (gs->variant == GS_FULL)
     {
@@ -723,7 +1020,7 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
 	SET_Free (&setmem, &ranks);
       }
 
-      mid_pattern = COM_Pattern (MPI_COMM_WORLD, TAG_GAUSS_SEIDEL_BOTTOM, send_mid, nsend_mid, &recv_mid, &nrecv_mid);
+      mid_pattern = COM_Pattern (MPI_COMM_WORLD, TAG_GAUSS_SEIDEL_MIDDLE, send_mid, nsend_mid, &recv_mid, &nrecv_mid);
     }
   }
   else if (gs->variant == GS_BOUNDARY_JACOBI)
@@ -734,6 +1031,16 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
     }
   }
 
+  if (THREAD_Count () > 1) /* color block sets for threaded sweeps */
+  {
+    cbottom = block_colors_create (bottom);
+    ctop = block_colors_create (top);
+    cint1 = block_colors_create (int1);
+    cint2 = block_colors_create (int2);
+    call = block_colors_create (all);
+    if (gs->variant == GS_MIDDLE_JACOBI) cmiddle = block_colors_create (middle);
+  }
+
   dynamic = dom->dynamic;
   step = dom->step;
   gs->error = GS_OK;
@@ -744,69 +1051,71 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
 
   do
   {
-    double errup = 0.0,
-	   errlo = 0.0,
-	   errloc [2],
-	   errsum [2];
+    double errup, errlo;
+    RED_SUM err [2];
+
+    RED_Init (&err [0], 0.0);
+    RED_Init (&err [1], 0.0);
 
     S("GSRUN"); undo_all (ldy); E("GSRUN"); 
 
+    if (gs->variant != GS_BOUNDARY_JACOBI) /* post receives early so that pipelined sends arrive into posted buffers */
+    {
+      S("GSCOM"); COM_Post (bot_pattern); COM_Post (top_pattern); E("GSCOM");
+    }
+
     if (gs->reverse && gs->iters % 2)
     {
       if (gs->variant != GS_BOUNDARY_JACOBI)
       {
-	S("GSRUN"); di = gauss_seidel_sweep (bottom, 1, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
-	S("GSCOM"); COM_Send (bot_pattern); E("GSCOM");
-	S("GSRUN"); di = gauss_seidel_sweep (int1, 1, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
-	S("GSCOM"); COM_Recv (bot_pattern); receive_reactions (dom, recv_bot, nrecv_bot); E("GSCOM");
+	di = boundary_sweep (bbottom, bottom, cbottom, 1, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di);
+	S("GSRUN"); di = gauss_seidel_sweep (int1, cint1, 1, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di); E("GSRUN");
+	S("GSWAIT"); COM_Recv (bot_pattern); E("GSWAIT"); S("GSCOM"); receive_reactions (dom, recv_bot, nrecv_bot); E("GSCOM");
 
 	if (gs->variant == GS_FULL)
 	{
-	  di = gauss_seidel_loop (middle, midupd, 1, &setmem, mycolor, color, gs, ldy, dynamic, step, &errup, &errlo); dimax = MAX (dimax, di);
+	  di = gauss_seidel_loop (middle, midupd, 1, &setmem, mycolor, color, gs, ldy, dynamic, step, err); dimax = MAX (dimax, di);
 	}
 	else /* GS_MIDDLE_JACOBI */
 	{
-	  S("GSRUN"); di = gauss_seidel_sweep (middle, 1, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
+	  S("GSRUN"); di = gauss_seidel_sweep (middle, cmiddle, 1, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di); E("GSRUN");
 	  S("GSCOM"); COM_Repeat (mid_pattern); receive_reactions (dom, recv_mid, nrecv_mid); E("GSCOM");
 	}
 
-	S("GSRUN"); di = gauss_seidel_sweep (top, 1, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
-	S("GSCOM"); COM_Send (top_pattern); E("GSCOM");
-	S("GSRUN"); di = gauss_seidel_sweep (int2, 1, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
-	S("GSCOM"); COM_Recv (top_pattern); receive_reactions (dom, recv_top, nrecv_top); E("GSCOM");
+	di = boundary_sweep (btop, top, ctop, 1, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di);
+	S("GSRUN"); di = gauss_seidel_sweep (int2, cint2, 1, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di); E("GSRUN");
+	S("GSWAIT"); COM_Recv (top_pattern); E("GSWAIT"); S("GSCOM"); receive_reactions (dom, recv_top, nrecv_top); E("GSCOM");
       }
       else
       {
-	S("GSRUN"); di = gauss_seidel_sweep (all, 1, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
+	S("GSRUN"); di = gauss_seidel_sweep (all, call, 1, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di); E("GSRUN");
       }
     }
     else
     {
       if (gs->variant != GS_BOUNDARY_JACOBI)
       {
-	S("GSRUN"); di = gauss_seidel_sweep (top, 0, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
-	S("GSCOM"); COM_Send (top_pattern); E("GSCOM");
-	S("GSRUN"); di = gauss_seidel_sweep (int2, 0, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN"); /* large |top| => large |int2| */
-	S("GSCOM"); COM_Recv (top_pattern); receive_reactions (dom, recv_top, nrecv_top); E("GSCOM");
+	di = boundary_sweep (btop, top, ctop, 0, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di);
+	S("GSRUN"); di = gauss_seidel_sweep (int2, cint2, 0, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di); E("GSRUN"); /* large |top| => large |int2| */
+	S("GSWAIT"); COM_Recv (top_pattern); E("GSWAIT"); S("GSCOM"); receive_reactions (dom, recv_top, nrecv_top); E("GSCOM");
 
 	if (gs->variant == GS_FULL)
 	{
-	  di = gauss_seidel_loop (middle, midupd, 0, &setmem, mycolor, color, gs, ldy, dynamic, step, &errup, &errlo); dimax = MAX (dimax, di);
+	  di = gauss_seidel_loop (middle, midupd, 0, &setmem, mycolor, color, gs, ldy, dynamic, step, err); dimax = MAX (dimax, di);
 	}
 	else /* GS_MIDDLE_JACOBI */
 	{
-	  S("GSRUN"); di = gauss_seidel_sweep (middle, 0, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
+	  S("GSRUN"); di = gauss_seidel_sweep (middle, cmiddle, 0, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di); E("GSRUN");
 	  S("GSCOM"); COM_Repeat (mid_pattern); receive_reactions (dom, recv_mid, nrecv_mid); E("GSCOM");
 	}
 
-	S("GSRUN"); di = gauss_seidel_sweep (bottom, 0, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
-	S("GSCOM"); COM_Send (bot_pattern); E("GSCOM");
-	S("GSRUN"); di = gauss_seidel_sweep (int1, 0, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
-	S("GSCOM"); COM_Recv (bot_pattern); receive_reactions (dom, recv_bot, nrecv_bot); E("GSCOM");
+	di = boundary_sweep (bbottom, bottom, cbottom, 0, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di);
+	S("GSRUN"); di = gauss_seidel_sweep (int1, cint1, 0, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di); E("GSRUN");
+	S("GSWAIT"); COM_Recv (bot_pattern); E("GSWAIT"); S("GSCOM"); receive_reactions (dom, recv_bot, nrecv_bot); E("GSCOM");
       }
       else
       {
-	S("GSRUN"); di = gauss_seidel_sweep (all, 0, gs, dynamic, step, gs->innerloops, &errup, &errlo); dimax = MAX (dimax, di); E("GSRUN");
+	S("GSRUN"); di = gauss_seidel_sweep (all, call, 0, gs, dynamic, step, gs->innerloops, err); dimax = MAX (dimax, di); E("GSRUN");
       }
     }
 
@@ -823,9 +1132,9 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
 
     /* sum up error */
     S("GSCOM"); 
-    errloc [0] = errup, errloc [1] = errlo;
-    MPI_Allreduce (errloc, errsum, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    errup = errsum [0], errlo = errsum [1];
+    RED_Allreduce (err, 2, MPI_COMM_WORLD);
+    errup = RED_Value (&err [0]);
+    errlo = RED_Value (&err [1]);
     E("GSCOM"); 
 
     /* calculate relative error */
@@ -843,6 +1152,8 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
 
   if (gs->variant < GS_BOUNDARY_JACOBI)
   {
+    boundary_destroy (bbottom);
+    boundary_destroy (btop);
     COM_Free (bot_pattern);
     COM_Free (top_pattern);
     free (send_bot);
@@ -858,6 +1169,12 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
       free (recv_mid);
     }
   }
+  block_colors_destroy (cbottom);
+  block_colors_destroy (ctop);
+  block_colors_destroy (cmiddle);
+  block_colors_destroy (cint1);
+  block_colors_destroy (cint2);
+  block_colors_destroy (call);
   MEM_Release (&setmem);
 
   /* get maximal iterations count of a diagonal block solver (this has been
@@ -930,10 +1247,13 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
   gs->iters = 0;
   do
   {
-    double errup = 0.0,
-	   errlo = 0.0;
+    double errup, errlo;
+    RED_SUM err [2];
     OFFB *blk;
     DIAB *dia;
+
+    RED_Init (&err [0], 0.0);
+    RED_Init (&err [1], 0.0);
    
     for (dia = end && gs->iters % 2 ? end : ldy->dia; dia; dia = end && gs->iters % 2 ? dia->p : dia->n) /* run forward and backward alternately */
     {
@@ -1002,10 +1322,13 @@ void GAUSS_SEIDEL_Solve (GAUSS_SEIDEL *gs, LOCDYN *ldy)
       /* accumulate relative
        * error components */
       SUB (R, R0, R0);
-      errup += DOT (R0, R0);
-      errlo += DOT (R, R);
+      RED_Add (&err [0], DOT (R0, R0));
+      RED_Add (&err [1], DOT (R, R));
     }
 
+    errup = RED_Value (&err [0]);
+    errlo = RED_Value (&err [1]);
+
     /* merit function value */
     if (!nomerit)
     {
@@ -34,6 +34,7 @@
 #include "cvx.h"
 #include "sph.h"
 #include "eli.h"
+#include "sdf.h"
 #include "pck.h"
 #include "err.h"
 #include "lng.h"
@@ -41,6 +42,7 @@
 #include "but.h"
 #include "rnd.h"
 #include "put.h"
+#include "red.h"
 
 /* implicit PRB integration */
 #define IMP_EPS 1E-8
@@ -837,10 +839,13 @@ static void compute_contacts_work (BODY *bod, double step)
 {
   double DU [3], *R, *energy = bod->energy, coef;
   short dynamic = bod->dom->dynamic;
+  RED_SUM work [2];
   SET *item;
   CON *con;
 
   coef = dynamic ? 0.5 * step : step;
+  RED_Init (&work [0], energy [FRICWORK]);
+  RED_Init (&work [1], energy [CONTWORK]);
   for (item = SET_First (bod->con); item; item = SET_Next (item))
   {
     con = item->data;
@@ -849,10 +854,12 @@ static void compute_contacts_work (BODY *bod, double step)
       R = con->R;
       if (dynamic) { ADD (con->U, con->V, DU); }
       else { COPY (con->U, DU); }
-      energy [FRICWORK] += coef * DOT2 (DU, R);
-      energy [CONTWORK] += coef * DU [2] * R [2];
+      RED_Add (&work [0], coef * DOT2 (DU, R));
+      RED_Add (&work [1], coef * DU [2] * R [2]);
     }
   }
+  energy [FRICWORK] = RED_Value (&work [0]);
+  energy [CONTWORK] = RED_Value (&work [1]);
 }
 
 void overwrite_state (BODY *src, BODY *dst)
@@ -1139,6 +1146,7 @@ void BODY_Material (BODY *bod, int volume, BULK_MATERIAL *mat)
   CONVEX *cvx;
   SPHERE *sph;
   ELLIP *eli;
+  SDF *sdf;
   ELEMENT *ele;
 
   for (shp = bod->shape; shp; shp = shp->next)
@@ -1180,6 +1188,13 @@ void BODY_Material (BODY *bod, int volume, BULK_MATERIAL *mat)
       if (eli->volume == volume)
 	eli->mat = mat;
 
+      break;
+    case SHAPE_SDF:
+
+      sdf = shp->data;
+      if (sdf->volume == volume)
+	sdf->mat = mat;
+
       break;
     }
   }
@@ -2043,6 +2058,26 @@ BODY** BODY_Separate (BODY *bod, int *m)
   return out;
 }
 
+/* update body after its state has been set from outside */
+static void state_updated (BODY *bod)
+{
+  /* post-process red data if needed */
+  if (bod->kind == FEM) FEM_Post_Read (bod);
+
+  /* update shape */
+  SHAPE_Update (bod->shape, bod, (MOTION)BODY_Cur_Point); 
+  if (bod->msh) FEM_Update_Rough_Mesh (bod);
+
+#if !MPI
+  /* update display points */
+  for (SET *item = SET_First (bod->displaypoints); item; item = SET_Next (item))
+  {
+    DISPLAY_POINT *point = item->data;
+    BODY_Cur_Point (bod, point->sgp, point->X, point->x);
+  }
+#endif
+}
+
 void BODY_Write_State (BODY *bod, PBF *bf)
 {
   PBF_Double (bf, bod->conf, BODY_Conf_Size (bod));
@@ -2073,21 +2108,32 @@ void BODY_Read_State (BODY *bod, PBF *bf)
     }
   }
 
-  /* post-process red data if needed */
-  if (bod->kind == FEM) FEM_Post_Read (bod);
+  state_updated (bod);
+}
 
-  /* update shape */
-  SHAPE_Update (bod->shape, bod, (MOTION)BODY_Cur_Point); 
-  if (bod->msh) FEM_Update_Rough_Mesh (bod);
+int BODY_State_Size (BODY *bod)
+{
+  return BODY_Conf_Size (bod) + bod->dofs + BODY_ENERGY_SIZE (bod);
+}
 
-#if !MPI
-  /* update display points */
-  for (SET *item = SET_First (bod->displaypoints); item; item = SET_Next (item))
-  {
-    DISPLAY_POINT *point = item->data;
-    BODY_Cur_Point (bod, point->sgp, point->X, point->x);
-  }
-#endif
+void BODY_Get_State (BODY *bod, double *x)
+{
+  int conf = BODY_Conf_Size (bod);
+
+  memcpy (x, bod->conf, sizeof (double [conf]));
+  memcpy (x + conf, bod->velo, sizeof (double [bod->dofs]));
+  memcpy (x + conf + bod->dofs, bod->energy, sizeof (double [BODY_ENERGY_SIZE(bod)]));
+}
+
+void BODY_Set_State (BODY *bod, double *x)
+{
+  int conf = BODY_Conf_Size (bod);
+
+  memcpy (bod->conf, x, sizeof (double [conf]));
+  memcpy (bod->velo, x + conf, sizeof (double [bod->dofs]));
+  memcpy (bod->energy, x + conf + bod->dofs, sizeof (double [BODY_ENERGY_SIZE(bod)]));
+
+  state_updated (bod);
 }
 
 void BODY_Destroy (BODY *bod)
@@ -2333,6 +2379,9 @@ void BODY_Parent_Pack (BODY *bod, int *dsize, double **d, int *doubles, int *isi
 
   /* pack energy */
   pack_doubles (dsize, d, doubles, bod->energy, BODY_ENERGY_SIZE(bod));
+
+  /* load balancing cost */
+  pack_double (dsize, d, doubles, bod->cost);
 }
 
 /* unpack parent body */
@@ -2361,6 +2410,9 @@ void BODY_Parent_Unpack (BODY *bod, int *dpos, double *d, int doubles, int *ipos
   /* unpack energy */
   unpack_doubles (dpos, d, doubles, bod->energy, BODY_ENERGY_SIZE(bod));
 
+  /* load balancing cost */
+  bod->cost = unpack_double (dpos, d, doubles);
+
   /* init inverse */
   if (dynamic) BODY_Dynamic_Init (bod);
   else BODY_Static_Init (bod);
@@ -2381,6 +2433,10 @@ void BODY_Child_Pack (BODY *bod, int *dsize, double **d, int *doubles, int *isiz
 
   pack_doubles (dsize, d, doubles, bod->conf, conf_pack_size (bod)); /* configuration */
 
+#if LOCAL_BODIES
+  pack_doubles (dsize, d, doubles, bod->velo, bod->dofs); /* velocity (only read by user queries) */
+#endif
+
   pack_int (isize, i, ints, bod->scheme); /* pack integration scheme */
   
   pack_double (dsize, d, doubles, bod->damping); /* damping */
@@ -2405,6 +2461,10 @@ void BODY_Child_Unpack (BODY *bod, int *dpos, double *d, int doubles, int *ipos,
 
   unpack_doubles (dpos, d, doubles, bod->conf, conf_pack_size (bod)); /* configuration */
 
+#if LOCAL_BODIES
+  unpack_doubles (dpos, d, doubles, bod->velo, bod->dofs); /* velocity */
+#endif
+
   bod->scheme = unpack_int (ipos, i, ints);  /* unpack integration scheme */
 
   bod->damping = unpack_double (dpos, d, doubles); /* damping */
@@ -2422,6 +2482,10 @@ void BODY_Child_Unpack (BODY *bod, int *dpos, double *d, int doubles, int *ipos,
 void BODY_Child_Update_Pack (BODY *bod, int *dsize, double **d, int *doubles, int *isize, int **i, int *ints)
 {
   pack_doubles (dsize, d, doubles, bod->conf, conf_pack_size (bod));
+
+#if LOCAL_BODIES
+  pack_doubles (dsize, d, doubles, bod->velo, bod->dofs);
+#endif
 }
 
 /* unpack child update */
@@ -2431,6 +2495,10 @@ void BODY_Child_Update_Unpack (BODY *bod, int *dpos, double *d, int doubles, int
 
   unpack_doubles (dpos, d, doubles, bod->conf, conf_pack_size (bod));
 
+#if LOCAL_BODIES
+  unpack_doubles (dpos, d, doubles, bod->velo, bod->dofs);
+#endif
+
   /* init inverse */
   if (dynamic) BODY_Dynamic_Init (bod);
   else BODY_Static_Init (bod);
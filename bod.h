@@ -204,6 +204,8 @@ struct general_body
 
 #if MPI
   SET *children, *prevchildren; /* set of children ranks for a parent/set of other children ranks for a child; set of previous children ranks for a parent */
+  double tint; /* time integration time accumulated since the last cost measurement */
+  double cost; /* smoothed measured computational cost [us] (load balancing weight) */
 #else
   void *rendering; /* rendering data */
 
@@ -301,6 +303,15 @@ void BODY_Write_State (BODY *bod, PBF *bf);
 /* read body state */
 void BODY_Read_State (BODY *bod, PBF *bf);
 
+/* get size of body state vector (configuration, velocity and energy) */
+int BODY_State_Size (BODY *bod);
+
+/* copy body state into 'x' of BODY_State_Size (bod) */
+void BODY_Get_State (BODY *bod, double *x);
+
+/* set body state from 'x' of BODY_State_Size (bod) */
+void BODY_Set_State (BODY *bod, double *x);
+
 /* release body memory */
 void BODY_Destroy (BODY *bod);
 
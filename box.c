@@ -22,11 +22,13 @@
 #include "sol.h"
 #include "box.h"
 #include "hyb.h"
+#include "bvh.h"
 #include "alg.h"
 #include "msh.h"
 #include "cvx.h"
 #include "sph.h"
 #include "eli.h"
+#include "sdf.h"
 #include "bod.h"
 #include "swp.h"
 #include "hsh.h"
@@ -39,6 +41,7 @@
 #endif
 
 #define SIZE 128 /* mempool size */
+#define BVHMIN 8 /* minimal number of body objects bounded by a hierarchy */
 
 /* auxiliary data */
 struct auxdata
@@ -77,31 +80,11 @@ static int gobjcmp (OPR *a, OPR *b)
   else return cmp;
 }
 
-/* local overlap creation callback => filters our unwnated adjacency */
-static void local_create (struct auxdata *aux, BOX *one, BOX *two)
+/* geometric object overlap creation callback => filters out excluded pairs and adjacency */
+static void gobj_create (struct auxdata *aux, BOX *one, BOX *two)
 {
   BODY *onebod = one->body, *twobod = two->body;
 
-#if MPI
-  SET *item = SET_First (one->ranks), *jtem = SET_First (two->ranks);
-
-  while (item->data != jtem->data) /* find the lowest common rank of two boxes */
-  {
-    if (item->data < jtem->data) item = SET_Next (item);
-    else jtem = SET_Next (jtem);
-
-    ASSERT_DEBUG (item && jtem, "Inconsistent lowest rank search for a box pair");
-  }
-
-  if (aux->rank > (int) (long) item->data) return; /* filter out overlaps from oter than the lowest common rank of two boxes */
-#endif
-
-  /* check if these are two obstacles => no need to report overlap */
-  if (onebod->kind == OBS && twobod->kind == OBS) return;
-
-  /* self-contact ? <=> one->body == two->body */
-  if (onebod == twobod && !(onebod->flags & BODY_DETECT_SELF_CONTACT)) return;
-
   int id1 = onebod->id,
       id2 = twobod->id,
       no1 = one->sgp - onebod->sgp,
@@ -109,9 +92,6 @@ static void local_create (struct auxdata *aux, BOX *one, BOX *two)
 
   OPR pair = {MIN (id1, id2), MAX (id1, id2), MIN (no1, no2), MAX (no1, no2)};
 
-  /* an excluded body pair ? */
-  if (SET_Contains (aux->nobody, &pair, (SET_Compare) bodcmp)) return;
-
   /* an excluded object pair ? */
   if (SET_Contains (aux->nogobj, &pair, (SET_Compare) gobjcmp)) return;
 
@@ -138,6 +118,59 @@ static void local_create (struct auxdata *aux, BOX *one, BOX *two)
   aux->create (aux->data, one, two);
 }
 
+/* local overlap creation callback => filters our unwnated adjacency */
+static void local_create (struct auxdata *aux, BOX *one, BOX *two)
+{
+  BODY *onebod = one->body, *twobod = two->body;
+
+#if MPI
+  SET *item = SET_First (one->ranks), *jtem = SET_First (two->ranks);
+
+  while (item->data != jtem->data) /* find the lowest common rank of two boxes */
+  {
+    if (item->data < jtem->data) item = SET_Next (item);
+    else jtem = SET_Next (jtem);
+
+    ASSERT_DEBUG (item && jtem, "Inconsistent lowest rank search for a box pair");
+  }
+
+  if (aux->rank > (int) (long) item->data) return; /* filter out overlaps from oter than the lowest common rank of two boxes */
+#endif
+
+  /* check if these are two obstacles => no need to report overlap */
+  if (onebod->kind == OBS && twobod->kind == OBS) return;
+
+  /* self-contact ? <=> one->body == two->body */
+  if (onebod == twobod && !(onebod->flags & BODY_DETECT_SELF_CONTACT)) return;
+
+  OPR pair = {MIN (onebod->id, twobod->id), MAX (onebod->id, twobod->id), 0, 0};
+
+  /* an excluded body pair ? */
+  if (SET_Contains (aux->nobody, &pair, (SET_Compare) bodcmp)) return;
+
+  if (one->tree || two->tree) /* body level boxes => descend into hierarchies */
+  {
+    BVH onenode = {{0}, NULL, NULL, one},
+        twonode = {{0}, NULL, NULL, two};
+
+    if (!one->tree) COPY6 (one->extents, onenode.extents);
+    if (!two->tree) COPY6 (two->extents, twonode.extents);
+
+    BVH_Overlap (one->tree ? one->tree : &onenode, two->tree ? two->tree : &twonode, aux, (BOX_Overlap_Create) gobj_create);
+  }
+  else gobj_create (aux, one, two);
+}
+
+/* test whether body objects should be bounded by a hierarchy */
+static int hierarchical (BODY *body)
+{
+#if MPI
+  return 0; /* boxes migrate between ranks object-wise */
+#else
+  return (body->kind == OBS || body->kind == RIG) && body->nsgp >= BVHMIN && !(body->flags & BODY_DETECT_SELF_CONTACT);
+#endif
+}
+
 #if MPI
 /* detach boxes from outside of the domain and attach new incoming boxes */
 static void detach_and_attach (AABB *aabb)
@@ -163,7 +196,7 @@ static void detach_and_attach (AABB *aabb)
   {
     COPY6 (box->extents, e);
 
-    ASSERT (Zoltan_LB_Box_Assign (dom->zol, e[0], e[1], e[2], e[3], e[4], e[5], procs, &numprocs) == ZOLTAN_OK, ERR_ZOLTAN);
+    DOM_Box_Assign (dom, e, procs, &numprocs);
 
     for (j = 0; j < numprocs; j ++)
     {
@@ -189,7 +222,7 @@ static void detach_and_attach (AABB *aabb)
 
 	update (sgp->shp->data, sgp->gobj, e);
 
-	ASSERT (Zoltan_LB_Box_Assign (dom->zol, e[0], e[1], e[2], e[3], e[4], e[5], procs, &numprocs) == ZOLTAN_OK, ERR_ZOLTAN);
+	DOM_Box_Assign (dom, e, procs, &numprocs);
 
 	for (j = 0; j < numprocs; j ++)
 	{
@@ -219,7 +252,7 @@ static void detach_and_attach (AABB *aabb)
 
 	update (sgp->shp->data, sgp->gobj, e);
 
-	ASSERT (Zoltan_LB_Box_Assign (dom->zol, e[0], e[1], e[2], e[3], e[4], e[5], procs, &numprocs) == ZOLTAN_OK, ERR_ZOLTAN);
+	DOM_Box_Assign (dom, e, procs, &numprocs);
 
 	for (j = 0; j < numprocs; j ++)
 	{
@@ -345,10 +378,47 @@ void AABB_Delete (AABB *aabb, BOX *box)
 void AABB_Insert_Body (AABB *aabb, BODY *body)
 {
   SGP *sgp, *sgpe;
+  BOX *box, **leaf;
+  int i;
+
+  if (hierarchical (body)) /* one listed body level box bounding a hierarchy of unlisted object boxes */
+  {
+    ERRMEM (leaf = malloc (sizeof (BOX*) * body->nsgp));
+
+    ERRMEM (box = MEM_Alloc (&aabb->boxmem));
+    box->kind = body->sgp->kind;
+    box->body = body;
+    box->sgp = body->sgp; /* unique per body => used in box comparisons of overlap algorithms */
+
+    for (i = 0, sgp = body->sgp, sgpe = sgp + body->nsgp; sgp < sgpe; i ++, sgp ++)
+    {
+      ERRMEM (leaf [i] = MEM_Alloc (&aabb->boxmem));
+      leaf [i]->update = SGP_Extents_Update (sgp);
+      leaf [i]->kind = sgp->kind;
+      leaf [i]->body = body;
+      leaf [i]->sgp = sgp;
+      leaf [i]->parent = box;
+      sgp->box = leaf [i];
+
+      leaf [i]->update (sgp->shp->data, sgp->gobj, leaf [i]->extents);
+    }
+
+    box->tree = BVH_Create (leaf, body->nsgp);
 
-  for (sgp = body->sgp, sgpe = sgp + body->nsgp; sgp < sgpe; sgp ++)
+    free (leaf);
+
+    box->next = aabb->lst;
+    if (aabb->lst) aabb->lst->prev= box;
+    aabb->lst = box;
+    aabb->boxnum ++;
+    aabb->modified = 1;
+  }
+  else
   {
-    AABB_Insert (aabb, body, sgp->kind, sgp, SGP_Extents_Update (sgp));
+    for (sgp = body->sgp, sgpe = sgp + body->nsgp; sgp < sgpe; sgp ++)
+    {
+      AABB_Insert (aabb, body, sgp->kind, sgp, SGP_Extents_Update (sgp));
+    }
   }
 }
 
@@ -356,10 +426,26 @@ void AABB_Insert_Body (AABB *aabb, BODY *body)
 void AABB_Delete_Body (AABB *aabb, BODY *body)
 {
   SGP *sgp, *sgpe;
+  BOX *box;
 
-  for (sgp = body->sgp, sgpe = sgp + body->nsgp; sgp < sgpe; sgp ++)
+  if (body->nsgp && body->sgp->box && (box = body->sgp->box->parent)) /* hierarchy */
   {
-    AABB_Delete (aabb, sgp->box);
+    for (sgp = body->sgp, sgpe = sgp + body->nsgp; sgp < sgpe; sgp ++)
+    {
+      MEM_Free (&aabb->boxmem, sgp->box);
+      sgp->box = NULL;
+    }
+
+    BVH_Destroy (box->tree);
+
+    AABB_Delete (aabb, box);
+  }
+  else
+  {
+    for (sgp = body->sgp, sgpe = sgp + body->nsgp; sgp < sgpe; sgp ++)
+    {
+      AABB_Delete (aabb, sgp->box);
+    }
   }
 }
 
@@ -374,7 +460,11 @@ void AABB_Update (AABB *aabb, BOXALG alg, void *data, BOX_Overlap_Create create)
 #endif
   BOX *box;
 
-  for (box = aabb->lst; box; box = box->next) box->update (box->sgp->shp->data, box->sgp->gobj, box->extents); /* update box extents */
+  for (box = aabb->lst; box; box = box->next) /* update box extents */
+  {
+    if (box->tree) BVH_Update (box->tree, box->extents); /* refit body hierarchy */
+    else box->update (box->sgp->shp->data, box->sgp->gobj, box->extents);
+  }
 
 #if MPI
   detach_and_attach (aabb); /* detach boxes from outside of the domain and attach new incoming boxes */
@@ -542,6 +632,7 @@ BOX_Extents_Update SGP_Extents_Update (SGP *sgp)
   case GOBJ_CONVEX: return (BOX_Extents_Update) CONVEX_Extents;
   case GOBJ_SPHERE: return (BOX_Extents_Update) SPHERE_Extents;
   case GOBJ_ELLIP: return (BOX_Extents_Update) ELLIP_Extents;
+  case GOBJ_SDF: return (BOX_Extents_Update) SDF_Extents;
   default: break;
   }
 
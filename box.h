@@ -65,6 +65,8 @@ typedef void (*BOX_Extents_Update)  (void *data, void *gobj, double *extents); /
 typedef struct box BOX; /* axis aligned box */
 #endif
 
+typedef struct bvh BVH; /* bounding volume hierarchy of body boxes */
+
 /* object pair */
 struct objpair
 {
@@ -89,6 +91,10 @@ struct box
 
   void *mark; /* auxiliary marker used by hashing algorithms */
 
+  BVH *tree; /* hierarchy of body boxes (body level box) or NULL */
+
+  BOX *parent; /* body level box (hierarchy leaf box) or NULL */
+
 #if MPI
   SET *ranks; /* ranks where this box overalps */
 #endif
@@ -131,6 +137,18 @@ inline static short GOBJ_Pair_Code (BOX *one, BOX *two)
 #define AABB_ELLIP_SPHERE	0x1004
 #define AABB_SPHERE_ELLIP	0x0410
 
+#define AABB_SDF_ELEMENT	0x0801
+#define AABB_ELEMENT_SDF	0x0108
+
+#define AABB_SDF_CONVEX		0x0802
+#define AABB_CONVEX_SDF		0x0208
+
+#define AABB_SDF_SPHERE		0x0804
+#define AABB_SPHERE_SDF		0x0408
+
+#define AABB_SDF_ELLIP		0x0810
+#define AABB_ELLIP_SDF		0x1008
+
 /* driver data */
 struct aabb
 {
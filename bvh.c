@@ -0,0 +1,170 @@
+/*
+ * bvh.c
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * bounding volume hierarchy of body boxes
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#include <stdlib.h>
+#include <float.h>
+#include "alg.h"
+#include "bvh.h"
+#include "err.h"
+
+/* extents overlap test */
+#define OVERLAP(a, b) ((a)[0] <= (b)[3] && (b)[0] <= (a)[3] &&\
+                       (a)[1] <= (b)[4] && (b)[1] <= (a)[4] &&\
+		       (a)[2] <= (b)[5] && (b)[2] <= (a)[5])
+
+/* extents volume */
+#define VOLUME(e) (((e)[3]-(e)[0])*((e)[4]-(e)[1])*((e)[5]-(e)[2]))
+
+/* extents union */
+static void extents_union (double *a, double *b, double *c)
+{
+  c[0] = MIN (a[0], b[0]);
+  c[1] = MIN (a[1], b[1]);
+  c[2] = MIN (a[2], b[2]);
+  c[3] = MAX (a[3], b[3]);
+  c[4] = MAX (a[4], b[4]);
+  c[5] = MAX (a[5], b[5]);
+}
+
+/* build a subtree over boxes [0, n) in preorder starting at *node */
+static BVH* build (BOX **boxes, int n, BVH **node)
+{
+  double lo [3], hi [3], d [3], c, split;
+  BVH *bvh = (*node) ++;
+  int i, j, k;
+  BOX *tmp;
+
+  if (n == 1)
+  {
+    bvh->left = bvh->right = NULL;
+    bvh->box = boxes [0];
+    COPY6 (boxes [0]->extents, bvh->extents);
+    return bvh;
+  }
+
+  /* bounds of box centers */
+  SET (lo, DBL_MAX);
+  SET (hi, -DBL_MAX);
+  for (i = 0; i < n; i ++)
+  {
+    for (k = 0; k < 3; k ++)
+    {
+      c = 0.5 * (boxes [i]->extents [k] + boxes [i]->extents [k+3]);
+      lo [k] = MIN (lo [k], c);
+      hi [k] = MAX (hi [k], c);
+    }
+  }
+
+  /* split along the longest direction at the midpoint of centers */
+  SUB (hi, lo, d);
+  k = (d [0] >= d [1] && d [0] >= d [2]) ? 0 : (d [1] >= d [2] ? 1 : 2);
+  split = 0.5 * (lo [k] + hi [k]);
+
+  for (i = 0, j = n - 1; i <= j;)
+  {
+    c = 0.5 * (boxes [i]->extents [k] + boxes [i]->extents [k+3]);
+    if (c < split) i ++;
+    else
+    {
+      tmp = boxes [i];
+      boxes [i] = boxes [j];
+      boxes [j --] = tmp;
+    }
+  }
+
+  if (i == 0 || i == n) i = n / 2; /* coincident centers => split in halves */
+
+  bvh->box = NULL;
+  bvh->left = build (boxes, i, node);
+  bvh->right = build (boxes + i, n - i, node);
+  extents_union (bvh->left->extents, bvh->right->extents, bvh->extents);
+
+  return bvh;
+}
+
+/* refit a subtree */
+static void refit (BVH *bvh)
+{
+  if (bvh->box)
+  {
+    BOX *box = bvh->box;
+
+    box->update (box->sgp->shp->data, box->sgp->gobj, box->extents);
+
+    COPY6 (box->extents, bvh->extents);
+  }
+  else
+  {
+    refit (bvh->left);
+    refit (bvh->right);
+    extents_union (bvh->left->extents, bvh->right->extents, bvh->extents);
+  }
+}
+
+/* create a hierarchy over n boxes with current extents (nodes are allocated as one block) */
+BVH* BVH_Create (BOX **boxes, int n)
+{
+  BVH *bvh, *node;
+
+  ASSERT_DEBUG (n > 0, "Empty box set in BVH_Create");
+
+  ERRMEM (bvh = malloc (sizeof (BVH [2*n-1])));
+
+  node = bvh;
+
+  build (boxes, n, &node);
+
+  ASSERT_DEBUG (node - bvh == 2*n-1, "Inconsistent node count in BVH_Create");
+
+  return bvh;
+}
+
+/* update leaf box extents, refit the hierarchy and output the root extents */
+void BVH_Update (BVH *bvh, double *extents)
+{
+  refit (bvh);
+
+  COPY6 (bvh->extents, extents);
+}
+
+/* report overlaps between leaves of two hierarchies */
+void BVH_Overlap (BVH *one, BVH *two, void *data, BOX_Overlap_Create create)
+{
+  if (!OVERLAP (one->extents, two->extents)) return;
+
+  if (one->box && two->box) create (data, one->box, two->box);
+  else if (two->box || (!one->box && VOLUME (one->extents) >= VOLUME (two->extents))) /* descend into the larger node */
+  {
+    BVH_Overlap (one->left, two, data, create);
+    BVH_Overlap (one->right, two, data, create);
+  }
+  else
+  {
+    BVH_Overlap (one, two->left, data, create);
+    BVH_Overlap (one, two->right, data, create);
+  }
+}
+
+/* release memory */
+void BVH_Destroy (BVH *bvh)
+{
+  free (bvh);
+}
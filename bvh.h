@@ -0,0 +1,49 @@
+/*
+ * bvh.h
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * bounding volume hierarchy of body boxes
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#include "box.h"
+
+#ifndef __bvh__
+#define __bvh__
+
+/* hierarchy node */
+struct bvh
+{
+  double extents [6]; /* min x, y, z, max x, y, z */
+
+  BVH *left, *right; /* children of an internal node */
+
+  BOX *box; /* leaf box or NULL for internal nodes */
+};
+
+/* create a hierarchy over n boxes with current extents (nodes are allocated as one block) */
+BVH* BVH_Create (BOX **boxes, int n);
+
+/* update leaf box extents, refit the hierarchy and output the root extents */
+void BVH_Update (BVH *bvh, double *extents);
+
+/* report overlaps between leaves of two hierarchies */
+void BVH_Overlap (BVH *one, BVH *two, void *data, BOX_Overlap_Create create);
+
+/* release memory */
+void BVH_Destroy (BVH *bvh);
+
+#endif
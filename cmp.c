@@ -91,9 +91,9 @@ void decompress (int *input, int size, double **d, int *doubles, int **i, int *i
 
   outsize = sizeof (int) * size;
 
-  length = outsize - sizeof (int [4]) + (remainder ? sizeof (int) - remainder : 0);
+  length = outsize - sizeof (int [4]) - (remainder ? sizeof (int) - remainder : 0); /* compressed length */
 
-  if (length >= 16)
+  if (sizeof (double [*doubles]) + sizeof (int [*ints]) >= 16) /* compressed (see above) */
   {
     outsize = sizeof (double [*doubles]) + sizeof (int [*ints]);
     ERRMEM (output = malloc (outsize));
@@ -20,6 +20,7 @@
  * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
 
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 #include <mpi.h>
 #include "mem.h"
@@ -27,6 +28,9 @@
 #include "map.h"
 #include "alg.h"
 #include "err.h"
+#include "cmp.h"
+
+static int compression = 0; /* payload compression threshold in bytes (0 => off) */
 
 typedef struct compattern COMPATTERN;
 
@@ -61,6 +65,13 @@ struct compattern
 
   int nsend,
       nrecv;
+
+  int *send_first, /* send items of the j-th send rank are send_item [send_first [j] ... send_first [j+1]-1] */
+      *send_item;
+
+  char *send_done; /* sent flags of send ranks */
+
+  short recv_posted; /* receives posted flag */
 };
 
 typedef struct comallpattern COMALLPATTERN;
@@ -93,10 +104,195 @@ struct comallpattern
       nrecv;
 };
 
+typedef struct comneighbours COMNEIGHBOURS;
+
+/* point to point communication
+ * between neighbour ranks */
+struct comneighbours
+{
+  MPI_Comm comm;
+
+  int tag,
+      ncpu,
+     *index, /* maps ranks to neighbour indices or -1 */
+     *rank, /* ascending neighbour ranks */
+      count,
+      size;
+};
+
+/* insert a neighbour rank */
+static void neighbours_insert (COMNEIGHBOURS *nb, int rank)
+{
+  int i;
+
+  if (nb->index [rank] >= 0) return;
+
+  if (nb->count == nb->size)
+  {
+    nb->size = 2 * nb->size + 8;
+    ERRMEM (nb->rank = realloc (nb->rank, nb->size * sizeof (int)));
+  }
+
+  for (i = nb->count; i > 0 && nb->rank [i-1] > rank; i --) /* keep ranks sorted */
+  {
+    nb->rank [i] = nb->rank [i-1];
+    nb->index [nb->rank [i]] = i;
+  }
+
+  nb->rank [i] = rank;
+  nb->index [rank] = i;
+  nb->count ++;
+}
+
+/* aggregate send data per rank and compress aggregates exceeding the threshold; each
+ * output item ends with an integer flag telling whether it has been compressed */
+static COMDATA* compress_send (COMDATA *send, int nsend, int *nout)
+{
+  COMDATA *out, *cd, *co;
+  MAP *map, *item;
+  int i, n, *c, size;
+  MEM mem;
+
+  MEM_Init (&mem, sizeof (MAP), MAX (nsend, 64));
+
+  /* count per rank sizes */
+  for (map = NULL, i = 0, cd = send; i < nsend; i ++, cd ++)
+  {
+    if (cd->ints || cd->doubles)
+    {
+      if (!(co = MAP_Find (map, (void*) (long) cd->rank, NULL)))
+      {
+	ERRMEM (co = MEM_CALLOC (sizeof (COMDATA)));
+	co->rank = cd->rank;
+	MAP_Insert (&mem, &map, (void*) (long) cd->rank, co, NULL);
+      }
+      co->ints += cd->ints;
+      co->doubles += cd->doubles;
+    }
+  }
+
+  *nout = MAP_Size (map);
+  ERRMEM (out = malloc ((*nout + 1) * sizeof (COMDATA)));
+
+  /* aggregate in the ascending rank order */
+  for (n = 0, item = MAP_First (map); item; item = MAP_Next (item), n ++)
+  {
+    co = item->data;
+    out [n].rank = co->rank;
+    ERRMEM (out [n].i = malloc ((co->ints + 1) * sizeof (int)));
+    ERRMEM (out [n].d = malloc ((co->doubles + 1) * sizeof (double)));
+    out [n].ints = out [n].doubles = 0;
+    item->data = &out [n];
+    free (co);
+  }
+
+  for (i = 0, cd = send; i < nsend; i ++, cd ++)
+  {
+    if (cd->ints || cd->doubles)
+    {
+      co = MAP_Find (map, (void*) (long) cd->rank, NULL);
+      memcpy (co->i + co->ints, cd->i, cd->ints * sizeof (int));
+      memcpy (co->d + co->doubles, cd->d, cd->doubles * sizeof (double));
+      co->ints += cd->ints;
+      co->doubles += cd->doubles;
+    }
+  }
+
+  for (n = 0, co = out; n < *nout; n ++, co ++)
+  {
+    if ((int) (co->ints * sizeof (int) + co->doubles * sizeof (double)) >= compression)
+    {
+      c = compress (CMP_FASTLZ, co->d, co->doubles, co->i, co->ints, &size);
+
+      if (size < co->ints + 2 * co->doubles) /* compression pays off */
+      {
+	free (co->i);
+	free (co->d);
+	ERRMEM (co->i = realloc (c, (size + 1) * sizeof (int)));
+	co->i [size] = 1;
+	co->ints = size + 1;
+	co->d = NULL;
+	co->doubles = 0;
+	continue;
+      }
+
+      free (c);
+    }
+
+    co->i [co->ints ++] = 0;
+  }
+
+  MEM_Release (&mem);
+
+  return out;
+}
+
+/* free compressed send data */
+static void compress_free (COMDATA *out, int nout)
+{
+  int n;
+
+  for (n = 0; n < nout; n ++)
+  {
+    free (out [n].i);
+    free (out [n].d);
+  }
+
+  free (out);
+}
+
+/* decompress received data into a new contiguous receive buffer */
+static void decompress_recv (COMDATA **recv, int nrecv)
+{
+  COMDATA *cd, *co, *out;
+  char *compressed;
+  int n, j;
+  void *p;
+
+  if (nrecv == 0) return;
+
+  ERRMEM (compressed = malloc (nrecv));
+
+  for (j = nrecv * sizeof (COMDATA), n = 0, cd = *recv; n < nrecv; n ++, cd ++)
+  {
+    if ((compressed [n] = cd->i [cd->ints - 1]))
+    {
+      decompress (cd->i, cd->ints - 1, &cd->d, &cd->doubles, &cd->i, &cd->ints); /* cd->i and cd->d become allocated */
+    }
+    else cd->ints --; /* drop the flag */
+
+    j += cd->ints * sizeof (int) + cd->doubles * sizeof (double);
+  }
+
+  ERRMEM (out = malloc (j));
+  p = out + nrecv;
+
+  for (n = 0, cd = *recv, co = out; n < nrecv; n ++, cd ++, co ++)
+  {
+    co->rank = cd->rank;
+    co->ints = cd->ints;
+    co->doubles = cd->doubles;
+    co->i = p; p = (co->i + co->ints);
+    co->d = p; p = (co->d + co->doubles);
+    memcpy (co->i, cd->i, cd->ints * sizeof (int));
+    memcpy (co->d, cd->d, cd->doubles * sizeof (double));
+
+    if (compressed [n])
+    {
+      free (cd->i);
+      free (cd->d);
+    }
+  }
+
+  free (compressed);
+  free (*recv);
+  *recv = out;
+}
+
 /* communicate integers and doubles using point to point communication */
-int COM (MPI_Comm comm, int tag,
-         COMDATA *send, int nsend,
-	 COMDATA **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
+static int com (MPI_Comm comm, int tag,
+                COMDATA *send, int nsend,
+	        COMDATA **recv, int *nrecv)
 {
   COMDATA *cd;
   int rank,
@@ -292,9 +488,9 @@ int COM (MPI_Comm comm, int tag,
 }
 
 /* communicate integers and doubles using all to all communication */
-int COMALL (MPI_Comm comm,
-            COMDATA *send, int nsend,
-	    COMDATA **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
+static int comall (MPI_Comm comm,
+                   COMDATA *send, int nsend,
+	           COMDATA **recv, int *nrecv)
 {
   COMDATA *cd;
   int rank,
@@ -452,6 +648,49 @@ int COMALL (MPI_Comm comm,
   return send_size;
 }
 
+/* set up payload compression: data sent to a rank is compressed if
+ * its size in bytes is >= threshold; threshold = 0 disables compression */
+void COM_Compression (int threshold)
+{
+  compression = MAX (threshold, 0);
+}
+
+/* communicate integers and doubles using point to point communication */
+int COM (MPI_Comm comm, int tag,
+         COMDATA *send, int nsend,
+	 COMDATA **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
+{
+  COMDATA *out;
+  int nout, ret;
+
+  if (compression == 0) return com (comm, tag, send, nsend, recv, nrecv);
+
+  out = compress_send (send, nsend, &nout);
+  ret = com (comm, tag, out, nout, recv, nrecv);
+  decompress_recv (recv, *nrecv);
+  compress_free (out, nout);
+
+  return ret;
+}
+
+/* communicate integers and doubles using all to all communication */
+int COMALL (MPI_Comm comm,
+            COMDATA *send, int nsend,
+	    COMDATA **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
+{
+  COMDATA *out;
+  int nout, ret;
+
+  if (compression == 0) return comall (comm, send, nsend, recv, nrecv);
+
+  out = compress_send (send, nsend, &nout);
+  ret = comall (comm, out, nout, recv, nrecv);
+  decompress_recv (recv, *nrecv);
+  compress_free (out, nout);
+
+  return ret;
+}
+
 /* communicate one set of integers and doubles to all other processors */
 int COMONEALL (MPI_Comm comm, COMDATA send,
 	       COMDATA **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
@@ -464,7 +703,7 @@ int COMONEALL (MPI_Comm comm, COMDATA send,
 
   ERRMEM (send_data = MEM_CALLOC ((ncpu - 1) * sizeof (COMDATA)));
 
-  for (i = 0; i < ncpu; i ++)
+  for (i = j = 0; i < ncpu; i ++)
   {
     if (i != rank)
     {
@@ -517,13 +756,13 @@ static double* next_double (COMDATA *data, int size, int *idx)
 }
 #endif
 
-/* communicate objects using point to point communication */
-int COMOBJS (MPI_Comm comm, int tag,
-	     OBJ_Pack pack,
-	     void *data,
-	     OBJ_Unpack unpack,
-             COMOBJ *send, int nsend,
-	     COMOBJ **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
+/* communicate objects using point to point, all to all or neighbour communication */
+static int comobjs (MPI_Comm comm, int tag, void *neighbours,
+	            OBJ_Pack pack,
+	            void *data,
+	            OBJ_Unpack unpack,
+                    COMOBJ *send, int nsend,
+	            COMOBJ **recv, int *nrecv)
 {
   COMDATA *send_data,
 	  *recv_data,
@@ -567,7 +806,8 @@ int COMOBJS (MPI_Comm comm, int tag,
   }
 
   /* send and receive packed data */
-  if (tag == INT_MIN) ret = COMALL (comm, send_data, nsend, &recv_data, &recv_count); /* all to all */
+  if (neighbours) ret = COMNB (neighbours, send_data, nsend, &recv_data, &recv_count); /* neighbours */
+  else if (tag == INT_MIN) ret = COMALL (comm, send_data, nsend, &recv_data, &recv_count); /* all to all */
   else ret = COM (comm, tag, send_data, nsend, &recv_data, &recv_count); /* point to point */
 
 #if PARDEBUG
@@ -577,7 +817,8 @@ int COMOBJS (MPI_Comm comm, int tag,
     double *qq, *pp;
 
     /* send backwards */
-    if (tag == INT_MIN) COMALL (comm, recv_data, recv_count, &debug_send_data, &debug_send_count);
+    if (neighbours) COMNB (neighbours, recv_data, recv_count, &debug_send_data, &debug_send_count);
+    else if (tag == INT_MIN) COMALL (comm, recv_data, recv_count, &debug_send_data, &debug_send_count);
     else COM (comm, tag, recv_data, recv_count, &debug_send_data, &debug_send_count);
 
     ii[0] = 0, ii[1] = 0;
@@ -667,6 +908,17 @@ int COMOBJS (MPI_Comm comm, int tag,
   return ret;
 }
 
+/* communicate objects using point to point communication */
+int COMOBJS (MPI_Comm comm, int tag,
+	     OBJ_Pack pack,
+	     void *data,
+	     OBJ_Unpack unpack,
+             COMOBJ *send, int nsend,
+	     COMOBJ **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
+{
+  return comobjs (comm, tag, NULL, pack, data, unpack, send, nsend, recv, nrecv);
+}
+
 /* communicate objects using all to all communication */
 int COMOBJSALL (MPI_Comm comm,
 	        OBJ_Pack pack,
@@ -857,6 +1109,22 @@ void* COM_Pattern (MPI_Comm comm, int tag,
     ERRMEM (pattern->send_data = realloc (pattern->send_data, pattern->send_count * sizeof (char*)));
   }
   if (pattern->recv_count) ERRMEM (pattern->recv_rank = realloc (pattern->recv_rank, pattern->recv_count * sizeof (int)));
+
+  /* group send items by send ranks (in the original order) */
+  ERRMEM (pattern->send_first = MEM_CALLOC ((pattern->send_count + 1) * sizeof (int)));
+  ERRMEM (pattern->send_item = malloc ((nsend + 1) * sizeof (int)));
+  ERRMEM (pattern->send_done = MEM_CALLOC (pattern->send_count + 1));
+  for (i = 0, cd = send; i < nsend; i ++, cd ++)
+  {
+    if (cd->ints || cd->doubles) pattern->send_first [pattern->rankmap [cd->rank] + 1] ++;
+  }
+  for (i = 0; i < pattern->send_count; i ++) pattern->send_first [i+1] += pattern->send_first [i];
+  for (i = 0; i < pattern->send_count; i ++) send_count_all [i] = pattern->send_first [i]; /* reuse as insertion positions */
+  for (i = 0, cd = send; i < nsend; i ++, cd ++)
+  {
+    if (cd->ints || cd->doubles) pattern->send_item [send_count_all [pattern->rankmap [cd->rank]] ++] = i;
+  }
+  pattern->recv_posted = 0;
  
   /* cleanup */
   free (send_rank_disp);
@@ -938,61 +1206,87 @@ int COM_Repeat (void *pattern)
   return cp->send_size;
 }
 
-/* non-blocking send */
-int COM_Send (void *pattern)
+/* post receives of a pattern unless already posted */
+static void post_receives (COMPATTERN *cp)
 {
-  COMPATTERN *cp = pattern;
-  int *rankmap = cp->rankmap,
-      *send_position = cp->send_position,
-     (*send_sizes) [3] = cp->send_sizes,
-      *send_rank = cp->send_rank,
-      *recv_rank = cp->recv_rank,
-     (*recv_sizes) [3] = cp->recv_sizes,
-       send_count = cp->send_count,
-       recv_count = cp->recv_count,
-       tag = cp->tag,
-       nsend = cp->nsend,
-       i, j;
-  char **send_data = cp->send_data,
-       **recv_data = cp->recv_data;
-  MPI_Request *send_req = cp->send_req,
-              *recv_req = cp->recv_req;
+  int i;
+
+  if (cp->recv_posted) return;
+
+  for (i = 0; i < cp->recv_count; i ++)
+  {
+    MPI_Irecv (cp->recv_data [i], cp->recv_sizes [i][2], MPI_PACKED, cp->recv_rank [i], cp->tag, cp->comm, &cp->recv_req [i]);
+  }
+
+  cp->recv_posted = 1;
+}
+
+/* pack and send data of the j-th send rank */
+static void send_to (COMPATTERN *cp, int j)
+{
+  int (*send_sizes) [3] = cp->send_sizes,
+       *send_position = cp->send_position,
+        i;
+  char *send_data = cp->send_data [j];
   MPI_Comm comm = cp->comm;
   COMDATA *cd;
 
-  for (i = 0; i < send_count; i ++)
-    send_position [i] = 0;
+  send_position [j] = 0;
 
   /* pack ints */
-  for (i = 0, cd = cp->send; i < nsend; i ++, cd ++)
+  for (i = cp->send_first [j]; i < cp->send_first [j+1]; i ++)
   {
-    if (cd->ints)
-    {
-      j = rankmap [cd->rank];
-      MPI_Pack (cd->i, cd->ints, MPI_INT, send_data [j], send_sizes [j][2], &send_position [j], comm);
-    }
+    cd = &cp->send [cp->send_item [i]];
+    if (cd->ints) MPI_Pack (cd->i, cd->ints, MPI_INT, send_data, send_sizes [j][2], &send_position [j], comm);
   }
 
   /* pack doubles */
-  for (i = 0, cd = cp->send; i < nsend; i ++, cd ++)
+  for (i = cp->send_first [j]; i < cp->send_first [j+1]; i ++)
   {
-    if (cd->doubles)
-    {
-      j = rankmap [cd->rank];
-      MPI_Pack (cd->d, cd->doubles, MPI_DOUBLE, send_data [j], send_sizes [j][2], &send_position [j], comm);
-    }
+    cd = &cp->send [cp->send_item [i]];
+    if (cd->doubles) MPI_Pack (cd->d, cd->doubles, MPI_DOUBLE, send_data, send_sizes [j][2], &send_position [j], comm);
   }
 
-  /* send data */
-  for (i = 0; i < send_count; i ++)
+  MPI_Isend (send_data, send_sizes [j][2], MPI_PACKED, cp->send_rank [j], cp->tag, comm, &cp->send_req [j]);
+
+  cp->send_done [j] = 1;
+}
+
+/* post non-blocking receives */
+void COM_Post (void *pattern)
+{
+  post_receives (pattern);
+}
+
+/* non-blocking send to one rank; return the number of sent bytes */
+int COM_Send_To (void *pattern, int rank)
+{
+  COMPATTERN *cp = pattern;
+  int j = cp->rankmap [rank];
+
+  if (j < cp->send_count && cp->send_rank [j] == rank && !cp->send_done [j])
   {
-    MPI_Isend (send_data [i], send_sizes [i][2], MPI_PACKED, send_rank [i], tag, comm, &send_req [i]);
+    post_receives (cp);
+
+    send_to (cp, j);
+
+    return cp->send_sizes [j][2];
   }
 
-  /* receive data */
-  for (i = 0; i < recv_count; i ++)
+  return 0;
+}
+
+/* non-blocking send */
+int COM_Send (void *pattern)
+{
+  COMPATTERN *cp = pattern;
+  int i;
+
+  post_receives (cp);
+
+  for (i = 0; i < cp->send_count; i ++) /* send data to ranks not yet served by COM_Send_To */
   {
-    MPI_Irecv (recv_data [i], recv_sizes [i][2], MPI_PACKED, recv_rank [i], tag, comm, &recv_req [i]);
+    if (!cp->send_done [i]) send_to (cp, i);
   }
 
   return cp->send_size;
@@ -1005,27 +1299,33 @@ void COM_Recv (void *pattern)
   int (*recv_sizes) [3] = cp->recv_sizes,
         recv_count = cp->recv_count,
         send_count = cp->send_count,
-        i, j;
+        i, j, k;
   char **recv_data = cp->recv_data;
-  MPI_Request *send_req = cp->send_req,
-	      *recv_req = cp->recv_req;
-  MPI_Status *send_sta = cp->send_sta,
-             *recv_sta = cp->recv_sta;
   MPI_Comm comm = cp->comm;
   COMDATA *cd;
 
-  /* wait until until send is done */
-  MPI_Waitall (send_count, send_req, send_sta);
+  for (i = 0; i < send_count; i ++) /* make sure that all data was sent */
+  {
+    if (!cp->send_done [i]) send_to (cp, i);
+  }
 
-  /* wait until until receive is done */
-  MPI_Waitall (recv_count, recv_req, recv_sta);
+  post_receives (cp);
 
-  /* unpack data */
-  for (i = j = 0, cd = cp->recv; i < recv_count; i ++, cd ++, j = 0)
+  /* unpack data as it arrives */
+  for (k = 0; k < recv_count; k ++)
   {
+    MPI_Waitany (recv_count, cp->recv_req, &i, MPI_STATUS_IGNORE);
+    cd = &cp->recv [i];
+    j = 0;
     MPI_Unpack (recv_data [i], recv_sizes [i][2], &j, cd->i, cd->ints, MPI_INT, comm);
     MPI_Unpack (recv_data [i], recv_sizes [i][2], &j, cd->d, cd->doubles, MPI_DOUBLE, comm);
   }
+
+  /* wait until until send is done */
+  MPI_Waitall (send_count, cp->send_req, cp->send_sta);
+
+  for (i = 0; i < send_count; i ++) cp->send_done [i] = 0;
+  cp->recv_posted = 0;
 }
 
 /* free point to point communication pattern */
@@ -1050,6 +1350,9 @@ void COM_Free (void *pattern)
   free (cp->recv_sta);
   free (cp->send_req);
   free (cp->send_sta);
+  free (cp->send_first);
+  free (cp->send_item);
+  free (cp->send_done);
   free (pattern);
 }
 
@@ -1235,3 +1538,263 @@ void COMALL_Free (void *pattern)
   free (pp->recv);
   free (pp);
 }
+
+/* create a neighbourhood for point to point communication with a changing set of
+ * neighbour ranks; neighbours are learnt from the traffic: whenever some rank sends
+ * to a non-neighbour, all ranks fall back to all to all communication and the new
+ * neighbour pairs are recorded */
+void* COM_Neighbours (MPI_Comm comm, int tag)
+{
+  COMNEIGHBOURS *nb;
+  int i;
+
+  ERRMEM (nb = MEM_CALLOC (sizeof (COMNEIGHBOURS)));
+  nb->comm = comm;
+  nb->tag = tag;
+  MPI_Comm_size (comm, &nb->ncpu);
+  ERRMEM (nb->index = malloc (nb->ncpu * sizeof (int)));
+  for (i = 0; i < nb->ncpu; i ++) nb->index [i] = -1;
+
+  return nb;
+}
+
+/* forget all neighbours (to be called on all ranks) */
+void COM_Neighbours_Reset (void *neighbours)
+{
+  COMNEIGHBOURS *nb = neighbours;
+  int i;
+
+  for (i = 0; i < nb->count; i ++) nb->index [nb->rank [i]] = -1;
+  nb->count = 0;
+}
+
+/* free neighbourhood */
+void COM_Neighbours_Free (void *neighbours)
+{
+  COMNEIGHBOURS *nb = neighbours;
+
+  free (nb->index);
+  free (nb->rank);
+  free (nb);
+}
+
+/* communicate integers and doubles between neighbours */
+static int comnb (COMNEIGHBOURS *nb,
+                  COMDATA *send, int nsend,
+	          COMDATA **recv, int *nrecv)
+{
+  int send_size,
+    (*send_sizes) [3],
+     *send_position,
+    (*recv_sizes) [3],
+      outside,
+      count,
+      i, j, k;
+  char **send_data,
+       **recv_data;
+  MPI_Request *req;
+  COMDATA *cd;
+  void *p;
+
+  /* find out whether some rank sends outside of its neighbourhood */
+  for (i = j = 0, cd = send; i < nsend; i ++, cd ++)
+  {
+    if ((cd->ints || cd->doubles) && nb->index [cd->rank] < 0) j = 1;
+  }
+  MPI_Allreduce (&j, &outside, 1, MPI_INT, MPI_MAX, nb->comm);
+
+  if (outside) /* fall back to all to all communication and record new neighbours */
+  {
+    send_size = comall (nb->comm, send, nsend, recv, nrecv);
+
+    for (i = 0, cd = send; i < nsend; i ++, cd ++)
+    {
+      if (cd->ints || cd->doubles) neighbours_insert (nb, cd->rank);
+    }
+
+    for (i = 0, cd = *recv; i < *nrecv; i ++, cd ++) neighbours_insert (nb, cd->rank);
+
+    return send_size;
+  }
+
+  count = nb->count;
+
+  ERRMEM (send_sizes = MEM_CALLOC (count * sizeof (int [3])));
+  ERRMEM (send_position = MEM_CALLOC (count * sizeof (int)));
+  ERRMEM (send_data = MEM_CALLOC (count * sizeof (char*)));
+  ERRMEM (recv_sizes = MEM_CALLOC (count * sizeof (int [3])));
+  ERRMEM (recv_data = MEM_CALLOC (count * sizeof (char*)));
+  ERRMEM (req = malloc (2 * count * sizeof (MPI_Request)));
+
+  /* compute send sizes */
+  for (i = 0, cd = send; i < nsend; i ++, cd ++)
+  {
+    if (cd->ints || cd->doubles)
+    {
+      int n = nb->index [cd->rank];
+
+      send_sizes [n][0] += cd->ints;
+      send_sizes [n][1] += cd->doubles;
+      MPI_Pack_size (cd->ints, MPI_INT, nb->comm, &j);
+      MPI_Pack_size (cd->doubles, MPI_DOUBLE, nb->comm, &k);
+      send_sizes [n][2] += (j + k);
+    }
+  }
+
+  /* allocate send buffers */
+  for (send_size = i = 0; i < count; i ++)
+  {
+    if (send_sizes [i][2])
+    {
+      ERRMEM (send_data [i] = malloc (send_sizes [i][2]));
+      send_size += send_sizes [i][2];
+    }
+  }
+
+  /* pack ints */
+  for (i = 0, cd = send; i < nsend; i ++, cd ++)
+  {
+    if (cd->ints)
+    {
+      j = nb->index [cd->rank];
+      MPI_Pack (cd->i, cd->ints, MPI_INT, send_data [j], send_sizes [j][2], &send_position [j], nb->comm);
+    }
+  }
+
+  /* pack doubles */
+  for (i = 0, cd = send; i < nsend; i ++, cd ++)
+  {
+    if (cd->doubles)
+    {
+      j = nb->index [cd->rank];
+      MPI_Pack (cd->d, cd->doubles, MPI_DOUBLE, send_data [j], send_sizes [j][2], &send_position [j], nb->comm);
+    }
+  }
+
+#if DEBUG
+  for (i = 0; i < count; i ++)
+  {
+    ASSERT_DEBUG (send_position [i] <= send_sizes [i][2], "Incorrect packing");
+  }
+#endif
+
+  /* exchange sizes with all neighbours (also zero sizes) */
+  for (i = 0; i < count; i ++)
+  {
+    MPI_Irecv (recv_sizes [i], 3, MPI_INT, nb->rank [i], nb->tag, nb->comm, &req [i]);
+    MPI_Isend (send_sizes [i], 3, MPI_INT, nb->rank [i], nb->tag, nb->comm, &req [count + i]);
+  }
+  MPI_Waitall (2 * count, req, MPI_STATUSES_IGNORE);
+
+  /* contiguous receive size */
+  for (j = k = i = 0; i < count; i ++)
+  {
+    if (recv_sizes [i][2])
+    {
+      j += recv_sizes [i][0] * sizeof (int) + 
+	   recv_sizes [i][1] * sizeof (double);
+      k ++;
+    }
+  }
+
+  if (k)
+  {
+    /* prepare receive buffers */
+    ERRMEM ((*recv) = malloc (k * sizeof (COMDATA) + j));
+    p = (*recv) + k;
+    *nrecv = k;
+    for (i = 0, cd = *recv; i < count; i ++)
+    {
+      if (recv_sizes [i][2])
+      {
+	cd->rank = nb->rank [i];
+	cd->ints = recv_sizes [i][0];
+	cd->doubles = recv_sizes [i][1];
+	cd->i = p; p = (cd->i + cd->ints);
+	cd->d = p; p = (cd->d + cd->doubles);
+	ERRMEM (recv_data [i] = malloc (recv_sizes [i][2]));
+	cd ++;
+      }
+    }
+  }
+  else
+  {
+    *recv = NULL;
+    *nrecv = 0;
+  }
+
+  /* communicate data */
+  for (k = i = 0; i < count; i ++)
+  {
+    if (recv_sizes [i][2])
+    {
+      MPI_Irecv (recv_data [i], recv_sizes [i][2], MPI_PACKED, nb->rank [i], nb->tag, nb->comm, &req [k ++]);
+    }
+  }
+  for (i = 0; i < count; i ++)
+  {
+    if (send_sizes [i][2])
+    {
+      MPI_Isend (send_data [i], send_sizes [i][2], MPI_PACKED, nb->rank [i], nb->tag, nb->comm, &req [k ++]);
+    }
+  }
+  MPI_Waitall (k, req, MPI_STATUSES_IGNORE);
+
+  /* unpack data */
+  for (i = 0, cd = *recv; i < count; i ++)
+  {
+    if (recv_sizes [i][2])
+    {
+      j = 0;
+      MPI_Unpack (recv_data [i], recv_sizes [i][2], &j, cd->i, cd->ints, MPI_INT, nb->comm);
+      MPI_Unpack (recv_data [i], recv_sizes [i][2], &j, cd->d, cd->doubles, MPI_DOUBLE, nb->comm);
+      cd ++;
+    }
+  }
+
+  /* cleanup */
+  for (i = 0; i < count; i ++)
+  {
+    free (send_data [i]);
+    free (recv_data [i]);
+  }
+  free (send_sizes);
+  free (send_position);
+  free (send_data);
+  free (recv_sizes);
+  free (recv_data);
+  free (req);
+
+  return send_size;
+}
+
+/* communicate integers and doubles between neighbours */
+int COMNB (void *neighbours,
+           COMDATA *send, int nsend,
+	   COMDATA **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
+{
+  COMDATA *out;
+  int nout, ret;
+
+  if (compression == 0) return comnb (neighbours, send, nsend, recv, nrecv);
+
+  out = compress_send (send, nsend, &nout);
+  ret = comnb (neighbours, out, nout, recv, nrecv);
+  decompress_recv (recv, *nrecv);
+  compress_free (out, nout);
+
+  return ret;
+}
+
+/* communicate objects between neighbours */
+int COMOBJSNB (void *neighbours,
+	       OBJ_Pack pack,
+	       void *data,
+	       OBJ_Unpack unpack,
+               COMOBJ *send, int nsend,
+	       COMOBJ **recv, int *nrecv) /* recv is contiguous => free (*recv) releases all memory */
+{
+  COMNEIGHBOURS *nb = neighbours;
+
+  return comobjs (nb->comm, nb->tag, neighbours, pack, data, unpack, send, nsend, recv, nrecv);
+}
@@ -47,6 +47,11 @@ struct comobj
   void *o; /* object */
 };
 
+/* set up payload compression: data sent to a rank is compressed if
+ * its size in bytes is >= threshold; threshold = 0 disables compression
+ * (default); patterns are not compressed; call on all processors */
+void COM_Compression (int threshold);
+
 /* communicate integers and doubles using point to point communication */
 int COM (MPI_Comm comm, int tag,
          COMDATA *send, int nsend,
@@ -96,7 +101,13 @@ void* COM_Pattern (MPI_Comm comm, int tag,
  * to the pattern computed by COM_Pattern */
 int COM_Repeat (void *pattern);
 
-/* non-blocking send */
+/* post non-blocking receives (optional: COM_Send and COM_Send_To post them too) */
+void COM_Post (void *pattern);
+
+/* non-blocking send to one rank of the pattern; return the number of sent bytes */
+int COM_Send_To (void *pattern, int rank);
+
+/* non-blocking send (to the ranks not yet served by COM_Send_To) */
 int COM_Send (void *pattern);
 
 /* blocking receive */
@@ -118,4 +129,29 @@ int COMALL_Repeat (void *pattern);
 
 /* free all to all communication pattern */
 void COMALL_Free (void *pattern);
+
+/* create a neighbourhood for point to point communication with a changing set of
+ * neighbour ranks; neighbours are learnt from the traffic: whenever some rank sends
+ * to a non-neighbour, all ranks fall back to all to all communication and the new
+ * neighbour pairs are recorded */
+void* COM_Neighbours (MPI_Comm comm, int tag);
+
+/* forget all neighbours (to be called on all ranks) */
+void COM_Neighbours_Reset (void *neighbours);
+
+/* free neighbourhood */
+void COM_Neighbours_Free (void *neighbours);
+
+/* communicate integers and doubles between neighbours */
+int COMNB (void *neighbours,
+           COMDATA *send, int nsend,
+	   COMDATA **recv, int *nrecv); /* recv is contiguous => free (*recv) releases all memory */
+
+/* communicate objects between neighbours */
+int COMOBJSNB (void *neighbours,
+	       OBJ_Pack pack,
+	       void *data,
+	       OBJ_Unpack unpack,
+               COMOBJ *send, int nsend,
+	       COMOBJ **recv, int *nrecv); /* recv is contiguous => free (*recv) releases all memory */
 #endif
@@ -24,10 +24,13 @@
 #include <float.h>
 #include "cvi.h"
 #include "hul.h"
+#include "map.h"
 #include "alg.h"
 #include "gjk.h"
 #include "err.h"
 
+#define MAPBLK 128 /* polarisation map items memory block size */
+
 /* push 'p' deeper inside of convices bounded by two plane sets */
 static int refine_point (double *pa, int npa, double *pb, int npb, double *p, double *epsout)
 {
@@ -114,20 +117,64 @@ static void dump_input (double *va, int nva, double *pa, int npa, double *vb, in
 
 /* compute intersection of two convex polyhedrons */
 TRI* cvi (double *va, int nva, double *pa, int npa, double *vb, int nvb, double *pb, int npb, CVIKIND kind, int *m)
+{
+  return cvi_warm (va, nva, NULL, pa, npa, vb, nvb, NULL, pb, npb, kind, NULL, m);
+}
+
+/* compute intersection of two convex polyhedrons with a warm started proximity query */
+TRI* cvi_warm (double *va, int nva, int *ga, double *pa, int npa, double *vb, int nvb, int *gb, double *pb, int npb, CVIKIND kind, GJK_CACHE *cache, int *m)
+{
+  CVI_WORKSPACE work;
+  TRI *tri;
+
+  cvi_workspace_init (&work);
+
+  if ((tri = cvi_work (&work, va, nva, ga, pa, npa, vb, nvb, gb, pb, npb, kind, cache, m))) work.tri = NULL; /* hand the output over */
+
+  cvi_workspace_release (&work);
+
+  return tri;
+}
+
+/* initialize an empty workspace */
+void cvi_workspace_init (CVI_WORKSPACE *work)
+{
+  hull_workspace_init (&work->hull);
+  MEM_Init (&work->mapmem, sizeof (MAP), MAPBLK);
+  work->pfv = NULL;
+  work->pfvsize = 0;
+  work->yy = NULL;
+  work->yysize = 0;
+  work->tri = NULL;
+  work->trisize = 0;
+}
+
+/* release workspace memory */
+void cvi_workspace_release (CVI_WORKSPACE *work)
+{
+  hull_workspace_release (&work->hull);
+  MEM_Release (&work->mapmem);
+  free (work->pfv);
+  free (work->yy);
+  free (work->tri);
+  cvi_workspace_init (work);
+}
+
+/* compute intersection of two convex polyhedrons using workspace memory */
+TRI* cvi_work (CVI_WORKSPACE *work, double *va, int nva, int *ga, double *pa, int npa, double *vb, int nvb, int *gb, double *pb, int npb, CVIKIND kind, GJK_CACHE *cache, int *m)
 {
   double e [6], p [3], q [3], eps, d, *nl, *pt, *nn, *yy;
   PFV *pfv, *v, *w, *z;
+  TRI *hul, *tri, *t;
   int i, j, k, n;
-  TRI *tri, *t;
+  size_t size;
 
   /* initialize */
   eps = GEOMETRIC_EPSILON;
   tri = t = NULL;
-  pfv = NULL;
-  yy = NULL;
 
   /* compute closest points */
-  d = gjk (va, nva, vb, nvb, p, q);
+  d = gjk_warm (va, nva, ga, vb, nvb, gb, cache, p, q);
   if (d > GEOMETRIC_EPSILON) { *m = 0; return NULL; }
 
   /* push 'p' deeper inside only if regularized intersection is sought */
@@ -138,7 +185,13 @@ TRI* cvi (double *va, int nva, double *pa, int npa, double *vb, int nvb, double
 
   /* translate base points of planes so that
    * p = q = 0; compute new normals 'yy' */
-  ERRMEM (yy = malloc (sizeof (double [3]) * (npa+npb)));
+  if (npa+npb > work->yysize)
+  {
+    free (work->yy);
+    work->yysize = 2 * (npa+npb);
+    ERRMEM (work->yy = malloc (sizeof (double [3]) * work->yysize));
+  }
+  yy = work->yy;
   for (i = 0, nl = pa, pt = pa + 3, nn = yy;
        i < npa; i ++, nl += 6, pt += 6, nn += 3)
   {
@@ -158,8 +211,8 @@ TRI* cvi (double *va, int nva, double *pa, int npa, double *vb, int nvb, double
 
   /* compute and polarise convex
    * hull of new normals 'yy' */
-  if (!(tri = hull (yy, npa+npb, &i))) goto error; /* tri = cv (polar (a) U polar (b)) */
-  if (!(pfv = TRI_Polarise (tri, i, &j))) goto error; /* pfv = polar (tri) => pfv = a * b */
+  if (!(hul = hull_work (&work->hull, yy, npa+npb, &i))) goto error; /* hul = cv (polar (a) U polar (b)) */
+  if (!(pfv = TRI_Polarise_Ext (hul, i, &work->mapmem, &work->pfv, &work->pfvsize, &j))) goto error; /* pfv = polar (hul) => pfv = a * b */
 
   /* normals in 'pfv' point to 'yy'; triangulate
    * polar faces and set 'a' or 'b' flags */
@@ -178,7 +231,14 @@ TRI* cvi (double *va, int nva, double *pa, int npa, double *vb, int nvb, double
 #else
   if (n - j*2 <= 3) goto error;
 #endif
-  ERRMEM (tri = realloc (tri, sizeof (TRI) * (n-j*2) + sizeof (double [3]) * i)); /* allocate space for triangles and vertices */
+  size = sizeof (TRI) * (n-j*2) + sizeof (double [3]) * i; /* space for triangles and vertices */
+  if (size > work->trisize)
+  {
+    free (work->tri);
+    work->trisize = (work->trisize ? 2 * size : size);
+    ERRMEM (work->tri = malloc (work->trisize));
+  }
+  tri = work->tri;
   pt = (double*) (tri + (n - j*2)); /* this is where output vertices begin */
   nn = (double*) (pfv + n); /* this is where coords begin in 'pfv' block */
   memcpy (pt, nn, sizeof (double [3]) * i); /* copy vertex data */
@@ -213,16 +273,10 @@ TRI* cvi (double *va, int nva, double *pa, int npa, double *vb, int nvb, double
     }
   }
 
-  goto done;
-
-error:
-  if (tri) free (tri);
-  tri = t = NULL;
-
-done:
-  free (yy);
-  free (pfv);
-
   (*m) = (t - tri);
   return tri;
+
+error:
+  *m = 0;
+  return NULL;
 }
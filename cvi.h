@@ -20,6 +20,8 @@
  * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
 
 #include "tri.h"
+#include "hul.h"
+#include "gjk.h"
 
 #ifndef __cvi__
 #define __cvi__
@@ -42,4 +44,40 @@ TRI* cvi (double *va, int nva, double *pa, int npa,
 	  CVIKIND kind,
 	  int *m);
 
+/* as above, where the initial proximity query is warm started
+ * from the optional vertex graphs 'ga', 'gb' and 'cache' (see gjk.h) */
+TRI* cvi_warm (double *va, int nva, int *ga, double *pa, int npa,
+               double *vb, int nvb, int *gb, double *pb, int npb,
+	       CVIKIND kind, GJK_CACHE *cache,
+	       int *m);
+
+typedef struct cvi_workspace CVI_WORKSPACE;
+
+/* memory of the intersection routine kept between calls */
+struct cvi_workspace
+{
+  HULL_WORKSPACE hull; /* hull of polar vertices */
+  MEM mapmem; /* polarisation map items */
+  PFV *pfv; /* polar faces */
+  size_t pfvsize; /* 'pfv' size in bytes */
+  double *yy; /* polar vertices */
+  int yysize; /* number of vertices 'yy' can hold */
+  TRI *tri; /* output triangles followed by their vertices */
+  size_t trisize; /* 'tri' size in bytes */
+};
+
+/* initialize an empty workspace */
+void cvi_workspace_init (CVI_WORKSPACE *work);
+
+/* release workspace memory */
+void cvi_workspace_release (CVI_WORKSPACE *work);
+
+/* as cvi_warm, but reusing the workspace memory, so that repeated calls do not allocate;
+ * the returned triangles belong to 'work' and stay valid until the next call with it */
+TRI* cvi_work (CVI_WORKSPACE *work,
+               double *va, int nva, int *ga, double *pa, int npa,
+               double *vb, int nvb, int *gb, double *pb, int npb,
+	       CVIKIND kind, GJK_CACHE *cache,
+	       int *m);
+
 #endif
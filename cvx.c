@@ -35,6 +35,7 @@
 #include "pck.h"
 #include "fem.h"
 #include "kdt.h"
+#include "thr.h"
 
 #define MEMINC 64 /* memory increment size used in convex manipulations */
 
@@ -176,6 +177,59 @@ static int size (CONVEX *cvx)
     sizeof (double [4]) * cvx->nfac + sizeof (int) * (l + cvx->nfac);
 }
 
+/* compute vertex graph from faces: neighbours of vertex i
+ * are stored at g [g [i]], ..., g [g [i+1]-1] (see gjk.h) */
+static int* vertex_graph (CONVEX *cvx)
+{
+  int n, m, l, i, j, k, e, *fac, *end, *g;
+
+  ERRMEM (end = calloc (cvx->nver + 1, sizeof (int)));
+
+  /* upper bound on the neighbour count: two per face corner */
+  for (fac = cvx->fac, n = m = e = 0; n < cvx->nfac; n ++, m += fac [m] + 1)
+  {
+    for (l = 1; l <= fac [m]; l ++, e += 2) end [fac [m+l] / 3] += 2;
+  }
+
+  ERRMEM (g = malloc (sizeof (int) * (cvx->nver + 1 + e)));
+
+  for (g [0] = cvx->nver + 1, i = 0; i < cvx->nver; i ++)
+  {
+    g [i+1] = g [i] + end [i];
+    end [i] = g [i]; /* current end of the neighbour list of i */
+  }
+
+  /* insert face neighbours skipping duplicates */
+  for (n = m = 0; n < cvx->nfac; n ++, m += fac [m] + 1)
+  {
+    for (l = 1; l <= fac [m]; l ++)
+    {
+      i = fac [m+l] / 3;
+
+      for (e = 0; e < 2; e ++)
+      {
+        j = fac [m + (e ? (l < fac [m] ? l + 1 : 1) : (l > 1 ? l - 1 : fac [m]))] / 3; /* next or previous corner */
+
+	for (k = g [i]; k < end [i] && g [k] != j; k ++);
+
+	if (k == end [i]) g [end [i] ++] = j;
+      }
+    }
+  }
+
+  /* compact lists */
+  for (k = cvx->nver + 1, i = 0; i < cvx->nver; i ++)
+  {
+    for (j = g [i], g [i] = k; j < end [i]; j ++) g [k ++] = g [j];
+  }
+  g [cvx->nver] = k;
+
+  free (end);
+  ERRMEM (g = realloc (g, sizeof (int) * k));
+
+  return g;
+}
+
 /* copy single convex */
 static CONVEX* copycvx (CONVEX *cvx)
 {
@@ -193,6 +247,7 @@ static CONVEX* copycvx (CONVEX *cvx)
   twin->pla = twin->cur + twin->nver * 3;
   twin->surface = (int*) (twin->pla + twin->nfac * 4);
   twin->fac = twin->surface + twin->nfac;
+  twin->vgr = vertex_graph (twin);
   if (cvx->nadj)
   {
     ERRMEM (twin->adj = malloc (cvx->nadj * sizeof (CONVEX*)));
@@ -644,6 +699,9 @@ CONVEX* CONVEX_Create (CONVEX *cvx, double *ver, int nver, int *fac, int nfac, i
 
   /* calculate planes */
   computeplanes (cvy);
+
+  /* vertex graph */
+  cvy->vgr = vertex_graph (cvy);
  
   /* append list */
   cvy->next = cvx;
@@ -713,6 +771,34 @@ CONVEX* CONVEX_Hull (CONVEX *cvx, double *pnt, int npnt, int surface, int volume
   return cvy;
 }
 
+typedef struct hull_batch HULL_BATCH;
+
+/* batch of point sets */
+struct hull_batch
+{
+  double **pnt;
+
+  int *npnt,
+      *surface,
+      *volume;
+
+  CONVEX **out;
+};
+
+/* create the i-th hull of a batch */
+static void hull_job (HULL_BATCH *data, int i)
+{
+  data->out [i] = CONVEX_Hull (NULL, data->pnt [i], data->npnt [i], data->surface [i], data->volume [i]);
+}
+
+/* create convex hulls of many point sets concurrently */
+void CONVEX_Hull_Batch (int count, double **pnt, int *npnt, int *surface, int *volume, CONVEX **out)
+{
+  HULL_BATCH data = {pnt, npnt, surface, volume, out};
+
+  THREAD_Loop (count, (THREAD_Job) hull_job, &data);
+}
+
 /* glue to convex lists */
 CONVEX* CONVEX_Glue (CONVEX *cvx, CONVEX *cvy)
 {
@@ -1411,19 +1497,27 @@ int CONVEX_Adjacent (CONVEX *one, CONVEX *two)
 /* return 6-vector (normal, point) planes of convex faces */
 double* CONVEX_Planes (CONVEX *cvx)
 {
-  double *cur, *pla, *p, *q;
-  int i, *f;
+  double *p;
 
   ERRMEM (p = malloc (cvx->nfac * sizeof (double [6])));
 
+  CONVEX_Planes_Ext (cvx, p);
+
+  return p;
+}
+
+/* output planes into a given table */
+void CONVEX_Planes_Ext (CONVEX *cvx, double *p)
+{
+  double *cur, *pla, *q;
+  int i, *f;
+
   for (i = 0, cur = cvx->cur, pla = cvx->pla, q = p, f = cvx->fac;
        i < cvx->nfac; i ++, pla += 4, q += 6, f += f[0]+1)
   {
     COPY (pla, q);
     COPY (&cur [f[1]], q+3);
   }
-
-  return p;
 }
 
 /* free list of convices */
@@ -1435,6 +1529,7 @@ void CONVEX_Destroy (CONVEX *cvx)
   {
     nxt = cvx->next;
     free (cvx->adj);
+    free (cvx->vgr);
     free (cvx->ele);
     free (cvx->epn);
     free (cvx);
@@ -1523,6 +1618,7 @@ CONVEX* CONVEX_Unpack (void *solfec, int *dpos, double *d, int doubles, int *ipo
 
     unpack_ints (ipos, i, ints, ptr->fac, facsi);
     unpack_ints (ipos, i, ints, ptr->surface, nfac);
+    ptr->vgr = vertex_graph (ptr);
 
     unpack_doubles (dpos, d, doubles, ptr->pla, nfac * 4);
     unpack_doubles (dpos, d, doubles, ptr->cur, nver * 3);
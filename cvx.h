@@ -48,7 +48,8 @@ struct convex
   ELEPNT *epn; /* element points corresponding to vertices */
   
   int *surface, /* surface identifiers */
-      *fac; /* faces */
+      *fac, /* faces */
+      *vgr; /* vertex graph (see gjk.h) */
  
   CONVEX **adj; /* adjacency */
 
@@ -76,6 +77,10 @@ CONVEX* CONVEX_Create (CONVEX *cvx, double *ver, int nver, int *fac, int nfac, i
 /* append convices list 'cvx' with a convex hull of the input point set */
 CONVEX* CONVEX_Hull (CONVEX *cvx, double *pnt, int npnt, int surface, int volume);
 
+/* create convex hulls of 'count' point sets 'pnt [i]' of sizes 'npnt [i]' concurrently; 'out [i]'
+ * is a single convex of the i-th hull or NULL if its creation failed; errors are re-thrown */
+void CONVEX_Hull_Batch (int count, double **pnt, int *npnt, int *surface, int *volume, CONVEX **out);
+
 /* glue two convex lists */
 CONVEX* CONVEX_Glue (CONVEX *cvx, CONVEX *cvy);
 
@@ -156,6 +161,9 @@ int CONVEX_Adjacent (CONVEX *one, CONVEX *two);
 /* return 6-vector (normal, point) planes of convex faces */
 double* CONVEX_Planes (CONVEX *cvx);
 
+/* as above, but output into a table of 6 * cvx->nfac doubles */
+void CONVEX_Planes_Ext (CONVEX *cvx, double *p);
+
 /* free list of convices */
 void CONVEX_Destroy (CONVEX *cvx);
 
@@ -5,7 +5,13 @@
  * domain input-output
  */
 
+#include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <float.h>
+#include <math.h>
+#include <rpc/types.h>
+#include <rpc/xdr.h>
 #include "sol.h"
 #include "dio.h"
 #include "pck.h"
@@ -143,25 +149,25 @@ static void write_new_bodies (DOM *dom)
   SET *item;
   int n;
 
-  PBF_Push (bf, "NEWBOD");
-
   n = SET_Size (dom->newb);
-  PBF_Int2 (bf, "count", &n, 1);
 
   for (item = SET_First (dom->newb); item; item = SET_Next (item))
   {
     BODY_Pack (item->data, &dsize, &d, &doubles, &isize, &i, &ints);
   }
 
-  PBF_Int2 (bf, "ints", &ints, 1);
-  PBF_Int2 (bf, "i", i, ints);
-  PBF_Int2 (bf, "doubles", &doubles, 1);
-  PBF_Double2 (bf, "d", d, doubles);
+  /* labeled frame data rather than a named group, so that
+   * ranks sharing one parallel file need not write in step */
+
+  PBF_Label (bf, "NEWBOD");
+  PBF_Int (bf, &n, 1);
+  PBF_Int (bf, &ints, 1);
+  PBF_Int (bf, i, ints);
+  PBF_Int (bf, &doubles, 1);
+  PBF_Double (bf, d, doubles);
 
   free (d);
   free (i);
-
-  PBF_Pop (bf);
 #else
   char *path, *ext;
   FILE *file;
@@ -227,17 +233,29 @@ static void read_new_bodies (DOM *dom, PBF *bf)
       int k, n;
       BODY *bod;
 
-      if (PBF_Has_Group (f, "NEWBOD") == 0) continue; /* don't try to read if there are no new bodies stored */
-
-      PBF_Push (f, "NEWBOD");
-
-      PBF_Int2 (f, "count", &n, 1);
-      PBF_Int2 (f, "ints", &ints, 1);
-      ERRMEM (i = malloc (sizeof (int [ints])));
-      PBF_Int2 (f, "i", i, ints);
-      PBF_Int2 (f, "doubles", &doubles, 1);
-      ERRMEM (d = malloc (sizeof (double [doubles])));
-      PBF_Double2 (f, "d", d, doubles);
+      if (PBF_Label (f, "NEWBOD"))
+      {
+	PBF_Int (f, &n, 1);
+	PBF_Int (f, &ints, 1);
+	ERRMEM (i = malloc (sizeof (int [ints])));
+	PBF_Int (f, i, ints);
+	PBF_Int (f, &doubles, 1);
+	ERRMEM (d = malloc (sizeof (double [doubles])));
+	PBF_Double (f, d, doubles);
+      }
+      else if (PBF_Has_Group (f, "NEWBOD")) /* older files */
+      {
+	PBF_Push (f, "NEWBOD");
+	PBF_Int2 (f, "count", &n, 1);
+	PBF_Int2 (f, "ints", &ints, 1);
+	ERRMEM (i = malloc (sizeof (int [ints])));
+	PBF_Int2 (f, "i", i, ints);
+	PBF_Int2 (f, "doubles", &doubles, 1);
+	ERRMEM (d = malloc (sizeof (double [doubles])));
+	PBF_Double2 (f, "d", d, doubles);
+	PBF_Pop (f);
+      }
+      else continue; /* no new bodies stored */
 
       for (k = 0; k < n; k ++)
       {
@@ -255,8 +273,6 @@ static void read_new_bodies (DOM *dom, PBF *bf)
 
       free (d);
       free (i);
-
-      PBF_Pop (f);
     }
   } while (PBF_Forward (bf, 1));
 
@@ -359,6 +375,61 @@ static void read_new_bodies (DOM *dom, PBF *bf)
 #endif
 }
 
+#if !HDF5
+/* write body offset table: ids, data positions and
+ * (outward rounded) extents of bodies written in this frame */
+static void write_body_table (DOM *dom, PBF *bf, unsigned int *pos)
+{
+  unsigned int *ids;
+  float *ext;
+  BODY *bod;
+  int n, k;
+
+  ERRMEM (ids = malloc (sizeof (unsigned int [dom->nbod + 1])));
+  ERRMEM (ext = malloc (sizeof (float [6 * (dom->nbod + 1)])));
+
+  for (n = 0, bod = dom->bod; bod; bod = bod->next, n ++)
+  {
+    ids [n] = bod->id;
+    for (k = 0; k < 3; k ++) ext [6*n+k] = nextafterf ((float) bod->extents [k], -HUGE_VALF);
+    for (k = 3; k < 6; k ++) ext [6*n+k] = nextafterf ((float) bod->extents [k], HUGE_VALF);
+  }
+
+  PBF_Label (bf, "BODX");
+  PBF_Int (bf, &n, 1);
+  PBF_Uint (bf, ids, n);
+  PBF_Uint (bf, pos, n);
+  PBF_Float (bf, ext, 6 * n);
+
+  free (ids);
+  free (ext);
+}
+#endif
+
+/* skip body state in the input */
+static void skip_body (BODY *bod, PBF *bf)
+{
+  int conf = BODY_Conf_Size (bod), energy = BODY_ENERGY_SIZE (bod), rank;
+  double *d;
+
+  ERRMEM (d = malloc (sizeof (double [MAX (MAX (conf, bod->dofs), energy)])));
+
+  PBF_Double (bf, d, conf);
+  PBF_Double (bf, d, bod->dofs);
+  PBF_Double (bf, d, energy);
+
+  if (bf->parallel == PBF_ON) PBF_Int (bf, &rank, 1);
+
+  free (d);
+}
+
+/* test whether extents overlap a box */
+static int overlap (double *e, double *box)
+{
+  return !(e[3] < box[0] || e[4] < box[1] || e[5] < box[2] ||
+           e[0] > box[3] || e[1] > box[4] || e[2] > box[5]);
+}
+
 /* write domain state */
 void dom_write_state (DOM *dom, PBF *bf)
 {
@@ -390,15 +461,35 @@ void dom_write_state (DOM *dom, PBF *bf)
 
   PBF_Int (bf, &dom->nbod, 1);
 
+#if !HDF5
+  unsigned int *pos;
+  int n = 0;
+
+  ERRMEM (pos = malloc (sizeof (unsigned int [dom->nbod + 1])));
+#endif
+
   for (BODY *bod = dom->bod; bod; bod = bod->next)
   {
     PBF_Uint (bf, &bod->id, 1);
 
     if (bod->label) PBF_Label (bf, bod->label); /* label body record for fast access */
 
+#if !HDF5
+    ASSERT_DEBUG (n < dom->nbod, "Inconsistent body count");
+    pos [n ++] = PBF_Tell (bf); /* record position of the body state */
+#endif
+
     BODY_Write_State (bod, bf);
   }
 
+#if !HDF5
+  /* write body offset table (for partial reads) */
+
+  write_body_table (dom, bf, pos);
+
+  free (pos);
+#endif
+
   /* write constraints */
 
   PBF_Label (bf, "CONS");
@@ -537,45 +628,137 @@ int dom_read_body (DOM *dom, PBF *bf, BODY *bod)
   }
   else
   {
-    for (; bf; bf = bf->next)
+    SET *subset = NULL;
+    MEM setmem;
+    int ret;
+
+    MEM_Init (&setmem, sizeof (SET), 4);
+    SET_Insert (&setmem, &subset, bod, NULL);
+    ret = dom_read_bodies (dom, bf, subset, NULL, NULL, NULL);
+    MEM_Release (&setmem);
+
+    return ret;
+  }
+
+  return 0;
+}
+
+/* read states of a subset of bodies */
+int dom_read_bodies (DOM *dom, PBF *bf, SET *subset, double *box, MEM *setmem, SET **out)
+{
+  MAP *wanted = NULL;
+  double e [6], *x = NULL;
+  MEM mapmem;
+  int count = 0;
+  BODY *bod;
+
+  if (!(subset || box)) return 0; /* nothing requested */
+
+  /* read all bodies if needed */
+  if (!dom->allbodiesread) read_new_bodies (dom, bf);
+
+  /* map requested bodies by ids */
+  MEM_Init (&mapmem, sizeof (MAP), 128);
+  for (SET *item = SET_First (subset); item; item = SET_Next (item))
+  {
+    bod = item->data;
+    MAP_Insert (&mapmem, &wanted, (void*) (long) bod->id, bod, NULL);
+  }
+
+  for (; bf; bf = bf->next)
+  {
+#if !HDF5
+    if (PBF_Label (bf, "BODX")) /* use body offset table */
     {
-      if (PBF_Label (bf, "BODS"))
+      unsigned int *ids, *pos;
+      float *ext;
+      int nbod, n, k;
+
+      PBF_Int (bf, &nbod, 1);
+      ERRMEM (ids = malloc (sizeof (unsigned int [nbod + 1])));
+      ERRMEM (pos = malloc (sizeof (unsigned int [nbod + 1])));
+      ERRMEM (ext = malloc (sizeof (float [6 * (nbod + 1)])));
+      PBF_Uint (bf, ids, nbod);
+      PBF_Uint (bf, pos, nbod);
+      PBF_Float (bf, ext, 6 * nbod);
+
+      for (n = 0; n < nbod; n ++)
       {
-	int nbod;
+	if (subset) bod = MAP_Find (wanted, (void*) (long) ids [n], NULL);
+	else
+	{
+	  for (k = 0; k < 6; k ++) e [k] = ext [6*n+k];
+	  if (overlap (e, box)) ASSERT_DEBUG_EXT (bod = MAP_Find (dom->allbodies, (void*) (long) ids [n], NULL), "Body id invalid");
+	  else bod = NULL;
+	}
+
+	if (bod)
+	{
+	  bod->dom = dom;
+	  PBF_Jump (bf, pos [n]);
+	  BODY_Read_State (bod, bf);
+	  if (out) SET_Insert (setmem, out, bod, NULL);
+	  count ++;
+	}
+      }
+
+      free (ids);
+      free (pos);
+      free (ext);
+    }
+    else
+#endif
+    if (PBF_Label (bf, "BODS")) /* no offset table => read sequentially */
+    {
+      int nbod, n;
+
+      PBF_Int (bf, &nbod, 1);
+
+      for (n = 0; n < nbod; n ++)
+      {
+	unsigned int id;
 
-	PBF_Int (bf, &nbod, 1);
+	PBF_Uint (bf, &id, 1);
+	ASSERT_DEBUG_EXT (bod = MAP_Find (dom->allbodies, (void*) (long) id, NULL), "Body id invalid");
 
-	for (int n = 0; n < nbod; n ++)
+	if (subset && !MAP_Find (wanted, (void*) (long) id, NULL)) skip_body (bod, bf);
+	else if (!subset) /* extents are known after reading => restore bodies outside of the box */
 	{
-	  unsigned int id;
-	  BODY *obj;
+	  int rank = bod->rank;
+
+	  ERRMEM (x = realloc (x, sizeof (double [BODY_State_Size (bod)])));
+	  BODY_Get_State (bod, x);
+
+	  bod->dom = dom;
+	  BODY_Read_State (bod, bf);
 
-	  PBF_Uint (bf, &id, 1);
-	  ASSERT_DEBUG_EXT (obj = MAP_Find (dom->idb, (void*) (long) id, NULL), "Body id invalid");
-	  if (bod->id == obj->id) 
+	  SHAPE_Extents (bod->shape, e);
+	  if (!overlap (e, box))
 	  {
-	    BODY_Read_State (bod, bf);
-	    return 1;
+	    BODY_Set_State (bod, x);
+	    bod->rank = rank;
+	    continue;
 	  }
-	  else /* skip body and continue */
-	  {
-	    BODY fake;
-
-	    ERRMEM (fake.conf = malloc (sizeof (double [BODY_Conf_Size (obj)])));
-	    ERRMEM (fake.velo = malloc (sizeof (double [obj->dofs])));
-	    fake.shape = NULL;
 
-	    BODY_Read_State (&fake, bf);
+	  if (out) SET_Insert (setmem, out, bod, NULL);
+	  count ++;
+	}
+	else
+	{
+	  bod->dom = dom;
+	  BODY_Read_State (bod, bf);
 
-	    free (fake.conf);
-	    free (fake.velo);
-	  }
+	  if (out) SET_Insert (setmem, out, bod, NULL);
+	  count ++;
 	}
       }
     }
   }
 
-  return 0;
+  MEM_Release (&mapmem);
+  free (x);
+
+  return count;
 }
 
 /* read state of an individual constraint */
@@ -642,3 +825,332 @@ int dom_init_state (DOM *dom, PBF *bf)
 
   return 1;
 }
+
+/* checkpoint file (XDR; one file per rank in parallel, suffixed by the rank)
+ * --------------------------------------------------------------------------
+ * u_int  CHK_MAGIC
+ * int    CHK_VERSION
+ * double time, step
+ * int    nbod
+ * u_int  ids [nbod]
+ * int    sizes [nbod]         BODY_State_Size of each body
+ * double states [sum(sizes)]  BODY_Get_State of each body, one after another
+ * int    ncon
+ * u_int  keys [5*ncon]        constraint keys (see warm_key)
+ * double points [3*ncon]      referential points on the first keyed body
+ * double R [3*ncon]           spatial reactions acting on the first keyed body
+ */
+
+#define CHK_MAGIC 0x53434B50 /* "SCKP" */
+
+#define CHK_VERSION 1
+
+#define CHK_BUFFER (1 << 20) /* stdio buffer size */
+
+/* checkpointed constraint reaction */
+struct warm_start
+{
+  unsigned int key [5];
+
+  double point [3]; /* referential point on the first keyed body */
+
+  double R [3]; /* spatial reaction */
+};
+
+/* constraint key: kind, two body ids and their SGP indices (0 stands for none, otherwise index + 1), and a referential
+ * point on the first body; constraints are not recreated on restart, hence their reactions are matched with the ones
+ * recreated by the input file or by contact detection during the first time step; contact bodies are ordered by their
+ * ids, as contact detection may swap masters and slaves; among several constraints sharing a key the one with the
+ * nearest referential point is used; return -1 if the bodies got swapped and 1 otherwise */
+static double warm_key (CON *con, unsigned int *key, double *point)
+{
+  BODY *bod [2] = {con->master, con->slave};
+  SGP *sgp [2] = {con->msgp, con->ssgp};
+  double sign = 1.0;
+  int k;
+
+  if (con->kind == CONTACT && con->slave->id < con->master->id)
+  {
+    bod [0] = con->slave, bod [1] = con->master;
+    sgp [0] = con->ssgp, sgp [1] = con->msgp;
+    sign = -1.0;
+  }
+
+  key [0] = con->kind;
+
+  for (k = 0; k < 2; k ++)
+  {
+    key [1+k] = bod [k] ? bod [k]->id : 0;
+    key [3+k] = bod [k] && sgp [k] >= bod [k]->sgp && sgp [k] < bod [k]->sgp + bod [k]->nsgp ? sgp [k] - bod [k]->sgp + 1 : 0;
+  }
+
+  if (sign > 0.0) { COPY (con->mpnt, point); }
+  else { COPY (con->spnt, point); }
+
+  return sign;
+}
+
+/* compare warm start keys */
+static int warm_compare (const void *a, const void *b)
+{
+  const unsigned int *x = a, *y = b;
+  int k;
+
+  for (k = 0; k < 5; k ++)
+  {
+    if (x [k] < y [k]) return -1;
+    else if (x [k] > y [k]) return 1;
+  }
+
+  return 0;
+}
+
+/* write restart checkpoint */
+void dom_write_checkpoint (DOM *dom, char *path)
+{
+  unsigned int magic = CHK_MAGIC, *ids, *keys;
+  int version = CHK_VERSION, nbod, ncon, size, *sizes;
+  double *states, *points, *R, *x, sign;
+  char *name, *temp;
+  FILE *file;
+  BODY *bod;
+  CON *con;
+  XDR xdr;
+
+  /* gather body states */
+
+  for (size = 0, bod = dom->bod; bod; bod = bod->next) size += BODY_State_Size (bod);
+
+  ERRMEM (ids = malloc (sizeof (unsigned int [dom->nbod + 1])));
+  ERRMEM (sizes = malloc (sizeof (int [dom->nbod + 1])));
+  ERRMEM (states = malloc (sizeof (double [size + 1])));
+
+  for (nbod = 0, x = states, bod = dom->bod; bod; x += sizes [nbod], bod = bod->next, nbod ++)
+  {
+    ASSERT_DEBUG (nbod < dom->nbod, "Inconsistent body count");
+    ids [nbod] = bod->id;
+    sizes [nbod] = BODY_State_Size (bod);
+    BODY_Get_State (bod, x);
+  }
+
+  /* gather constraint reactions */
+
+  ERRMEM (keys = malloc (sizeof (unsigned int [5 * dom->ncon + 1])));
+  ERRMEM (points = malloc (sizeof (double [3 * dom->ncon + 1])));
+  ERRMEM (R = malloc (sizeof (double [3 * dom->ncon + 1])));
+
+  for (ncon = 0, con = dom->con; con; con = con->next, ncon ++)
+  {
+    ASSERT_DEBUG (ncon < dom->ncon, "Inconsistent constraint count");
+    sign = warm_key (con, &keys [5*ncon], &points [3*ncon]);
+    NVMUL (con->base, con->R, &R [3*ncon]); /* spatial reactions do not depend on local bases */
+    SCALE (&R [3*ncon], sign);
+  }
+
+  /* write into a temporary file and rename it, so that
+   * an interrupted write does not spoil the previous checkpoint */
+
+  ERRMEM (name = malloc (strlen (path) + 32));
+#if MPI
+  sprintf (name, "%s.%d", path, dom->rank);
+#else
+  strcpy (name, path);
+#endif
+  ERRMEM (temp = malloc (strlen (name) + 8));
+  sprintf (temp, "%s.tmp", name);
+
+  ASSERT (file = fopen (temp, "w"), ERR_FILE_OPEN);
+  setvbuf (file, NULL, _IOFBF, CHK_BUFFER);
+  xdrstdio_create (&xdr, file, XDR_ENCODE);
+
+  ASSERT (xdr_u_int (&xdr, &magic), ERR_FILE_WRITE);
+  ASSERT (xdr_int (&xdr, &version), ERR_FILE_WRITE);
+  ASSERT (xdr_double (&xdr, &dom->time), ERR_FILE_WRITE);
+  ASSERT (xdr_double (&xdr, &dom->step), ERR_FILE_WRITE);
+  ASSERT (xdr_int (&xdr, &nbod), ERR_FILE_WRITE);
+  ASSERT (xdr_vector (&xdr, (char*)ids, nbod, sizeof (unsigned int), (xdrproc_t)xdr_u_int), ERR_FILE_WRITE);
+  ASSERT (xdr_vector (&xdr, (char*)sizes, nbod, sizeof (int), (xdrproc_t)xdr_int), ERR_FILE_WRITE);
+  ASSERT (xdr_vector (&xdr, (char*)states, size, sizeof (double), (xdrproc_t)xdr_double), ERR_FILE_WRITE);
+  ASSERT (xdr_int (&xdr, &ncon), ERR_FILE_WRITE);
+  ASSERT (xdr_vector (&xdr, (char*)keys, 5*ncon, sizeof (unsigned int), (xdrproc_t)xdr_u_int), ERR_FILE_WRITE);
+  ASSERT (xdr_vector (&xdr, (char*)points, 3*ncon, sizeof (double), (xdrproc_t)xdr_double), ERR_FILE_WRITE);
+  ASSERT (xdr_vector (&xdr, (char*)R, 3*ncon, sizeof (double), (xdrproc_t)xdr_double), ERR_FILE_WRITE);
+
+  xdr_destroy (&xdr);
+  ASSERT (fclose (file) == 0, ERR_FILE_CLOSE);
+  ASSERT (rename (temp, name) == 0, ERR_FILE_WRITE);
+
+  free (temp);
+  free (name);
+  free (R);
+  free (points);
+  free (keys);
+  free (states);
+  free (sizes);
+  free (ids);
+}
+
+/* read restart checkpoint */
+int dom_read_checkpoint (DOM *dom, char *path)
+{
+  unsigned int magic, *ids, *keys;
+  int version, nbod, ncon, nwarm, size, *sizes, parallel, m, n;
+  double time, step, *states, *points, *R, *x;
+  struct warm_start *warm;
+  MAP *restored;
+  BODY *bod, *next;
+  MEM mapmem;
+  char *name;
+  FILE *file;
+  XDR xdr;
+
+  ERRMEM (name = malloc (strlen (path) + 32));
+
+  sprintf (name, "%s.0", path);
+  if ((file = fopen (name, "r"))) fclose (file);
+  parallel = file != NULL;
+
+  MEM_Init (&mapmem, sizeof (MAP), 1024);
+  restored = NULL;
+  warm = NULL;
+  nwarm = 0;
+  time = step = 0.0;
+
+  for (m = 0; ; m ++) /* a single sequential pass over each rank file */
+  {
+    if (parallel) sprintf (name, "%s.%d", path, m);
+    else if (m) break;
+    else strcpy (name, path);
+
+    if (!(file = fopen (name, "r"))) break;
+    setvbuf (file, NULL, _IOFBF, CHK_BUFFER);
+    xdrstdio_create (&xdr, file, XDR_DECODE);
+
+    ASSERT (xdr_u_int (&xdr, &magic) && magic == CHK_MAGIC, ERR_FILE_FORMAT);
+    ASSERT (xdr_int (&xdr, &version) && version == CHK_VERSION, ERR_FILE_FORMAT);
+    ASSERT (xdr_double (&xdr, &time), ERR_FILE_READ);
+    ASSERT (xdr_double (&xdr, &step), ERR_FILE_READ);
+
+    /* body states */
+
+    ASSERT (xdr_int (&xdr, &nbod) && nbod >= 0, ERR_FILE_READ);
+    ERRMEM (ids = malloc (sizeof (unsigned int [nbod + 1])));
+    ERRMEM (sizes = malloc (sizeof (int [nbod + 1])));
+    ASSERT (xdr_vector (&xdr, (char*)ids, nbod, sizeof (unsigned int), (xdrproc_t)xdr_u_int), ERR_FILE_READ);
+    ASSERT (xdr_vector (&xdr, (char*)sizes, nbod, sizeof (int), (xdrproc_t)xdr_int), ERR_FILE_READ);
+    for (size = n = 0; n < nbod; n ++) size += sizes [n];
+    ERRMEM (states = malloc (sizeof (double [size + 1])));
+    ASSERT (xdr_vector (&xdr, (char*)states, size, sizeof (double), (xdrproc_t)xdr_double), ERR_FILE_READ);
+
+    for (n = 0, x = states; n < nbod; x += sizes [n], n ++)
+    {
+      bod = MAP_Find (dom->allbodies, (void*) (long) ids [n], NULL);
+#if MPI && LOCAL_BODIES
+      if (!bod) continue; /* not stored on this rank */
+#endif
+      ASSERT_TEXT (bod, "Invalid body identifier => most likely due to a mismatched checkpoint file.");
+      ASSERT_TEXT (sizes [n] == BODY_State_Size (bod), "Invalid body state size => most likely due to a mismatched checkpoint file.");
+      BODY_Set_State (bod, x);
+      MAP_Insert (&mapmem, &restored, (void*) (long) ids [n], bod, NULL);
+    }
+
+    free (states);
+    free (sizes);
+    free (ids);
+
+    /* constraint reactions */
+
+    ASSERT (xdr_int (&xdr, &ncon) && ncon >= 0, ERR_FILE_READ);
+    ERRMEM (keys = malloc (sizeof (unsigned int [5 * ncon + 1])));
+    ERRMEM (points = malloc (sizeof (double [3 * ncon + 1])));
+    ERRMEM (R = malloc (sizeof (double [3 * ncon + 1])));
+    ASSERT (xdr_vector (&xdr, (char*)keys, 5*ncon, sizeof (unsigned int), (xdrproc_t)xdr_u_int), ERR_FILE_READ);
+    ASSERT (xdr_vector (&xdr, (char*)points, 3*ncon, sizeof (double), (xdrproc_t)xdr_double), ERR_FILE_READ);
+    ASSERT (xdr_vector (&xdr, (char*)R, 3*ncon, sizeof (double), (xdrproc_t)xdr_double), ERR_FILE_READ);
+
+    ERRMEM (warm = realloc (warm, sizeof (struct warm_start [nwarm + ncon + 1])));
+    for (n = 0; n < ncon; n ++)
+    {
+      memcpy (warm [nwarm + n].key, &keys [5*n], sizeof (unsigned int [5]));
+      COPY (&points [3*n], warm [nwarm + n].point);
+      COPY (&R [3*n], warm [nwarm + n].R);
+    }
+    nwarm += ncon;
+
+    free (R);
+    free (points);
+    free (keys);
+
+    xdr_destroy (&xdr);
+    fclose (file);
+  }
+
+  free (name);
+
+  if (m == 0) /* no checkpoint */
+  {
+    MEM_Release (&mapmem);
+    return 0;
+  }
+
+  /* remove bodies deleted before the checkpoint was written */
+  for (bod = dom->bod; bod; bod = next)
+  {
+    next = bod->next;
+
+    if (!MAP_Find (restored, (void*) (long) bod->id, NULL))
+    {
+      DOM_Remove_Body (dom, bod);
+      BODY_Destroy (bod);
+    }
+  }
+
+  MEM_Release (&mapmem);
+
+  /* sort reactions for matching during the first update; these replace any not yet applied */
+  free (dom->warm);
+  dom->warm = warm;
+  dom->nwarm = nwarm;
+  qsort (dom->warm, dom->nwarm, sizeof (struct warm_start), warm_compare);
+
+  dom->time = time;
+  dom->step = step;
+
+  return 1;
+}
+
+/* apply checkpointed reactions to matching constraints and release them */
+void dom_warm_start (DOM *dom)
+{
+  struct warm_start *item, *first, *last, *end;
+  double point [3], d [3], dist, best, sign, R [3];
+  unsigned int key [5];
+  CON *con;
+
+  end = dom->warm + dom->nwarm;
+
+  for (con = dom->con; con; con = con->next)
+  {
+    sign = warm_key (con, key, point);
+
+    if ((item = bsearch (key, dom->warm, dom->nwarm, sizeof (struct warm_start), warm_compare)))
+    {
+      for (first = item; first > dom->warm && warm_compare ((first-1)->key, key) == 0; first --);
+      for (last = item + 1; last < end && warm_compare (last->key, key) == 0; last ++);
+
+      for (best = DBL_MAX; first < last; first ++)
+      {
+	SUB (first->point, point, d);
+	dist = DOT (d, d);
+	if (dist < best) best = dist, item = first;
+      }
+
+      MUL (item->R, sign, R);
+      TVMUL (con->base, R, con->R);
+    }
+  }
+
+  free (dom->warm);
+  dom->warm = NULL;
+  dom->nwarm = 0;
+}
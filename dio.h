@@ -20,10 +20,24 @@ void dom_read_state (DOM *dom, PBF *bf);
 /* read state of an individual body */
 int dom_read_body (DOM *dom, PBF *bf, BODY *bod);
 
+/* read states of a subset of bodies: those in the 'subset' or, if 'subset' is NULL, those whose
+ * stored extents overlap the 'box'; read bodies are inserted into 'out' (unless NULL); the rest
+ * of the domain is left untouched; return the number of read bodies */
+int dom_read_bodies (DOM *dom, PBF *bf, SET *subset, double *box, MEM *setmem, SET **out);
+
 /* read state of an individual constraint */
 int dom_read_constraint (DOM *dom, PBF *bf, CON *con);
 
 /* initialize domain state */
 int dom_init_state (DOM *dom, PBF *bf);
 
+/* write restart checkpoint: body states and constraint reactions */
+void dom_write_checkpoint (DOM *dom, char *path);
+
+/* read restart checkpoint in a single pass over the checkpoint files */
+int dom_read_checkpoint (DOM *dom, char *path);
+
+/* apply checkpointed reactions to matching constraints and release them */
+void dom_warm_start (DOM *dom);
+
 #endif
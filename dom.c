@@ -36,15 +36,19 @@
 #include "cra.h"
 #include "fra.h"
 #include "psc.h"
+#include "thr.h"
 
 #if MPI
 #include "put.h"
 #include "com.h"
+#include "tag.h"
 #endif
 
 #define CONBLK 128 /* constraints memory block size */
 #define MAPBLK 128 /* map items memory block size */
 #define SETBLK 128 /* set items memory block size */
+#define MANAGE 8 /* maximal number of contact updates served by a manifold */
+#define COST_SMOOTHING 0.3 /* weight of the most recent measurement in smoothed load balancing costs */
 
 /* excluded surface pairs comparison */
 static int pair_compare (int *a, int *b)
@@ -340,24 +344,110 @@ static int contact_exists (BOX *one, BOX *two)
   return SET_Contains (one->body->con, &aux, CONCMP);
 }
 
-/* box overlap creation callback */
-static void overlap_create (DOM *dom, BOX *one, BOX *two)
+/* cached separating axis of a pair of objects */
+struct sepaxis
+{
+  SGP *one, *two; /* ordered by address */
+
+  GJK_CACHE gjk; /* axis and simplex */
+
+  short used; /* used during the current contact detection */
+};
+
+/* separating axis comparison */
+static int sepaxis_compare (struct sepaxis *a, struct sepaxis *b)
+{
+  if (a->one < b->one) return -1;
+  else if (a->one > b->one) return 1;
+  else if (a->two < b->two) return -1;
+  else if (a->two > b->two) return 1;
+  else return 0;
+}
+
+/* reject separated polyhedral pairs before the costly intersection test */
+static int separated (DOM *dom, BOX *one, BOX *two)
+{
+  struct sepaxis aux, *sep;
+  short paircode;
+  BOX *tmp;
+  int ret;
+
+  if (one->sgp > two->sgp) { tmp = one; one = two; two = tmp; } /* the cache is kept for one pair order */
+
+  paircode = GOBJ_Pair_Code (one, two);
+
+  switch (paircode)
+  {
+    case AABB_ELEMENT_ELEMENT:
+    case AABB_ELEMENT_CONVEX:
+    case AABB_CONVEX_ELEMENT:
+    case AABB_CONVEX_CONVEX: break;
+    default: return 0;
+  }
+
+  aux.one = one->sgp;
+  aux.two = two->sgp;
+
+  if (!(sep = MAP_Find (dom->sep, &aux, (MAP_Compare) sepaxis_compare)))
+  {
+    ERRMEM (sep = MEM_Alloc (&dom->sepmem)); /* zeroed => cold start */
+    sep->one = one->sgp;
+    sep->two = two->sgp;
+    MAP_Insert (&dom->mapmem, &dom->sep, sep, sep, (MAP_Compare) sepaxis_compare);
+  }
+
+  sep->used = 1;
+
+  ret = gobjseparated (paircode, one->sgp->shp, one->sgp->gobj, two->sgp->shp, two->sgp->gobj, &sep->gjk);
+
+  switch (ret)
+  {
+    case 0: dom->nsepcvi ++; break;
+    case 1: dom->nsepaxis ++; break;
+    case 2: dom->nsepgjk ++; break;
+  }
+
+  return ret;
+}
+
+/* drop separating axes of pairs which were not tested during the last contact detection */
+static void separated_cleanup (DOM *dom)
+{
+  struct sepaxis *sep;
+  MAP *item;
+
+  for (item = MAP_First (dom->sep); item; )
+  {
+    sep = item->data;
+
+    if (sep->used)
+    {
+      sep->used = 0;
+      item = MAP_Next (item);
+    }
+    else
+    {
+      item = MAP_Delete_Node (&dom->mapmem, &dom->sep, item);
+      MEM_Free (&dom->sepmem, sep);
+    }
+  }
+}
+
+/* detect and insert a contact between objects in overlapping boxes */
+static void contact_create (DOM *dom, BOX *one, BOX *two)
 {
   double onepnt [3], twopnt [3], normal [3], gap, area;
-  int state, spair [2], pair [2], ntri;
+  int state, spair [2], pair [2];
   SURFACE_MATERIAL *mat;
   short paircode;
   CON *con;
-  TRI *tri;
-
-  if (contact_exists (one, two)) return;
 
   state = gobjcontact (
     CONTACT_DETECT, GOBJ_Pair_Code (one, two),
     one->sgp->shp, one->sgp->gobj,
     two->sgp->shp, two->sgp->gobj,
     onepnt, twopnt, normal,
-    &gap, &area, spair, &tri, &ntri);
+    &gap, &area, spair, NULL, NULL, NULL);
 
   if (state)
   {
@@ -373,11 +463,7 @@ static void overlap_create (DOM *dom, BOX *one, BOX *two)
       if (spair [0] <= spair [1]) { pair [0] = spair [0]; pair [1] = spair [1]; }
       else { pair [0] = spair [1]; pair [1] = spair [0]; }
 
-      if (SET_Contains (dom->excluded, pair, (SET_Compare) pair_compare))
-      {
-	free (tri);
-	return; /* exluded pair */
-      }
+      if (SET_Contains (dom->excluded, pair, (SET_Compare) pair_compare)) return; /* exluded pair */
     }
   }
 
@@ -400,8 +486,112 @@ static void overlap_create (DOM *dom, BOX *one, BOX *two)
     }
     break;
   }
+}
 
-  if (tri) free (tri);
+/* box overlap creation callback */
+static void overlap_create (DOM *dom, BOX *one, BOX *two)
+{
+  if (contact_exists (one, two)) return;
+
+  if (separated (dom, one, two)) return;
+
+  if (gobjbatch_push (&dom->detbatch, GOBJ_Pair_Code (one, two), one->sgp->gobj, two->sgp->gobj, one, two)) return; /* curved pairs are detected in bulk */
+
+  contact_create (dom, one, two);
+}
+
+/* detect batched curved object contacts */
+static void batch_detect (DOM *dom)
+{
+  GOBJ_BATCH *batch = &dom->detbatch;
+  GOBJ_BLOCK *b;
+  int i, j;
+
+  gobjbatch_proximity (batch);
+
+  for (i = 0; i < batch->n; i ++)
+  {
+    b = &batch->block [i / GOBJ_BLOCKSIZE];
+    j = i % GOBJ_BLOCKSIZE;
+
+    if (b->state [j] && !contact_exists (b->data [0][j], b->data [1][j])) /* a pair might have been reported more than once */
+    {
+      contact_create (dom, b->data [0][j], b->data [1][j]);
+    }
+  }
+
+  batch->n = 0;
+}
+
+/* rigid convex contacts maintain manifolds */
+static int manifold_applicable (DOM *dom, CON *con)
+{
+  return dom->mantol > 0.0 && con->paircode == AABB_CONVEX_CONVEX && !(con->state & CON_COHESIVE) &&
+         (con->master->kind == OBS || con->master->kind == RIG) &&
+         (con->slave->kind == OBS || con->slave->kind == RIG);
+}
+
+/* record contact manifold after a full update; the manifold is used only if the contact
+ * point has not moved on the master body since the previous full update; this is because
+ * the point is the mass center of the intersection surface, which is sensitive to small
+ * motions of thin intersections and freezing it in such cases leads to deeper penetration */
+static void manifold_create (DOM *dom, CON *con, double *point, double *normal)
+{
+  double d [3], tol;
+
+  if (manifold_applicable (dom, con))
+  {
+    tol = dom->mantol * sqrt (con->area);
+    SUB (con->mpnt, con->man.point, d);
+    con->man.age = (con->man.tol > 0.0 && DOT (d, d) < tol * tol); /* stable contact patch */
+    BODY_Ref_Vector (con->slave, sgobj(con), point, normal, con->man.normal [0]);
+    BODY_Ref_Vector (con->master, mgobj(con), point, normal, con->man.normal [1]);
+    BODY_Ref_Vector (con->slave, sgobj(con), point, con->base, con->man.tangent [0]);
+    BODY_Ref_Vector (con->master, mgobj(con), point, con->base, con->man.tangent [1]);
+    COPY (con->mpnt, con->man.point);
+    con->man.gap = con->gap;
+    con->man.tol = tol;
+  }
+  else
+  {
+    con->man.age = 0;
+    con->man.tol = 0.0;
+  }
+}
+
+/* update contact by transforming its manifold; return 0 if the manifold
+ * is invalid and a full update needs to be performed; the points and normal
+ * follow the rigid motion of their bodies, while the gap changes by the relative
+ * normal motion of the points; manifolds are invalidated by relative rotation,
+ * slip or normal motion beyond their tolerances, separation and aging */
+static int manifold_update (DOM *dom, CON *con)
+{
+  double mpnt [3], spnt [3], snormal [3], mnormal [3], stangent [3], mtangent [3], d [3], dn, cosine;
+
+  if (con->man.age == 0 || con->man.age >= MANAGE || !manifold_applicable (dom, con)) return 0;
+
+  BODY_Cur_Vector (con->slave, sgobj(con), con->spnt, con->man.normal [0], snormal);
+  BODY_Cur_Vector (con->master, mgobj(con), con->mpnt, con->man.normal [1], mnormal);
+  BODY_Cur_Vector (con->slave, sgobj(con), con->spnt, con->man.tangent [0], stangent);
+  BODY_Cur_Vector (con->master, mgobj(con), con->mpnt, con->man.tangent [1], mtangent);
+  cosine = 1.0 - 0.5 * dom->mantol * dom->mantol; /* the admissible relative rotation angle equals the relative tolerance */
+  if (DOT (snormal, mnormal) < cosine || DOT (stangent, mtangent) < cosine) return 0; /* relative rotation */
+
+  BODY_Cur_Point (con->master, con->msgp, con->mpnt, mpnt);
+  BODY_Cur_Point (con->slave, con->ssgp, con->spnt, spnt);
+  SUB (mpnt, spnt, d);
+  dn = DOT (snormal, d); /* the normal is outward to the slave */
+  if (fabs (dn) > con->man.tol || con->man.gap + dn > 0.0) return 0; /* normal motion or separation */
+  ADDMUL (d, -dn, snormal, d);
+  if (DOT (d, d) > con->man.tol * con->man.tol) return 0; /* slip */
+
+  con->gap = con->man.gap + dn;
+  if (con->gap <= dom->depth) dom->flags |= DOM_DEPTH_VIOLATED;
+  COPY (mpnt, con->point);
+  localbase (snormal, con->base);
+  con->man.age ++;
+
+  return 1;
 }
 
 #if MPI
@@ -423,8 +613,9 @@ static void update_contact (DOM *dom, CON *con)
        *sgobj = sgobj(con);
   SHAPE *mshp = mshp(con),
 	*sshp = sshp(con);
-  int state, ntri;
-  TRI *tri;
+  int state;
+
+  if (manifold_update (dom, con)) return; /* small relative motion */
 
   /* current spatial points and normal */
   BODY_Cur_Point (con->master, con->msgp, con->mpnt, mpnt);
@@ -436,7 +627,7 @@ static void update_contact (DOM *dom, CON *con)
     CONTACT_UPDATE, con->paircode,
     sshp, sgobj, mshp, mgobj, /* the slave body holds the outward normal */
     spnt, mpnt, normal, &con->gap, /* 'mpnt' and 'spnt' are updated here */
-    &con->area, con->spair, &tri, &ntri); /* surface pair might change though */
+    &con->area, con->spair, &con->gjk, NULL, NULL); /* surface pair might change though */
 
   if (state || (con->state & CON_COHESIVE))
   {
@@ -458,6 +649,7 @@ static void update_contact (DOM *dom, CON *con)
 	SURFACE_MATERIAL *mat = SPSET_Find (dom->sps, con->spair [0], con->spair [1]); /* find new surface pair description */
 	con->state |= SURFACE_MATERIAL_Transfer (dom->time, mat, &con->mat); /* transfer surface pair data from the database to the local variable */
       }
+      manifold_create (dom, con, mpnt, normal);
     }
   }
   else
@@ -467,8 +659,58 @@ static void update_contact (DOM *dom, CON *con)
 #endif
     DOM_Remove_Constraint (dom, con); /* remove from the domain */
   }
+}
+
+/* schedule a sphere contact for the update in bulk; return 0 if it needs to be updated individually */
+static int batch_contact (DOM *dom, CON *con)
+{
+  if (con->paircode != AABB_SPHERE_SPHERE || (con->state & CON_COHESIVE)) return 0;
+
+  return gobjbatch_push (&dom->updbatch, AABB_SPHERE_SPHERE, sgobj(con), mgobj(con), con, NULL); /* the slave sphere holds the outward normal */
+}
+
+/* update batched sphere contacts */
+static void batch_update (DOM *dom)
+{
+  GOBJ_BATCH *batch = &dom->updbatch;
+  double (*y) [GOBJ_BLOCKSIZE], spnt [3], mpnt [3], normal [3];
+  GOBJ_BLOCK *b;
+  CON *con;
+  int i, j;
+
+  gobjbatch_spheres (batch);
+
+  for (i = 0; i < batch->n; i ++)
+  {
+    b = &batch->block [i / GOBJ_BLOCKSIZE];
+    j = i % GOBJ_BLOCKSIZE;
+    con = b->data [0][j];
+    y = b->y;
+
+    if (b->state [j])
+    {
+      con->gap = y [0][j];
+      if (con->gap <= dom->depth) dom->flags |= DOM_DEPTH_VIOLATED;
+
+      spnt [0] = y [1][j]; spnt [1] = y [2][j]; spnt [2] = y [3][j];
+      mpnt [0] = y [4][j]; mpnt [1] = y [5][j]; mpnt [2] = y [6][j];
+      normal [0] = y [7][j]; normal [1] = y [8][j]; normal [2] = y [9][j];
+
+      COPY (mpnt, con->point);
+      BODY_Ref_Point (con->master, con->msgp, mpnt, con->mpnt);
+      BODY_Ref_Point (con->slave, con->ssgp, spnt, con->spnt);
+      localbase (normal, con->base);
+    }
+    else
+    {
+#if MPI
+      ext_to_remove (dom, con); /* schedule remote deletion of external constraints */
+#endif
+      DOM_Remove_Constraint (dom, con); /* remove from the domain */
+    }
+  }
 
-  if (tri) free (tri);
+  batch->n = 0;
 }
 
 /* update fixed point data */
@@ -593,36 +835,68 @@ static SGP* SGP_from_index (DOM *dom, BODY *bod, int n)
   return sgp;
 }
 
-/* constraint weight */
-static int constraint_weight (CON *con)
+/* number of blocks in the local dynamics row of a constraint */
+static int constraint_row_size (CON *con)
 {
-  int wgt0 = 1, /* default weight */
-      wgt1 = 0; /* weight of local dynamics row */
-  DOM *dom = con->master->dom;
+  int n = 1;
 
   if (con->dia)
   {
     OFFB *blk;
 
-    for (blk = con->dia->adjext; blk; blk = blk->n) wgt1 ++;
-    for (blk = con->dia->adj; blk; blk = blk->n) wgt1 ++;
+    for (blk = con->dia->adjext; blk; blk = blk->n) n ++;
+    for (blk = con->dia->adj; blk; blk = blk->n) n ++;
   }
 
-  wgt0 += (int) (dom->weight_factor * (double) wgt1);
+  return n;
+}
 
-  return wgt0;
+/* heuristic constraint weight */
+static int constraint_heuristic (CON *con)
+{
+  DOM *dom = con->master->dom;
+
+  return 1 + (int) (dom->weight_factor * (double) (constraint_row_size (con) - 1));
 }
 
-/* body weight */
-static int body_weight (BODY *bod)
+/* heuristic body weight */
+static int body_heuristic (BODY *bod)
 {
   return  bod->dofs + bod->nsgp; /* XXX: this is meant to represent the time integration and contact detection together */
 }
 
+/* constraint weight */
+static double constraint_weight (CON *con)
+{
+  DOM *dom = con->master->dom;
+
+  if (dom->weightsmode == MEASURED_WEIGHTS)
+  {
+    if (con->cost > 0.0) return con->cost;
+    else if (dom->conavg > 0.0) return dom->conavg; /* not yet measured */
+  }
+
+  return constraint_heuristic (con);
+}
+
+/* body weight */
+static double body_weight (BODY *bod)
+{
+  DOM *dom = bod->dom;
+
+  if (dom->weightsmode == MEASURED_WEIGHTS)
+  {
+    if (bod->cost > 0.0) return bod->cost;
+    else if (dom->bodavg > 0.0) return dom->bodavg; /* not yet measured */
+  }
+
+  return body_heuristic (bod);
+}
+
 /* domain weight */
-static int domain_weight (DOM *dom)
+static double domain_weight (DOM *dom)
 {
-  int weight = 0;
+  double weight = 0.0;
   BODY *bod;
   CON *con;
 
@@ -639,6 +913,90 @@ static int domain_weight (DOM *dom)
   return weight;
 }
 
+/* timers of phases whose costs are attributed to objects */
+static char *cost_phases [] = {"CONDET", "CONUPD", "LOCDYN", "CONSOL"};
+
+/* measure computational costs of bodies and constraints over the last step; time integration
+ * is timed per body, while the remaining phases are attributed to objects through their work
+ * counts (contact detection: surface geometric objects of bodies; constraint update: one per
+ * constraint; local dynamics: row blocks; constraint solution: work reported by the solver)
+ * at per-unit rates calibrated globally, since phase timings include waiting for other ranks */
+static void measure_costs (DOM *dom)
+{
+  double dt [4], units [4], rate [4], measured, t;
+  int i, n, nbod, ncon;
+  BODY *bod;
+  CON *con;
+
+  for (i = 0; i < 4; i ++)
+  {
+    t = SOLFEC_Timing (dom->solfec, cost_phases [i]);
+    dt [i] = MAX (1E6 * (t - dom->phase [i]), 0.0); /* [us] */
+    dom->phase [i] = t;
+    units [i] = 0.0;
+  }
+
+  for (bod = dom->bod; bod; bod = bod->next) units [0] += bod->nsgp;
+
+  for (con = dom->con; con; con = con->next)
+  {
+    n = constraint_row_size (con);
+    units [1] += 1.0;
+    units [2] += n;
+    units [3] += con->work > 0.0 ? con->work : n;
+  }
+
+  for (i = 0; i < 4; i ++) rate [i] = units [i] > 0.0 && dt [i] > 0.0 ? dt [i] / units [i] : DBL_MAX;
+
+  PUT_doubles_min (4, rate); /* the least waiting rank gives the best compute rate estimate */
+
+  for (i = 0; i < 4; i ++)
+  {
+    if (rate [i] == DBL_MAX) rate [i] = 0.0;
+    dom->load [i] = 0.0;
+  }
+
+  dom->bodavg = dom->conavg = 0.0;
+  nbod = ncon = 0;
+
+  for (bod = dom->bod; bod; bod = bod->next)
+  {
+    dom->load [0] += 1E6 * bod->tint;
+    dom->load [1] += rate [0] * bod->nsgp;
+
+    measured = 1E6 * bod->tint + rate [0] * bod->nsgp;
+    bod->tint = 0.0;
+
+    if (measured > 0.0)
+    {
+      bod->cost = bod->cost > 0.0 ? (1.0 - COST_SMOOTHING) * bod->cost + COST_SMOOTHING * measured : measured;
+      dom->bodavg += bod->cost;
+      nbod ++;
+    }
+  }
+
+  for (con = dom->con; con; con = con->next)
+  {
+    n = constraint_row_size (con);
+    t = con->work > 0.0 ? con->work : n;
+    dom->load [2] += rate [2] * n;
+    dom->load [3] += rate [3] * t;
+
+    measured = rate [1] + rate [2] * n + rate [3] * t;
+    con->work = 0.0;
+
+    if (measured > 0.0)
+    {
+      con->cost = con->cost > 0.0 ? (1.0 - COST_SMOOTHING) * con->cost + COST_SMOOTHING * measured : measured;
+      dom->conavg += con->cost;
+      ncon ++;
+    }
+  }
+
+  if (nbod) dom->bodavg /= (double) nbod;
+  if (ncon) dom->conavg /= (double) ncon;
+}
+
 /* number of objects for balacing */
 static int obj_count (DOM *dom, int *ierr)
 {
@@ -851,6 +1209,7 @@ static void pack_constraint (CON *con, int *dsize, double **d, int *doubles, int
   pack_doubles (dsize, d, doubles, con->point, 3);
   pack_doubles (dsize, d, doubles, con->base, 9);
   pack_double  (dsize, d, doubles, con->gap);
+  pack_double  (dsize, d, doubles, con->cost);
 
   switch ((int) con->kind)
   {
@@ -931,6 +1290,7 @@ static void unpack_constraint (DOM *dom, int *dpos, double *d, int doubles, int
   unpack_doubles (dpos, d, doubles, con->point, 3);
   unpack_doubles (dpos, d, doubles, con->base, 9);
   con->gap = unpack_double  (dpos, d, doubles);
+  con->cost = unpack_double  (dpos, d, doubles);
 
   switch (kind)
   {
@@ -1310,6 +1670,10 @@ static void pack_stats (DOM *dom, int rank, int *dsize, double **d, int *doubles
   pack_int (isize, i, ints, dom->nspa);
   pack_int (isize, i, ints, dom->bytes);
   pack_int (isize, i, ints, dom->weight);
+  pack_int (isize, i, ints, dom->nsepaxis);
+  pack_int (isize, i, ints, dom->nsepgjk);
+  pack_int (isize, i, ints, dom->nsepcvi);
+  for (int j = 0; j < 4; j ++) pack_int (isize, i, ints, (int) dom->load [j]);
 
   if (rank == (dom->ncpu-1)) /* last set was packed => zero current statistics record */
   {
@@ -1339,7 +1703,7 @@ static void unpack_stats (DOM *dom, int *dpos, double *d, int doubles, int *ipos
 /* create statistics */
 static void stats_create (DOM *dom)
 {
-  dom->nstats = 7;
+  dom->nstats = 14;
 
   ERRMEM (dom->stats = MEM_CALLOC (sizeof (DOMSTATS [dom->nstats])));
   
@@ -1350,6 +1714,15 @@ static void stats_create (DOM *dom)
   dom->stats [4].name = "SPARSIFIED";
   dom->stats [5].name = "BYTES SENT";
   dom->stats [6].name = "DOM WEIGHT";
+  dom->stats [7].name = "AXIS REJECT";
+  dom->stats [8].name = "GJK REJECT";
+  dom->stats [9].name = "CVI CALLS";
+  dom->stats [10].name = "TIMINT [us]";
+  dom->stats [11].name = "CONDET [us]";
+  dom->stats [12].name = "LOCDYN [us]";
+  dom->stats [13].name = "CONSOL [us]";
+
+  for (int i = 10; i < 14; i ++) dom->stats [i].imbalance = 1; /* per-phase measured loads */
 }
 
 /* compute statistics */
@@ -1396,7 +1769,7 @@ static void update_external_constraint_points (DOM *dom)
     }
   }
 
-  dom->bytes += COMALL (MPI_COMM_WORLD, send, nsend, &recv, &nrecv);
+  dom->bytes += COMNB (dom->neighbours, send, nsend, &recv, &nrecv);
 
   for (i = 0; i < nrecv; i ++)
   {
@@ -1448,7 +1821,7 @@ static void* update_children_unpack (DOM *dom, int *dpos, double *d, int doubles
 static void update_children (DOM *dom)
 {
   COMOBJ *send, *recv;
-  int i, nrecv;
+  int i, nsend, nrecv;
   BODY *bod;
   SET *item;
   DBD *dbd;
@@ -1465,14 +1838,18 @@ static void update_children (DOM *dom)
 
   ERRMEM (send = malloc (sizeof (COMOBJ [dom->ncpu])));
 
-  for (i = 0; i < dom->ncpu; i ++)
+  for (nsend = i = 0; i < dom->ncpu; i ++)
   {
-    send [i].o = &dbd [i];
-    send [i].rank = i;
+    if (dbd [i].children) /* only ranks with children */
+    {
+      send [nsend].o = &dbd [i];
+      send [nsend].rank = i;
+      nsend ++;
+    }
   }
 
   /* send children updates; since this is the first communication in a sequence, we have here dom->bytes = ... rather than dom->bytes += ... */
-  dom->bytes = COMOBJSALL (MPI_COMM_WORLD, (OBJ_Pack)update_children_pack, dom, (OBJ_Unpack)update_children_unpack, send, dom->ncpu, &recv, &nrecv);
+  dom->bytes = COMOBJSNB (dom->neighbours, (OBJ_Pack)update_children_pack, dom, (OBJ_Unpack)update_children_unpack, send, nsend, &recv, &nrecv);
 
   for (i = 0; i < dom->ncpu; i ++) SET_Free (&dom->setmem, &dbd [i].children);
   free (send);
@@ -1498,7 +1875,7 @@ static void children_migration_begin (DOM *dom, DBD *dbd)
     bod->prevchildren = bod->children;
     bod->children = NULL;
 
-    Zoltan_LB_Box_Assign (dom->zol, e[0], e[1], e[2], e[3], e[4], e[5], procs, &numprocs);
+    DOM_Box_Assign (dom, e, procs, &numprocs);
 
     for (i = 0; i < numprocs; i ++)
     {
@@ -1730,81 +2107,196 @@ static void* old_external_constraints_unpack (DOM *dom, int *dpos, double *d, in
   return pp;
 }
 
-/* insert or delete pending constraints */
-static void insert_pending_constraints (DOM *dom)
+/* extend extents so that they contain a point */
+static void extents_include (double *e, double *p)
+{
+  if (p [0] < e [0]) e [0] = p [0];
+  if (p [1] < e [1]) e [1] = p [1];
+  if (p [2] < e [2]) e [2] = p [2];
+  if (p [0] > e [3]) e [3] = p [0];
+  if (p [1] > e [4]) e [4] = p [1];
+  if (p [2] > e [5]) e [5] = p [2];
+}
+
+/* enlarge extents by the PUT_GEOMEPS fraction of their size;
+ * note that we are not using GEOMETRIC_EPSILON here as this can be set
+ * by the user which in turn may cause migration consitency problems */
+static void extents_enlarge (double *e)
+{
+  double d [3];
+
+  SUB (e+3, e, d);
+  SCALE (d, PUT_GEOMEPS);
+  SUB (e, d, e);
+  ADD (e+3, d, e+3);
+}
+
+#if LOCAL_BODIES
+/* pending constraints are scheduled where their masters are stored; slaves
+ * stored elsewhere are copied here from their processors, which in turn extend
+ * the slave extents so that the slave children will follow the constraints */
+static void fetch_pending_slaves (DOM *dom)
 {
-  double d [3], *e, *p;
+  int nsend, nrecv, *isize, *dsize, i, j, k, ipos, dpos;
+  COMDATA *send, *recv, *ptr;
+  SET *item, **sent, *requested;
   PNDCON *pnd;
-  SET *item;
-  CON *con;
+  BODY *bod;
+  double *D;
+
+  nsend = dom->ncpu;
+  ERRMEM (send = MEM_CALLOC (sizeof (COMDATA [nsend])));
+  ERRMEM (isize = MEM_CALLOC (sizeof (int [nsend])));
+  ERRMEM (dsize = MEM_CALLOC (sizeof (int [nsend])));
+  ERRMEM (sent = MEM_CALLOC (sizeof (SET* [nsend])));
+
+  for (i = 0; i < nsend; i ++) send [i].rank = i;
 
   for (item = SET_First (dom->pendingcons); item; item = SET_Next (item))
   {
     pnd = item->data;
 
-    /* make sure that all attached body constraint points are within the body extents so that the newly
-     * inserted constraints will migrate to partitions where bodies have representation (child/parent) */
+    if (pnd->slave == NULL && pnd->sid)
+    {
+      i = pnd->sid % (unsigned) dom->ncpu; /* two-body constraints are pending only before the first balancing
+                                              of a run (possibly restarted), when bodies reside on their creation ranks */
+      ptr = &send [i];
+      pack_int (&isize [i], &ptr->i, &ptr->ints, pnd->sid);
+      pack_doubles (&dsize [i], &ptr->d, &ptr->doubles, pnd->mpnt, 3);
+      pack_doubles (&dsize [i], &ptr->d, &ptr->doubles, pnd->spnt, 3);
+    }
+  }
+
+  dom->bytes += COMALL (MPI_COMM_WORLD, send, nsend, &recv, &nrecv); /* send slave requests */
+
+  for (i = 0; i < nsend; i ++)
+  {
+    free (send [i].i);
+    free (send [i].d);
+    send [i].i = NULL;
+    send [i].d = NULL;
+    send [i].ints = send [i].doubles = 0;
+    isize [i] = dsize [i] = 0;
+  }
+
+  for (i = 0, requested = NULL; i < nrecv; i ++)
+  {
+    ptr = &recv [i];
 
-    if (pnd->master->flags & BODY_PARENT)
+    for (j = 0, D = ptr->d; j < ptr->ints; j ++, D += 6)
     {
-      e = pnd->master->extents;
-      p = pnd->mpnt;
+      ASSERT_DEBUG_EXT (bod = MAP_Find (dom->idb, (void*) (long) ptr->i [j], NULL), "Invalid body id");
 
-      if (p [0] < e [0]) e [0] = p [0];
-      if (p [1] < e [1]) e [1] = p [1];
-      if (p [2] < e [2]) e [2] = p [2];
-      if (p [0] > e [3]) e [3] = p [0];
-      if (p [1] > e [4]) e [4] = p [1];
-      if (p [2] > e [5]) e [5] = p [2];
+      extents_include (bod->extents, D); /* the slave needs to know about both points */
+      extents_include (bod->extents, D+3);
+      SET_Insert (&dom->setmem, &requested, bod, NULL);
     }
+  }
 
-    if (pnd->slave && pnd->slave->flags & BODY_PARENT)
+  for (item = SET_First (requested); item; item = SET_Next (item))
+  {
+    extents_enlarge (((BODY*)item->data)->extents); /* once per body, however many times it was requested */
+  }
+
+  SET_Free (&dom->setmem, &requested);
+
+  for (i = 0; i < nrecv; i ++)
+  {
+    ptr = &recv [i];
+    k = ptr->rank;
+
+    for (j = 0; j < ptr->ints; j ++)
     {
-      double *pp [] = {pnd->mpnt, pnd->spnt};
-      e = pnd->slave->extents;
+      ASSERT_DEBUG_EXT (bod = MAP_Find (dom->idb, (void*) (long) ptr->i [j], NULL), "Invalid body id");
 
-      for (int i = 0; i < 2; i ++)
+      if (!SET_Contains (sent [k], bod, NULL))
       {
-        p = pp [i]; /* make sure that slave knows about both points since it can be on a processor different that
-		       the parent and can have no other means of knowing where to migrate the needed child */
-
-	if (p [0] < e [0]) e [0] = p [0];
-	if (p [1] < e [1]) e [1] = p [1];
-	if (p [2] < e [2]) e [2] = p [2];
-	if (p [0] > e [3]) e [3] = p [0];
-	if (p [1] > e [4]) e [4] = p [1];
-	if (p [2] > e [5]) e [5] = p [2];
+	BODY_Pack (bod, &dsize [k], &send [k].d, &send [k].doubles, &isize [k], &send [k].i, &send [k].ints);
+	SET_Insert (&dom->setmem, &sent [k], bod, NULL);
       }
     }
   }
 
+  free (recv);
+
+  dom->bytes += COMALL (MPI_COMM_WORLD, send, nsend, &recv, &nrecv); /* send slave copies */
+
+  for (i = 0; i < nrecv; i ++)
+  {
+    ptr = &recv [i];
+
+    for (ipos = dpos = 0; ipos < ptr->ints; )
+    {
+      bod = BODY_Unpack (dom->solfec, &dpos, ptr->d, ptr->doubles, &ipos, ptr->i, ptr->ints);
+      bod->dom = dom;
+
+      ASSERT_DEBUG (!MAP_Find (dom->allbodies, (void*) (long) bod->id, NULL), "Slave body already stored");
+      MAP_Insert (&dom->mapmem, &dom->allbodies, (void*) (long) bod->id, bod, NULL); /* neither parent nor child: deleted by manage_bodies when unused */
+    }
+  }
+
   for (item = SET_First (dom->pendingcons); item; item = SET_Next (item))
   {
     pnd = item->data;
 
-    /* extend extents of these bodies that might have been altered above;
-     * note that we are not using GEOMETRIC_EPSILON here as this can be set
-     * by the user which in turn may cause migration consitency problems */
-
-    if (pnd->master->flags & BODY_PARENT)
+    if (pnd->slave == NULL && pnd->sid)
     {
-      e = pnd->master->extents;
-      SUB (e+3, e, d);
-      SCALE (d, PUT_GEOMEPS);
-      SUB (e, d, e);
-      ADD (e+3, d, e+3);
+      ASSERT_DEBUG_EXT (pnd->slave = MAP_Find (dom->allbodies, (void*) (long) pnd->sid, NULL), "Invalid body id");
     }
+  }
+
+  for (i = 0; i < nsend; i ++)
+  {
+    SET_Free (&dom->setmem, &sent [i]);
+    free (send [i].i);
+    free (send [i].d);
+  }
+  free (sent);
+  free (dsize);
+  free (isize);
+  free (send);
+  free (recv);
+}
+#endif
+
+/* insert or delete pending constraints */
+static void insert_pending_constraints (DOM *dom)
+{
+  PNDCON *pnd;
+  SET *item;
+  CON *con;
+
+#if LOCAL_BODIES
+  if (dom->firstupdate) fetch_pending_slaves (dom);
+#endif
+
+  for (item = SET_First (dom->pendingcons); item; item = SET_Next (item))
+  {
+    pnd = item->data;
+
+    /* make sure that all attached body constraint points are within the body extents so that the newly
+     * inserted constraints will migrate to partitions where bodies have representation (child/parent) */
+
+    if (pnd->master->flags & BODY_PARENT) extents_include (pnd->master->extents, pnd->mpnt);
 
     if (pnd->slave && pnd->slave->flags & BODY_PARENT)
     {
-      e = pnd->slave->extents;
-      SUB (e+3, e, d);
-      SCALE (d, PUT_GEOMEPS);
-      SUB (e, d, e);
-      ADD (e+3, d, e+3);
+      extents_include (pnd->slave->extents, pnd->mpnt); /* make sure that slave knows about both points since it can be on a processor different that */
+      extents_include (pnd->slave->extents, pnd->spnt); /* the parent and can have no other means of knowing where to migrate the needed child */
     }
   }
 
+  for (item = SET_First (dom->pendingcons); item; item = SET_Next (item))
+  {
+    pnd = item->data;
+
+    /* extend extents of these bodies that might have been altered above */
+
+    if (pnd->master->flags & BODY_PARENT) extents_enlarge (pnd->master->extents);
+
+    if (pnd->slave && pnd->slave->flags & BODY_PARENT) extents_enlarge (pnd->slave->extents);
+  }
+
   for (item = SET_First (dom->pendingcons); item; item = SET_Next (item))
   {
     pnd = item->data;
@@ -1924,6 +2416,154 @@ static void update_bidsets (DOM *dom)
 }
 #endif
 
+/* decide whether to repartition the domain; in the adaptive mode the time lost to load imbalance
+ * in a step is the sum of MAX - AVG differences of per-phase loads (identical on all ranks as the
+ * statistics are exchanged by all); the loss measured right after the last repartitioning is what
+ * repartitioning can reach, hence only the excess over it, accumulated since then, is the predicted
+ * saving of a new partitioning, which is worth it once it exceeds the cost of the previous one */
+static int repartition_needed (DOM *dom)
+{
+  DOMSTATS *s, *e;
+  double ratio, loss;
+
+  if (dom->rebalanced == 0) return 1; /* initial partitioning */
+
+  if (dom->repartitionmode == FIXED_REPARTITION) return dom->rebalanced % dom->updatefreq == 0;
+
+  for (ratio = 1.0, loss = 0.0, s = dom->stats, e = s + dom->nstats; s < e; s ++)
+  {
+    if (s->imbalance && s->avg > 0)
+    {
+      loss += s->max - s->avg;
+      ratio = MAX (ratio, (double) s->max / (double) s->avg);
+    }
+  }
+
+  if (dom->repbase < 0.0) /* first step after repartitioning */
+  {
+    dom->repbase = loss;
+    return 0;
+  }
+
+  dom->imbloss = MAX (dom->imbloss + loss - dom->repbase, 0.0); /* steps better than the baseline bank nothing */
+
+  return ratio > dom->imbalance_tolerance && dom->imbloss >= dom->repcost;
+}
+
+/* rank of the partition containing a point */
+static int point_assign (DOM *dom, double *point)
+{
+  int rank;
+
+  if (dom->sfc) return SFC_Point_Assign (dom->sfc, point);
+
+  ASSERT (Zoltan_LB_Point_Assign (dom->zol, point, &rank) == ZOLTAN_OK, ERR_ZOLTAN);
+
+  return rank;
+}
+
+/* repartition constraints and bodies along the space filling curve */
+static void sfc_repartition (DOM *dom, DBD *dbd)
+{
+  double *points, *weights, *e;
+  int i, n, *ranks;
+  BODY *bod;
+  CON *con;
+
+  n = dom->ncon + dom->nbod;
+  ERRMEM (points = malloc (sizeof (double [3 * n + 3])));
+  ERRMEM (weights = malloc (sizeof (double [n + 1])));
+  ERRMEM (ranks = malloc (sizeof (int [n + 1])));
+
+  for (con = dom->con, i = 0; con; con = con->next, i ++)
+  {
+    COPY (con->point, &points [3*i]);
+    weights [i] = constraint_weight (con);
+  }
+
+  for (bod = dom->bod; bod; bod = bod->next, i ++)
+  {
+    e = bod->extents;
+    MID (e, e+3, &points [3*i]);
+    weights [i] = body_weight (bod);
+  }
+
+  SFC_Balance (dom->sfc, dom->extents, n, points, weights, ranks);
+
+  for (con = dom->con, i = 0; con; con = con->next, i ++)
+  {
+    if (ranks [i] != dom->rank) SET_Insert (&dom->setmem, &dbd [ranks [i]].constraints, con, NULL); /* map this constraint to its export rank */
+  }
+
+  for (bod = dom->bod; bod; bod = bod->next, i ++)
+  {
+    if (ranks [i] != dom->rank)
+    {
+      bod->rank = ranks [i]; /* set the new rank */
+      SET_Insert (&dom->setmem, &dbd [ranks [i]].bodies, bod, NULL); /* map this body to its export rank */
+#if PSCTEST
+      PSC_Write_Body (bod);
+#endif
+    }
+  }
+
+  free (points);
+  free (weights);
+  free (ranks);
+}
+
+typedef struct body_key BODY_KEY;
+
+/* body and its curve key */
+struct body_key
+{
+  SFC_KEY key;
+  BODY *bod;
+};
+
+/* body keys comparison */
+static int body_key_compare (BODY_KEY *a, BODY_KEY *b)
+{
+  if (a->key < b->key) return -1;
+  else if (a->key > b->key) return 1;
+  else if (a->bod->id < b->bod->id) return -1;
+  else if (a->bod->id > b->bod->id) return 1;
+  else return 0;
+}
+
+/* order the body list along the space filling curve, so that traversals of bodies follow their spatial proximity */
+static void sfc_order_bodies (DOM *dom)
+{
+  BODY_KEY *keys;
+  double v [3];
+  BODY *bod;
+  int i, n;
+
+  if (dom->nbod < 2) return;
+
+  ERRMEM (keys = malloc (sizeof (BODY_KEY [dom->nbod])));
+
+  for (bod = dom->bod, n = 0; bod; bod = bod->next, n ++)
+  {
+    MID (bod->extents, bod->extents+3, v);
+    keys [n].key = SFC_Key (dom->sfc, v);
+    keys [n].bod = bod;
+  }
+
+  qsort (keys, n, sizeof (BODY_KEY), (int (*) (const void*, const void*)) body_key_compare);
+
+  for (i = 0; i < n; i ++)
+  {
+    bod = keys [i].bod;
+    bod->prev = i > 0 ? keys [i-1].bod : NULL;
+    bod->next = i < n-1 ? keys [i+1].bod : NULL;
+  }
+
+  dom->bod = keys [0].bod;
+
+  free (keys);
+}
+
 /* domain balancing */
 static void domain_balancing (DOM *dom)
 {
@@ -1941,8 +2581,10 @@ static void domain_balancing (DOM *dom)
 		export_local_ids;
 
   COMOBJ *send, *recv;
+  int i, rank, bytes;
+  short repartition;
+  TIMING timing;
   char str [128];
-  int i, rank;
   int nrecv;
   SET *item;
   BODY *bod;
@@ -1970,7 +2612,7 @@ static void domain_balancing (DOM *dom)
 #endif
 
   /* domain weight for statistics */
-  dom->weight = domain_weight (dom);
+  dom->weight = (int) domain_weight (dom);
 
   /* load balancing migration sets */
   dbd = dom->dbd;
@@ -1982,43 +2624,51 @@ static void domain_balancing (DOM *dom)
   ASSERT_DEBUG (i == dom->nbod, "Inconsistent bodies count");
 #endif
 
-  if (dom->rebalanced % dom->updatefreq == 0)
+  if ((repartition = repartition_needed (dom)))
   {
+    timerstart (&timing);
+
+    if (dom->sfc) sfc_repartition (dom, dbd);
+    else
+    {
 #if 0
-    Zoltan_Generate_Files (dom->zol, "kdd", 1, 1, 0, 0);
+      Zoltan_Generate_Files (dom->zol, "kdd", 1, 1, 0, 0);
 #endif
 
-    /* update RCB parameters */
-    snprintf (str, 128, "%g", dom->imbalance_tolerance);
-    Zoltan_Set_Param (dom->zol, "IMBALANCE_TOL", str);
+      /* update RCB parameters */
+      snprintf (str, 128, "%g", dom->imbalance_tolerance);
+      Zoltan_Set_Param (dom->zol, "IMBALANCE_TOL", str);
 
-    /* update body partitioning */
-    ASSERT (Zoltan_LB_Balance (dom->zol, &changes, &num_gid_entries, &num_lid_entries,
-	    &num_import, &import_global_ids, &import_local_ids, &import_procs,
-	    &num_export, &export_global_ids, &export_local_ids, &export_procs) == ZOLTAN_OK, ERR_ZOLTAN);
+      /* update body partitioning */
+      ASSERT (Zoltan_LB_Balance (dom->zol, &changes, &num_gid_entries, &num_lid_entries,
+	      &num_import, &import_global_ids, &import_local_ids, &import_procs,
+	      &num_export, &export_global_ids, &export_local_ids, &export_procs) == ZOLTAN_OK, ERR_ZOLTAN);
 
-    for (i = 0; (dom->bod || dom->con) && i < num_export; i ++)
-    {
-      rank = export_procs [i];
-
-      if (rank != dom->rank)
+      for (i = 0; (dom->bod || dom->con) && i < num_export; i ++)
       {
-	con = MAP_Find (dom->idc, (void*) (long) export_global_ids [i], NULL);
-	if (con) SET_Insert (&dom->setmem, &dbd [rank].constraints, con, NULL); /* map this constraint to its export rank */
-	else
+	rank = export_procs [i];
+
+	if (rank != dom->rank)
 	{
-	  ASSERT_DEBUG_EXT (bod = MAP_Find (dom->idb, (void*) (long) (UINT_MAX - export_global_ids [i]), NULL), "Invalid body id");
-	  bod->rank = rank; /* set the new rank */
-	  SET_Insert (&dom->setmem, &dbd [rank].bodies, bod, NULL); /* map this body to its export rank */
+	  con = MAP_Find (dom->idc, (void*) (long) export_global_ids [i], NULL);
+	  if (con) SET_Insert (&dom->setmem, &dbd [rank].constraints, con, NULL); /* map this constraint to its export rank */
+	  else
+	  {
+	    ASSERT_DEBUG_EXT (bod = MAP_Find (dom->idb, (void*) (long) (UINT_MAX - export_global_ids [i]), NULL), "Invalid body id");
+	    bod->rank = rank; /* set the new rank */
+	    SET_Insert (&dom->setmem, &dbd [rank].bodies, bod, NULL); /* map this body to its export rank */
 #if PSCTEST
-	  PSC_Write_Body (bod);
+	    PSC_Write_Body (bod);
 #endif
+	  }
 	}
       }
+
+      Zoltan_LB_Free_Data (&import_global_ids, &import_local_ids, &import_procs,
+			   &export_global_ids, &export_local_ids, &export_procs);
     }
 
-    Zoltan_LB_Free_Data (&import_global_ids, &import_local_ids, &import_procs,
-			 &export_global_ids, &export_local_ids, &export_procs);
+    COM_Neighbours_Reset (dom->neighbours); /* subdomains have changed: neighbours will be learnt again */
 
     dom->rebalanced = 1;
   }
@@ -2028,7 +2678,7 @@ static void domain_balancing (DOM *dom)
     {
       double *e = bod->extents, v [3];
       MID (e, e+3, v);
-      Zoltan_LB_Point_Assign (dom->zol, v, &rank);
+      rank = point_assign (dom, v);
       if (rank != dom->rank)
       {
 	bod->rank = rank;
@@ -2041,7 +2691,7 @@ static void domain_balancing (DOM *dom)
 
     for (con = dom->con; con; con = con->next)
     {
-      Zoltan_LB_Point_Assign (dom->zol, con->point, &rank);
+      rank = point_assign (dom, con->point);
       if (rank != dom->rank) SET_Insert (&dom->setmem, &dbd [rank].constraints, con, NULL);
     }
 
@@ -2062,7 +2712,19 @@ static void domain_balancing (DOM *dom)
   children_migration_begin (dom, dbd);
 
   /* communication */
-  dom->bytes += COMOBJSALL (MPI_COMM_WORLD, (OBJ_Pack)domain_balancing_pack, dom, (OBJ_Unpack)domain_balancing_unpack, send, dom->ncpu, &recv, &nrecv);
+  bytes = COMOBJSALL (MPI_COMM_WORLD, (OBJ_Pack)domain_balancing_pack, dom, (OBJ_Unpack)domain_balancing_unpack, send, dom->ncpu, &recv, &nrecv);
+  dom->bytes += bytes;
+
+  if (repartition) /* record the cost of this repartitioning */
+  {
+    dom->repcost = 1E6 * PUT_double_max (timerend (&timing));
+    dom->repbytes = PUT_int_sum (bytes);
+    dom->imbloss = 0.0;
+    dom->repbase = -1.0; /* to be measured */
+    dom->repartitions ++;
+  }
+
+  if (repartition && dom->sfc) sfc_order_bodies (dom); /* memory access locality */
 
   /* delete migrated out children */
   children_migration_end (dom);
@@ -2615,18 +3277,22 @@ static void* unpack_RUV (DOM *dom, int *dpos, double *d, int doubles, int *ipos,
 void update_external_RUV (DOM *dom)
 {
   COMOBJ *send, *recv;
-  int i, nrecv;
+  int i, nsend, nrecv;
 
   ERRMEM (send = malloc (sizeof (COMOBJ [dom->ncpu])));
 
-  for (i = 0; i < dom->ncpu; i ++)
+  for (nsend = i = 0; i < dom->ncpu; i ++)
   {
-    send [i].o = dom->dbd [i].ext;
-    send [i].rank = i;
+    if (dom->dbd [i].ext) /* only ranks with external receivers */
+    {
+      send [nsend].o = dom->dbd [i].ext;
+      send [nsend].rank = i;
+      nsend ++;
+    }
   }
 
-  dom->bytes += COMOBJSALL (MPI_COMM_WORLD, (OBJ_Pack)pack_RUV, dom,
-    (OBJ_Unpack)unpack_RUV, send, dom->ncpu, &recv, &nrecv);
+  dom->bytes += COMOBJSNB (dom->neighbours, (OBJ_Pack)pack_RUV, dom,
+    (OBJ_Unpack)unpack_RUV, send, nsend, &recv, &nrecv);
 
   free (send);
   free (recv);
@@ -2635,6 +3301,8 @@ void update_external_RUV (DOM *dom)
 /* create MPI related data */
 static void create_mpi (DOM *dom)
 {
+  dom->firstupdate = 1;
+
   dom->rebalanced = 0;
 
   dom->updatefreq = 10;
@@ -2669,8 +3337,12 @@ static void create_mpi (DOM *dom)
 
   ASSERT (dom->zol = Zoltan_Create (MPI_COMM_WORLD), ERR_ZOLTAN); /* zoltan context domain partitioning */
 
+  dom->neighbours = COM_Neighbours (MPI_COMM_WORLD, TAG_NEIGHBOURS); /* neighbour-only communication */
+
   dom->imbalance_tolerance = 1.3;
   dom->weight_factor = 1.0;
+  dom->weightsmode = MEASURED_WEIGHTS;
+  dom->repartitionmode = ADAPTIVE_REPARTITION;
 
   /* general parameters */
   Zoltan_Set_Param (dom->zol, "DEBUG_LEVEL", "0");
@@ -2706,12 +3378,151 @@ static void destroy_mpi (DOM *dom)
 {
   free (dom->dbd);
 
+  COM_Neighbours_Free (dom->neighbours);
+
   stats_destroy (dom);
 
+  if (dom->sfc) SFC_Destroy (dom->sfc);
+
   Zoltan_Destroy (&dom->zol);
 }
 #endif
 
+/* bodies processed by the thread pool */
+typedef struct body_loop BODY_LOOP;
+
+struct body_loop
+{
+  BODY **bod;
+
+  double time,
+	 step;
+};
+
+/* can time integration of a body run concurrently with other bodies? (user callbacks need
+ * the Python interpreter and finite element bodies can use non-reentrant sparse solvers) */
+static int concurrent_body (BODY *bod)
+{
+  FORCE *force;
+
+  if (bod->kind == FEM) return 0;
+
+  for (force = bod->forces; force; force = force->next)
+  {
+    if (force->func) return 0;
+  }
+
+  return 1;
+}
+
+/* begin time step of a body (in parallel its time integration is timed for load balancing) */
+static void body_step_begin (BODY *bod, short dynamic, double time, double step)
+{
+#if MPI
+  TIMING t;
+
+  timerstart (&t);
+#endif
+
+  if (dynamic) BODY_Dynamic_Step_Begin (bod, time, step);
+  else BODY_Static_Step_Begin (bod, time, step);
+
+#if MPI
+  bod->tint += timerend (&t);
+#endif
+}
+
+/* end time step of a body */
+static void body_step_end (BODY *bod, short dynamic, double time, double step)
+{
+#if MPI
+  TIMING t;
+
+  timerstart (&t);
+#endif
+
+  if (dynamic) BODY_Dynamic_Step_End (bod, time, step);
+  else BODY_Static_Step_End (bod, time, step);
+
+#if MPI
+  bod->tint += timerend (&t);
+#endif
+}
+
+/* begin dynamic time step of the i-th body */
+static void dynamic_step_begin (BODY_LOOP *data, int i)
+{
+  body_step_begin (data->bod [i], 1, data->time, data->step);
+}
+
+/* begin static time step of the i-th body */
+static void static_step_begin (BODY_LOOP *data, int i)
+{
+  body_step_begin (data->bod [i], 0, data->time, data->step);
+}
+
+/* update extents of the i-th body */
+static void update_extents (BODY_LOOP *data, int i)
+{
+  BODY_Update_Extents (data->bod [i]);
+}
+
+/* begin time integration of all bodies; bodies which can be
+ * integrated concurrently are processed by the thread pool */
+static void bodies_step_begin (DOM *dom, double time, double step)
+{
+  THREAD_Job job = dom->dynamic ? (THREAD_Job) dynamic_step_begin : (THREAD_Job) static_step_begin;
+  BODY_LOOP data;
+  BODY *bod;
+  int n;
+
+  if (THREAD_Count () == 1)
+  {
+    for (bod = dom->bod; bod; bod = bod->next) body_step_begin (bod, dom->dynamic, time, step);
+
+    return;
+  }
+
+  for (n = 0, bod = dom->bod; bod; bod = bod->next) n ++;
+  ERRMEM (data.bod = malloc (sizeof (BODY*) * (n + 1)));
+  data.time = time;
+  data.step = step;
+
+  for (n = 0, bod = dom->bod; bod; bod = bod->next)
+  {
+    if (concurrent_body (bod)) data.bod [n ++] = bod;
+    else body_step_begin (bod, dom->dynamic, time, step);
+  }
+
+  THREAD_Loop (n, job, &data);
+
+  free (data.bod);
+}
+
+/* update extents of all bodies using the thread pool */
+static void bodies_update_extents (DOM *dom)
+{
+  BODY_LOOP data;
+  BODY *bod;
+  int n;
+
+  if (THREAD_Count () == 1)
+  {
+    for (bod = dom->bod; bod; bod = bod->next) BODY_Update_Extents (bod);
+
+    return;
+  }
+
+  for (n = 0, bod = dom->bod; bod; bod = bod->next) n ++;
+  ERRMEM (data.bod = malloc (sizeof (BODY*) * (n + 1)));
+
+  for (n = 0, bod = dom->bod; bod; bod = bod->next) data.bod [n ++] = bod;
+
+  THREAD_Loop (n, (THREAD_Job) update_extents, &data);
+
+  free (data.bod);
+}
+
 /* go over contact points and remove those whose corresponding
  * areas are much smaller than those of other points related to
  * objects directly topologically adjacent in their shape definitions */
@@ -2849,6 +3660,7 @@ DOM* DOM_Create (AABB *aabb, SPSET *sps, short dynamic, double step)
   MEM_Init (&dom->setmem, sizeof (SET), SETBLK);
   MEM_Init (&dom->sgpmem, sizeof (SGP), CONBLK);
   MEM_Init (&dom->excmem, sizeof (int [2]), SETBLK);
+  MEM_Init (&dom->sepmem, sizeof (struct sepaxis), MAPBLK);
   dom->bid = 1;
   dom->lab = NULL;
   dom->idb = NULL;
@@ -2863,12 +3675,17 @@ DOM* DOM_Create (AABB *aabb, SPSET *sps, short dynamic, double step)
   dom->idc= NULL;
   dom->con = NULL;
   dom->ncon = 0;
+  dom->sep = NULL;
+  dom->nsepaxis = dom->nsepgjk = dom->nsepcvi = 0;
   dom->prev = dom->next = NULL;
   dom->flags = 0;
   dom->threshold = 0.01;
   dom->minarea = 0.0;
   dom->mindist = GEOMETRIC_EPSILON;
+  dom->mantol = 0.0;
   dom->depth = -DBL_MAX;
+  dom->warm = NULL;
+  dom->nwarm = 0;
   ERRMEM (dom->ldy = LOCDYN_Create (dom));
 
   dom->gravity [0] = NULL;
@@ -2905,15 +3722,11 @@ void DOM_Insert_Body (DOM *dom, BODY *bod)
   MAP_Insert (&dom->mapmem, &dom->allbodies, (void*) (long) bod->id, bod, NULL);
 
 #if MPI
-  /* insert every 'rank' body into this domain */
-#if LOCAL_BODIES
-  if (dom->insertbodymode == ALWAYS ||
-     (dom->insertbodymode == EVERYNCPU && dom->rank == 0)) /* all bodies created on rank 0 */
-#else
+  /* insert every 'rank' body into this domain; in the LOCAL_BODIES
+   * mode other bodies are not stored here (see lng_BODY_new in lng.c) */
   if (dom->insertbodymode == ALWAYS ||
      (dom->insertbodymode == EVERYNCPU &&
       bod->id % (unsigned) dom->ncpu == (unsigned) dom->rank))
-#endif
   {
     /* mark as parent */
     bod->flags |= BODY_PARENT;
@@ -3397,9 +4210,13 @@ LOCDYN* DOM_Update_Begin (DOM *dom)
 #endif
 
 #if MPI
+  if (dom->firstupdate)
+  {
 #if LOCAL_BODIES
-  if (dom->time == 0.0) domain_balancing (dom); /* initially balance bodies */
+    domain_balancing (dom); /* initially balance bodies, also after a restart */
 #endif
+    dom->firstupdate = 0;
+  }
 
   if (dom->rank == 0)
 #endif
@@ -3432,12 +4249,7 @@ LOCDYN* DOM_Update_Begin (DOM *dom)
   if (dom->verbose) printf (" (STEP: %.3g) ", step), fflush (stdout);
 
   /* begin time integration */
-  if (dom->dynamic)
-    for (bod = dom->bod; bod; bod = bod->next)
-      BODY_Dynamic_Step_Begin (bod, time, step);
-  else
-    for (bod = dom->bod; bod; bod = bod->next)
-      BODY_Static_Step_Begin (bod, time, step);
+  bodies_step_begin (dom, time, step);
 
   SOLFEC_Timer_End (dom->solfec, "TIMINT");
 
@@ -3458,7 +4270,7 @@ LOCDYN* DOM_Update_Begin (DOM *dom)
 
     switch (con->kind)
     {
-      case CONTACT: update_contact (dom, con); break;
+      case CONTACT: if (!batch_contact (dom, con)) update_contact (dom, con); break;
       case FIXPNT:  update_fixpnt  (dom, con); break;
       case FIXDIR:  update_fixdir  (dom, con); break;
       case VELODIR: update_velodir (dom, con); break;
@@ -3467,6 +4279,8 @@ LOCDYN* DOM_Update_Begin (DOM *dom)
     }
   }
 
+  batch_update (dom); /* sphere contacts */
+
 #if MPI
   /* external con->point coordinates are need to be updated before the update of body extents;
    * this way slave bodies suitably update their extents and maintain children on the constraint owner processor */
@@ -3474,7 +4288,7 @@ LOCDYN* DOM_Update_Begin (DOM *dom)
 #endif
 
   /* update body extents after constraints update so that constraint points can be incorporated if needed */
-  for (bod = dom->bod; bod; bod = bod->next) BODY_Update_Extents (bod);
+  bodies_update_extents (dom);
 
   SOLFEC_Timer_End (dom->solfec, "CONUPD");
 
@@ -3498,8 +4312,14 @@ LOCDYN* DOM_Update_Begin (DOM *dom)
 
   timerstart (&timing);
 
+  dom->nsepaxis = dom->nsepgjk = dom->nsepcvi = 0;
+
   AABB_Update (dom->aabb, alg, dom, (BOX_Overlap_Create) overlap_create);
 
+  batch_detect (dom);
+
+  separated_cleanup (dom);
+
   aabb_timing (dom, timerend (&timing));
 
   SOLFEC_Timer_End (dom->solfec, "CONDET");
@@ -3542,6 +4362,8 @@ LOCDYN* DOM_Update_Begin (DOM *dom)
     }
   }
 
+  if (dom->warm) dom_warm_start (dom); /* first update after restart */
+
   SOLFEC_Timer_End (dom->solfec, "CONUPD");
 
   /* output local dynamics */
@@ -3574,12 +4396,8 @@ void DOM_Update_End (DOM *dom)
   step = dom->step;
 
   /* end time integration */
-  if (dom->dynamic)
-    for (bod = dom->bod; bod; bod = bod->next)
-      BODY_Dynamic_Step_End (bod, time, step);
-  else
-    for (bod = dom->bod; bod; bod = bod->next)
-      BODY_Static_Step_End (bod, time, step);
+  for (bod = dom->bod; bod; bod = bod->next)
+    body_step_end (bod, dom->dynamic, time, step);
 
   /* advance time */
   dom->time += step;
@@ -3654,33 +4472,80 @@ void DOM_Update_End (DOM *dom)
   }
 
   SOLFEC_Timer_End (dom->solfec, "TIMINT");
+
+#if MPI
+  measure_costs (dom); /* load balancing costs of this step */
+#endif
 }
 
 #if MPI
+/* synchronise load balancing cost measurement with reset labeled timers */
+void DOM_Timers_Reset (DOM *dom)
+{
+  int i;
+
+  for (i = 0; i < 4; i ++) dom->phase [i] = SOLFEC_Timing (dom->solfec, cost_phases [i]);
+}
+
+/* ranks of the partitions overlapped by a box; 'procs' needs to have 'dom->ncpu' size */
+void DOM_Box_Assign (DOM *dom, double *extents, int *procs, int *numprocs)
+{
+  double *e = extents;
+
+  if (dom->sfc) SFC_Box_Assign (dom->sfc, extents, procs, numprocs);
+  else ASSERT (Zoltan_LB_Box_Assign (dom->zol, e[0], e[1], e[2], e[3], e[4], e[5], procs, numprocs) == ZOLTAN_OK, ERR_ZOLTAN);
+}
+
+/* select the partitioning method: 'curve' < 0 selects Zoltan, otherwise
+ * an SFC_CURVE; the domain is repartitioned at the next balancing */
+void DOM_Partitioner (DOM *dom, int curve)
+{
+  if (dom->sfc) SFC_Destroy (dom->sfc);
+
+  if (curve < 0) dom->sfc = NULL;
+  else dom->sfc = SFC_Create (MPI_COMM_WORLD, curve);
+
+  dom->rebalanced = 0; /* enforce repartitioning */
+}
+
+/* refresh child (ghost) copies with the current states of their parents (collective) */
+void DOM_Update_Children (DOM *dom)
+{
+  int bytes = dom->bytes;
+
+  update_children (dom);
+
+  dom->bytes += bytes; /* update_children starts a new count */
+}
+
 /* send boundary reactions to their external receivers;
  * if 'normal' is > 0 only normal components are sent */
 void DOM_Update_External_Reactions (DOM *dom, short normal)
 {
   COMOBJ *send, *recv;
-  int i, nrecv;
+  int i, nsend, nrecv;
 
   ERRMEM (send = malloc (sizeof (COMOBJ [dom->ncpu])));
 
-  for (i = 0; i < dom->ncpu; i ++)
+  for (nsend = i = 0; i < dom->ncpu; i ++)
   {
-    send [i].o = dom->dbd [i].ext;
-    send [i].rank = i;
+    if (dom->dbd [i].ext) /* only ranks with external receivers */
+    {
+      send [nsend].o = dom->dbd [i].ext;
+      send [nsend].rank = i;
+      nsend ++;
+    }
   }
 
   if (normal > 0)
   {
-    dom->bytes += COMOBJSALL (MPI_COMM_WORLD, (OBJ_Pack)pack_normal_reactions, dom,
-      (OBJ_Unpack)unpack_normal_reactions, send, dom->ncpu, &recv, &nrecv);
+    dom->bytes += COMOBJSNB (dom->neighbours, (OBJ_Pack)pack_normal_reactions, dom,
+      (OBJ_Unpack)unpack_normal_reactions, send, nsend, &recv, &nrecv);
   }
   else
   {
-    dom->bytes += COMOBJSALL (MPI_COMM_WORLD, (OBJ_Pack)pack_reactions, dom,
-      (OBJ_Unpack)unpack_reactions, send, dom->ncpu, &recv, &nrecv);
+    dom->bytes += COMOBJSNB (dom->neighbours, (OBJ_Pack)pack_reactions, dom,
+      (OBJ_Unpack)unpack_reactions, send, nsend, &recv, &nrecv);
   }
 
   free (send);
@@ -3688,7 +4553,7 @@ void DOM_Update_External_Reactions (DOM *dom, short normal)
 }
 
 /* schedule parallel insertion of a constraint (to be called on all processors) */
-int DOM_Pending_Constraint (DOM *dom, short kind, BODY *master, BODY *slave,
+int DOM_Pending_Constraint (DOM *dom, short kind, BODY *master, BODY *slave, unsigned int sid,
     double *mpnt, double *spnt, double *dir, TMS *val, int mnode, int snode, double strength)
 {
   PNDCON *pnd;
@@ -3697,6 +4562,7 @@ int DOM_Pending_Constraint (DOM *dom, short kind, BODY *master, BODY *slave,
   pnd->kind = kind;
   pnd->master = master;
   pnd->slave = slave;
+  pnd->sid = slave ? slave->id : sid;
   if (mpnt) COPY (mpnt, pnd->mpnt);
   if (spnt) COPY (spnt, pnd->spnt);
   if (dir) COPY (dir, pnd->dir);
@@ -3756,12 +4622,30 @@ int DOM_Read_Body (DOM *dom, PBF *bf, BODY *bod)
   return dom_read_body (dom, bf, bod);
 }
 
+/* read states of a subset of bodies */
+int DOM_Read_Bodies (DOM *dom, PBF *bf, SET *subset, double *box, MEM *setmem, SET **out)
+{
+  return dom_read_bodies (dom, bf, subset, box, setmem, out);
+}
+
 /* read state of an individual constraint */
 int DOM_Read_Constraint (DOM *dom, PBF *bf, CON *con)
 {
   return dom_read_constraint (dom, bf, con);
 }
 
+/* write restart checkpoint */
+void DOM_Write_Checkpoint (DOM *dom, char *path)
+{
+  dom_write_checkpoint (dom, path);
+}
+
+/* read restart checkpoint */
+int DOM_Read_Checkpoint (DOM *dom, char *path)
+{
+  return dom_read_checkpoint (dom, path);
+}
+
 /* exclude contact between a pair of surfaces */
 void DOM_Exclude_Contact (DOM *dom, int surf1, int surf2)
 {
@@ -3809,6 +4693,10 @@ void DOM_Destroy (DOM *dom)
   MEM_Release (&dom->mapmem);
   MEM_Release (&dom->sgpmem);
   MEM_Release (&dom->excmem);
+  MEM_Release (&dom->sepmem);
+
+  gobjbatch_free (&dom->detbatch);
+  gobjbatch_free (&dom->updbatch);
 
   if (dom->gravity [0]) TMS_Destroy (dom->gravity [0]);
   if (dom->gravity [1]) TMS_Destroy (dom->gravity [1]);
@@ -3816,6 +4704,8 @@ void DOM_Destroy (DOM *dom)
 
   aabb_destroy_data (dom->aabb_data);
 
+  free (dom->warm);
+
   free (dom);
 }
 
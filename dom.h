@@ -22,6 +22,7 @@
 #if MPI
 #include <zoltan.h>
 #include "com.h"
+#include "sfc.h"
 #endif
 
 #include "mem.h"
@@ -31,6 +32,8 @@
 #include "bod.h"
 #include "ldy.h"
 #include "pbf.h"
+#include "gjk.h"
+#include "goc.h"
 
 #ifndef SOLFEC_TYPE
 #define SOLFEC_TYPE
@@ -90,6 +93,19 @@ struct constraint
 
   int spair [2]; /* surface pair */
 
+  GJK_CACHE gjk; /* warm start data of contact updates */
+
+  struct
+  {
+    double normal [2][3], /* normal in the slave [0] and master [1] referential frames */
+           tangent [2][3], /* tangent in the slave [0] and master [1] referential frames */
+           point [3], /* master referential point of the last full update */
+           gap, /* gap at the last full update */
+           tol; /* admissible slip and normal motion (zero if the previous full update was not recorded) */
+
+    int age; /* number of updates since the last full update (0 if there is no manifold) */
+  } man; /* persistent manifold of rigid convex contacts; 'mpnt' and 'spnt' hold its points */
+
   SURFACE_MATERIAL_STATE mat; /* surface pair material data */
 
   TMS *tms; /* time series data (if any) */
@@ -112,6 +128,8 @@ struct constraint
    * the data layout does not change for serial code (e.g. dbs.c) */
 #if MPI
   SET *ext; /* ranks of remote external images of this constraint */
+  double work; /* constraint solver work units accumulated since the last cost measurement */
+  double cost; /* smoothed measured computational cost [us] (load balancing weight) */
 #endif
 };
 
@@ -134,6 +152,7 @@ struct domain_statistics
   int min;
   int avg;
   int max;
+  short imbalance; /* report the MAX/AVG imbalance ratio */
 };
 
 typedef struct domain_balancing_data DBD;
@@ -162,6 +181,8 @@ struct pending_constraint
   BODY *master,
        *slave;
 
+  unsigned int sid; /* slave id (LOCAL_BODIES: a NULL slave is stored on another processor) */
+
   double mpnt [3],
 	 spnt [3],
 	 dir  [3];
@@ -205,7 +226,8 @@ struct domain
       mapmem, /* map items memory pool */
       setmem, /* set items memory pool */
       sgpmem, /* non-surface SGPs memory */
-      excmem; /* excluded surface pairs memory */
+      excmem, /* excluded surface pairs memory */
+      sepmem; /* separating axes memory */
 
   AABB *aabb; /* box overlap engine */
   SPSET *sps; /* surface pairs */
@@ -235,6 +257,12 @@ struct domain
   CON *con; /* list of constraints */
   int ncon; /* number of constraints */
   int nspa; /* number of sparsified contacts */
+  MAP *sep; /* cached separating axes of overlapping (in the box sense) but separated polyhedral pairs */
+  int nsepaxis, /* pairs rejected by their cached separating axes during the last contact detection */
+      nsepgjk, /* pairs rejected by the GJK distance query */
+      nsepcvi; /* pairs passed on to the full intersection test */
+  GOBJ_BATCH detbatch, /* curved object pairs detected in bulk */
+             updbatch; /* sphere contacts updated in bulk */
   SET *excluded; /* excluded surface pairs */
 
   LOCDYN *ldy; /* local dynamics */
@@ -247,6 +275,7 @@ struct domain
   double threshold; /* sparsification threshold */
   double minarea; /* minimal contact point area */
   double mindist; /* minimal distance between contact points */
+  double mantol; /* relative tolerance of rigid convex contact manifolds (zero disables them) */
   double depth; /* unphisical interpenetration depth bound (negative) */
 
   DOM_FLAGS flags; /* some flags */
@@ -254,13 +283,21 @@ struct domain
 
   double merit; /* most recent constraints satisfaction merit function value */
 
+  struct warm_start *warm; /* checkpointed constraint reactions awaiting the first update after restart */
+  int nwarm; /* number of them */
+
 #if MPI
   int rank; /* communicator rank */
   int ncpu; /* cummunicator size */
   SET *children; /* current children */
   struct Zoltan_Struct *zol; /* load balancing */
+  SFC *sfc; /* built-in space filling curve partitioning (used instead of Zoltan when not NULL) */
   double imbalance_tolerance; /* imbalance threshold */
   double weight_factor; /* local dynamics weight factor */
+  enum {MEASURED_WEIGHTS, HEURISTIC_WEIGHTS} weightsmode; /* load balancing weights */
+  double phase [4]; /* CONDET, CONUPD, LOCDYN, CONSOL timer totals at the last cost measurement */
+  double load [4]; /* TIMINT, CONDET, LOCDYN, CONSOL measured loads [us] over the last step */
+  double bodavg, conavg; /* average measured body and constraint costs (assumed for unmeasured objects) */
   unsigned int noid; /* constraint id generation ommition flag */
   MAP *conext; /* id based map of external constraints */
   int bytes; /* bytes sent during load balancing */
@@ -268,12 +305,20 @@ struct domain
   DOMSTATS *stats; /* domain statistics */
   int nstats; /* statistics count */
   DBD *dbd; /* load balancing send sets */
+  void *neighbours; /* neighbour-only communication (reset after repartitioning) */
   SET *pendingcons; /* pending constraints to be inserted in parallel */
   SET *pendingbods; /* pending bodies to be inserted in parallel */
   SET *sparebid; /* deleted body ids */
   enum {ALWAYS, NEVER, EVERYNCPU} insertbodymode; /* insert body mode */
+  short firstupdate; /* set until the first update of this run, which can follow a restart */
   int rebalanced; /* counts rebalancing steps */
   int updatefreq; /* domain partitioning update frequency */
+  enum {ADAPTIVE_REPARTITION, FIXED_REPARTITION} repartitionmode; /* repartitioning policy */
+  double imbloss; /* time lost to load imbalance in excess of repbase since the last repartitioning [us] */
+  double repbase; /* time lost to load imbalance in the first step after the last repartitioning [us] */
+  double repcost; /* measured cost of the last repartitioning [us] */
+  int repbytes; /* bytes migrated during the last repartitioning */
+  int repartitions; /* number of repartitionings */
 #endif
 
   DOM *prev, *next; /* list */
@@ -343,12 +388,27 @@ LOCDYN* DOM_Update_Begin (DOM *dom);
 void DOM_Update_End (DOM *dom);
 
 #if MPI
+/* synchronise load balancing cost measurement with reset labeled timers */
+void DOM_Timers_Reset (DOM *dom);
+
+/* ranks of the partitions overlapped by a box; 'procs' needs to have 'dom->ncpu' size */
+void DOM_Box_Assign (DOM *dom, double *extents, int *procs, int *numprocs);
+
+/* select the partitioning method: 'curve' < 0 selects Zoltan, otherwise
+ * an SFC_CURVE; the domain is repartitioned at the next balancing */
+void DOM_Partitioner (DOM *dom, int curve);
+
+/* refresh child (ghost) copies with the current states of their parents (collective) */
+void DOM_Update_Children (DOM *dom);
+
 /* send boundary reactions to their external receivers;
  * if 'normal' is > 0 only normal components are sent */
 void DOM_Update_External_Reactions (DOM *dom, short normal);
 
-/* schedule parallel insertion of a constraint (to be called on all processors) */
-int DOM_Pending_Constraint (DOM *dom, short kind, BODY *master, BODY *slave,
+/* schedule parallel insertion of a constraint (to be called on all processors);
+ * in the LOCAL_BODIES mode it is called where the master is stored, while the slave
+ * can be NULL if it is stored on another processor (it is then found by its 'sid') */
+int DOM_Pending_Constraint (DOM *dom, short kind, BODY *master, BODY *slave, unsigned int sid,
     double *mpnt, double *spnt, double *dir, TMS *val, int mnode, int snode, double strength);
 
 /* schedule ASAP insertion of a body in parallel (to be called on one processor) */
@@ -364,9 +424,18 @@ void DOM_Read_State (DOM *dom, PBF *bf);
 /* read state of an individual body */
 int  DOM_Read_Body (DOM *dom, PBF *bf, BODY *bod);
 
+/* read states of a subset of bodies (see dio.h) */
+int  DOM_Read_Bodies (DOM *dom, PBF *bf, SET *subset, double *box, MEM *setmem, SET **out);
+
 /* read state of an individual constraint */
 int  DOM_Read_Constraint (DOM *dom, PBF *bf, CON *con);
 
+/* write restart checkpoint to 'path' (with a rank suffix in parallel) */
+void DOM_Write_Checkpoint (DOM *dom, char *path);
+
+/* read restart checkpoint from 'path'; return 1 on success, 0 otherwise */
+int DOM_Read_Checkpoint (DOM *dom, char *path);
+
 /* exclude contact between a pair of surfaces */
 void DOM_Exclude_Contact (DOM *dom, int surf1, int surf2);
 
@@ -21,7 +21,7 @@
 
 #include "err.h"
 
-ERRSTACK *__errstack__ = NULL; /* global error context */
+__thread ERRSTACK *__errstack__ = NULL; /* per-thread error context */
 
 short WARNINGS_ENABLED = 1; /* warnings flag */
 
@@ -38,7 +38,7 @@ struct errstack /* error stack */
   ERRSTACK *next;
 };
 
-extern ERRSTACK *__errstack__; /* global error stack */
+extern __thread ERRSTACK *__errstack__; /* per-thread error stack (see thr.h) */
 
 extern short WARNINGS_ENABLED; /* warnings flag */
 
@@ -62,8 +62,12 @@ static void fracture_state_write (DOM *dom)
   int numbod;
   PBF *f;
 
+#if MPI /* ranks write independently, hence not into a shared parallel file */
+  snprintf (path, 1024, "%s/fracture%d", dom->solfec->outpath, dom->rank);
+#else
   snprintf (path, 1024, "%s/fracture", dom->solfec->outpath);
-  ASSERT (f = PBF_Write (path, PBF_ON, PBF_ON), ERR_FILE_OPEN);
+#endif
+  ASSERT (f = PBF_Write (path, PBF_ON, PBF_OFF), ERR_FILE_OPEN);
 
   PBF_Time (f, &dom->time);
 
@@ -173,20 +177,15 @@ static void fracture_state_write (DOM *dom)
 #endif
 }
 
-/* read fracture state */
-FS* fracture_state_read (BODY *bod)
+#if HDF5
+/* read fracture states of a body from all frames of 'g' and prepend them to 'out' */
+static FS* fracture_frames_read (PBF *g, BODY *bod, FS *out)
 {
-  FS *out = NULL, *item, *instance;
-  char path [1024];
+  FS *item, *instance;
   unsigned int id;
   int i, n, dofs;
   double *disp;
-
-#if HDF5
-  PBF *f, *g;
-
-  snprintf (path, 1024, "%s/fracture", bod->dom->solfec->outpath);
-  g = PBF_Read (path);
+  PBF *f;
 
   do
   {
@@ -237,8 +236,47 @@ FS* fracture_state_read (BODY *bod)
     }
   } while (PBF_Forward (g, 1));
 
-  PBF_Close (g);
+  return out;
+}
+#endif
+
+/* read fracture state */
+FS* fracture_state_read (BODY *bod)
+{
+  FS *out = NULL;
+  char path [1024];
+
+#if HDF5
+  PBF *g;
+  int rank, size;
+
+  snprintf (path, 1024, "%s/fracture", bod->dom->solfec->outpath);
+
+  if ((g = PBF_Read (path))) /* serial output */
+  {
+    out = fracture_frames_read (g, bod, out);
+    PBF_Close (g);
+  }
+  else /* ranks of MPI runs write independently and only when their bodies fracture */
+  {
+    for (size = 0, g = bod->dom->solfec->bf; g; g = g->next) size ++; /* number of ranks */
+
+    for (rank = 0; rank < size; rank ++)
+    {
+      snprintf (path, 1024, "%s/fracture%d", bod->dom->solfec->outpath, rank);
+
+      if ((g = PBF_Read (path)))
+      {
+	out = fracture_frames_read (g, bod, out);
+	PBF_Close (g);
+      }
+    }
+  }
 #else
+  FS *item, *instance;
+  unsigned int id;
+  int i, n, dofs;
+  double *disp;
   FILE *f;
   XDR x;
 
@@ -29,6 +29,12 @@
  * points in the Minkowski difference set (A - B) */
 typedef struct { double w[3], *a, *b; } point;
 
+/* ellipsoid pair Newton iterations: count, convergence
+ * rotation of the normal and maximal rotation per step */
+#define NEWTON_ITERS 16
+#define NEWTON_ANGLE 1E-10
+#define NEWTON_RANGE 0.5
+
 /* simple bit lighting macro for vertex sets */
 #define set(i,j,k,l) ((i*8)|(j*4)|(k*2)|(l*1))
 
@@ -92,6 +98,40 @@ inline static double* maximal_support_point (double *c, int n, double *v)
   return out;
 }
 
+/* polyhedra with fewer vertices are scanned linearly */
+#define CLIMB_MIN 32
+
+/* find maximal (sign > 0) or minimal (sign < 0) point in set (c, n) along the direction of 'v' by hill-climbing
+ * over the vertex graph 'g' (see gjk.h), starting from the point 'x' (or from the first point if 'x' is NULL);
+ * small sets, missing graphs and plateaus (a face orthogonal to 'v') fall back to the linear scan */
+inline static double* climbing_support_point (double *c, int n, int *g, double *x, double sign, double *v)
+{
+  double u [3], dot, dotmax;
+  int i, j, k, flat;
+
+  if (!g || n < CLIMB_MIN) return sign > 0.0 ? maximal_support_point (c, n, v) : minimal_support_point (c, n, v);
+
+  MUL (v, sign, u);
+  i = x ? (x - c) / 3 : 0;
+  dotmax = DOT (c+3*i, u);
+
+  for (;;)
+  {
+    for (k = i, flat = 0, j = g [i]; j < g [i+1]; j ++)
+    {
+      dot = DOT (c+3*g[j], u);
+      if (dot > dotmax) { dotmax = dot; k = g [j]; }
+      else if (dot == dotmax) flat = 1;
+    }
+
+    if (k == i) break; /* a local maximum is global for a convex polyhedron */
+    else i = k;
+  }
+
+  if (flat) return sign > 0.0 ? maximal_support_point (c, n, v) : minimal_support_point (c, n, v);
+  else return c+3*i;
+}
+
 /* allocate output point for curved primitives */
 inline static double* output_point (point *w, int n, double x [4][3], short maximal)
 {
@@ -337,12 +377,55 @@ static int project (point *w, int n, double *l, double *v)
   return 0;
 }
 
+/* restore the simplex of polytopes A = (a, na) and B = (b, nb) from the cached vertex indices;
+ * if b == NULL then B is a single point 'pnt'; return the projected simplex size or 0 for a cold start */
+static int warm_simplex (double *a, int na, double *b, int nb, double *pnt, GJK_CACHE *cache, point *w, double *l, double *v)
+{
+  int i;
+
+  if (!cache || cache->n < 1 || cache->n > 4) return 0;
+
+  for (i = 0; i < cache->n; i ++)
+  {
+    if (cache->a [i] >= na || (b && cache->b [i] >= nb)) return 0; /* vertex sets have changed */
+
+    w[i].a = a + 3*cache->a [i];
+    w[i].b = b ? b + 3*cache->b [i] : pnt;
+    SUB (w[i].a, w[i].b, w[i].w);
+  }
+
+  return project (w, cache->n, l, v);
+}
+
+/* store the final simplex of polytopes A = (a, na) and B = (b, nb) and the separating axis 'v' */
+static void store_simplex (double *a, double *b, GJK_CACHE *cache, point *w, int n, double *v)
+{
+  int i;
+
+  for (i = 0; i < n; i ++)
+  {
+    cache->a [i] = (w[i].a - a) / 3;
+    cache->b [i] = b ? (w[i].b - b) / 3 : 0;
+  }
+
+  cache->n = n;
+  COPY (v, cache->v);
+}
+
 /* public driver routine => input two polytopes A = (a, na) and B = (b, nb); outputs
  * p in A and q in B such that d = |p - q| is minimal; the distance d is returned */
 double gjk (double *a, int na, double *b, int nb, double *p, double *q)
+{
+  return gjk_warm (a, na, NULL, b, nb, NULL, NULL, p, q);
+}
+
+/* warm started gjk (a, na, b, nb, p, q) using optional vertex graphs (ga, gb) */
+double gjk_warm (double *a, int na, int *ga, double *b, int nb, int *gb, GJK_CACHE *cache, double *p, double *q)
 {
   point w [4];
-  double v [3],
+  double *xa = a, /* last support points */
+	 *xb = b,
+	 v [3],
 	 vlen,
 	 delta,
 	 mi = 0.0,
@@ -353,13 +436,14 @@ double gjk (double *a, int na, double *b, int nb, double *p, double *q)
       j = 0,
       k = (na+nb)*(na+nb);
 
-  SUB (a, b, v);
+  if ((n = warm_simplex (a, na, b, nb, NULL, cache, w, l, v))) xa = w[0].a, xb = w[0].b;
+  else SUB (a, b, v); /* an initial point in the set A-B */
   vlen = LEN (v);
 
   while (toofar && vlen > GEOMETRIC_EPSILON && n < 4 && j ++ < k) /* (#) see below */
   {
-    w[n].a = minimal_support_point (a, na, v);
-    w[n].b = maximal_support_point (b, nb, v);
+    w[n].a = xa = climbing_support_point (a, na, ga, xa, -1.0, v);
+    w[n].b = xb = climbing_support_point (b, nb, gb, xb, 1.0, v);
     SUB (w[n].a, w[n].b, w[n].w);
     delta = DOT (v, w[n].w) / vlen;
     mi = MAX (mi, delta);
@@ -371,6 +455,8 @@ double gjk (double *a, int na, double *b, int nb, double *p, double *q)
     }
   }
 
+  if (cache) store_simplex (a, b, cache, w, n, v);
+
   if (n)
   {
     SET (p, 0);
@@ -390,13 +476,43 @@ double gjk (double *a, int na, double *b, int nb, double *p, double *q)
   return vlen;
 }
 
+/* separation of polytopes A = (a, na) and B = (b, nb) along the cached axis; the support
+ * queries start from the cached simplex (when still valid) and use optional vertex graphs */
+double gjk_axis_separation (double *a, int na, int *ga, double *b, int nb, int *gb, GJK_CACHE *cache)
+{
+  double *xa = a,
+	 *xb = b,
+	 *v = cache->v,
+	 len = LEN (v);
+
+  if (len == 0.0) return -DBL_MAX; /* no axis yet */
+
+  if (cache->n > 0 && cache->a [0] < na && cache->b [0] < nb)
+  {
+    xa = a + 3*cache->a [0];
+    xb = b + 3*cache->b [0];
+  }
+
+  xa = climbing_support_point (a, na, ga, xa, -1.0, v);
+  xb = climbing_support_point (b, nb, gb, xb, 1.0, v);
+
+  return (DOT (v, xa) - DOT (v, xb)) / len;
+}
+
 /* public driver routine => input polytope A = (a, na) and sphere B = (c, r); outputs
  * p in A and q in B such that d = |p - q| is minimal; the distance d is returned */
 double gjk_convex_sphere (double *a, int na, double *c, double r, double *p, double *q)
+{
+  return gjk_convex_sphere_warm (a, na, NULL, c, r, NULL, p, q);
+}
+
+/* warm started gjk_convex_sphere (a, na, c, r, p, q) using an optional vertex graph 'ga' */
+double gjk_convex_sphere_warm (double *a, int na, int *ga, double *c, double r, GJK_CACHE *cache, double *p, double *q)
 {
   point w [4];
   double v [3],
 	 b [4][3], /* support points for the sphere */
+	 *x = a, /* initial and then last support point in A */
 	 vlen,
 	 delta,
 	 mi = 0.0,
@@ -407,14 +523,22 @@ double gjk_convex_sphere (double *a, int na, double *c, double r, double *p, dou
       j = 0,
       k = 4*na*na;
 
-  COPY (c, b [0]);
-  b [0][0] += r; /* be is now a point on the sphere */
-  SUB (a, b [0], v); /* an initial point in the set A-B */
+  if (cache && DOT (cache->v, cache->v) > 0.0) /* start along the cached separating axis */
+  {
+    x = climbing_support_point (a, na, ga, x, -1.0, cache->v);
+    maximal_sphere_support_point (w, 0, b, c, r, cache->v); /* b [0] */
+  }
+  else
+  {
+    COPY (c, b [0]);
+    b [0][0] += r; /* be is now a point on the sphere */
+  }
+  SUB (x, b [0], v); /* an initial point in the set A-B */
   vlen = LEN (v);
 
   while (toofar && vlen > GEOMETRIC_EPSILON && n < 4 && j ++ < k) /* (#) see below */
   {
-    w[n].a = minimal_support_point (a, na, v);
+    w[n].a = x = climbing_support_point (a, na, ga, x, -1.0, v);
     w[n].b = maximal_sphere_support_point (w, n, b, c, r, v);
     SUB (w[n].a, w[n].b, w[n].w);
     delta = DOT (v, w[n].w) / vlen;
@@ -427,6 +551,8 @@ double gjk_convex_sphere (double *a, int na, double *c, double r, double *p, dou
     }
   }
 
+  if (cache) COPY (v, cache->v);
+
   if (n)
   {
     SET (p, 0);
@@ -439,7 +565,7 @@ double gjk_convex_sphere (double *a, int na, double *c, double r, double *p, dou
   }
   else /* while loop never entered */
   {
-    COPY (a, p);
+    COPY (x, p);
     COPY (b [0], q); 
   }
 
@@ -449,10 +575,17 @@ double gjk_convex_sphere (double *a, int na, double *c, double r, double *p, dou
 /* (a,na) and (b,bsca, brot) are the input polyhedron and ellipsoid; 'p' and 'q' are the two outputed
  * closest points, respectively in polyhedron (a,na) and ellipsoid (b, bsca, brot); the distance is returned */
 double gjk_convex_ellip (double *a, int na, double *b, double *bsca, double *brot, double *p, double *q)
+{
+  return gjk_convex_ellip_warm (a, na, NULL, b, bsca, brot, NULL, p, q);
+}
+
+/* warm started gjk_convex_ellip (a, na, b, bsca, brot, p, q) using an optional vertex graph 'ga' */
+double gjk_convex_ellip_warm (double *a, int na, int *ga, double *b, double *bsca, double *brot, GJK_CACHE *cache, double *p, double *q)
 {
   point w [4];
   double v [3],
 	 z [4][3], /* support points for the ellipsoid */
+	 *x = a, /* initial and then last support point in A */
 	 vlen,
 	 delta,
 	 mi = 0.0,
@@ -463,17 +596,25 @@ double gjk_convex_ellip (double *a, int na, double *b, double *bsca, double *bro
       j = 0,
       k = 4*na*na;
 
-  SET (v, 0);
-  v[0] = bsca [0]; /* a point on a scaled unit sphere */
-  NVMUL (brot, v, z [0]); /* a point on a scaled, rotated unit sphere */
-  ADD (b, z [0], z [0]); /* a point on a scaled, rotated and translated unit sphere => ellipsoid */
+  if (cache && DOT (cache->v, cache->v) > 0.0) /* start along the cached separating axis */
+  {
+    x = climbing_support_point (a, na, ga, x, -1.0, cache->v);
+    maximal_ellip_support_point (w, 0, z, b, bsca, brot, cache->v); /* z [0] */
+  }
+  else
+  {
+    SET (v, 0);
+    v[0] = bsca [0]; /* a point on a scaled unit sphere */
+    NVMUL (brot, v, z [0]); /* a point on a scaled, rotated unit sphere */
+    ADD (b, z [0], z [0]); /* a point on a scaled, rotated and translated unit sphere => ellipsoid */
+  }
 
-  SUB (a, z [0], v); /* an initial point in the set A-B */
+  SUB (x, z [0], v); /* an initial point in the set A-B */
   vlen = LEN (v);
 
   while (toofar && vlen > GEOMETRIC_EPSILON && n < 4 && j ++ < k) /* (#) see below */
   {
-    w[n].a = minimal_support_point (a, na, v);
+    w[n].a = x = climbing_support_point (a, na, ga, x, -1.0, v);
     w[n].b = maximal_ellip_support_point (w, n, z, b, bsca, brot, v);
     SUB (w[n].a, w[n].b, w[n].w);
     delta = DOT (v, w[n].w) / vlen;
@@ -486,6 +627,8 @@ double gjk_convex_ellip (double *a, int na, double *b, double *bsca, double *bro
     }
   }
 
+  if (cache) COPY (v, cache->v);
+
   if (n)
   {
     SET (p, 0);
@@ -498,7 +641,7 @@ double gjk_convex_ellip (double *a, int na, double *b, double *bsca, double *bro
   }
   else /* while loop never entered */
   {
-    COPY (a, p);
+    COPY (x, p);
     COPY (z [0], q); 
   }
 
@@ -508,9 +651,16 @@ double gjk_convex_ellip (double *a, int na, double *b, double *bsca, double *bro
 /* (a,na) and p are the input polyhedron and point; 'q' is the outputed
  * closest point on the polyhedron; the distance is returned */
 double gjk_convex_point (double *a, int na, double *p, double *q)
+{
+  return gjk_convex_point_warm (a, na, NULL, p, NULL, q);
+}
+
+/* warm started gjk_convex_point (a, na, p, q) using an optional vertex graph 'ga' */
+double gjk_convex_point_warm (double *a, int na, int *ga, double *p, GJK_CACHE *cache, double *q)
 {
   point w [4];
-  double v [3],
+  double *x = a, /* last support point */
+	 v [3],
 	 vlen,
 	 delta,
 	 mi = 0.0,
@@ -521,12 +671,13 @@ double gjk_convex_point (double *a, int na, double *p, double *q)
       j = 0,
       k = 4*na*na;
 
-  SUB (a, p, v); /* an initial point in the set A-B */
+  if ((n = warm_simplex (a, na, NULL, 0, p, cache, w, l, v))) x = w[0].a;
+  else SUB (a, p, v); /* an initial point in the set A-B */
   vlen = LEN (v);
 
   while (toofar && vlen > GEOMETRIC_EPSILON && n < 4 && j ++ < k) /* (#) see below */
   {
-    w[n].a = minimal_support_point (a, na, v);
+    w[n].a = x = climbing_support_point (a, na, ga, x, -1.0, v);
     w[n].b = p;
     SUB (w[n].a, w[n].b, w[n].w);
     delta = DOT (v, w[n].w) / vlen;
@@ -539,6 +690,8 @@ double gjk_convex_point (double *a, int na, double *p, double *q)
     }
   }
 
+  if (cache) store_simplex (a, NULL, cache, w, n, v);
+
   if (n)
   {
     SET (q, 0);
@@ -586,6 +739,12 @@ double gjk_sphere_sphere (double *a, double ra, double *b, double rb, double *p,
 /* (a,ra) and (b,bsca,brot)) are the input sphere and ellipsoid; 'p' and 'q' are the two outputed
  * closest points, respectively in sphere (a,ra) and ellipsoid (b,bsca,brot); the distance is returned */
 double gjk_sphere_ellip (double *a, double ra, double *b, double *bsca, double *brot, double *p, double *q)
+{
+  return gjk_sphere_ellip_warm (a, ra, b, bsca, brot, NULL, p, q);
+}
+
+/* warm started gjk_sphere_ellip (a, ra, b, bsca, brot, p, q) */
+double gjk_sphere_ellip_warm (double *a, double ra, double *b, double *bsca, double *brot, GJK_CACHE *cache, double *p, double *q)
 {
   point w [4];
   double v [3],
@@ -601,13 +760,21 @@ double gjk_sphere_ellip (double *a, double ra, double *b, double *bsca, double *
       j = 0,
       k = 128;
 
-  COPY (a, y [0]);
-  y [0][0] += ra; /* y[0] is now a point on the sphere */
+  if (cache && DOT (cache->v, cache->v) > 0.0) /* start along the cached separating axis */
+  {
+    minimal_sphere_support_point (w, 0, y, a, ra, cache->v); /* y [0] */
+    maximal_ellip_support_point (w, 0, z, b, bsca, brot, cache->v); /* z [0] */
+  }
+  else
+  {
+    COPY (a, y [0]);
+    y [0][0] += ra; /* y[0] is now a point on the sphere */
 
-  SET (v, 0);
-  v[0] = bsca [0]; /* a point on a scaled unit sphere */
-  NVMUL (brot, v, z [0]); /* a point on a scaled, rotated unit sphere */
-  ADD (b, z [0], z [0]); /* a point on a scaled, rotated and translated unit sphere => ellipsoid */
+    SET (v, 0);
+    v[0] = bsca [0]; /* a point on a scaled unit sphere */
+    NVMUL (brot, v, z [0]); /* a point on a scaled, rotated unit sphere */
+    ADD (b, z [0], z [0]); /* a point on a scaled, rotated and translated unit sphere => ellipsoid */
+  }
 
   SUB (y [0], z [0], v); /* an initial point in the set A-B */
   vlen = LEN (v);
@@ -627,6 +794,8 @@ double gjk_sphere_ellip (double *a, double ra, double *b, double *bsca, double *
     }
   }
 
+  if (cache) COPY (v, cache->v);
+
   if (n)
   {
     SET (p, 0);
@@ -649,6 +818,12 @@ double gjk_sphere_ellip (double *a, double ra, double *b, double *bsca, double *
 /* (a,asca,arot) and (b,bsca,brot) are the two input ellipsoids; 'p' and 'q' are the two outputed
  * closest points, respectively in (a,asca,arot) and (b,bsca,brot); the distance is returned */
 double gjk_ellip_ellip (double *a, double *asca, double *arot, double *b, double *bsca, double *brot, double *p, double *q)
+{
+  return gjk_ellip_ellip_warm (a, asca, arot, b, bsca, brot, NULL, p, q);
+}
+
+/* warm started gjk_ellip_ellip (a, asca, arot, b, bsca, brot, p, q) */
+double gjk_ellip_ellip_warm (double *a, double *asca, double *arot, double *b, double *bsca, double *brot, GJK_CACHE *cache, double *p, double *q)
 {
   point w [4];
   double v [3],
@@ -664,15 +839,23 @@ double gjk_ellip_ellip (double *a, double *asca, double *arot, double *b, double
       j = 0,
       k = 128;
 
-  SET (v, 0);
-  v[0] = asca [0]; /* a point on a scaled unit sphere */
-  NVMUL (arot, v, y [0]); /* a point on a scaled, rotated unit sphere */
-  ADD (a, y [0], y [0]); /* a point on a scaled, rotated and translated unit sphere => ellipsoid */
-
-  SET (v, 0);
-  v[0] = bsca [0]; /* a point on a scaled unit sphere */
-  NVMUL (brot, v, z [0]); /* a point on a scaled, rotated unit sphere */
-  ADD (b, z [0], z [0]); /* a point on a scaled, rotated and translated unit sphere => ellipsoid */
+  if (cache && DOT (cache->v, cache->v) > 0.0) /* start along the cached separating axis */
+  {
+    minimal_ellip_support_point (w, 0, y, a, asca, arot, cache->v); /* y [0] */
+    maximal_ellip_support_point (w, 0, z, b, bsca, brot, cache->v); /* z [0] */
+  }
+  else
+  {
+    SET (v, 0);
+    v[0] = asca [0]; /* a point on a scaled unit sphere */
+    NVMUL (arot, v, y [0]); /* a point on a scaled, rotated unit sphere */
+    ADD (a, y [0], y [0]); /* a point on a scaled, rotated and translated unit sphere => ellipsoid */
+
+    SET (v, 0);
+    v[0] = bsca [0]; /* a point on a scaled unit sphere */
+    NVMUL (brot, v, z [0]); /* a point on a scaled, rotated unit sphere */
+    ADD (b, z [0], z [0]); /* a point on a scaled, rotated and translated unit sphere => ellipsoid */
+  }
 
   SUB (y [0], z [0], v); /* an initial point in the set A-B */
   vlen = LEN (v);
@@ -692,6 +875,8 @@ double gjk_ellip_ellip (double *a, double *asca, double *arot, double *b, double
     }
   }
 
+  if (cache) COPY (v, cache->v);
+
   if (n)
   {
     SET (p, 0);
@@ -711,6 +896,107 @@ double gjk_ellip_ellip (double *a, double *asca, double *arot, double *b, double
   return vlen;
 }
 
+/* symmetric shape matrix M = T T', where T = {rot} * diag {sca}, of an ellipsoid;
+ * its support point along a unit direction n is then c + M n / sqrt (n' M n) */
+static void ellip_shape_matrix (double *sca, double *rot, double *M)
+{
+  double s [3] = {sca[0]*sca[0], sca[1]*sca[1], sca[2]*sca[2]};
+  int i, j;
+
+  for (j = 0; j < 3; j ++)
+  for (i = 0; i < 3; i ++)
+    M [i+3*j] = s[0]*rot[i]*rot[j] + s[1]*rot[3+i]*rot[3+j] + s[2]*rot[6+i]*rot[6+j];
+}
+
+/* signed distance of ellipsoids (a,asca,arot) and (b,bsca,brot) by Newton iterations over the unit normal */
+int gjk_ellip_ellip_newton (double *a, double *asca, double *arot, double *b, double *bsca, double *brot, GJK_CACHE *cache, double *p, double *q, double *normal, double *gap)
+{
+  /* The separation of the two support planes along a unit normal n, pointing from 'a' towards 'b',
+   *
+   * d (n) = n'(b - a) - sqrt (n'A n) - sqrt (n'B n), where A, B are the shape matrices,
+   *
+   * attains its maximum on the unit sphere at the signed distance of the ellipsoids (minus the
+   * penetration depth for overlaps). Its gradient is g = q - p, where p and q are the support points
+   * along n and -n. At the maximum g is parallel to n, hence the Newton steps below are taken within
+   * the tangent plane of n, using the Riemannian Hessian P H P - d (n) I, where P = I - n n'.
+   */
+
+  double A [9], B [9], n [3], e [3], t [2][3], an [3], bn [3], at [2][3], bt [2][3],
+	 la, lb, g [3], r [2], K [3], det, d [2], step, len;
+  int j, k;
+
+  ellip_shape_matrix (asca, arot, A);
+  ellip_shape_matrix (bsca, brot, B);
+
+  if (cache && DOT (cache->v, cache->v) > 0.0) { COPY (cache->v, n); SCALE (n, -1.0); } /* cached axis points from 'b' to 'a' */
+  else SUB (b, a, n);
+
+  if ((len = LEN (n)) == 0.0) return 0;
+  DIV (n, len, n);
+
+  for (k = 0; k < NEWTON_ITERS; k ++)
+  {
+    NVMUL (A, n, an);
+    NVMUL (B, n, bn);
+    la = sqrt (DOT (n, an));
+    lb = sqrt (DOT (n, bn));
+    ADDMUL (a, 1.0/la, an, p);
+    ADDMUL (b, -1.0/lb, bn, q);
+    SUB (q, p, g);
+    *gap = DOT (n, g);
+
+    /* tangent basis */
+    j = fabs (n[0]) < fabs (n[1]) ? (fabs (n[0]) < fabs (n[2]) ? 0 : 2) : (fabs (n[1]) < fabs (n[2]) ? 1 : 2);
+    SET (e, 0.0);
+    e [j] = 1.0;
+    PRODUCT (n, e, t[0]);
+    NORMALIZE (t[0]);
+    PRODUCT (n, t[0], t[1]);
+
+    r [0] = DOT (t[0], g);
+    r [1] = DOT (t[1], g);
+
+    NVMUL (A, t[0], at[0]);
+    NVMUL (A, t[1], at[1]);
+    NVMUL (B, t[0], bt[0]);
+    NVMUL (B, t[1], bt[1]);
+
+    d [0] = DOT (an, t[0]) / la;
+    d [1] = DOT (an, t[1]) / la;
+    K [0] = -(DOT (t[0], at[0]) - d[0]*d[0]) / la;
+    K [1] = -(DOT (t[0], at[1]) - d[0]*d[1]) / la;
+    K [2] = -(DOT (t[1], at[1]) - d[1]*d[1]) / la;
+
+    d [0] = DOT (bn, t[0]) / lb;
+    d [1] = DOT (bn, t[1]) / lb;
+    K [0] -= (DOT (t[0], bt[0]) - d[0]*d[0]) / lb + *gap;
+    K [1] -= (DOT (t[0], bt[1]) - d[0]*d[1]) / lb;
+    K [2] -= (DOT (t[1], bt[1]) - d[1]*d[1]) / lb + *gap;
+
+    det = K[0]*K[2] - K[1]*K[1];
+
+    if (K[0] >= 0.0 || det <= 0.0) return 0; /* not near a maximum */
+
+    d [0] = (K[1]*r[1] - K[2]*r[0]) / det;
+    d [1] = (K[1]*r[0] - K[0]*r[1]) / det;
+    step = sqrt (d[0]*d[0] + d[1]*d[1]);
+
+    if (step < NEWTON_ANGLE) /* converged => 'p', 'q' and 'gap' are current */
+    {
+      COPY (n, normal);
+      if (cache) { COPY (n, cache->v); SCALE (cache->v, -1.0); }
+      return 1;
+    }
+    else if (step > NEWTON_RANGE) return 0; /* too far from the warm start */
+
+    ADDMUL (n, d[0], t[0], n);
+    ADDMUL (n, d[1], t[1], n);
+    NORMALIZE (n);
+  }
+
+  return 0;
+}
+
 /* (a,asca,arot) and p are the input ellipsoid and point; 'q' is the outputed
  * closest point on the ellipsoid; the distance is returned */
 double gjk_ellip_point (double *a, double *asca, double *arot, double *p, double *q)
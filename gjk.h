@@ -23,22 +23,50 @@
 #ifndef __gjk__
 #define __gjk__
 
+typedef struct gjk_cache GJK_CACHE;
+
+/* warm start data of a persistent pair of objects; a zeroed cache
+ * results in a cold start; the *_warm variants of the routines below
+ * read and update it, so that small relative motions of the objects
+ * typically converge in one or two iterations */
+struct gjk_cache
+{
+  int n, /* simplex size */
+      a [4], /* simplex vertex indices in the first polyhedron */
+      b [4]; /* simplex vertex indices in the second polyhedron */
+
+  double v [3]; /* separating axis (used with curved objects) */
+};
+
+/* the *_warm routines accept optional vertex graphs of polyhedra (or NULL): neighbours
+ * of vertex i are g [g [i]], ..., g [g [i+1]-1]; the graphs enable hill-climbing
+ * support queries, which pay off for polyhedra with many vertices */
+
 /* (a,na) and (b,nb) are the two input tables of polyhedrons vertices;
  * 'p' and 'q' are the two outputed closest points, respectively in
  * polyhedron (a,na) and polyhedron (b,nb); the distance is returned */
 double gjk (double *a, int na, double *b, int nb, double *p, double *q);
+double gjk_warm (double *a, int na, int *ga, double *b, int nb, int *gb, GJK_CACHE *cache, double *p, double *q);
+
+/* separation of polyhedra (a,na) and (b,nb) along the separating axis stored in the cache by an
+ * earlier gjk_warm call; a positive result proves the polyhedra are at least that far apart,
+ * otherwise nothing can be concluded; this costs two support queries instead of a GJK run */
+double gjk_axis_separation (double *a, int na, int *ga, double *b, int nb, int *gb, GJK_CACHE *cache);
 
 /* (a,na) and (c,r) are the input polyhedron and sphere; 'p' and 'q' are the two outputed
  * closest points, respectively in polyhedron (a,na) and sphere (c,r); the distance is returned */
 double gjk_convex_sphere (double *a, int na, double *c, double r, double *p, double *q);
+double gjk_convex_sphere_warm (double *a, int na, int *ga, double *c, double r, GJK_CACHE *cache, double *p, double *q);
 
 /* (a,na) and p are the input polyhedron and point; 'q' is the outputed
  * closest point on the polyhedron; the distance is returned */
 double gjk_convex_point (double *a, int na, double *p, double *q);
+double gjk_convex_point_warm (double *a, int na, int *ga, double *p, GJK_CACHE *cache, double *q);
 
 /* (a,na) and (b,bsca, brot) are the input polyhedron and ellipsoid; 'p' and 'q' are the two outputed
  * closest points, respectively in polyhedron (a,na) and ellipsoid (b, bsca, brot); the distance is returned */
 double gjk_convex_ellip (double *a, int na, double *b, double *bsca, double *brot, double *p, double *q);
+double gjk_convex_ellip_warm (double *a, int na, int *ga, double *b, double *bsca, double *brot, GJK_CACHE *cache, double *p, double *q);
 
 /* (a,ra) and (b,rb) are the input spheres; * 'p' and 'q' are the two outputed closest points,
  * respectively in spheres (a,ra) and (b,rb); the distance is returned */
@@ -47,10 +75,18 @@ double gjk_sphere_sphere (double *a, double ra, double *b, double rb, double *p,
 /* (a,ra) and (b,bsca,brot)) are the input sphere and ellipsoid; 'p' and 'q' are the two outputed
  * closest points, respectively in sphere (a,ra) and ellipsoid (b,bsca,brot); the distance is returned */
 double gjk_sphere_ellip (double *a, double ra, double *b, double *bsca, double *brot, double *p, double *q);
+double gjk_sphere_ellip_warm (double *a, double ra, double *b, double *bsca, double *brot, GJK_CACHE *cache, double *p, double *q);
 
 /* (a,asca,arot) and (b,bsca,brot) are the two input ellipsoids; 'p' and 'q' are the two outputed
  * closest points, respectively in (a,asca,arot) and (b,bsca,brot); the distance is returned */
 double gjk_ellip_ellip (double *a, double *asca, double *arot, double *b, double *bsca, double *brot, double *p, double *q);
+double gjk_ellip_ellip_warm (double *a, double *asca, double *arot, double *b, double *bsca, double *brot, GJK_CACHE *cache, double *p, double *q);
+
+/* a fast path for persistent pairs of ellipsoids (a,asca,arot) and (b,bsca,brot): Newton iterations
+ * warm started from the cached axis find the outward unit 'normal' of the first ellipsoid, which
+ * maximises the separation 'gap' of the support planes (negative for overlaps); 'p' and 'q' are the
+ * corresponding support points; 1 is returned on convergence and 0 if the gjk routines are needed */
+int gjk_ellip_ellip_newton (double *a, double *asca, double *arot, double *b, double *bsca, double *brot, GJK_CACHE *cache, double *p, double *q, double *normal, double *gap);
 
 /* (a,asca,arot) and p are the input ellipsoid and point; 'q' is the outputed
  * closest point on the ellipsoid; the distance is returned */
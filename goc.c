@@ -27,11 +27,41 @@
 #include "cvx.h"
 #include "sph.h"
 #include "eli.h"
+#include "sdf.h"
 #include "cvi.h"
 #include "gjk.h"
 #include "goc.h"
 #include "err.h"
 
+#define SDF_ITERS 8 /* deepest ellipsoid point iterations against a distance field */
+#define SDF_ANGLE 1E-10 /* normal direction change tolerance of these iterations */
+
+/* memory reused by the contact routines */
+typedef struct goc_workspace GOC_WORKSPACE;
+
+struct goc_workspace
+{
+  CVI_WORKSPACE cvi; /* convex intersection */
+  double *pla [2]; /* planes of the first and the second convex */
+  int size [2]; /* number of planes they can hold */
+  short init; /* initialization flag */
+};
+
+/* one workspace per thread */
+static __thread GOC_WORKSPACE workspace;
+
+/* get initialized workspace of the calling thread */
+inline static GOC_WORKSPACE* work (void)
+{
+  if (!workspace.init)
+  {
+    cvi_workspace_init (&workspace.cvi);
+    workspace.init = 1;
+  }
+
+  return &workspace;
+}
+
 /* line-plane intersection => intersection = point + direction * coef if 1 is returned */
 inline static int lineplane (double *plane, double *point, double *direction, double *coef)
 {
@@ -213,13 +243,12 @@ static int detect_convex_convex (
   int k = 0, m;
   TRI *tri;
 
-  if (!(tri = cvi (va, nva, pa, npa, vb, nvb, pb, npb, NON_REGULARIZED, &m))) return 0;
+  if (!(tri = cvi_work (&work ()->cvi, va, nva, NULL, pa, npa, vb, nvb, NULL, pb, npb, NON_REGULARIZED, NULL, &m))) return 0;
 
   k = point_normal_spair_area_gap (tri, m, va, nva, vb, nvb, pa, npa, pb, npb, sa, nsa, sb, nsb, onepnt, normal, spair, area, gap);
   sanity = (onepnt[0]+onepnt[1]+onepnt[2]+normal[0]+normal[1]+normal[2]+(*area)+(*gap));
   COPY (onepnt, twopnt);
   if (ptri && ntri) *ptri = tri, *ntri = m;
-  else free (tri);
 
   if (!isfinite (sanity)) return 0;
   else return k;
@@ -453,19 +482,20 @@ static int update_convex_convex (
   double *gap,
   double *area,
   int spair [2],
+  int *ga, int *gb, /* vertex graphs (or NULL) */
+  GJK_CACHE *cache,
   TRI **ptri, int *ntri)
 {
   double sanity;
   int k = 0, m;
   TRI *tri;
 
-  if (!(tri = cvi (va, nva, pa, npa, vb, nvb, pb, npb, NON_REGULARIZED, &m))) return 0;
+  if (!(tri = cvi_work (&work ()->cvi, va, nva, ga, pa, npa, vb, nvb, gb, pb, npb, NON_REGULARIZED, cache, &m))) return 0;
 
   k = point_normal_spair_area_gap (tri, -m, va, nva, vb, nvb, pa, npa, pb, npb, sa, nsa, sb, nsb, onepnt, normal, spair, area, gap);
   sanity = (onepnt[0]+onepnt[1]+onepnt[2]+normal[0]+normal[1]+normal[2]+(*area)+(*gap));
   COPY (onepnt, twopnt);
   if (ptri && ntri) *ptri = tri, *ntri = m;
-  else free (tri);
 
   if (!isfinite (sanity)) return 0;
   else return k;
@@ -480,12 +510,14 @@ static int update_convex_sphere (
   double normal [3],
   double *gap,
   double *area,
-  int spair [2])
+  int spair [2],
+  int *gc, /* vertex graph (or NULL) */
+  GJK_CACHE *cache)
 {
   double dot, len, ilen, *nn;
   int s0;
 
-  if (gjk_convex_point (vc, nvc, c, onepnt) < r + GEOMETRIC_EPSILON)
+  if (gjk_convex_point_warm (vc, nvc, gc, c, cache, onepnt) < r + GEOMETRIC_EPSILON)
   {
     SUB (c, onepnt, normal);
     dot = DOT (normal, normal);
@@ -524,11 +556,13 @@ static int update_convex_ellip (
   double normal [3],
   double *gap,
   double *area,
-  int spair [2])
+  int spair [2],
+  int *gc, /* vertex graph (or NULL) */
+  GJK_CACHE *cache)
 {
   int s0;
 
-  if (gjk_convex_ellip (vc, nvc, c, sca, rot, onepnt, twopnt) < GEOMETRIC_EPSILON)
+  if (gjk_convex_ellip_warm (vc, nvc, gc, c, sca, rot, cache, onepnt, twopnt) < GEOMETRIC_EPSILON)
   {
     double *pla = pc, *end = pc + 6*nsc, p [3], q [3], d;
 
@@ -604,13 +638,26 @@ static int update_ellip_ellip (
   double normal [3],
   double *gap,
   double *area,
-  int spair [2])
+  int spair [2],
+  GJK_CACHE *cache)
 {
-  if (gjk_ellip_ellip (a, asca, arot, b, bsca, brot, onepnt, twopnt) < GEOMETRIC_EPSILON)
+  if (gjk_ellip_ellip_newton (a, asca, arot, b, bsca, brot, cache, onepnt, twopnt, normal, gap)) /* fast path */
+  {
+    if (*gap < GEOMETRIC_EPSILON)
+    {
+      if (*gap > 0) *gap = 0; /* XXX: GEOMETRIC_EPSILON roundoff */
+      return 1;
+    }
+
+    return 0;
+  }
+
+  if (gjk_ellip_ellip_warm (a, asca, arot, b, bsca, brot, cache, onepnt, twopnt) < GEOMETRIC_EPSILON)
   {
     ellip_normal (a, asca, arot, onepnt, normal);
     *gap = gjk_ellip_ellip_gap (a, asca, arot, b, bsca, brot, normal);
     if (*gap > 0) *gap = 0; /* XXX: GEOMETRIC_EPSILON roundoff */
+    if (cache) { COPY (normal, cache->v); SCALE (cache->v, -1.0); } /* seed the fast path */
     return 1;
   }
 
@@ -626,9 +673,10 @@ static int update_sphere_ellip (
   double normal [3],
   double *gap,
   double *area,
-  int spair [2])
+  int spair [2],
+  GJK_CACHE *cache)
 {
-  if (gjk_sphere_ellip (a, ra, b, bsca, brot, onepnt, twopnt) < GEOMETRIC_EPSILON)
+  if (gjk_sphere_ellip_warm (a, ra, b, bsca, brot, cache, onepnt, twopnt) < GEOMETRIC_EPSILON)
   {
     sphere_normal (a, ra, onepnt, normal);
     *gap = gjk_sphere_ellip_gap (a, ra, b, bsca, brot, normal);
@@ -639,12 +687,25 @@ static int update_sphere_ellip (
   return 0;
 }
 
-/* initialize convex a convex representation */
-inline static void convex_init (CONVEX *cvx, double **v, int *nv, double **p, int *np, int **s, int *ns)
+/* initialize convex a convex representation; planes of the
+ * first (i = 0) or the second (i = 1) convex of a pair are
+ * placed in the workspace memory and need not be freed */
+inline static void convex_init (CONVEX *cvx, int i, double **v, int *nv, double **p, int *np, int **s, int *ns)
 {
+  GOC_WORKSPACE *w = work ();
+
+  if (cvx->nfac > w->size [i])
+  {
+    free (w->pla [i]);
+    w->size [i] = 2 * cvx->nfac;
+    ERRMEM (w->pla [i] = malloc (sizeof (double [6]) * w->size [i]));
+  }
+
+  CONVEX_Planes_Ext (cvx, w->pla [i]);
+
   *v = cvx->cur;
   *nv = cvx->nver;
-  *p = CONVEX_Planes (cvx);
+  *p = w->pla [i];
   *np = cvx->nfac;
   *s = cvx->surface;
   /* when created with MESH_Convex (or MESH2CONVEX) stop at the first
@@ -652,11 +713,8 @@ inline static void convex_init (CONVEX *cvx, double **v, int *nv, double **p, in
   for (*ns = 0; *ns < cvx->nfac && (*s) [*ns] != -INT_MAX; (*ns) ++);
 }
 
-/* finalize a convex representation */
-inline static void convex_done (CONVEX *cvx, double **v, int *nv, double **p, int *np, int **s, int *ns)
-{
-  free (*p);
-}
+/* convex vertex graph */
+#define vgr(gobj) (((CONVEX*)(gobj))->vgr)
 
 /* swap surface pairs */
 inline static void swap (int spair [2])
@@ -689,6 +747,213 @@ inline static int update_swap (int ret, int spair [2])
   return ret;
 }
 
+/* detect contact between a signed distance field and a sphere */
+static int detect_sdf_sphere (
+  SDF *sdf,
+  double *c, double r, int s, /* center, radius, surface */
+  double onepnt [3],
+  double twopnt [3],
+  double normal [3],
+  double *gap,
+  double *area,
+  int spair [2])
+{
+  double d, len;
+
+  d = SDF_Distance (sdf, c, normal);
+
+  if (d - r < GEOMETRIC_EPSILON)
+  {
+    len = LEN (normal);
+    if (len == 0.0) return 0;
+    DIV (normal, len, normal);
+    ADDMUL (c, -d, normal, onepnt);
+    ADDMUL (c, -r, normal, twopnt);
+
+    spair [0] = sdf->surface;
+    spair [1] = s;
+    *area = 1.0;
+    d -= r;
+    *gap = MIN (d, 0.0);
+    return 1;
+  }
+
+  return 0;
+}
+
+/* detect contact between a signed distance field and an ellipsoid */
+static int detect_sdf_ellip (
+  SDF *sdf,
+  double *c, double *sca, double *rot, int s, /* center, scaling, rotation, surface */
+  double onepnt [3],
+  double twopnt [3],
+  double normal [3],
+  double *gap,
+  double *area,
+  int spair [2])
+{
+  double d, len, p [3], g [3];
+  int k;
+
+  d = SDF_Distance (sdf, c, normal);
+
+  if (d - MAX (sca[0], MAX (sca[1], sca[2])) >= GEOMETRIC_EPSILON) return 0; /* bounding sphere is away */
+
+  len = LEN (normal);
+  if (len == 0.0) return 0;
+  DIV (normal, len, normal);
+
+  for (k = 0; k < SDF_ITERS; k ++) /* the deepest point is the support point opposed to the field normal there */
+  {
+    gjk_ellip_support_point (c, sca, rot, normal, 1, p);
+    d = SDF_Distance (sdf, p, g);
+    len = LEN (g);
+    if (len == 0.0) return 0;
+    DIV (g, len, g);
+    len = DOT (g, normal);
+    COPY (g, normal);
+    if (len > 1.0 - SDF_ANGLE) break;
+  }
+
+  if (d < GEOMETRIC_EPSILON)
+  {
+    ADDMUL (p, -d, normal, onepnt);
+    COPY (p, twopnt);
+
+    spair [0] = sdf->surface;
+    spair [1] = s;
+    *area = 1.0;
+    *gap = MIN (d, 0.0);
+    return 1;
+  }
+
+  return 0;
+}
+
+/* detect contact between a signed distance field and a convex; the contact point, normal and gap
+ * are averaged over all penetrating vertices of the convex, weighted by their penetration depths,
+ * so that a resting face or edge is supported at its centre rather than at a single corner */
+static int detect_sdf_convex (
+  SDF *sdf,
+  double *vc, int nvc, double *pc, int *sc, int nsc, /* vertices, planes, surfaces (see detect_convex_convex) */
+  double onepnt [3],
+  double twopnt [3],
+  double normal [3],
+  double *gap,
+  double *area,
+  int spair [2])
+{
+  double d, w, sum, dep, len, g [3], *v, *end;
+  int k;
+
+  SET (twopnt, 0.0);
+  SET (normal, 0.0);
+
+  for (sum = dep = 0.0, v = vc, end = vc + 3*nvc; v < end; v += 3)
+  {
+    d = SDF_Distance (sdf, v, g);
+
+    if (d < GEOMETRIC_EPSILON)
+    {
+      len = LEN (g);
+      if (len == 0.0) continue;
+      w = GEOMETRIC_EPSILON - d; /* depth weight; positive for all penetrating vertices */
+      len = w / len;
+      ADDMUL (normal, len, g, normal);
+      ADDMUL (twopnt, w, v, twopnt);
+      dep += w * d;
+      sum += w;
+    }
+  }
+
+  if (sum > 0.0)
+  {
+    len = LEN (normal);
+    if (len == 0.0) return 0;
+    DIV (normal, len, normal);
+    DIV (twopnt, sum, twopnt);
+    dep /= sum;
+    ADDMUL (twopnt, -dep, normal, onepnt);
+
+    spair [0] = sdf->surface;
+    spair [1] = sc [0];
+    for (len = DBL_MAX, k = 0; k < nsc; k ++) /* surface facing the field most */
+    {
+      d = DOT (pc + 6*k, normal);
+      if (d < len) len = d, spair [1] = sc [k];
+    }
+
+    *area = 1.0;
+    *gap = MIN (dep, 0.0);
+    return 1;
+  }
+
+  return 0;
+}
+
+/* detect contact between a signed distance field and an object of given kind */
+static int detect_sdf (
+    SDF *sdf, short kind,
+    SHAPE *shp, void *gobj,
+    double onepnt [3],
+    double twopnt [3],
+    double normal [3],
+    double *gap,
+    double *area,
+    int spair [2])
+{
+  switch (kind)
+  {
+    case GOBJ_ELEMENT:
+    {
+      double v [24], p [36];
+      int nv, s [6], ns;
+
+      nv = ELEMENT_Vertices (shp->data, gobj, v);
+      ELEMENT_Planes (shp->data, gobj, p, s, &ns);
+
+      return detect_sdf_convex (sdf, v, nv, p, s, ns, onepnt, twopnt, normal, gap, area, spair);
+    }
+    break;
+    case GOBJ_CONVEX:
+    {
+      double *v, *p;
+      int nv, np, *s, ns;
+
+      convex_init (gobj, 0, &v, &nv, &p, &np, &s, &ns);
+
+      return detect_sdf_convex (sdf, v, nv, p, s, ns, onepnt, twopnt, normal, gap, area, spair);
+    }
+    break;
+    case GOBJ_SPHERE:
+    {
+      SPHERE *b = gobj;
+
+      return detect_sdf_sphere (sdf, b->cur_center, b->cur_radius, b->surface,
+                                onepnt, twopnt, normal, gap, area, spair);
+    }
+    break;
+    case GOBJ_ELLIP:
+    {
+      ELLIP *b = gobj;
+
+      return detect_sdf_ellip (sdf, b->cur_center, b->cur_sca, b->cur_rot, b->surface,
+                               onepnt, twopnt, normal, gap, area, spair);
+    }
+    break;
+  }
+
+  return 0;
+}
+
+/* update return value of a signed distance field contact detected anew */
+inline static int update_sdf (int ret, int old [2], int spair [2])
+{
+  if (ret == 0) return 0;
+  else if (old [0] == spair [0] && old [1] == spair [1]) return 1;
+  else return 2;
+}
+
 /* detect contact */
 static int detect (
     short paircode,
@@ -730,17 +995,14 @@ static int detect (
 	  nvb, npb, *sb, nsb,
 	  ret;
 
-      convex_init (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
-      convex_init (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+      convex_init (onegobj, 0, &va, &nva, &pa, &npa, &sa, &nsa);
+      convex_init (twogobj, 1, &vb, &nvb, &pb, &npb, &sb, &nsb);
 
       ret = detect_convex_convex (va, nva, pa, npa, sa, nsa,
                                   vb, nvb, pb, npb, sb, nsb,
                                   onepnt, twopnt, normal,
 				  gap, area, spair, ptri, ntri);
 
-      convex_done (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
-      convex_done (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
-
       return ret;
     }
     break;
@@ -766,15 +1028,13 @@ static int detect (
       nva = ELEMENT_Vertices (oneshp->data, onegobj, va);
       npa = ELEMENT_Planes (oneshp->data, onegobj, pa, sa, &nsa);
 
-      convex_init (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+      convex_init (twogobj, 1, &vb, &nvb, &pb, &npb, &sb, &nsb);
 
       ret = detect_convex_convex (va, nva, pa, npa, sa, nsa,
                                   vb, nvb, pb, npb, sb, nsb,
                                   onepnt, twopnt, normal,
 				  gap, area, spair, ptri, ntri);
 
-      convex_done (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
-
       return ret;
     }
     break;
@@ -786,7 +1046,7 @@ static int detect (
 	  nvb, npb, sb [6], nsb,
 	  ret;
 
-      convex_init (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+      convex_init (onegobj, 0, &va, &nva, &pa, &npa, &sa, &nsa);
 
       nvb = ELEMENT_Vertices (twoshp->data, twogobj, vb);
       npb = ELEMENT_Planes (twoshp->data, twogobj, pb, sb, &nsb);
@@ -796,8 +1056,6 @@ static int detect (
                                   onepnt, twopnt, normal,
 				  gap, area, spair, ptri, ntri);
 
-      convex_done (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
-
       return ret;
     }
     break;
@@ -843,15 +1101,13 @@ static int detect (
       int nva, npa, *sa, nsa,
 	  ret;
 
-      convex_init (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+      convex_init (onegobj, 0, &va, &nva, &pa, &npa, &sa, &nsa);
 
       ret = detect_convex_sphere (va, nva, pa, npa, sa, nsa,
                                   b->cur_center, b->cur_radius, b->surface,
                                   onepnt, twopnt, normal,
 				  gap, area, spair);
 
-      convex_done (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
-
       return ret;
     }
     break;
@@ -862,7 +1118,7 @@ static int detect (
       int nvb, npb, *sb, nsb,
 	  ret;
 
-      convex_init (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+      convex_init (twogobj, 1, &vb, &nvb, &pb, &npb, &sb, &nsb);
 
       swap (spair);
 
@@ -871,8 +1127,6 @@ static int detect (
                                   twopnt, onepnt, normal,
 				  gap, area, spair);
 
-      convex_done (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
-
       return detect_swap (ret, spair);
     }
     break;
@@ -926,14 +1180,12 @@ static int detect (
       int nva, npa, *sa, nsa,
 	  ret;
 
-      convex_init (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+      convex_init (onegobj, 0, &va, &nva, &pa, &npa, &sa, &nsa);
 
       ret = detect_convex_ellip (va, nva, pa, npa, sa, nsa,
                                   b->cur_center, b->cur_sca, b->cur_rot, b->surface,
                                   onepnt, twopnt, normal, gap, area, spair);
 
-      convex_done (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
-
       return ret;
     }
     break;
@@ -943,7 +1195,7 @@ static int detect (
       double *vb, *pb;
       int nvb, npb, *sb, nsb, ret;
 
-      convex_init (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+      convex_init (twogobj, 1, &vb, &nvb, &pb, &npb, &sb, &nsb);
 
       swap (spair);
 
@@ -951,8 +1203,6 @@ static int detect (
                                   a->cur_center, a->cur_sca, a->cur_rot, a->surface,
                                   twopnt, onepnt, normal, gap, area, spair);
 
-      convex_done (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
-
       return detect_swap (ret, spair);
     }
     break;
@@ -982,6 +1232,30 @@ static int detect (
       return detect_swap (ret, spair);
     }
     break;
+    case AABB_SDF_ELEMENT:
+    case AABB_SDF_CONVEX:
+    case AABB_SDF_SPHERE:
+    case AABB_SDF_ELLIP:
+    {
+      return detect_sdf (onegobj, paircode & 0xff, twoshp, twogobj,
+                         onepnt, twopnt, normal, gap, area, spair);
+    }
+    break;
+    case AABB_ELEMENT_SDF:
+    case AABB_CONVEX_SDF:
+    case AABB_SPHERE_SDF:
+    case AABB_ELLIP_SDF:
+    {
+      int ret;
+
+      swap (spair);
+
+      ret = detect_sdf (twogobj, paircode >> 8, oneshp, onegobj,
+                        twopnt, onepnt, normal, gap, area, spair);
+
+      return detect_swap (ret, spair);
+    }
+    break;
   }
 
   return 0;
@@ -998,6 +1272,7 @@ static int update (
     double *gap,
     double *area,
     int spair [2],
+    GJK_CACHE *cache,
     TRI **ptri, int *ntri)
 {
   switch (paircode)
@@ -1017,7 +1292,7 @@ static int update (
       return update_convex_convex (va, nva, pa, npa, sa, nsa,
                                    vb, nvb, pb, npb, sb, nsb,
                                    onepnt, twopnt, normal,
-				   gap, area, spair, ptri, ntri);
+				   gap, area, spair, NULL, NULL, cache, ptri, ntri);
     }
     break;
     case AABB_CONVEX_CONVEX:
@@ -1028,16 +1303,13 @@ static int update (
 	  nvb, npb, *sb, nsb,
 	  ret;
 
-      convex_init (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
-      convex_init (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+      convex_init (onegobj, 0, &va, &nva, &pa, &npa, &sa, &nsa);
+      convex_init (twogobj, 1, &vb, &nvb, &pb, &npb, &sb, &nsb);
 
       ret = update_convex_convex (va, nva, pa, npa, sa, nsa,
                                   vb, nvb, pb, npb, sb, nsb,
                                   onepnt, twopnt, normal,
-				  gap, area, spair, ptri, ntri);
-
-      convex_done (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
-      convex_done (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+				  gap, area, spair, vgr (onegobj), vgr (twogobj), cache, ptri, ntri);
 
       return ret;
     }
@@ -1064,14 +1336,12 @@ static int update (
       nva = ELEMENT_Vertices (oneshp->data, onegobj, va);
       npa = ELEMENT_Planes (oneshp->data, onegobj, pa, sa, &nsa);
 
-      convex_init (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+      convex_init (twogobj, 1, &vb, &nvb, &pb, &npb, &sb, &nsb);
 
       ret = update_convex_convex (va, nva, pa, npa, sa, nsa,
                                   vb, nvb, pb, npb, sb, nsb,
                                   onepnt, twopnt, normal,
-				  gap, area, spair, ptri, ntri);
-
-      convex_done (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+				  gap, area, spair, NULL, vgr (twogobj), cache, ptri, ntri);
 
       return ret;
     }
@@ -1084,7 +1354,7 @@ static int update (
 	  nvb, npb, sb [6], nsb,
 	  ret;
 
-      convex_init (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+      convex_init (onegobj, 0, &va, &nva, &pa, &npa, &sa, &nsa);
 
       nvb = ELEMENT_Vertices (twoshp->data, twogobj, vb);
       npb = ELEMENT_Planes (twoshp->data, twogobj, pb, sb, &nsb);
@@ -1092,9 +1362,7 @@ static int update (
       ret = update_convex_convex (va, nva, pa, npa, sa, nsa,
                                   vb, nvb, pb, npb, sb, nsb,
                                   onepnt, twopnt, normal,
-				  gap, area, spair, ptri, ntri);
-
-      convex_done (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+				  gap, area, spair, vgr (onegobj), NULL, cache, ptri, ntri);
 
       return ret;
     }
@@ -1110,7 +1378,7 @@ static int update (
 
       return update_convex_sphere (va, nva, pa, npa, sa, nsa,
                                    b->cur_center, b->cur_radius, b->surface,
-                                   onepnt, twopnt, normal, gap, area, spair);
+                                   onepnt, twopnt, normal, gap, area, spair, NULL, cache);
     }
     break;
     case AABB_SPHERE_ELEMENT:
@@ -1126,7 +1394,7 @@ static int update (
 
       ret = update_convex_sphere (vb, nvb, pb, npb, sb, nsb,
                                   a->cur_center, a->cur_radius, a->surface,
-                                  twopnt, onepnt, normal, gap, area, spair);
+                                  twopnt, onepnt, normal, gap, area, spair, NULL, cache);
 
       return update_swap (ret, spair);
     }
@@ -1137,13 +1405,11 @@ static int update (
       SPHERE *b = twogobj;
       int nva, npa, *sa, nsa, ret;
 
-      convex_init (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+      convex_init (onegobj, 0, &va, &nva, &pa, &npa, &sa, &nsa);
 
       ret = update_convex_sphere (va, nva, pa, npa, sa, nsa,
                                   b->cur_center, b->cur_radius, b->surface,
-                                  onepnt, twopnt, normal, gap, area, spair);
-
-      convex_done (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+                                  onepnt, twopnt, normal, gap, area, spair, vgr (onegobj), cache);
 
       return ret;
     }
@@ -1154,15 +1420,13 @@ static int update (
       double *vb, *pb;
       int nvb, npb, *sb, nsb, ret;
 
-      convex_init (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+      convex_init (twogobj, 1, &vb, &nvb, &pb, &npb, &sb, &nsb);
 
       swap (spair);
 
       ret = update_convex_sphere (vb, nvb, pb, npb, sb, nsb,
                                   a->cur_center, a->cur_radius, a->surface,
-                                  twopnt, onepnt, normal, gap, area, spair);
-
-      convex_done (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+                                  twopnt, onepnt, normal, gap, area, spair, vgr (twogobj), cache);
 
       return update_swap (ret, spair);
     }
@@ -1174,7 +1438,7 @@ static int update (
 
       return update_ellip_ellip (a->cur_center, a->cur_sca, a->cur_rot, a->surface,
                                  b->cur_center, b->cur_sca, b->cur_rot, b->surface,
-                                 onepnt, twopnt, normal, gap, area, spair);
+                                 onepnt, twopnt, normal, gap, area, spair, cache);
     }
     break;
     case AABB_ELEMENT_ELLIP:
@@ -1188,7 +1452,7 @@ static int update (
 
       return update_convex_ellip (va, nva, pa, npa, sa, nsa,
                                   b->cur_center, b->cur_sca, b->cur_rot, b->surface,
-                                  onepnt, twopnt, normal, gap, area, spair);
+                                  onepnt, twopnt, normal, gap, area, spair, NULL, cache);
     }
     break;
     case AABB_ELLIP_ELEMENT:
@@ -1205,7 +1469,7 @@ static int update (
 
       ret = update_convex_ellip (vb, nvb, pb, npb, sb, nsb,
                                  a->cur_center, a->cur_sca, a->cur_rot, a->surface,
-                                 twopnt, onepnt, normal, gap, area, spair);
+                                 twopnt, onepnt, normal, gap, area, spair, NULL, cache);
 
       return update_swap (ret, spair);
     }
@@ -1216,13 +1480,11 @@ static int update (
       ELLIP *b = twogobj;
       int nva, npa, *sa, nsa, ret;
 
-      convex_init (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+      convex_init (onegobj, 0, &va, &nva, &pa, &npa, &sa, &nsa);
 
       ret = update_convex_ellip (va, nva, pa, npa, sa, nsa,
                                  b->cur_center, b->cur_sca, b->cur_rot, b->surface,
-                                 onepnt, twopnt, normal, gap, area, spair);
-
-      convex_done (onegobj, &va, &nva, &pa, &npa, &sa, &nsa);
+                                 onepnt, twopnt, normal, gap, area, spair, vgr (onegobj), cache);
 
       return ret;
     }
@@ -1233,15 +1495,13 @@ static int update (
       double *vb, *pb;
       int nvb, npb, *sb, nsb, ret;
 
-      convex_init (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+      convex_init (twogobj, 1, &vb, &nvb, &pb, &npb, &sb, &nsb);
 
       swap (spair);
 
       ret = update_convex_ellip (vb, nvb, pb, npb, sb, nsb,
                                  a->cur_center, a->cur_sca, a->cur_rot, a->surface,
-                                 twopnt, onepnt, normal, gap, area, spair);
-
-      convex_done (twogobj, &vb, &nvb, &pb, &npb, &sb, &nsb);
+                                 twopnt, onepnt, normal, gap, area, spair, vgr (twogobj), cache);
 
       return update_swap (ret, spair);
     }
@@ -1253,7 +1513,7 @@ static int update (
 
       return update_sphere_ellip (a->cur_center, a->cur_radius, a->surface,
                                   b->cur_center, b->cur_sca, b->cur_rot, b->surface,
-                                  onepnt, twopnt, normal, gap, area, spair);
+                                  onepnt, twopnt, normal, gap, area, spair, cache);
     }
     break;
     case AABB_ELLIP_SPHERE:
@@ -1266,11 +1526,41 @@ static int update (
 
       ret = update_sphere_ellip (b->cur_center, b->cur_radius, b->surface,
                                  a->cur_center, a->cur_sca, a->cur_rot, a->surface,
-                                 twopnt, onepnt, normal, gap, area, spair);
+                                 twopnt, onepnt, normal, gap, area, spair, cache);
 
       return update_swap (ret, spair);
     }
     break;
+    case AABB_SDF_ELEMENT:
+    case AABB_SDF_CONVEX:
+    case AABB_SDF_SPHERE:
+    case AABB_SDF_ELLIP:
+    {
+      int old [2] = {spair [0], spair [1]}, ret;
+
+      ret = detect_sdf (onegobj, paircode & 0xff, twoshp, twogobj,
+                        onepnt, twopnt, normal, gap, area, spair);
+
+      return update_sdf (ret, old, spair);
+    }
+    break;
+    case AABB_ELEMENT_SDF:
+    case AABB_CONVEX_SDF:
+    case AABB_SPHERE_SDF:
+    case AABB_ELLIP_SDF:
+    {
+      int old [2], ret;
+
+      swap (spair);
+      old [0] = spair [0];
+      old [1] = spair [1];
+
+      ret = detect_sdf (twogobj, paircode >> 8, oneshp, onegobj,
+                        twopnt, onepnt, normal, gap, area, spair);
+
+      return update_swap (update_sdf (ret, old, spair), spair);
+    }
+    break;
   }
 
   return 0;
@@ -1288,6 +1578,7 @@ int gobjcontact (
     double *gap,
     double *area,
     int spair [2],
+    GJK_CACHE *cache,
     TRI **ptri, int *ntri)
 {
   if (ptri) *ptri = NULL;
@@ -1297,9 +1588,209 @@ int gobjcontact (
     return detect (paircode, oneshp, onegobj, twoshp,
       twogobj, onepnt, twopnt, normal, gap, area, spair, ptri, ntri);
   else return update (paircode, oneshp, onegobj, twoshp,
-    twogobj, onepnt, twopnt, normal, gap, area, spair, ptri, ntri);
+    twogobj, onepnt, twopnt, normal, gap, area, spair, cache, ptri, ntri);
+}
+
+
+/* vertices and vertex graph of an element or a convex */
+inline static double* polyhedron (short kind, SHAPE *shp, void *gobj, double *v, int *nv, int **g)
+{
+  if (kind == GOBJ_ELEMENT)
+  {
+    *nv = ELEMENT_Vertices (shp->data, gobj, v);
+    *g = NULL;
+    return v;
+  }
+  else
+  {
+    *nv = ((CONVEX*)gobj)->nver;
+    *g = vgr (gobj);
+    return ((CONVEX*)gobj)->cur;
+  }
+}
+
+/* test whether two objects are separated */
+int gobjseparated (short paircode, SHAPE *oneshp, void *onegobj, SHAPE *twoshp, void *twogobj, GJK_CACHE *cache)
+{
+  double va [24], vb [24], p [3], q [3], *a, *b;
+  int na, nb, *ga, *gb;
+
+  switch (paircode)
+  {
+    case AABB_ELEMENT_ELEMENT:
+    case AABB_ELEMENT_CONVEX:
+    case AABB_CONVEX_ELEMENT:
+    case AABB_CONVEX_CONVEX: break;
+    default: return 0;
+  }
+
+  a = polyhedron (paircode >> 8, oneshp, onegobj, va, &na, &ga);
+  b = polyhedron (paircode & 0xff, twoshp, twogobj, vb, &nb, &gb);
+
+  if (gjk_axis_separation (a, na, ga, b, nb, gb, cache) > GEOMETRIC_EPSILON) return 1;
+
+  if (gjk_warm (a, na, ga, b, nb, gb, cache, p, q) > GEOMETRIC_EPSILON) return 2;
+
+  return 0;
+}
+
+/* store bounding sphere of a curved object at position 'i' */
+inline static void bounding_sphere (short kind, void *gobj, double (*x) [GOBJ_BLOCKSIZE], int i)
+{
+  if (kind == GOBJ_SPHERE)
+  {
+    SPHERE *sph = gobj;
+
+    x [0][i] = sph->cur_center [0];
+    x [1][i] = sph->cur_center [1];
+    x [2][i] = sph->cur_center [2];
+    x [3][i] = sph->cur_radius;
+  }
+  else
+  {
+    ELLIP *eli = gobj;
+
+    x [0][i] = eli->cur_center [0];
+    x [1][i] = eli->cur_center [1];
+    x [2][i] = eli->cur_center [2];
+    x [3][i] = MAX (eli->cur_sca [0], MAX (eli->cur_sca [1], eli->cur_sca [2]));
+  }
+}
+
+/* append a pair to the batch */
+int gobjbatch_push (GOBJ_BATCH *batch, short paircode, void *onegobj, void *twogobj, void *onedata, void *twodata)
+{
+  GOBJ_BLOCK *b;
+  int i;
+
+  switch (paircode)
+  {
+    case AABB_SPHERE_SPHERE:
+    case AABB_SPHERE_ELLIP:
+    case AABB_ELLIP_SPHERE:
+    case AABB_ELLIP_ELLIP: break;
+    default: return 0;
+  }
+
+  if (batch->n == batch->size * GOBJ_BLOCKSIZE)
+  {
+    batch->size = (batch->size ? 2 * batch->size : 4);
+    ERRMEM (batch->block = realloc (batch->block, sizeof (GOBJ_BLOCK) * batch->size));
+  }
+
+  b = &batch->block [batch->n / GOBJ_BLOCKSIZE];
+  i = batch->n % GOBJ_BLOCKSIZE;
+  bounding_sphere (paircode >> 8, onegobj, b->x, i);
+  bounding_sphere (paircode & 0xff, twogobj, b->x + 4, i);
+  b->data [0][i] = onedata;
+  b->data [1][i] = twodata;
+  batch->n ++;
+
+  return 1;
+}
+
+/* bounding sphere proximity of batched pairs */
+void gobjbatch_proximity (GOBJ_BATCH *batch)
+{
+  double dx, dy, dz, e;
+  GOBJ_BLOCK *b;
+  int i, j, n;
+
+  for (j = 0; j < batch->n; j += GOBJ_BLOCKSIZE)
+  {
+    b = &batch->block [j / GOBJ_BLOCKSIZE];
+    n = MIN (batch->n - j, GOBJ_BLOCKSIZE);
+
+    for (i = 0; i < n; i ++) /* branch free => vectorizable */
+    {
+      dx = b->x [0][i] - b->x [4][i];
+      dy = b->x [1][i] - b->x [5][i];
+      dz = b->x [2][i] - b->x [6][i];
+      e = b->x [3][i] + b->x [7][i] + 2.0 * GEOMETRIC_EPSILON; /* the margin covers roundoff of the squared test */
+      b->state [i] = (dx*dx + dy*dy + dz*dz < e*e);
+    }
+  }
 }
 
+/* batched update of sphere pairs; arithmetic is the same as in
+ * gjk_sphere_sphere and update_sphere_sphere, but the branches
+ * are replaced by selections, so that the loop can be vectorized */
+void gobjbatch_spheres (GOBJ_BATCH *batch)
+{
+  double dx, dy, dz, dlen, ka, kb, deno, dist, len, dot,
+	 p0, p1, p2, q0, q1, q2, m0, m1, m2, n0, n1, n2,
+	 (*x) [GOBJ_BLOCKSIZE], (*y) [GOBJ_BLOCKSIZE];
+  int i, j, n, apart, zero;
+  GOBJ_BLOCK *b;
+
+  for (j = 0; j < batch->n; j += GOBJ_BLOCKSIZE)
+  {
+    b = &batch->block [j / GOBJ_BLOCKSIZE];
+    n = MIN (batch->n - j, GOBJ_BLOCKSIZE);
+    x = b->x;
+    y = b->y;
+
+    for (i = 0; i < n; i ++)
+    {
+      /* closest points (gjk_sphere_sphere) */
+      dx = x [0][i] - x [4][i];
+      dy = x [1][i] - x [5][i];
+      dz = x [2][i] - x [6][i];
+      deno = x [3][i] + x [7][i];
+      dlen = sqrt (dx*dx + dy*dy + dz*dz);
+      zero = dlen == 0.0;
+      apart = dlen > deno;
+      ka = x [3][i] / dlen;
+      kb = x [7][i] / dlen;
+      p0 = x [0][i] - ka*dx;
+      p1 = x [1][i] - ka*dy;
+      p2 = x [2][i] - ka*dz;
+      q0 = x [4][i] + kb*dx;
+      q1 = x [5][i] + kb*dy;
+      q2 = x [6][i] + kb*dz;
+      m0 = .5*(p0 + q0);
+      m1 = .5*(p1 + q1);
+      m2 = .5*(p2 + q2);
+      p0 = zero ? x [0][i] : (apart ? p0 : m0);
+      p1 = zero ? x [1][i] : (apart ? p1 : m1);
+      p2 = zero ? x [2][i] : (apart ? p2 : m2);
+      q0 = zero ? x [4][i] : (apart ? q0 : m0);
+      q1 = zero ? x [5][i] : (apart ? q1 : m1);
+      q2 = zero ? x [6][i] : (apart ? q2 : m2);
+      dist = apart ? dlen - deno : 0.0;
+
+      /* normal and gap (update_sphere_sphere) */
+      n0 = p0 - x [0][i];
+      n1 = p1 - x [1][i];
+      n2 = p2 - x [2][i];
+      len = sqrt (n0*n0 + n1*n1 + n2*n2);
+      n0 /= len;
+      n1 /= len;
+      n2 /= len;
+      dot = (x [4][i] - x [0][i])*n0 + (x [5][i] - x [1][i])*n1 + (x [6][i] - x [2][i])*n2;
+
+      y [0][i] = (deno > dot ? dot - deno : 0);
+      y [1][i] = p0;
+      y [2][i] = p1;
+      y [3][i] = p2;
+      y [4][i] = q0;
+      y [5][i] = q1;
+      y [6][i] = q2;
+      y [7][i] = n0;
+      y [8][i] = n1;
+      y [9][i] = n2;
+      b->state [i] = dist < GEOMETRIC_EPSILON;
+    }
+  }
+}
+
+/* free batch memory */
+void gobjbatch_free (GOBJ_BATCH *batch)
+{
+  free (batch->block);
+  batch->block = NULL;
+  batch->n = batch->size = 0;
+}
 
 /* get distance between two objects (output closest point pair in p, q) */
 double gobjdistance (short paircode, SGP *one, SGP *two, double *p, double *q)
@@ -1430,6 +1921,44 @@ double gobjdistance (short paircode, SGP *one, SGP *two, double *p, double *q)
       ASSERT (0, ERR_NOT_IMPLEMENTED); /* TODO */
     }
     break;
+    case AABB_SDF_SPHERE:
+    {
+      SDF *a = one->gobj;
+      SPHERE *b = two->gobj;
+      double n [3], d;
+
+      d = SDF_Distance (a, b->cur_center, n);
+      NORMALIZE (n);
+      ADDMUL (b->cur_center, -d, n, p);
+      ADDMUL (b->cur_center, -b->cur_radius, n, q);
+
+      return d - b->cur_radius;
+    }
+    break;
+    case AABB_SPHERE_SDF:
+    {
+      SPHERE *a = one->gobj;
+      SDF *b = two->gobj;
+      double n [3], d;
+
+      d = SDF_Distance (b, a->cur_center, n);
+      NORMALIZE (n);
+      ADDMUL (a->cur_center, -d, n, q);
+      ADDMUL (a->cur_center, -a->cur_radius, n, p);
+
+      return d - a->cur_radius;
+    }
+    break;
+    case AABB_SDF_ELEMENT:
+    case AABB_ELEMENT_SDF:
+    case AABB_SDF_CONVEX:
+    case AABB_CONVEX_SDF:
+    case AABB_SDF_ELLIP:
+    case AABB_ELLIP_SDF:
+    {
+      ASSERT (0, ERR_NOT_IMPLEMENTED); /* TODO */
+    }
+    break;
   }
 
   return 0;
@@ -20,6 +20,7 @@
  * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
 
 #include "shp.h"
+#include "gjk.h"
 
 #ifndef __goc__
 #define __goc__
@@ -57,7 +58,54 @@ int gobjcontact (
     double *gap, /* gap between objects */
     double *area, /* area of contact */
     int spair [2], /* surface pair codes */
-    TRI **ptri, int *ntri); /* contact surface */
+    GJK_CACHE *cache, /* warm start data of the object pair used in CONTACT_UPDATE mode (or NULL) */
+    TRI **ptri, int *ntri); /* contact surface (or NULL); it belongs to a per-thread workspace
+			       and stays valid until the next call in the same thread */
+
+/* cheap rejection test run before CONTACT_DETECT: returns 1 if polyhedral objects (elements, convices)
+ * are separated along the axis cached from an earlier call, 2 if they are separated according to a warm
+ * started GJK distance query (which refreshes the cached axis), and 0 if they may intersect (or are curved) */
+int gobjseparated (short paircode, SHAPE *oneshp, void *onegobj, SHAPE *twoshp, void *twogobj, GJK_CACHE *cache);
+
+#define GOBJ_BLOCKSIZE 64 /* number of pairs in a batch block */
+
+/* structure-of-arrays block of curved object pairs (spheres, ellipsoids); the
+ * fixed size arrays do not alias each other, which allows to vectorize the loops */
+typedef struct gobj_block GOBJ_BLOCK;
+
+struct gobj_block
+{
+  double x [8][GOBJ_BLOCKSIZE]; /* bounding sphere centers (x [0..2]) and radii (x [3]) of the first objects; x [4..7] of the second ones */
+  double y [10][GOBJ_BLOCKSIZE]; /* outputs: gap (y [0]), first point (y [1..3]), second point (y [4..6]), normal (y [7..9]) */
+  double state [GOBJ_BLOCKSIZE]; /* output pair states (1.0 or 0.0) */
+  void *data [2][GOBJ_BLOCKSIZE]; /* two user pointers per pair */
+};
+
+/* batch of curved object pairs; pair 'i' is stored at position i % GOBJ_BLOCKSIZE of block [i / GOBJ_BLOCKSIZE] */
+typedef struct gobj_batch GOBJ_BATCH;
+
+struct gobj_batch
+{
+  GOBJ_BLOCK *block; /* blocks */
+  int n, /* number of pairs */
+      size; /* number of allocated blocks */
+};
+
+/* append a pair of curved objects to the batch together with two user pointers;
+ * return 0 and ignore the pair if the pair code is not supported by batches */
+int gobjbatch_push (GOBJ_BATCH *batch, short paircode, void *onegobj, void *twogobj, void *onedata, void *twodata);
+
+/* set the state of pairs to 1.0 for pairs whose bounding spheres are not clearly separated by
+ * more than GEOMETRIC_EPSILON (and to 0 otherwise); this is a conservative filter before the
+ * CONTACT_DETECT call, which for sphere pairs rejects all, but nearly touching, non-contacts */
+void gobjbatch_proximity (GOBJ_BATCH *batch);
+
+/* CONTACT_UPDATE of a batch of sphere pairs: pair states are set as returned by gobjcontact
+ * and the outputs (gap, points, normal outward to the first sphere) are written into the 'y' arrays */
+void gobjbatch_spheres (GOBJ_BATCH *batch);
+
+/* free batch memory */
+void gobjbatch_free (GOBJ_BATCH *batch);
 
 /* get distance between two objects (output closest point pair in p, q) */
 double gobjdistance (short paircode, SGP *one, SGP *two, double *p, double *q);
@@ -22,6 +22,7 @@
  * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
 
 #include <stdlib.h>
+#include <string.h>
 #include <float.h>
 #include "mem.h"
 #include "err.h"
@@ -29,8 +30,15 @@
 #include "lis.h"
 #include "set.h"
 #include "hul.h"
+#include "thr.h"
 #include "ext/predicates.h"
 
+/* point sets larger than this are culled and split into chunks whose hulls are computed concurrently */
+#define SPLIT 4096
+
+/* number of directions along which extreme points are used for culling */
+#define NDIR 14
+
 typedef struct vertex vertex;
 typedef struct edge edge;
 typedef struct face face;
@@ -53,7 +61,8 @@ struct face
   double pla [4];
   vertex *v, *w; /* list of facial vertices 'v' and the furthest vertex 'w' */
   edge *e; /* list of edges (and implicitly, the list of neighbours */
-  face *n; /* next face in a list */
+  face *n, *p; /* next and previous face in a list */
+  face *m; /* next marked face */
   char marked; /* marker used for visible faces */
   TRI *tri; /* auxiliary adjacent triangle (used to create the output table) */
 };
@@ -235,23 +244,20 @@ static int vcmp (double **a, double **b)
 }
 
 /* select vertices of an initial simplex and output the list of remaining vertices */
-static int simplex_vertices (double *v, int n, MEM *mv, double *sv [4], vertex **out)
+static int simplex_vertices (double *v, int n, double **pv, MEM *mv, MEM *setmem, double *sv [4], vertex **out)
 {
-  double **pv, **pp, **pq, **pe, **pn;
+  double **pp, **pq, **pe, **pn;
   double d, a[3], b[3], c[3], u[3];
   SET *points, *item;
-  MEM setmem;
   vertex *x;
   int i, j;
 
-  ERRMEM (pv = MEM_CALLOC (sizeof (double*) * n));
-  MEM_Init (&setmem, sizeof (SET), n);
   points = NULL;
   *out = NULL;
 
   for (pp = pv, pe = pv+n; pp < pe; pp ++, v += 3)
   {
-    SET_Insert (&setmem, &points, v, NULL); /* set of all input points */
+    SET_Insert (setmem, &points, v, NULL); /* set of all input points */
     *pp = v; /* vector of pointers to all input points */
   }
 
@@ -272,7 +278,7 @@ static int simplex_vertices (double *v, int n, MEM *mv, double *sv [4], vertex *
 
       if (i == 3) /* if it overlaps along all three directions */
       {
-	SET_Delete (&setmem, &points, *pq, NULL); /* remove it from the input set */
+	SET_Delete (setmem, &points, *pq, NULL); /* remove it from the input set */
       }
       else if (pn == pe) pn = pq; /* first non-overlaping point */
     }
@@ -319,19 +325,14 @@ static int simplex_vertices (double *v, int n, MEM *mv, double *sv [4], vertex *
       }
       
       sv [j++] = *pp; /* add vertex to initial simplex */
-      SET_Delete (&setmem, &points, *pp, NULL); /* remove it from the point set */
+      SET_Delete (setmem, &points, *pp, NULL); /* remove it from the point set */
     }
   }
 
 #if GEOMDEBUG
   ASSERT_DEBUG (j == 4, "All input points coincide");
 #else
-  if (j != 4)
-  {
-    MEM_Release (&setmem);
-    free (pv);
-    return 0;
-  }
+  if (j != 4) return 0;
 #endif
 
   for (item = SET_First (points); item; item = SET_Next (item)) /* for each remaining point */
@@ -342,8 +343,6 @@ static int simplex_vertices (double *v, int n, MEM *mv, double *sv [4], vertex *
     *out = x; /* put into the output list */
   }
 
-  MEM_Release (&setmem);
-  free (pv);
   return 1;
 }
 
@@ -465,19 +464,52 @@ static face* simplex (MEM *me, MEM *mf, double *a, double *b, double *c, double
   return f [0];
 }
 
-/* mark faces visible from 'v'ertex */
-static void mark (face *f, double *v, face **g)
+/* mark faces visible from 'v'ertex and collect them into the 'marked' list */
+static void mark (face *f, double *v, face **g, face **marked)
 {
   double d = orient (f, v);
     
   if (!f->marked && d > 0.0)
   {
     f->marked = 1;
-    for (edge *e = f->e; e; e = e->n) mark (e->f, v, g);
+    f->m = *marked;
+    *marked = f;
+    for (edge *e = f->e; e; e = e->n) mark (e->f, v, g, marked);
   }
   else if (d <= 0.0) *g = f;
 }
 
+/* remove a face from the doubly linked list (h, t) */
+inline static void unlink_face (face *f, face **h, face **t)
+{
+  if (f->p) f->p->n = f->n;
+  else *h = f->n;
+  if (f->n) f->n->p = f->p;
+  else *t = f->p;
+}
+
+/* insert a face into the doubly linked list (h, t); faces with nonempty
+ * outside sets go to the front, so that the list head is processed next */
+inline static void insert_face (face *f, face **h, face **t)
+{
+  if (f->w)
+  {
+    f->p = NULL;
+    f->n = *h;
+    if (*h) (*h)->p = f;
+    else *t = f;
+    *h = f;
+  }
+  else
+  {
+    f->n = NULL;
+    f->p = *t;
+    if (*t) (*t)->n = f;
+    else *h = f;
+    *t = f;
+  }
+}
+
 /* return next CCW face after f around vertx v */
 inline static face* nextaround (face *f, double *v)
 {
@@ -551,26 +583,257 @@ static int testsimplex (face *h)
   return 1;
 }
 
+/* compute hull using a temporary workspace */
+static TRI* serial (double *v, int n, int *m)
+{
+  HULL_WORKSPACE work;
+  TRI *tri;
+
+  hull_workspace_init (&work);
+
+  if ((tri = hull_work (&work, v, n, m))) work.tri = NULL; /* hand the output over */
+
+  hull_workspace_release (&work);
+
+  return tri;
+}
+
+/* copy into 'w' points of 'v' that are not deeply inside of the hull of extreme points; output
+ * their indices into 'idx' and return their number; the plane tests use floating point arithmetic
+ * and a margin, so that only points which cannot be hull vertices are dropped; the loops over
+ * the short plane arrays vectorize; exact predicates are used in the subsequent hull computation */
+static int cull (double *v, int n, double *w, int *idx)
+{
+  static const double dir [NDIR][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+    {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {1, -1, -1}, {-1, 1, 1}, {-1, 1, -1}, {-1, -1, 1}, {-1, -1, -1}};
+  double ext [NDIR][3], dmax [NDIR], nx [2*NDIR], ny [2*NDIR], nz [2*NDIR], nd [2*NDIR], tol [2*NDIR],
+	 center [3], size, len, d, *p;
+  HULL_WORKSPACE work;
+  int i, j, k, m, out;
+  TRI *tri, *t;
+
+  for (j = 0; j < NDIR; j ++) dmax [j] = -DBL_MAX;
+
+  for (i = 0, p = v; i < n; i ++, p += 3) /* extreme points */
+  {
+    for (j = 0; j < NDIR; j ++)
+    {
+      d = DOT (dir [j], p);
+      if (d > dmax [j]) { dmax [j] = d; COPY (p, ext [j]); }
+    }
+  }
+
+  SET (center, 0.0);
+  for (j = 0, size = 0.0; j < NDIR; j ++)
+  {
+    ADD (center, ext [j], center);
+    for (k = 0; k < 3; k ++) size = MAX (size, fabs (ext [j][k]));
+  }
+  DIV (center, (double) NDIR, center);
+
+  hull_workspace_init (&work);
+
+  if ((tri = hull_work (&work, (double*)ext, NDIR, &m)))
+  {
+    for (t = tri, j = 0; j < m; t ++, j ++) /* outward planes */
+    {
+      len = LEN (t->out);
+      if (len == 0.0) { m = 0; break; } /* degenerate face: no culling */
+      d = - DOT (t->out, t->ver [0]);
+      if (DOT (t->out, center) + d > 0.0) len = -len; /* make sure the normal is outward */
+      nx [j] = t->out [0] / len;
+      ny [j] = t->out [1] / len;
+      nz [j] = t->out [2] / len;
+      nd [j] = d / len;
+      tol [j] = -10.0 * GEOMETRIC_EPSILON - 1E3 * DBL_EPSILON * size;
+    }
+  }
+  else m = 0; /* degenerate extreme points: no culling */
+
+  hull_workspace_release (&work);
+
+  for (i = k = 0, p = v; i < n; i ++, p += 3)
+  {
+    for (j = 0, out = (m == 0); j < m; j ++) out |= (nx [j]*p[0] + ny [j]*p[1] + nz [j]*p[2] + nd [j] > tol [j]);
+
+    if (out)
+    {
+      COPY (p, w + 3*k);
+      idx [k ++] = i;
+    }
+  }
+
+  return k;
+}
+
+typedef struct chunk_data CHUNK_DATA;
+
+/* hulls of point set chunks */
+struct chunk_data
+{
+  double *w; /* points */
+
+  int n; /* number of points */
+
+  char *used; /* marks points used as vertices of chunk hulls */
+};
+
+/* compute hull of the i-th chunk and mark its vertices */
+static void chunk_job (CHUNK_DATA *data, int i)
+{
+  double *w = data->w + 3*i*SPLIT;
+  int j, k, m, n = MIN (SPLIT, data->n - i*SPLIT);
+  char *used = data->used;
+  TRI *tri, *t;
+
+  if ((tri = serial (w, n, &m)))
+  {
+    for (t = tri, j = 0; j < m; t ++, j ++)
+      for (k = 0; k < 3; k ++) used [(t->ver [k] - data->w) / 3] = 1;
+
+    free (tri);
+  }
+  else for (j = 0; j < n; j ++) used [i*SPLIT + j] = 1; /* degenerate chunk: keep all of its points */
+}
+
+/* divide and conquer hull of a large point set: interior points are culled first; the remaining points are split
+ * into chunks whose hulls are computed concurrently; the final hull is computed from vertices of the chunk hulls */
+static TRI* split (double *v, int n, int *m)
+{
+  CHUNK_DATA data;
+  int i, j, k, *idx;
+  double *w;
+  TRI *tri;
+
+  ERRMEM (w = malloc (sizeof (double [3]) * n));
+  ERRMEM (idx = malloc (sizeof (int) * n));
+
+  k = cull (v, n, w, idx);
+
+  if (k > SPLIT)
+  {
+    data.w = w;
+    data.n = k;
+    ERRMEM (data.used = calloc (k, 1));
+
+    THREAD_Loop ((k + SPLIT - 1) / SPLIT, (THREAD_Job) chunk_job, &data);
+
+    for (i = j = 0; i < k; i ++)
+    {
+      if (data.used [i])
+      {
+	COPY (w + 3*i, w + 3*j);
+	idx [j ++] = idx [i];
+      }
+    }
+
+    k = j;
+    free (data.used);
+  }
+
+  if ((tri = serial (w, k, m)))
+  {
+    for (i = 0; i < *m; i ++)
+      for (j = 0; j < 3; j ++) tri [i].ver [j] = v + 3 * idx [(tri [i].ver [j] - w) / 3]; /* point to the input memory */
+  }
+
+  free (idx);
+  free (w);
+
+  return tri;
+}
+
 /* compute convex hull */
 TRI* hull (double *v, int n, int *m)
 {
-  face *f, *g, *h, *head, *cur, *tail;
+  if (n > SPLIT) return split (v, n, m);
+  else return serial (v, n, m);
+}
+
+typedef struct batch_data BATCH_DATA;
+
+/* batch of point sets */
+struct batch_data
+{
+  double **v;
+
+  int *n;
+
+  TRI **tri;
+
+  int *m;
+};
+
+/* compute the i-th hull of a batch */
+static void batch_job (BATCH_DATA *data, int i)
+{
+  data->tri [i] = hull (data->v [i], data->n [i], &data->m [i]);
+}
+
+/* compute convex hulls of many point sets concurrently */
+void hull_batch (int count, double **v, int *n, TRI **tri, int *m)
+{
+  BATCH_DATA data = {v, n, tri, m};
+
+  THREAD_Loop (count, (THREAD_Job) batch_job, &data);
+}
+
+/* initialize an empty workspace */
+void hull_workspace_init (HULL_WORKSPACE *work)
+{
+  work->pv = NULL;
+  work->tri = NULL;
+  work->size = work->trisize = 0;
+}
+
+/* release workspace memory */
+void hull_workspace_release (HULL_WORKSPACE *work)
+{
+  if (work->size)
+  {
+    MEM_Release (&work->mv);
+    MEM_Release (&work->me);
+    MEM_Release (&work->mf);
+    MEM_Release (&work->setmem);
+  }
+
+  free (work->pv);
+  free (work->tri);
+
+  hull_workspace_init (work);
+}
+
+/* compute convex hull using workspace memory */
+TRI* hull_work (HULL_WORKSPACE *work, double *v, int n, int *m)
+{
+  face *f, *g, *h, *t, *head, *cur, *tail, *marked;
   edge *e, *k, *i, *j, *ehead, *etail;
   double d, dmax, *sv [4];
   vertex *x, *y, *z, *l;
-  MEM mv, me, mf;
-  TRI *tri, *t;
+  MEM *mv, *me, *mf;
+  TRI *tri, *r;
 
-  MEM_Init (&mv, sizeof (vertex), n);
-  MEM_Init (&me, sizeof (edge), n);
-  MEM_Init (&mf, sizeof (face), n);
+  if (n > work->size || !work->size) /* grow */
+  {
+    hull_workspace_release (work);
+    work->size = n;
+    ERRMEM (work->pv = malloc (sizeof (double*) * n));
+    MEM_Init (&work->mv, sizeof (vertex), n);
+    MEM_Init (&work->me, sizeof (edge), n);
+    MEM_Init (&work->mf, sizeof (face), n);
+    MEM_Init (&work->setmem, sizeof (SET), n);
+  }
+
+  mv = &work->mv;
+  me = &work->me;
+  mf = &work->mf;
   tri = NULL;
 
   /* select vertices of an initial simplex into 'sv' */
-  if (!simplex_vertices (v, n, &mv, sv, &l)) goto error;
+  if (!simplex_vertices (v, n, work->pv, mv, &work->setmem, sv, &l)) goto error;
  
   /* create the initial simplex */ 
-  if (!(h = simplex (&me, &mf, sv[0], sv[1], sv[2], sv[3]))) goto error;
+  if (!(h = simplex (me, mf, sv[0], sv[1], sv[2], sv[3]))) goto error;
 
   if (!(testsimplex (h))) goto error;
 
@@ -602,11 +865,18 @@ TRI* hull (double *v, int n, int *m)
     }
   }
 
-  for (f = h; f && (!f->w); f = f->n); /* find first face with a nonempty vertex list */
-  while (f)
+  /* faces with nonempty vertex lists go first */
+  for (f = h, h = t = NULL; f; f = g)
+  {
+    g = f->n;
+    insert_face (f, &h, &t);
+  }
+
+  for (f = h; f && f->w; f = h) /* the list head is the next face with nonempty vertex list (if any) */
   {
     /* mark visible faces */
-    mark (f, f->w->v, &g);
+    marked = NULL;
+    mark (f, f->w->v, &g, &marked);
 
     /* loop over the ridge edges */
     if (!g || !(k = e = nextonridge (n, g->e, NULL))) goto error;
@@ -615,18 +885,18 @@ TRI* hull (double *v, int n, int *m)
     do
     {
       /* create new face */
-      ERRMEM (cur = MEM_Alloc (&mf));
+      ERRMEM (cur = MEM_Alloc (mf));
       if (!tail) tail = cur; /* record last face */
-      ERRMEM (i = MEM_Alloc (&me));
+      ERRMEM (i = MEM_Alloc (me));
       i->v [0] = e->v [1]; /* first new edge is adjacent to 'e' => reversed */
       i->v [1] = e->v [0];
       i->f = g; /* first new edge is the neighbour of 'g' */
       cur->e = i; /* include the edge into the new face's edge list */
-      ERRMEM (j = MEM_Alloc (&me));
+      ERRMEM (j = MEM_Alloc (me));
       j->v [0] = f->w->v; /* this is the top vertes */
       j->v [1] = e->v [1];
       j->n = cur->e; cur->e = j; /* maintain edge list */
-      ERRMEM (i = MEM_Alloc (&me));
+      ERRMEM (i = MEM_Alloc (me));
       i->v [0] = e->v [0];
       i->v [1] = f->w->v; /* top vertex */
       i->n = cur->e; cur->e = i; /* maintain edge list */
@@ -649,7 +919,7 @@ TRI* hull (double *v, int n, int *m)
     etail->f = head;
 
     /* free top vertex */
-    MEM_Free (&mv, f->w);
+    MEM_Free (mv, f->w);
     f->w = NULL;
 
     /* for each new face */
@@ -662,118 +932,116 @@ TRI* hull (double *v, int n, int *m)
     }
 
     /* for each marked face f */
-    for (f = h; f; f = f->n)
+    for (f = marked; f; f = f->m)
     {
-      if (f->marked)
-      {
-	if (f->w)
-	{ f->w->n = f->v; /* put the furthest vertex 'w' back into the 'v' list */
-	  f->v = f->w; }
+      if (f->w)
+      { f->w->n = f->v; /* put the furthest vertex 'w' back into the 'v' list */
+	f->v = f->w; }
 
-	if (f->v)
+      if (f->v)
+      {
+	/* for each new face g */
+	for (g = head; g; g = g->n)
 	{
-	  /* for each new face g */
-	  for (g = head; g; g = g->n)
+	  /* for each v in f->v */
+	  for (dmax = 0.0, l = NULL, x = f->v; x; x = y)
 	  {
-	    /* for each v in f->v */
-	    for (dmax = 0.0, l = NULL, x = f->v; x; x = y)
-	    {
-	      y = x->n;
+	    y = x->n;
 
-	      d = orient (g, x->v);
-	      if (d > 0.0) /* x is above g->pla */
+	    d = orient (g, x->v);
+	    if (d > 0.0) /* x is above g->pla */
+	    {
+	      if (d > dmax) /* and is maximal */
 	      {
-		if (d > dmax) /* and is maximal */
-		{
-		  if (g->w)
-		  { g->w->n = g->v;
-		    g->v = g->w; } /* move to the regular list */
-		  g->w = x; /* set as maximal */
-		}
-		else /* insert into the regular list */
-		{ x->n = g->v;
-		  g->v = x; }
-
-		if (l) l->n = y; /* x is removed from f->v */
-		else f->v = y;
+		if (g->w)
+		{ g->w->n = g->v;
+		  g->v = g->w; } /* move to the regular list */
+		g->w = x; /* set as maximal */
 	      }
-	      else l = x; /* last not moved vertex */
+	      else /* insert into the regular list */
+	      { x->n = g->v;
+		g->v = x; }
+
+	      if (l) l->n = y; /* x is removed from f->v */
+	      else f->v = y;
 	    }
+	    else l = x; /* last not moved vertex */
 	  }
 	}
       }
     }
 
     /* for each marked face f */
-    for (f = h, h = NULL; f; f = g)
+    for (f = marked; f; f = g)
     {
-      g = f->n;
-      if (f->marked)
-      {
-        /* delete all v in f->v */
-	for (x = f->v; x; x = y)
-	{ y = x->n; MEM_Free (&mv, x); }
+      g = f->m;
 
-        /* delete all e in f->e */
-	for (e = f->e; e; e = i)
-	{ i = e->n; MEM_Free (&me, e); }
+      /* delete all v in f->v */
+      for (x = f->v; x; x = y)
+      { y = x->n; MEM_Free (mv, x); }
 
-        /* delete f */
-	MEM_Free (&mf, f);
-      }
-      else /* output unmarked faces */
-      {
-	f->n = h;
-	h = f;
-      }
+      /* delete all e in f->e */
+      for (e = f->e; e; e = i)
+      { i = e->n; MEM_Free (me, e); }
+
+      /* delete f */
+      unlink_face (f, &h, &t);
+      MEM_Free (mf, f);
     }
 
-    /* append h with
-     * the new faces */
-    tail->n = h;
-    h = head;
-   
-    /* select next face with nonempty vertex list */ 
-    for (f = h; f && (!f->w); f = f->n);
+    /* insert the new faces so that they are processed in the list order */
+    for (f = head, g = NULL; f; f = f->n) { f->m = g; g = f; }
+    for (f = g; f; f = g)
+    {
+      g = f->m;
+      insert_face (f, &h, &t);
+    }
   }
 
   /* h contains faces of the convex hull;
    * it be now translated into a table TRI[] */
 
   for ((*m) = 0, f = h; f; f = f->n) (*m) ++; /* count output faces */
-  ERRMEM (tri = MEM_CALLOC ((*m) * sizeof (TRI))); /* output memory (faces are triangular) */
-  for (t = tri, f = h; f; f = f->n, t ++) /* translate each face into a triangle */
+  if ((*m) > work->trisize) /* output memory (faces are triangular) */
+  {
+    free (work->tri);
+    work->trisize = 2 * (*m);
+    ERRMEM (work->tri = malloc (work->trisize * sizeof (TRI)));
+  }
+  tri = work->tri;
+  memset (tri, 0, (*m) * sizeof (TRI));
+  for (r = tri, f = h; f; f = f->n, r ++) /* translate each face into a triangle */
   {
     e = f->e; k = e->n; i = k->n;
-    COPY (f->pla, t->out); /* same normal */
-    t->ver [0] = e->v [0]; /* CCW ordered vertices */
-    t->ver [1] = k->v [0];
-    t->ver [2] = i->v [0];
+    COPY (f->pla, r->out); /* same normal */
+    r->ver [0] = e->v [0]; /* CCW ordered vertices */
+    r->ver [1] = k->v [0];
+    r->ver [2] = i->v [0];
 #if GEOMDEBUG
-    if (e->f->tri) { ASSERT_DEBUG (TRI_Addadj (e->f->tri, t), "Too many triangle neighbours"); } /* called only once for each pair => after (***) ... */
-    if (k->f->tri) { ASSERT_DEBUG (TRI_Addadj (k->f->tri, t), "Too many triangle neighbours"); }
-    if (i->f->tri) { ASSERT_DEBUG (TRI_Addadj (i->f->tri, t), "Too many triangle neighbours"); }
+    if (e->f->tri) { ASSERT_DEBUG (TRI_Addadj (e->f->tri, r), "Too many triangle neighbours"); } /* called only once for each pair => after (***) ... */
+    if (k->f->tri) { ASSERT_DEBUG (TRI_Addadj (k->f->tri, r), "Too many triangle neighbours"); }
+    if (i->f->tri) { ASSERT_DEBUG (TRI_Addadj (i->f->tri, r), "Too many triangle neighbours"); }
 #else
-    if (e->f->tri) if (!TRI_Addadj (e->f->tri, t)) goto error; /* called only once for each pair => after (***) ... */
-    if (k->f->tri) if (!TRI_Addadj (k->f->tri, t)) goto error;
-    if (i->f->tri) if (!TRI_Addadj (i->f->tri, t)) goto error;
+    if (e->f->tri) if (!TRI_Addadj (e->f->tri, r)) goto error; /* called only once for each pair => after (***) ... */
+    if (k->f->tri) if (!TRI_Addadj (k->f->tri, r)) goto error;
+    if (i->f->tri) if (!TRI_Addadj (i->f->tri, r)) goto error;
 #endif
-    f->tri = t; /* ... (***) has been executed for the first of neighbours */
+    f->tri = r; /* ... (***) has been executed for the first of neighbours */
   }
 
-  for (t --; t >= tri; t --) TRI_Sortadj (t); /* sort adjacency lists */
+  for (r --; r >= tri; r --) TRI_Sortadj (r); /* sort adjacency lists */
   
   goto done; /* skip error handling */
 
 error:
- if (tri) free (tri); 
  tri = NULL;
 
 done:
   /* clean up */
-  MEM_Release (&mv);
-  MEM_Release (&me);
-  MEM_Release (&mf);
+  MEM_Reset (mv);
+  MEM_Reset (me);
+  MEM_Reset (mf);
+  MEM_Reset (&work->setmem);
 
   return tri;
 }
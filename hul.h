@@ -21,6 +21,7 @@
  * You should have received a copy of the GNU Lesser General Public
  * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
 
+#include "mem.h"
 #include "tri.h"
 
 #ifndef __hul__
@@ -32,4 +33,33 @@
  * reasons; throw memory exception when out of memory */
 TRI* hull (double *v, int n, int *m);
 
+/* compute convex hulls of 'count' point sets 'v [i]' of sizes 'n [i]' concurrently; output tables of
+ * sizes 'm [i]' are returned in 'tri [i]', or NULL where hull creation failed; errors are re-thrown */
+void hull_batch (int count, double **v, int *n, TRI **tri, int *m);
+
+typedef struct hull_workspace HULL_WORKSPACE;
+
+/* memory of the hull routine kept between calls */
+struct hull_workspace
+{
+  MEM mv, me, mf, setmem; /* vertex, edge, face and point set pools */
+
+  double **pv; /* sorted input points */
+
+  TRI *tri; /* output triangles */
+
+  int size, /* number of points 'pv' can hold */
+      trisize; /* number of triangles 'tri' can hold */
+};
+
+/* initialize an empty workspace */
+void hull_workspace_init (HULL_WORKSPACE *work);
+
+/* release workspace memory */
+void hull_workspace_release (HULL_WORKSPACE *work);
+
+/* as hull (v, n, m), but reusing the workspace memory, so that repeated calls of similar
+ * size do not allocate; the returned table belongs to 'work' and is valid until the next call */
+TRI* hull_work (HULL_WORKSPACE *work, double *v, int n, int *m);
+
 #endif
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+CPUS="2 3 4"
+
+echo -n "(processors: "
+
+FAILED=""
+for NCPU in $CPUS; do
+  if [ $NCPU -lt "4" ]; then echo -n $NCPU", "
+  else echo -n $NCPU") "
+  fi
+  rm -f ./out/tests/ghost-queries/ghost-queries-*
+  mpirun -np $NCPU solfec-mpi ./inp/tests/ghost-queries.py
+  # every (time, body) pair must be answered identically by all processors that answer it
+  D=`cat ./out/tests/ghost-queries/ghost-queries-* | sort -u | awk '{print $1, $2}' | uniq -d`
+  FAILED="$FAILED$D"
+done
+
+if [ -n "$FAILED" ]; then
+  echo "FAILED"
+else
+  echo "PASSED"
+fi
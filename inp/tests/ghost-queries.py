@@ -0,0 +1,45 @@
+# falling chain: body queries served by owners and ghost copies should agree
+
+import os
+
+step = 0.001
+solfec = SOLFEC ('DYNAMIC', step, 'out/tests/ghost-queries')
+solfec.verbose = 'OFF'
+SURFACE_MATERIAL (solfec, model = 'SIGNORINI_COULOMB', friction = 0.3)
+bulk = BULK_MATERIAL (solfec, 'KIRCHHOFF', young = 15E9, poisson = 0.25, density = 1.8E3)
+GRAVITY (solfec, (0, 0, -10))
+gs = GAUSS_SEIDEL_SOLVER (1E-8, 1000)
+
+def box (x0, y0, z0, x1, y1, z1):
+  return HULL ([x0, y0, z0, x1, y0, z0, x1, y1, z0, x0, y1, z0,
+                x0, y0, z1, x1, y0, z1, x1, y1, z1, x0, y1, z1], 1, 1)
+
+BODY (solfec, 'OBSTACLE', box (-1, -1, -1, 9, 1, 0), bulk)
+
+bods = []
+for i in range (12):
+  bods.append (BODY (solfec, 'RIGID', SPHERE ((0.5*i, 0, 0.6), 0.2, 1, 1), bulk))
+for i in range (11):
+  PUT_RIGID_LINK (bods [i], bods [i+1], (0.5*i, 0, 0.6), (0.5*(i+1), 0, 0.6))
+FIX_POINT (bods [0], (0, 0, 0.6))
+
+if solfec.mode == 'READ': print '\nPrevious test results exist. Please "make del" and rerun tests'
+else:
+  out = open ('out/tests/ghost-queries/ghost-queries-%d' % RANK (), 'w')
+
+  # print everything this processor can answer: the owner and ghost answers are compared afterwards
+  def record (label):
+    for b in bods:
+      c = b.conf
+      v = b.velo
+      if c != None and v != None:
+	out.write ('%s %d %s %s\n' % (label, b.id, ' '.join (['%.15e' % x for x in c]), ' '.join (['%.15e' % x for x in v])))
+
+  def callback_function (solfec):
+    record ('%.3f' % solfec.time)
+    return 1
+
+  CALLBACK (solfec, 0.01, solfec, callback_function)
+  RUN (solfec, gs, 0.05)
+  record ('end')
+  out.close ()
@@ -1,6 +1,6 @@
 #!/bin/bash
 
-tests="inp/tests/locdyn-test.sh"
+tests="inp/tests/locdyn-test.sh inp/tests/ghost-queries-test.sh"
 
 echo "------------------------------------------------------------------------------------------"
 echo "Solfec parallel tests"
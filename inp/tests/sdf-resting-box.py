@@ -0,0 +1,62 @@
+# box resting on a signed distance field floor
+
+T = [] # plots
+Z = []
+
+# plotting callback
+def callback_function (bod, solfec):
+  T.append (solfec.time)
+  Z.append (bod.conf [11])
+  return 1
+
+# main module
+def box (x0, y0, z0, x1, y1, z1):
+  return HULL ([x0, y0, z0, x1, y0, z0, x1, y1, z0, x0, y1, z0,
+                x0, y0, z1, x1, y0, z1, x1, y1, z1, x0, y1, z1], 1, 1)
+
+step = 0.001
+stop = 3.0
+gravity = 10.0
+solfec = SOLFEC ('DYNAMIC', step, 'out/tests/sdf-resting-box')
+if not VIEWER(): solfec.verbose = 'OFF'
+SURFACE_MATERIAL (solfec, model = 'SIGNORINI_COULOMB', friction = 0.3)
+material = BULK_MATERIAL (solfec, 'KIRCHHOFF', young = 15E9, poisson = 0.25, density = 1.8E3)
+gs = GAUSS_SEIDEL_SOLVER (1E-3, 1000)
+GRAVITY (solfec, (0, 0, -gravity))
+
+floor = SDF (box (-1, -1, -1, 1, 1, 0), 0.05, 1, 1)
+BODY (solfec, 'OBSTACLE', floor, material)
+bod = BODY (solfec, 'RIGID', box (-0.1, -0.1, 0.001, 0.1, 0.1, 0.201), material)
+
+if not VIEWER():
+  if solfec.mode == 'READ': print '\nPrevious test results exist. Please "make del" and rerun tests'
+  else:
+    CALLBACK (solfec, step, (bod, solfec), callback_function)
+    RUN (solfec, gs, stop)
+
+    # the box should rest flat on its bottom face: its mass center stays at the half height,
+    # its velocity vanishes and it does not rotate; supporting it at a single corner of the
+    # face makes it rock and sink instead
+    z = bod.conf [11]
+    tilt = 1.0 - bod.conf [8]
+    speed = max ([abs (x) for x in bod.velo])
+
+    if abs (z - 0.1) < 1E-3 and tilt < 1E-6 and speed < 1E-3: print 'PASSED'
+    else:
+      print 'FAILED'
+      print '(', 'Computed height was %.5f' % z, 'tilt %.2e' % tilt, 'and speed %.2e' % speed,
+      print 'while the references are 0.10000, 0.0 and 0.0', ')'
+
+    try:
+      import matplotlib.pyplot as plt
+      plt.clf ()
+      plt.plot (T, Z, label='z')
+      plt.axis (xmin = 0, xmax = stop, ymin = 0.09, ymax = 0.11)
+      plt.xlabel ('Time [s]')
+      plt.ylabel ('Height [m]')
+      plt.legend (loc = 'upper right')
+      plt.savefig ('out/tests/sdf-resting-box/sdf-resting-box-z.eps')
+    except ImportError:
+      pass # no reaction
+
+else: RUN (solfec, gs, stop)
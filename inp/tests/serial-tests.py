@@ -5,7 +5,8 @@ tests = ['inp/tests/pinned-bar.py',
          'inp/tests/double-pendulum.py',
          'inp/tests/projectile.py',
 	 'inp/tests/block-sliding.py',
-	 'inp/tests/arch.py']
+	 'inp/tests/arch.py',
+	 'inp/tests/sdf-resting-box.py']
 
 print '------------------------------------------------------------------------------------------'
 print 'Solfec serial tests'
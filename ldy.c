@@ -26,6 +26,8 @@
 #include "lap.h"
 #include "msh.h"
 #include "err.h"
+#include "thr.h"
+#include "red.h"
 
 #if MPI
 #include "com.h"
@@ -192,7 +194,7 @@ static void compute_adjext (LOCDYN *ldy, UPKIND upkind)
 
     BODY *bodies [] = {ext->master, ext->slave}; /* e.g. two remote child bodies of local parents might be in contact */
 
-    for (i = 0, bod = bodies [i]; i < 2 && bod; i ++, bod = bodies [i]) /* (i < 2 && bod) skips NULL slaves of single-body constraints */
+    for (i = 0; i < 2 && (bod = bodies [i]); i ++) /* (i < 2 && bod) skips NULL slaves of single-body constraints */
     {
       if (ext->kind == CONTACT && bod->kind == OBS) continue; /* obstacles do not trasnder contact adjacency */
 
@@ -345,41 +347,91 @@ static int dumpcmp (CON *a, CON *b)
   return 0;
 }
 
-/* update previous and free local velocities */
-static void update_V_and_B (DOM *dom)
+/* diagonal blocks processed by the thread pool */
+typedef struct dia_loop DIA_LOOP;
+
+struct dia_loop
+{
+  DIAB **dia; /* diagonal blocks in the list order */
+
+  int n; /* number of blocks */
+
+  double *energy; /* free energy terms: 2 per block */
+
+  UPKIND upkind;
+
+  double step;
+};
+
+/* collect diagonal blocks into an array */
+static void dia_loop_init (LOCDYN *ldy, DIA_LOOP *data)
+{
+  DIAB *dia;
+  int n;
+
+  for (n = 0, dia = ldy->dia; dia; dia = dia->n) n ++;
+
+  ERRMEM (data->dia = malloc (sizeof (DIAB*) * (n + 1)));
+  ERRMEM (data->energy = malloc (sizeof (double [2]) * (n + 1)));
+
+  for (n = 0, dia = ldy->dia; dia; dia = dia->n) data->dia [n ++] = dia;
+
+  data->n = n;
+  data->upkind = update_kind (ldy->dom->solfec);
+  data->step = ldy->dom->step;
+}
+
+/* free diagonal blocks array */
+static void dia_loop_free (DIA_LOOP *data)
+{
+  free (data->dia);
+  free (data->energy);
+}
+
+/* update previous and free local velocity of the i-th block */
+static void local_velocity (DIA_LOOP *data, int i)
 {
   double X [6], *V, *B;
   CON *con;
 
-  for (con = dom->con; con; con = con->next)
-  {
-    V = con->V;
-    B = con->dia->B;
+  con = data->dia [i]->con;
+  V = con->V;
+  B = con->dia->B;
 
-    SET (V, 0);
-    SET (B, 0);
+  SET (V, 0);
+  SET (B, 0);
 
 #if MPI
-    if (con->master->flags & BODY_PARENT) /* local parent */
+  if (con->master->flags & BODY_PARENT) /* local parent */
 #endif
-    {
-      BODY_Local_Velo (con->master, con->msgp, con->mpnt, con->base, X, X+3);
-      ADD (V, X, V);
-      ADD (B, X+3, B);
-    }
+  {
+    BODY_Local_Velo (con->master, con->msgp, con->mpnt, con->base, X, X+3);
+    ADD (V, X, V);
+    ADD (B, X+3, B);
+  }
 
-    if (con->slave)
-    {
+  if (con->slave)
+  {
 #if MPI
-      if (con->slave->flags & BODY_PARENT) /* local slave */
+    if (con->slave->flags & BODY_PARENT) /* local slave */
 #endif
-      {
-        BODY_Local_Velo (con->slave, con->ssgp, con->spnt, con->base, X, X+3);
-	SUB (V, X, V); /* relative = master - slave */
-	SUB (B, X+3, B);
-      }
+    {
+      BODY_Local_Velo (con->slave, con->ssgp, con->spnt, con->base, X, X+3);
+      SUB (V, X, V); /* relative = master - slave */
+      SUB (B, X+3, B);
     }
   }
+}
+
+/* update previous and free local velocities */
+static void update_V_and_B (DOM *dom, DIA_LOOP *data)
+{
+#if MPI
+  double X [6], *V, *B;
+  CON *con;
+#endif
+
+  THREAD_Loop (data->n, (THREAD_Job) local_velocity, data);
 
 #if MPI
   /* in parallel, parent bodies calculate local velocities of their external constraints and send them to the constraint parents;
@@ -422,7 +474,7 @@ static void update_V_and_B (DOM *dom)
     }
   }
 
-  COMALL (MPI_COMM_WORLD, send, nsend, &recv, &nrecv); /* send V, B */
+  COMNB (dom->neighbours, send, nsend, &recv, &nrecv); /* send V, B */
 
   for (i = 0; i < nrecv; i ++)
   {
@@ -608,225 +660,250 @@ void LOCDYN_Remove (LOCDYN *ldy, DIAB *dia)
   MEM_Free (&ldy->diamem, dia);
 }
 
-void LOCDYN_Update_Begin (LOCDYN *ldy)
+/* calculate local velocities and assemble the diagonal force-velocity 'W' block of the i-th block */
+static void diagonal_block (DIA_LOOP *data, int i)
 {
-  DOM *dom = ldy->dom;
-  UPKIND upkind = update_kind (dom->solfec);
-  double step = dom->step;
-  OFFB *blk, *blj;
-  DIAB *dia;
-
-#if MPI
-  if (dom->rank == 0)
-#endif
-  if (dom->verbose) printf ("LOCDYN ... "), fflush (stdout);
-
-  SOLFEC_Timer_Start (ldy->dom->solfec, "LOCDYN");
-
-  /* update previous and free velocites */
-  update_V_and_B (dom);
-
-  if (upkind == UPMIN) goto end; /* skip update */
-
-#if MPI
-  compute_adjext (ldy, upkind);
-#endif
-
-  ldy->free_energy = 0.0;
-
-  /* calculate local velocities and assmeble
-   * the diagonal force-velocity 'W' operator */
-  for (dia = ldy->dia; dia; dia = dia->n)
+  DIAB *dia = data->dia [i];
+  UPKIND upkind = data->upkind;
+  double step = data->step;
+  CON *con = dia->con;
+  BODY *m = con->master,
+       *s = con->slave;
+  SGP *msgp = con->msgp,
+      *ssgp = con->ssgp;
+  double *mpnt = con->mpnt,
+	 *spnt = con->spnt,
+	 *base = con->base,
+	 *B = dia->B,
+	 X [3], Y [9];
+  MX_DENSE_PTR (W, 3, 3, dia->W);
+  MX_DENSE_PTR (A, 3, 3, dia->A);
+  MX_DENSE (C, 3, 3);
+
+  /* diagonal block */
+  if (m != s)
   {
-    CON *con = dia->con;
-    BODY *m = con->master,
-	 *s = con->slave;
-    SGP *msgp = con->msgp,
-	*ssgp = con->ssgp;
-    double *mpnt = con->mpnt,
-	   *spnt = con->spnt,
-	   *base = con->base,
-	   *B = dia->B,
-           X [3], Y [9];
-    MX_DENSE_PTR (W, 3, 3, dia->W);
-    MX_DENSE_PTR (A, 3, 3, dia->A);
-    MX_DENSE (C, 3, 3);
-
-    /* diagonal block */
-    if (m != s)
-    {
-      dia->mH = BODY_Gen_To_Loc_Operator (m, con->kind, msgp, mpnt, base);
+    dia->mH = BODY_Gen_To_Loc_Operator (m, con->kind, msgp, mpnt, base);
 #if MPI
-      dia->mprod = MX_Matmat (1.0, dia->mH, m->inverse, 0.0, NULL);
-      MX_Matmat (1.0, dia->mprod, MX_Tran (dia->mH), 0.0, &W); /* H * inv (M) * H^T */
+    dia->mprod = MX_Matmat (1.0, dia->mH, m->inverse, 0.0, NULL);
+    MX_Matmat (1.0, dia->mprod, MX_Tran (dia->mH), 0.0, &W); /* H * inv (M) * H^T */
 #else
-      dia->mprod = MX_Matmat (1.0, m->inverse, MX_Tran (dia->mH), 0.0, NULL);
-      MX_Matmat (1.0, dia->mH, dia->mprod, 0.0, &W); /* H * inv (M) * H^T */
+    dia->mprod = MX_Matmat (1.0, m->inverse, MX_Tran (dia->mH), 0.0, NULL);
+    MX_Matmat (1.0, dia->mH, dia->mprod, 0.0, &W); /* H * inv (M) * H^T */
 #endif
 
-      if (s)
-      {
-	dia->sH = BODY_Gen_To_Loc_Operator (s, con->kind, ssgp, spnt, base);
-	MX_Scale (dia->sH, -1.0);
+    if (s)
+    {
+      dia->sH = BODY_Gen_To_Loc_Operator (s, con->kind, ssgp, spnt, base);
+      MX_Scale (dia->sH, -1.0);
 #if MPI
-	dia->sprod = MX_Matmat (1.0, dia->sH, s->inverse, 0.0, NULL);
-	MX_Matmat (1.0, dia->sprod, MX_Tran (dia->sH), 0.0, &C); /* H * inv (M) * H^T */
+      dia->sprod = MX_Matmat (1.0, dia->sH, s->inverse, 0.0, NULL);
+      MX_Matmat (1.0, dia->sprod, MX_Tran (dia->sH), 0.0, &C); /* H * inv (M) * H^T */
 #else
-	dia->sprod = MX_Matmat (1.0, s->inverse, MX_Tran (dia->sH), 0.0, NULL);
-	MX_Matmat (1.0, dia->sH, dia->sprod, 0.0, &C); /* H * inv (M) * H^T */
+      dia->sprod = MX_Matmat (1.0, s->inverse, MX_Tran (dia->sH), 0.0, NULL);
+      MX_Matmat (1.0, dia->sH, dia->sprod, 0.0, &C); /* H * inv (M) * H^T */
 #endif
-	NNADD (W.x, C.x, W.x);
-      }
+      NNADD (W.x, C.x, W.x);
     }
-    else /* eg. self-contact */
-    {
-      MX *mH = BODY_Gen_To_Loc_Operator (m, con->kind, msgp, mpnt, base),
-	 *sH = BODY_Gen_To_Loc_Operator (s, con->kind, ssgp, spnt, base);
+  }
+  else /* eg. self-contact */
+  {
+    MX *mH = BODY_Gen_To_Loc_Operator (m, con->kind, msgp, mpnt, base),
+       *sH = BODY_Gen_To_Loc_Operator (s, con->kind, ssgp, spnt, base);
 
-      dia->mH = MX_Add (1.0, mH, -1.0, sH, NULL);
-      dia->sH = MX_Copy (dia->mH, NULL);
+    dia->mH = MX_Add (1.0, mH, -1.0, sH, NULL);
+    dia->sH = MX_Copy (dia->mH, NULL);
 
-      MX_Destroy (mH);
-      MX_Destroy (sH);
+    MX_Destroy (mH);
+    MX_Destroy (sH);
 #if MPI
-      dia->mprod = MX_Matmat (1.0, dia->mH, m->inverse, 0.0, NULL);
-      dia->sprod = MX_Copy (dia->mprod, NULL);
-      MX_Matmat (1.0, dia->mprod, MX_Tran (dia->mH), 0.0, &W); /* H * inv (M) * H^T */
+    dia->mprod = MX_Matmat (1.0, dia->mH, m->inverse, 0.0, NULL);
+    dia->sprod = MX_Copy (dia->mprod, NULL);
+    MX_Matmat (1.0, dia->mprod, MX_Tran (dia->mH), 0.0, &W); /* H * inv (M) * H^T */
 #else
-      dia->mprod = MX_Matmat (1.0, m->inverse, MX_Tran (dia->mH), 0.0, NULL);
-      dia->sprod = MX_Copy (dia->mprod, NULL);
-      MX_Matmat (1.0, dia->mH, dia->mprod, 0.0, &W); /* H * inv (M) * H^T */
+    dia->mprod = MX_Matmat (1.0, m->inverse, MX_Tran (dia->mH), 0.0, NULL);
+    dia->sprod = MX_Copy (dia->mprod, NULL);
+    MX_Matmat (1.0, dia->mH, dia->mprod, 0.0, &W); /* H * inv (M) * H^T */
 #endif
-    }
-
-    SCALE9 (W.x, step); /* W = h * ( ... ) */
+  }
 
-    if (upkind != UPPES) /* diagonal regularization (not needed by the explicit solver) */
-    {
-      NNCOPY (W.x, C.x); /* calculate regularisation parameter */
-      ASSERT (lapack_dsyev ('N', 'U', 3, C.x, 3, X, Y, 9) == 0, ERR_LDY_EIGEN_DECOMP);
-      dia->rho = 1.0 / X [2]; /* inverse of maximal eigenvalue */
-    }
+  SCALE9 (W.x, step); /* W = h * ( ... ) */
 
-    NNCOPY (W.x, A.x);
-    MX_Inverse (&A, &A); /* inverse of diagonal block */
+  if (upkind != UPPES) /* diagonal regularization (not needed by the explicit solver) */
+  {
+    NNCOPY (W.x, C.x); /* calculate regularisation parameter */
+    ASSERT (lapack_dsyev ('N', 'U', 3, C.x, 3, X, Y, 9) == 0, ERR_LDY_EIGEN_DECOMP);
+    dia->rho = 1.0 / X [2]; /* inverse of maximal eigenvalue */
+  }
 
-    NVMUL (A.x, B, X);
-    ldy->free_energy += DOT (X, B); /* sum up free energy */
+  NNCOPY (W.x, A.x);
+  MX_Inverse (&A, &A); /* inverse of diagonal block */
 
-    /* add up prescribed velocity contribution */
-    if (con->kind == VELODIR) ldy->free_energy += A.x[8] * VELODIR(con->Z) * VELODIR(con->Z);
-  }
+  NVMUL (A.x, B, X);
+  data->energy [2*i] = DOT (X, B); /* free energy term */
 
-  ldy->free_energy *= 0.5; /* 0.5 * DOT (AB, B) */
+  /* prescribed velocity contribution */
+  if (con->kind == VELODIR) data->energy [2*i+1] = A.x[8] * VELODIR(con->Z) * VELODIR(con->Z);
+}
 
-  for (dia = ldy->dia; dia; dia = dia->n) /* off-diagonal blocks update */
-  {
-    CON *con = dia->con;
-    BODY *m = con->master,
-	 *s = con->slave;
+/* update off-diagonal blocks of the i-th block row */
+static void offdiagonal_blocks (DIA_LOOP *data, int i)
+{
+  DIAB *dia = data->dia [i];
+  UPKIND upkind = data->upkind;
+  double step = data->step;
+  CON *con = dia->con;
+  BODY *m = con->master,
+       *s = con->slave;
+  OFFB *blk;
 
-    if (upkind == UPPES && con->kind == CONTACT) continue; /* update only non-contact constraint blocks */
+  if (upkind == UPPES && con->kind == CONTACT) return; /* update only non-contact constraint blocks */
 
-    /* off-diagonal local blocks */
-    for (blk = dia->adj; blk; blk = blk->n)
-    {
-      if (upkind == UPALL && blk->dia < dia) continue; /* skip lower triangle */
+  /* off-diagonal local blocks */
+  for (blk = dia->adj; blk; blk = blk->n)
+  {
+    if (upkind == UPALL && blk->dia < dia) continue; /* skip lower triangle */
 
-      MX *left, *right;
-      DIAB *adj = blk->dia;
-      BODY *bod = blk->bod;
-      CON *con = adj->con;
-      MX_DENSE_PTR (W, 3, 3, blk->W);
+    MX *left, *right;
+    DIAB *adj = blk->dia;
+    BODY *bod = blk->bod;
+    CON *con = adj->con;
+    MX_DENSE_PTR (W, 3, 3, blk->W);
 
-      ASSERT_DEBUG (bod == m || bod == s, "Off diagonal block is not connected!");
+    ASSERT_DEBUG (bod == m || bod == s, "Off diagonal block is not connected!");
 
 #if MPI
-      left = (bod == m ? dia->mprod : dia->sprod);
+    left = (bod == m ? dia->mprod : dia->sprod);
 #else
-      left = (bod == m ? dia->mH : dia->sH);
+    left = (bod == m ? dia->mH : dia->sH);
 #endif
 
-      if (bod == con->master) /* master on the right */
-      {
+    if (bod == con->master) /* master on the right */
+    {
 #if MPI
-	right = adj->mH;
+      right = adj->mH;
 #else
-	right =  adj->mprod;
+      right =  adj->mprod;
 #endif
-      }
-      else /* blk->bod == con->slave (slave on the right) */
-      {
+    }
+    else /* blk->bod == con->slave (slave on the right) */
+    {
 #if MPI
-	right = adj->sH;
+      right = adj->sH;
 #else
-	right =  adj->sprod;
+      right =  adj->sprod;
 #endif
-      }
+    }
 
 #if MPI
-      MX_Matmat (1.0, left, MX_Tran (right), 0.0, &W);
+    MX_Matmat (1.0, left, MX_Tran (right), 0.0, &W);
 #else
-      MX_Matmat (1.0, left, right, 0.0, &W);
+    MX_Matmat (1.0, left, right, 0.0, &W);
 #endif
-      SCALE9 (W.x, step);
-    }
+    SCALE9 (W.x, step);
+  }
 
 #if MPI
-    /* off-diagonal external blocks */
-    for (blk = dia->adjext; blk; blk = blk->n)
-    {
-      MX *left, *right;
-      CON *ext = (CON*)blk->dia;
-      BODY *bod = blk->bod;
-      MX_DENSE_PTR (W, 3, 3, blk->W);
-
-      ASSERT_DEBUG (bod == m || bod == s, "Not connected external off-diagonal block");
+  /* off-diagonal external blocks */
+  for (blk = dia->adjext; blk; blk = blk->n)
+  {
+    MX *left, *right;
+    CON *ext = (CON*)blk->dia;
+    BODY *bod = blk->bod;
+    MX_DENSE_PTR (W, 3, 3, blk->W);
 
-      if (bod == ext->master)
-      {
-	right = BODY_Gen_To_Loc_Operator (bod, ext->kind, ext->msgp, ext->mpnt, ext->base);
+    ASSERT_DEBUG (bod == m || bod == s, "Not connected external off-diagonal block");
 
-	if (bod == ext->slave) /* right self-contact */
-	{
-	  MX *a = right,
-	     *b = BODY_Gen_To_Loc_Operator (bod, ext->kind, ext->ssgp, ext->spnt, ext->base);
+    if (bod == ext->master)
+    {
+      right = BODY_Gen_To_Loc_Operator (bod, ext->kind, ext->msgp, ext->mpnt, ext->base);
 
-	  right = MX_Add (1.0, a, -1.0, b, NULL);
-	  MX_Destroy (a);
-	}
-      }
-      else
+      if (bod == ext->slave) /* right self-contact */
       {
-	right = BODY_Gen_To_Loc_Operator (bod, ext->kind, ext->ssgp, ext->spnt, ext->base);
-	MX_Scale (right, -1.0);
-      }
-     
-      left = (bod == m ? dia->mprod : dia->sprod);
+	MX *a = right,
+	   *b = BODY_Gen_To_Loc_Operator (bod, ext->kind, ext->ssgp, ext->spnt, ext->base);
 
-      MX_Matmat (1.0, left, MX_Tran (right), 0.0, &W);
-      SCALE9 (W.x, step);
-      MX_Destroy (right);
+	right = MX_Add (1.0, a, -1.0, b, NULL);
+	MX_Destroy (a);
+      }
     }
-#endif
+    else
+    {
+      right = BODY_Gen_To_Loc_Operator (bod, ext->kind, ext->ssgp, ext->spnt, ext->base);
+      MX_Scale (right, -1.0);
+    }
+   
+    left = (bod == m ? dia->mprod : dia->sprod);
+
+    MX_Matmat (1.0, left, MX_Tran (right), 0.0, &W);
+    SCALE9 (W.x, step);
+    MX_Destroy (right);
   }
+#endif
+}
 
-  /* use symmetry */
-  if (upkind == UPALL)
+/* copy transposed upper triangle blocks into the lower triangle blocks of the i-th block row */
+static void symmetric_blocks (DIA_LOOP *data, int i)
+{
+  DIAB *dia = data->dia [i];
+  OFFB *blk, *blj;
+
+  for (blk = dia->adj; blk; blk = blk->n)
   {
-    for (dia = ldy->dia; dia; dia = dia->n)
+    if (blk->dia < dia) /* lower triangle = transposed upper triangle */
     {
-      for (blk = dia->adj; blk; blk = blk->n)
-      {
-	if (blk->dia < dia) /* lower triangle = transposed upper triangle */
-	{
-	  for (blj = blk->dia->adj; blj && (blj->dia != dia || blj->bod != blk->bod); blj = blj->n); /* find upper triangle symmetric block */
-	  ASSERT_DEBUG (blj, "Inconsistent W adjacency");
-	  TNCOPY (blj->W, blk->W); /* transposed copy of a symmetric block */
-	}
-      }
+      for (blj = blk->dia->adj; blj && (blj->dia != dia || blj->bod != blk->bod); blj = blj->n); /* find upper triangle symmetric block */
+      ASSERT_DEBUG (blj, "Inconsistent W adjacency");
+      TNCOPY (blj->W, blk->W); /* transposed copy of a symmetric block */
     }
   }
+}
+
+void LOCDYN_Update_Begin (LOCDYN *ldy)
+{
+  DOM *dom = ldy->dom;
+  UPKIND upkind = update_kind (dom->solfec);
+  RED_SUM energy;
+  DIA_LOOP data;
+  DIAB *dia;
+  int i;
+
+#if MPI
+  if (dom->rank == 0)
+#endif
+  if (dom->verbose) printf ("LOCDYN ... "), fflush (stdout);
+
+  SOLFEC_Timer_Start (ldy->dom->solfec, "LOCDYN");
+
+  dia_loop_init (ldy, &data);
+
+  /* update previous and free velocites */
+  update_V_and_B (dom, &data);
+
+  if (upkind == UPMIN) goto end; /* skip update */
+
+#if MPI
+  compute_adjext (ldy, upkind);
+#endif
+
+  /* calculate local velocities and assmeble
+   * the diagonal force-velocity 'W' operator */
+  THREAD_Loop (data.n, (THREAD_Job) diagonal_block, &data);
+
+  /* sum up free energy in the list order, so that the result does not depend on threads */
+  for (RED_Init (&energy, 0.0), i = 0; i < data.n; i ++)
+  {
+    RED_Add (&energy, data.energy [2*i]); /* 0.5 * DOT (AB, B) */
+    if (data.dia [i]->con->kind == VELODIR) RED_Add (&energy, data.energy [2*i+1]); /* add up prescribed velocity contribution */
+  }
+
+  ldy->free_energy = 0.5 * RED_Value (&energy); /* 0.5 * DOT (AB, B) */
+
+  /* off-diagonal blocks update */
+  THREAD_Loop (data.n, (THREAD_Job) offdiagonal_blocks, &data);
+
+  /* use symmetry */
+  if (upkind == UPALL) THREAD_Loop (data.n, (THREAD_Job) symmetric_blocks, &data);
 
   /* clean up */
   for (dia = ldy->dia; dia; dia = dia->n)
@@ -857,6 +934,8 @@ void LOCDYN_Update_Begin (LOCDYN *ldy)
 #endif
 
 end:
+  dia_loop_free (&data);
+
   SOLFEC_Timer_End (ldy->dom->solfec, "LOCDYN");
 }
 
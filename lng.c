@@ -36,12 +36,15 @@
 #include "box.h"
 #include "goc.h"
 #include "err.h"
+#include "red.h"
 #include "eli.h"
+#include "sdf.h"
 #include "fra.h"
 #include "costy/costy.h"
 
 #if MPI
 #include <mpi.h>
+#include "com.h"
 #endif
 
 #ifndef Py_RETURN_FALSE
@@ -1432,6 +1435,118 @@ static PyGetSetDef lng_ELLIP_getset [] =
   {NULL, 0, 0, NULL, NULL}
 };
 
+/*
+ * SDF => object
+ */
+
+typedef struct lng_SDF lng_SDF;
+
+static PyTypeObject lng_SDF_TYPE;
+
+struct lng_SDF
+{
+  PyObject_HEAD
+  SDF *sdf;
+};
+
+static int is_shape (PyObject *obj, char *var); /* shape test */
+static SHAPE* create_shape (PyObject *obj, short empty); /* shape constructor */
+static int has_sdf (PyObject *obj); /* signed distance field test */
+
+/* constructor */
+static PyObject* lng_SDF_new (PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("shape", "spacing", "volid", "surfid");
+  PyObject *shape;
+  double spacing;
+  int volid, surfid;
+  lng_SDF *self;
+  SHAPE *shp;
+
+  self = (lng_SDF*)type->tp_alloc (type, 0);
+
+  if (self)
+  {
+    PARSEKEYS ("Odii", &shape, &spacing, &volid, &surfid);
+
+    TYPETEST (is_shape (shape, kwl [0]) && is_positive (spacing, kwl [1]));
+
+    if (has_sdf (shape))
+    {
+      PyErr_SetString (PyExc_ValueError, "A SDF object can not be sampled from another SDF object");
+      return NULL;
+    }
+
+    shp = create_shape (shape, 0); /* the input shape is not emptied */
+
+    self->sdf = SDF_Create (shp, spacing, surfid, volid);
+
+    SHAPE_Destroy_Wrapper (shp);
+  }
+
+  return (PyObject*)self;
+}
+
+/* destructor */
+static void lng_SDF_dealloc (lng_SDF *self)
+{
+  if (self->sdf) SDF_Destroy (self->sdf);
+
+  self->ob_type->tp_free ((PyObject*)self);
+}
+
+/* spacing */
+static PyObject* lng_SDF_get_spacing (lng_SDF *self, void *closure)
+{
+  if (!self->sdf)
+  {
+    PyErr_SetString (PyExc_ValueError, "The SDF object is empty");
+    return NULL;
+  }
+
+  return PyFloat_FromDouble (self->sdf->spacing);
+}
+
+static int lng_SDF_set_spacing (lng_SDF *self, PyObject *value, void *closure)
+{
+  PyErr_SetString (PyExc_ValueError, "Writing to a read-only member");
+  return -1;
+}
+
+/* grid size */
+static PyObject* lng_SDF_get_size (lng_SDF *self, void *closure)
+{
+  if (!self->sdf)
+  {
+    PyErr_SetString (PyExc_ValueError, "The SDF object is empty");
+    return NULL;
+  }
+
+  return Py_BuildValue ("(i, i, i)", self->sdf->n [0], self->sdf->n [1], self->sdf->n [2]);
+}
+
+static int lng_SDF_set_size (lng_SDF *self, PyObject *value, void *closure)
+{
+  PyErr_SetString (PyExc_ValueError, "Writing to a read-only member");
+  return -1;
+}
+
+/* SDF methods */
+static PyMethodDef lng_SDF_methods [] =
+{ {NULL, NULL, 0, NULL} };
+
+/* SDF members */
+static PyMemberDef lng_SDF_members [] =
+{ {NULL, 0, 0, 0, NULL} };
+
+/* SDF getset */
+static PyGetSetDef lng_SDF_getset [] =
+{ 
+  {"spacing", (getter)lng_SDF_get_spacing, (setter)lng_SDF_set_spacing, "grid spacing", NULL},
+  {"size", (getter)lng_SDF_get_size, (setter)lng_SDF_set_size, "numbers of grid nodes", NULL},
+  {NULL, 0, 0, NULL, NULL}
+};
+
 /*
  * SOLFEC => object
  */
@@ -2335,6 +2450,37 @@ static int IS_HERE (lng_BODY *body)
 
   return 0;
 }
+
+/* is a body or its ghost (child) copy on this processor? */
+static int IS_VISIBLE (lng_BODY *body)
+{
+  if (IS_HERE (body)) return 1;
+
+#if LOCAL_BODIES
+  if (body->id) /* ghost copies are refreshed before control returns to Python (SOLFEC_Run), hence read-only queries can use them */
+  {
+    BODY *bod = MAP_Find (body->dom->allbodies, (void*) (long) body->id, NULL);
+
+    if (bod && (bod->flags & BODY_CHILD))
+    {
+      body->bod = bod;
+      return 1;
+    }
+  }
+#endif
+
+  return 0;
+}
+
+/* slave body of a pending constraint (in the LOCAL_BODIES mode NULL if stored on another processor) */
+static BODY* PENDING_SLAVE (lng_BODY *body)
+{
+#if LOCAL_BODIES
+  return IS_HERE (body) ? body->bod : NULL;
+#else
+  return body->bod;
+#endif
+}
 #endif
 
 /* test whether an object is a bulk material or a bulk material label */
@@ -2381,6 +2527,11 @@ static int is_basic_shape (PyObject *obj)
       lng_ELLIP *ellip = (lng_ELLIP*) obj;
       if (ellip->eli == NULL) return 0; /* empty */
     }
+    else if (PyObject_IsInstance ((PyObject*)obj, (PyObject*)&lng_SDF_TYPE))
+    {
+      lng_SDF *sdf = (lng_SDF*) obj;
+      if (sdf->sdf == NULL) return 0; /* empty */
+    }
     else return 0;
   }
 
@@ -2405,7 +2556,7 @@ static int is_shape (PyObject *obj, char *var)
       }
 
       char buf [BUFLEN];
-      sprintf (buf, "'%s' must be a non-empty CONVEX/MESH/SPHERE/ELLIP object or a list of those", var);
+      sprintf (buf, "'%s' must be a non-empty CONVEX/MESH/SPHERE/ELLIP/SDF object or a list of those", var);
       PyErr_SetString (PyExc_TypeError, buf);
       return 0;
     }
@@ -2467,7 +2618,7 @@ static int is_shape_or_vector (PyObject *obj, char *var)
       if (!PyTuple_Check (obj))
       {
 	char buf [BUFLEN];
-	sprintf (buf, "'%s' must be a non-empty CONVEX/MESH/SPHERE/ELLIP object, a list of those or a (x, y, z) tuple", var);
+	sprintf (buf, "'%s' must be a non-empty CONVEX/MESH/SPHERE/ELLIP/SDF object, a list of those or a (x, y, z) tuple", var);
 	PyErr_SetString (PyExc_TypeError, buf);
 	return 0;
       }
@@ -2516,7 +2667,7 @@ static int is_shape_or_body (PyObject *obj, char *var)
       if (!is_body_check (obj))
       {
 	char buf [BUFLEN];
-	sprintf (buf, "'%s' must be a non-empty CONVEX/MESH/SPHERE/ELLIP object, a list of those or a BODY object", var);
+	sprintf (buf, "'%s' must be a non-empty CONVEX/MESH/SPHERE/ELLIP/SDF object, a list of those or a BODY object", var);
 	PyErr_SetString (PyExc_TypeError, buf);
 	return 0;
       }
@@ -2549,10 +2700,26 @@ static int shape_kind (PyObject *obj)
   else if (PyObject_IsInstance ((PyObject*)obj, (PyObject*)&lng_MESH_TYPE)) return SHAPE_MESH;
   else if (PyObject_IsInstance ((PyObject*)obj, (PyObject*)&lng_SPHERE_TYPE)) return SHAPE_SPHERE;
   else if (PyObject_IsInstance ((PyObject*)obj, (PyObject*)&lng_ELLIP_TYPE)) return SHAPE_ELLIP;
+  else if (PyObject_IsInstance ((PyObject*)obj, (PyObject*)&lng_SDF_TYPE)) return SHAPE_SDF;
 
   return -1;
 }
 
+/* test whether a shape object or a list of those includes a signed distance field */
+static int has_sdf (PyObject *obj)
+{
+  if (PyList_Check (obj))
+  {
+    int i, n = PyList_Size (obj);
+
+    for (i = 0; i < n; i ++)
+      if (shape_kind (PyList_GetItem (obj, i)) == SHAPE_SDF) return 1;
+
+    return 0;
+  }
+  else return shape_kind (obj) == SHAPE_SDF;
+}
+
 /* return basic shape and empty the container */
 static void* get_shape (PyObject *obj, short empty)
 {
@@ -2584,6 +2751,12 @@ static void* get_shape (PyObject *obj, short empty)
     out = ellip->eli;
     if (empty) ellip->eli = NULL; /* empty */
   }
+  else if (PyObject_IsInstance ((PyObject*)obj, (PyObject*)&lng_SDF_TYPE))
+  {
+    lng_SDF *sdf = (lng_SDF*)obj;
+    out = sdf->sdf;
+    if (empty) sdf->sdf = NULL; /* empty */
+  }
 
   return out;
 }
@@ -2660,21 +2833,25 @@ static PyObject* lng_BODY_new (PyTypeObject *type, PyObject *args, PyObject *kwd
   self = (lng_BODY*)type->tp_alloc (type, 0);
 
 #if MPI && LOCAL_BODIES
-  int rank;
-  MPI_Comm_rank (MPI_COMM_WORLD, &rank);
-  if (self && rank != 0) /* all bodies created on rank 0 */
+  if (self)
   {
     PARSEKEYS ("OOOO|OOOO", &solfec, &kind, &shape, &material, &label, &formulation, &mesh, &modal);
 
     TYPETEST (is_solfec (solfec, kwl[0]) && is_string (kind, kwl[1]) &&
 	      is_shape (shape, kwl[2]) && is_bulk_material (solfec->sol, material, kwl[3]));
 
-    self->dom = solfec->sol->dom;
-    self->id = self->dom->bid ++;
-    self->bod = (BODY*)1; /* XXX is_body will not complain */
+    DOM *dom = solfec->sol->dom;
+
+    if (dom->bid % (unsigned) dom->ncpu != (unsigned) dom->rank) /* a body is created only on its owner rank (see DOM_Insert_Body) */
+    {
+      self->dom = dom;
+      self->id = dom->bid ++;
+      self->bod = (BODY*)1; /* XXX is_body will not complain */
+      return (PyObject*)self;
+    }
   }
-  else
 #endif
+
   if (self)
   {
     label = NULL;
@@ -2700,6 +2877,12 @@ static PyObject* lng_BODY_new (PyTypeObject *type, PyObject *args, PyObject *kwd
       if (mesh) TYPETEST (is_shape_convex (shape, kwl[2]));
     }
 
+    if (strcmp (PyString_AsString (kind), "OBSTACLE") && has_sdf (shape))
+    {
+      PyErr_SetString (PyExc_ValueError, "SDF shapes can only be used with OBSTACLE bodies");
+      return NULL;
+    }
+
     SHAPE *shp = create_shape (shape, 1);
 
     for (SHAPE *x = shp; x; x = x->next)
@@ -2840,7 +3023,7 @@ static void lng_BODY_dealloc (lng_BODY *self)
 static PyObject* lng_BODY_get_id (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -2861,7 +3044,7 @@ static int lng_BODY_set_id (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_kind (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -2882,7 +3065,7 @@ static int lng_BODY_set_kind (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_label (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -2909,7 +3092,7 @@ static PyObject* lng_BODY_get_conf (lng_BODY *self, void *closure)
   double *q;
 
 #if MPI
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -2943,7 +3126,7 @@ static PyObject* lng_BODY_get_velo (lng_BODY *self, void *closure)
   double *u;
 
 #if MPI
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -2973,7 +3156,7 @@ static int lng_BODY_set_velo (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_mass (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -2994,7 +3177,7 @@ static int lng_BODY_set_mass (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_volume (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -3015,7 +3198,7 @@ static int lng_BODY_set_volume (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_center (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -3037,7 +3220,7 @@ static int lng_BODY_set_center (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_tensor (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -3059,7 +3242,7 @@ static int lng_BODY_set_tensor (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_selfcontact (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -3105,7 +3288,7 @@ static int lng_BODY_set_selfcontact (lng_BODY *self, PyObject *value, void *clos
 static PyObject* lng_BODY_get_scheme (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -3208,7 +3391,7 @@ static int lng_BODY_set_scheme (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_damping (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -3294,7 +3477,7 @@ static int lng_BODY_set_ncon (lng_BODY *self, PyObject *value, void *closure)
 static PyObject* lng_BODY_get_material (lng_BODY *self, void *closure)
 {
 #if MPI
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
   return lng_BULK_MATERIAL_WRAPPER (self->bod->mat);
@@ -3313,7 +3496,7 @@ static int lng_BODY_set_material (lng_BODY *self, PyObject *value, void *closure
 static PyObject* lng_BODY_get_fracturecheck (lng_BODY *self, void *closure)
 {
 #if MPI && LOCAL_BODIES
-  if (IS_HERE (self))
+  if (IS_VISIBLE (self))
   {
 #endif
 
@@ -4061,10 +4244,10 @@ struct lng_NEWTON_SOLVER
 /* constructor */
 static PyObject* lng_NEWTON_SOLVER_new (PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
-  KEYWORDS ("meritval", "maxiter", "locdyn", "linver", "linmaxiter", "maxmatvec", "epsilon", "delta", "theta", "omega", "gsflag");
+  KEYWORDS ("meritval", "maxiter", "locdyn", "linver", "linmaxiter", "maxmatvec", "epsilon", "delta", "theta", "omega", "gsflag", "linprec", "linsweeps");
   double meritval, epsilon, delta, theta, omega;
-  int maxiter, linmaxiter, maxmatvec;
-  PyObject *locdyn, *linver, *gsflag;
+  int maxiter, linmaxiter, maxmatvec, linsweeps;
+  PyObject *locdyn, *linver, *gsflag, *linprec;
   lng_NEWTON_SOLVER *self;
 
   self = (lng_NEWTON_SOLVER*)type->tp_alloc (type, 0);
@@ -4082,12 +4265,14 @@ static PyObject* lng_NEWTON_SOLVER_new (PyTypeObject *type, PyObject *args, PyOb
     theta = 0.25;
     omega = 1E-10;
     gsflag = NULL;
+    linprec = NULL;
+    linsweeps = 2;
 
-    PARSEKEYS ("|diOOiiddddO", &meritval, &maxiter, &locdyn, &linver, &linmaxiter, &maxmatvec, &epsilon, &delta, &theta, &omega, &gsflag);
+    PARSEKEYS ("|diOOiiddddOOi", &meritval, &maxiter, &locdyn, &linver, &linmaxiter, &maxmatvec, &epsilon, &delta, &theta, &omega, &gsflag, &linprec, &linsweeps);
 
-    TYPETEST (is_positive (meritval, kwl[0]) && is_positive (maxiter, kwl[1]) && is_string (locdyn, kwl[2]) && is_string (locdyn, kwl[3]) &&
+    TYPETEST (is_positive (meritval, kwl[0]) && is_positive (maxiter, kwl[1]) && is_string (locdyn, kwl[2]) && is_string (linver, kwl[3]) &&
       is_positive (linmaxiter, kwl[4]) && is_positive (maxmatvec, kwl[5]) && is_positive (epsilon, kwl[6]) && is_non_negative (delta, kwl[7]) &&
-      is_gt_le (theta, kwl[8], 0, 1.0) && is_positive (omega, kwl[9]));
+      is_gt_le (theta, kwl[8], 0, 1.0) && is_positive (omega, kwl[9]) && is_string (linprec, kwl[11]) && is_positive (linsweeps, kwl[12]));
 
     self->ns = NEWTON_Create (meritval, maxiter);
     self->ns->linmaxiter = linmaxiter;
@@ -4096,6 +4281,7 @@ static PyObject* lng_NEWTON_SOLVER_new (PyTypeObject *type, PyObject *args, PyOb
     self->ns->delta = delta;
     self->ns->theta = theta;
     self->ns->omega = omega;
+    self->ns->linsweeps = linsweeps;
 
     if (locdyn)
     {
@@ -4131,6 +4317,23 @@ static PyObject* lng_NEWTON_SOLVER_new (PyTypeObject *type, PyObject *args, PyOb
       }
     }
 
+    if (linprec)
+    {
+      IFIS (linprec, "DIAG")
+      {
+	self->ns->linprec = PQN_PREC_DIAG;
+      }
+      ELIF (linprec, "BLOCK_JACOBI")
+      {
+	self->ns->linprec = PQN_PREC_BLOCK_JACOBI;
+      }
+      ELSE
+      {
+	PyErr_SetString (PyExc_ValueError, "Invalid linprec value: neither DIAG nor BLOCK_JACOBI");
+	return NULL;
+      }
+    }
+
     if (gsflag)
     {
       IFIS (gsflag, "ON")
@@ -4254,6 +4457,45 @@ static int lng_NEWTON_SOLVER_set_linmaxiter (lng_NEWTON_SOLVER *self, PyObject *
   return 0;
 }
 
+static PyObject* lng_NEWTON_SOLVER_get_linprec (lng_NEWTON_SOLVER *self, void *closure)
+{
+  if (self->ns->linprec == PQN_PREC_DIAG) return PyString_FromString ("DIAG");
+  else return PyString_FromString ("BLOCK_JACOBI");
+}
+
+static int lng_NEWTON_SOLVER_set_linprec (lng_NEWTON_SOLVER *self, PyObject *value, void *closure)
+{
+  if (!is_string (value, "linprec")) return -1;
+
+  IFIS (value, "DIAG")
+  {
+    self->ns->linprec = PQN_PREC_DIAG;
+  }
+  ELIF (value, "BLOCK_JACOBI")
+  {
+    self->ns->linprec = PQN_PREC_BLOCK_JACOBI;
+  }
+  ELSE
+  {
+    PyErr_SetString (PyExc_ValueError, "Invalid linprec value: neither DIAG nor BLOCK_JACOBI");
+    return -1;
+  }
+
+  return 0;
+}
+
+static PyObject* lng_NEWTON_SOLVER_get_linsweeps (lng_NEWTON_SOLVER *self, void *closure)
+{
+  return PyInt_FromLong (self->ns->linsweeps);
+}
+
+static int lng_NEWTON_SOLVER_set_linsweeps (lng_NEWTON_SOLVER *self, PyObject *value, void *closure)
+{
+  if (!is_number_gt (value, "linsweeps", 0)) return -1;
+  self->ns->linsweeps = PyInt_AsLong (value);
+  return 0;
+}
+
 static PyObject* lng_NEWTON_SOLVER_get_maxmatvec (lng_NEWTON_SOLVER *self, void *closure)
 {
   return PyInt_FromLong (self->ns->maxmatvec);
@@ -4406,6 +4648,8 @@ static PyGetSetDef lng_NEWTON_SOLVER_getset [] =
   {"locdyn", (getter)lng_NEWTON_SOLVER_get_locdyn, (setter)lng_NEWTON_SOLVER_set_locdyn, "local dynamics assembling", NULL},
   {"linver", (getter)lng_NEWTON_SOLVER_get_linver, (setter)lng_NEWTON_SOLVER_set_linver, "linearization version", NULL},
   {"linmaxiter", (getter)lng_NEWTON_SOLVER_get_linmaxiter, (setter)lng_NEWTON_SOLVER_set_linmaxiter, "GMRES iterations bound", NULL},
+  {"linprec", (getter)lng_NEWTON_SOLVER_get_linprec, (setter)lng_NEWTON_SOLVER_set_linprec, "GMRES preconditioner", NULL},
+  {"linsweeps", (getter)lng_NEWTON_SOLVER_get_linsweeps, (setter)lng_NEWTON_SOLVER_set_linsweeps, "block-Jacobi preconditioner sweeps", NULL},
   {"maxmatvec", (getter)lng_NEWTON_SOLVER_get_maxmatvec, (setter)lng_NEWTON_SOLVER_set_maxmatvec, "GMRES matrix-vector products bound", NULL},
   {"epsilon", (getter)lng_NEWTON_SOLVER_get_epsilon, (setter)lng_NEWTON_SOLVER_set_epsilon, "GMRES relative accuracy", NULL},
   {"delta", (getter)lng_NEWTON_SOLVER_get_delta, (setter)lng_NEWTON_SOLVER_set_delta, "diagonal regularization", NULL},
@@ -5048,6 +5292,81 @@ static PyGetSetDef lng_CONSTRAINT_getset [] =
  * Solfec => module
  */
 
+/* create a list of convex hulls of a list of point sets concurrently */
+static PyObject* hull_list (PyObject *points, int volid, int surfid)
+{
+  int count, error, *npnt, *surface, *volume, i, j, l;
+  double **pnt;
+  CONVEX **cvx;
+  PyObject *list, *item;
+  lng_CONVEX *obj;
+
+  count = PyList_Size (points);
+
+  for (i = 0; i < count; i ++)
+  {
+    if (!is_list (PyList_GetItem (points, i), "points", 3, 12)) return NULL;
+  }
+
+  ERRMEM (pnt = malloc (count * sizeof (double*)));
+  ERRMEM (npnt = malloc (count * sizeof (int)));
+  ERRMEM (surface = malloc (count * sizeof (int)));
+  ERRMEM (volume = malloc (count * sizeof (int)));
+  ERRMEM (cvx = malloc (count * sizeof (CONVEX*)));
+
+  for (i = 0; i < count; i ++)
+  {
+    item = PyList_GetItem (points, i);
+    l = PyList_Size (item);
+    ERRMEM (pnt [i] = malloc (l * sizeof (double)));
+    for (j = 0; j < l; j ++) pnt [i][j] = PyFloat_AsDouble (PyList_GetItem (item, j));
+    npnt [i] = l / 3;
+    surface [i] = surfid;
+    volume [i] = volid;
+  }
+
+  list = NULL;
+
+  TRY ()
+    CONVEX_Hull_Batch (count, pnt, npnt, surface, volume, cvx);
+  CATCHANY (error)
+  {
+    PyErr_SetString (PyExc_RuntimeError, errstring (error));
+#if MPI
+    PyErr_Print ();
+    MPI_Abort (MPI_COMM_WORLD, 2000+error);
+#endif
+    return NULL;
+  }
+  ENDTRY ()
+
+  for (i = 0; i < count; i ++) if (cvx [i] == NULL) break;
+
+  if (i < count)
+  {
+    for (i = 0; i < count; i ++) if (cvx [i]) CONVEX_Destroy (cvx [i]);
+    PyErr_SetString (PyExc_RuntimeError, "Failed to create convex hull");
+  }
+  else if ((list = PyList_New (count)))
+  {
+    for (i = 0; i < count; i ++)
+    {
+      obj = (lng_CONVEX*)lng_CONVEX_TYPE.tp_alloc (&lng_CONVEX_TYPE, 0);
+      obj->cvx = cvx [i];
+      PyList_SetItem (list, i, (PyObject*)obj);
+    }
+  }
+
+  for (i = 0; i < count; i ++) free (pnt [i]);
+  free (pnt);
+  free (npnt);
+  free (surface);
+  free (volume);
+  free (cvx);
+
+  return list;
+}
+
 /* create convex hull of a point set */
 static PyObject* lng_HULL (PyObject *self, PyObject *args, PyObject *kwds)
 {
@@ -5068,6 +5387,12 @@ static PyObject* lng_HULL (PyObject *self, PyObject *args, PyObject *kwds)
 
     PARSEKEYS ("Oii|O", &points, &volid, &surfid, &convex);
 
+    if (!convex && PyList_Check (points) && PyList_Size (points) > 0 && PyList_Check (PyList_GetItem (points, 0))) /* a list of point sets */
+    {
+      Py_DECREF (out);
+      return hull_list (points, volid, surfid);
+    }
+
     TYPETEST (is_list (points, kwl[0], 3, 12) && is_convex (convex, kwl[3]));
 
     l = PyList_Size (points);
@@ -5736,12 +6061,19 @@ static PyObject* lng_PUT_RIGID_LINK (PyObject *self, PyObject *args, PyObject *k
       TYPETEST (is_body (body1, kwl[0]) && is_body (body2, kwl[1]) &&
 		is_tuple (point1, kwl[2], 3) && is_tuple (point2, kwl[3], 3));
 
+#if MPI
+      if (body1->dom != body2->dom)
+#else
       if (body1->bod->dom != body2->bod->dom)
+#endif
       {
 	PyErr_SetString (PyExc_ValueError, "Cannot link bodies from different domains");
 	return NULL;
       }
 
+#if MPI && LOCAL_BODIES
+      if (IS_HERE (body1) && IS_HERE (body2)) /* otherwise tested during the parallel insertion */
+#endif
       if (body1->bod->kind == OBS && body2->bod->kind == OBS)
       {
 	PyErr_SetString (PyExc_ValueError, "Cannot constrain an obstacle with the rigid link");
@@ -5780,13 +6112,16 @@ static PyObject* lng_PUT_RIGID_LINK (PyObject *self, PyObject *args, PyObject *k
     }
     else /* both bodies passed */
     {
-      if (body1->bod->dom->time != 0.0)
+      if (body1->dom->time != 0.0)
       {
 	PyErr_SetString (PyExc_ValueError, "Rigid links can be inserted only at time zero");
 	return NULL;
       }
 
-      if (!DOM_Pending_Constraint (body1->bod->dom, RIGLNK, body1->bod, body2->bod, p1, p2, NULL, NULL, -1, -1, strength))
+#if LOCAL_BODIES
+      if (IS_HERE (body1)) /* scheduled where the master is stored */
+#endif
+      if (!DOM_Pending_Constraint (body1->dom, RIGLNK, body1->bod, PENDING_SLAVE (body2), body2->id, p1, p2, NULL, NULL, -1, -1, strength))
       {
 	PyErr_SetString (PyExc_ValueError, "Point outside of domain");
 	return NULL;
@@ -5817,14 +6152,21 @@ static PyObject* lng_PUT_SPRING (PyObject *self, PyObject *args, PyObject *kwds)
 	      is_tuple (point1, kwl[2], 3) && is_tuple (point2, kwl[3], 3) &&
               is_callable (function, kwl[4]) && is_tuple (limits, kwl[5], 2));
 
+#if MPI
+    if (body1->dom != body2->dom)
+#else
     if (body1->bod->dom != body2->bod->dom)
+#endif
     {
       PyErr_SetString (PyExc_ValueError, "Cannot link bodies from different domains");
       return NULL;
     }
 
-    if (!(body1->bod->kind = RIG || body1->bod->kind == PRB) ||
-        !(body2->bod->kind = RIG || body2->bod->kind == PRB))
+#if MPI && LOCAL_BODIES
+    if (IS_HERE (body1) && IS_HERE (body2)) /* otherwise tested during the parallel insertion */
+#endif
+    if (!(body1->bod->kind == RIG || body1->bod->kind == PRB) ||
+        !(body2->bod->kind == RIG || body2->bod->kind == PRB))
     {
       PyErr_SetString (PyExc_ValueError, "Slider only works with rigid and pseudo-rigid bodies");
       return NULL;
@@ -5862,13 +6204,16 @@ static PyObject* lng_PUT_SPRING (PyObject *self, PyObject *args, PyObject *kwds)
     }
     else /* both bodies passed */
     {
-      if (body1->bod->dom->time != 0.0)
+      if (body1->dom->time != 0.0)
       {
 	PyErr_SetString (PyExc_ValueError, "Springs can be inserted only at time zero");
 	return NULL;
       }
 
-      if (!DOM_Pending_Constraint (body1->bod->dom, SPRING, body1->bod, body2->bod, p1, p2, lim, (TMS*)function, -1, -1, DBL_MAX))
+#if LOCAL_BODIES
+      if (IS_HERE (body1)) /* scheduled where the master is stored */
+#endif
+      if (!DOM_Pending_Constraint (body1->dom, SPRING, body1->bod, PENDING_SLAVE (body2), body2->id, p1, p2, lim, (TMS*)function, -1, -1, DBL_MAX))
       {
 	PyErr_SetString (PyExc_ValueError, "Point outside of domain");
 	return NULL;
@@ -6260,7 +6605,8 @@ static PyObject* lng_SIMPLIFIED_CRACK (PyObject *self, PyObject *args, PyObject
 /* set imbalance tolerances */
 static PyObject* lng_IMBALANCE_TOLERANCE (PyObject *self, PyObject *args, PyObject *kwds)
 {
-  KEYWORDS ("solfec", "tolerance", "weightfactor", "updatefreq");
+  KEYWORDS ("solfec", "tolerance", "weightfactor", "updatefreq", "weights", "repartition", "partitioner");
+  PyObject *weights, *repartition, *partitioner;
   lng_SOLFEC *solfec;
   double tolerance,
 	 weightfactor;
@@ -6268,12 +6614,72 @@ static PyObject* lng_IMBALANCE_TOLERANCE (PyObject *self, PyObject *args, PyObje
 
   weightfactor = 1.0;
   updatefreq = 10;
+  weights = NULL;
+  repartition = NULL;
+  partitioner = NULL;
 
-  PARSEKEYS ("Od|di", &solfec, &tolerance, &weightfactor, &updatefreq);
+  PARSEKEYS ("Od|diOOO", &solfec, &tolerance, &weightfactor, &updatefreq, &weights, &repartition, &partitioner);
 
   TYPETEST (is_solfec (solfec, kwl[0]) && is_positive (tolerance, kwl[1]) &&
-            is_ge_le (weightfactor, kwl [2], 0.0, 1.0) && is_ge (updatefreq, kwl [3], 1));
+            is_ge_le (weightfactor, kwl [2], 0.0, 1.0) && is_ge (updatefreq, kwl [3], 1) &&
+	    is_string (weights, kwl [4]) && is_string (repartition, kwl [5]) && is_string (partitioner, kwl [6]));
 #if MPI
+  if (weights)
+  {
+    IFIS (weights, "MEASURED")
+    {
+      solfec->sol->dom->weightsmode = MEASURED_WEIGHTS;
+    }
+    ELIF (weights, "HEURISTIC")
+    {
+      solfec->sol->dom->weightsmode = HEURISTIC_WEIGHTS;
+    }
+    ELSE
+    {
+      PyErr_SetString (PyExc_ValueError, "Invalid weights mode");
+      return NULL;
+    }
+  }
+
+  if (repartition)
+  {
+    IFIS (repartition, "ADAPTIVE")
+    {
+      solfec->sol->dom->repartitionmode = ADAPTIVE_REPARTITION;
+    }
+    ELIF (repartition, "FIXED")
+    {
+      solfec->sol->dom->repartitionmode = FIXED_REPARTITION;
+    }
+    ELSE
+    {
+      PyErr_SetString (PyExc_ValueError, "Invalid repartition mode");
+      return NULL;
+    }
+  }
+
+  if (partitioner)
+  {
+    IFIS (partitioner, "ZOLTAN")
+    {
+      DOM_Partitioner (solfec->sol->dom, -1);
+    }
+    ELIF (partitioner, "MORTON")
+    {
+      DOM_Partitioner (solfec->sol->dom, SFC_MORTON);
+    }
+    ELIF (partitioner, "HILBERT")
+    {
+      DOM_Partitioner (solfec->sol->dom, SFC_HILBERT);
+    }
+    ELSE
+    {
+      PyErr_SetString (PyExc_ValueError, "Invalid partitioner");
+      return NULL;
+    }
+  }
+
+  solfec->sol->dom->imbalance_tolerance = tolerance;
   solfec->sol->dom->weight_factor = weightfactor;
   solfec->sol->dom->updatefreq = updatefreq;
 #endif
@@ -6663,6 +7069,7 @@ static PyObject* shape_to_list (SHAPE *shp)
     lng_CONVEX *convex;
     lng_SPHERE *sphere;
     lng_ELLIP *ellip;
+    lng_SDF *sdf;
     PyObject *list;
     SHAPE *shq;
     int n;
@@ -6713,6 +7120,15 @@ static PyObject* shape_to_list (SHAPE *shp)
 	  }
 	  else return NULL;
 	  break;
+        case SHAPE_SDF:
+	  sdf = (lng_SDF*)lng_SDF_TYPE.tp_alloc (&lng_SDF_TYPE, 0);
+	  if (sdf)
+	  {
+	    sdf->sdf = shq->data;
+	    PyList_SetItem (list, n, (PyObject*)sdf);
+	  }
+	  else return NULL;
+	  break;
 
 	}
       }
@@ -6759,6 +7175,15 @@ static PyObject* shape_to_list (SHAPE *shp)
 	}
 	else return NULL;
 	break;
+      case SHAPE_SDF:
+	sdf = (lng_SDF*)lng_SDF_TYPE.tp_alloc (&lng_SDF_TYPE, 0);
+	if (sdf)
+	{
+	  sdf->sdf = shp->data;
+	  return (PyObject*)sdf;
+	}
+	else return NULL;
+	break;
       }
     }
   }
@@ -6871,6 +7296,13 @@ static PyObject* lng_SPLIT (PyObject *self, PyObject *args, PyObject *kwds)
 	else if (two) front = SHAPE_Glue (SHAPE_Create (SHAPE_ELLIP, two), front);
       }
       break;
+      case SHAPE_SDF:
+      {
+	CONVEX *one = NULL, *two = NULL;
+
+	SDF_Split (shq->data, p, n, tadj, surf, &one, &two);
+      }
+      break;
       case SHAPE_MESH:
       {
 	MESH *one = NULL, *two = NULL;
@@ -7032,6 +7464,9 @@ static PyObject* lng_COPY (PyObject *self, PyObject *args, PyObject *kwds)
     case SHAPE_ELLIP:
       shq->data = ELLIP_Copy (shq->data);
       break;
+    case SHAPE_SDF:
+      shq->data = SDF_Copy (shq->data);
+      break;
     }
   }
 
@@ -7313,6 +7748,22 @@ static PyObject* lng_CONTACT_SPARSIFY (PyObject *self, PyObject *args, PyObject
   Py_RETURN_NONE;
 }
 
+/* set contact manifold tolerance */
+static PyObject* lng_CONTACT_MANIFOLD (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("solfec", "tolerance");
+  lng_SOLFEC *solfec;
+  double tolerance;
+
+  PARSEKEYS ("Od", &solfec, &tolerance);
+
+  TYPETEST (is_solfec (solfec, kwl[0]) && is_non_negative (tolerance, kwl[1]));
+
+  solfec->sol->dom->mantol = tolerance;
+
+  Py_RETURN_NONE;
+}
+
 /* test whether an object is a constraint solver */
 static int is_solver (PyObject *obj, char *var)
 {
@@ -7461,6 +7912,24 @@ static PyObject* lng_OUTPUT (PyObject *self, PyObject *args, PyObject *kwds)
   Py_RETURN_NONE;
 }
 
+/* set restart checkpoint frequency */
+static PyObject* lng_CHECKPOINT (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("solfec", "interval");
+  lng_SOLFEC *solfec;
+  double interval;
+
+  PARSEKEYS ("Od", &solfec, &interval);
+
+  TYPETEST (is_solfec (solfec, kwl[0]) && is_positive (interval, kwl[1]));
+
+  if (solfec->sol->mode == SOLFEC_READ) Py_RETURN_NONE; /* skip READ mode */
+
+  SOLFEC_Checkpoint (solfec->sol, interval);
+
+  Py_RETURN_NONE;
+}
+
 /* set scene extents */
 static PyObject* lng_EXTENTS (PyObject *self, PyObject *args, PyObject *kwds)
 {
@@ -7605,6 +8074,50 @@ static PyObject* lng_WARNINGS (PyObject *self, PyObject *args, PyObject *kwds)
   Py_RETURN_NONE;
 }
 
+/* enable/disable reproducible reductions */
+static PyObject* lng_REPRODUCIBLE_REDUCTIONS (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("state");
+  PyObject *state;
+
+  PARSEKEYS ("O", &state);
+
+  TYPETEST (is_string (state, kwl[0]));
+
+  IFIS (state, "ON")
+  {
+    REPRODUCIBLE_REDUCTIONS = 1;
+  }
+  ELIF (state, "OFF")
+  {
+    REPRODUCIBLE_REDUCTIONS = 0;
+  }
+  ELSE
+  {
+    PyErr_SetString (PyExc_ValueError, "Only 'ON' or 'OFF' are valid states");
+    return NULL;
+  }
+
+  Py_RETURN_NONE;
+}
+
+/* set message compression threshold */
+static PyObject* lng_MESSAGE_COMPRESSION (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("threshold");
+  int threshold;
+
+  PARSEKEYS ("i", &threshold);
+
+  TYPETEST (is_ge (threshold, kwl[0], 0));
+
+#if MPI
+  COM_Compression (threshold);
+#endif
+
+  Py_RETURN_NONE;
+}
+
 /* initialize state */
 static PyObject* lng_INITIALIZE_STATE (PyObject *self, PyObject *args, PyObject *kwds)
 {
@@ -7633,6 +8146,33 @@ static PyObject* lng_INITIALIZE_STATE (PyObject *self, PyObject *args, PyObject
   Py_RETURN_NONE;
 }
 
+/* restart from checkpoint */
+static PyObject* lng_RESTART (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("solfec", "path");
+  lng_SOLFEC *solfec;
+  PyObject *path;
+
+  PARSEKEYS ("OO", &solfec, &path);
+
+  TYPETEST (is_solfec (solfec, kwl[0]) && is_string (path, kwl[1]));
+
+  if (solfec->sol->mode == SOLFEC_WRITE)
+  {
+    if (SOLFEC_Restart (solfec->sol, PyString_AsString (path)) == 0)
+    {
+      PyErr_SetString (PyExc_RuntimeError, "Restart has failed");
+      return NULL;
+    }
+  }
+  else
+  {
+    WARNING (0, "RESTART has been ingnored in the 'READ' mode");
+  }
+
+  Py_RETURN_NONE;
+}
+
 /* dump local dynamics */
 static PyObject* lng_LOCDYN_DUMP (PyObject *self, PyObject *args, PyObject *kwds)
 {
@@ -7672,7 +8212,7 @@ static void overlap_create (OCD *ocd, BOX *one, BOX *two)
     CONTACT_DETECT, GOBJ_Pair_Code (one, two),
     one->sgp->shp, one->sgp->gobj,
     two->sgp->shp, two->sgp->gobj,
-    onepnt, twopnt, normal, &gap, &area, spair, NULL, NULL);
+    onepnt, twopnt, normal, &gap, &area, spair, NULL, NULL, NULL);
 
   if (state && gap <= ocd->gap)
   {
@@ -8344,20 +8884,81 @@ static PyObject* lng_BACKWARD (PyObject *self, PyObject *args, PyObject *kwds)
   Py_RETURN_NONE;
 }
 
+static int is_solfec_or_body_or_list_of_bodies (PyObject *obj, char *var); /* defined below */
+static SET* object_to_body_set (PyObject *obj, MEM *setmem, SOLFEC *sol); /* defined below */
+
 /* seek to time */
 static PyObject* lng_SEEK (PyObject *self, PyObject *args, PyObject *kwds)
 {
-  KEYWORDS ("solfec", "time");
+  KEYWORDS ("solfec", "time", "subset");
+  PyObject *subset, *list;
   lng_SOLFEC *solfec;
-  double time;
+  SET *bodies, *out, *item;
+  double time, box [6];
+  MEM setmem;
+  int i, error;
+
+  subset = NULL;
 
-  PARSEKEYS ("Od", &solfec, &time);
+  PARSEKEYS ("Od|O", &solfec, &time, &subset);
 
   TYPETEST (is_solfec (solfec, kwl[0]));
 
-  if (solfec->sol->mode == SOLFEC_READ) SOLFEC_Seek_To (solfec->sol, time); 
+  if (subset)
+  {
+    if (PyTuple_Check (subset))
+    {
+      TYPETEST (is_tuple (subset, kwl[2], 6));
+    }
+    else
+    {
+      TYPETEST (is_solfec_or_body_or_list_of_bodies (subset, kwl[2]));
+    }
+  }
+
+  if (solfec->sol->mode == SOLFEC_WRITE) Py_RETURN_NONE;
 
-  Py_RETURN_NONE;
+  if (subset == NULL || PyObject_IsInstance (subset, (PyObject*)&lng_SOLFEC_TYPE))
+  {
+    SOLFEC_Seek_To (solfec->sol, time); 
+
+    Py_RETURN_NONE;
+  }
+
+  /* partial read => return the list of read bodies */
+
+  MEM_Init (&setmem, sizeof (SET), 128);
+  bodies = out = NULL;
+
+  if (PyTuple_Check (subset))
+  {
+    for (i = 0; i < 6; i ++) box [i] = PyFloat_AsDouble (PyTuple_GetItem (subset, i));
+  }
+  else bodies = object_to_body_set (subset, &setmem, solfec->sol);
+
+  TRY ()
+  {
+    SOLFEC_Seek_Bodies (solfec->sol, time, bodies, PyTuple_Check (subset) ? box : NULL, &setmem, &out);
+  }
+  CATCHANY (error)
+  {
+    MEM_Release (&setmem);
+    PyErr_SetString (PyExc_RuntimeError, errstring (error));
+    return NULL;
+  }
+  ENDTRY ()
+
+  if ((list = PyList_New (SET_Size (out))))
+  {
+    for (i = 0, item = SET_First (out); item; i ++, item = SET_Next (item))
+    {
+      PyList_SetItem (list, i, lng_BODY_WRAPPER (item->data));
+    }
+  }
+
+  MEM_Release (&setmem);
+
+  return list;
 }
 
 /* get displacement */
@@ -8374,7 +8975,7 @@ static PyObject* lng_DISPLACEMENT (PyObject *self, PyObject *args, PyObject *kwd
   TYPETEST (is_body (body, kwl[0]) && is_tuple (point, kwl[1], 3));
 
 #if MPI
-  if (IS_HERE (body))
+  if (IS_VISIBLE (body))
   {
 #endif
 
@@ -8417,7 +9018,7 @@ static PyObject* lng_VELOCITY (PyObject *self, PyObject *args, PyObject *kwds)
   TYPETEST (is_body (body, kwl[0]) && is_tuple (point, kwl[1], 3));
 
 #if MPI
-  if (IS_HERE (body))
+  if (IS_VISIBLE (body))
   {
 #endif
 
@@ -8462,7 +9063,7 @@ static PyObject* lng_STRESS (PyObject *self, PyObject *args, PyObject *kwds)
   TYPETEST (is_body (body, kwl[0]) && is_tuple (point, kwl[1], 3));
 
 #if MPI
-  if (IS_HERE (body))
+  if (IS_VISIBLE (body))
   {
 #endif
 
@@ -8917,6 +9518,7 @@ static int parse_history_item (PyObject *obj, MEM *setmem, SOLFEC *sol, SHI *shi
     ELIF (obj, "GSRUN") { shi->item = TIMING_VALUE; }
     ELIF (obj, "GSCOM") { shi->item = TIMING_VALUE; }
     ELIF (obj, "GSMCOM") { shi->item = TIMING_VALUE; }
+    ELIF (obj, "GSWAIT") { shi->item = TIMING_VALUE; }
     ELIF (obj, "LININIT") { shi->item = TIMING_VALUE; }
     ELIF (obj, "LINUPD") { shi->item = TIMING_VALUE; }
     ELIF (obj, "LINMV") { shi->item = TIMING_VALUE; }
@@ -9117,14 +9719,19 @@ static PyMethodDef lng_methods [] =
   {"CONTACT_EXCLUDE_BODIES", (PyCFunction)lng_CONTACT_EXCLUDE_BODIES, METH_VARARGS|METH_KEYWORDS, "Exclude body pair from contact detection"},
   {"CONTACT_EXCLUDE_SURFACES", (PyCFunction)lng_CONTACT_EXCLUDE_SURFACES, METH_VARARGS|METH_KEYWORDS, "Exclude surface pair from contact detection"},
   {"CONTACT_SPARSIFY", (PyCFunction)lng_CONTACT_SPARSIFY, METH_VARARGS|METH_KEYWORDS, "Adjust contact sparsification"},
+  {"CONTACT_MANIFOLD", (PyCFunction)lng_CONTACT_MANIFOLD, METH_VARARGS|METH_KEYWORDS, "Adjust contact manifold caching"},
   {"RUN", (PyCFunction)lng_RUN, METH_VARARGS|METH_KEYWORDS, "Run analysis"},
   {"OUTPUT", (PyCFunction)lng_OUTPUT, METH_VARARGS|METH_KEYWORDS, "Set data output interval"},
+  {"CHECKPOINT", (PyCFunction)lng_CHECKPOINT, METH_VARARGS|METH_KEYWORDS, "Set restart checkpoint interval"},
   {"EXTENTS", (PyCFunction)lng_EXTENTS, METH_VARARGS|METH_KEYWORDS, "Set scene extents"},
   {"CALLBACK", (PyCFunction)lng_CALLBACK, METH_VARARGS|METH_KEYWORDS, "Set analysis callback"},
   {"UNPHYSICAL_PENETRATION", (PyCFunction)lng_UNPHYSICAL_PENETRATION, METH_VARARGS|METH_KEYWORDS, "Set unphysical penetration bound"},
   {"GEOMETRIC_EPSILON", (PyCFunction)lng_GEOMETRIC_EPSILON, METH_VARARGS|METH_KEYWORDS, "Set geometric epsilon"},
   {"WARNINGS", (PyCFunction)lng_WARNINGS, METH_VARARGS|METH_KEYWORDS, "Enable or disable warnings"},
+  {"REPRODUCIBLE_REDUCTIONS", (PyCFunction)lng_REPRODUCIBLE_REDUCTIONS, METH_VARARGS|METH_KEYWORDS, "Enable or disable reproducible reductions"},
+  {"MESSAGE_COMPRESSION", (PyCFunction)lng_MESSAGE_COMPRESSION, METH_VARARGS|METH_KEYWORDS, "Set message compression threshold"},
   {"INITIALIZE_STATE", (PyCFunction)lng_INITIALIZE_STATE, METH_VARARGS|METH_KEYWORDS, "Initialize Solfec state"},
+  {"RESTART", (PyCFunction)lng_RESTART, METH_VARARGS|METH_KEYWORDS, "Restart from checkpoint"},
   {"LOCDYN_DUMP", (PyCFunction)lng_LOCDYN_DUMP, METH_VARARGS|METH_KEYWORDS, "Dump local dynamics"},
   {"OVERLAPPING", (PyCFunction)lng_OVERLAPPING, METH_VARARGS|METH_KEYWORDS, "Detect shapes (not) overlapping obstacles"},
   {"MBFCP_EXPORT", (PyCFunction)lng_MBFCP_EXPORT, METH_VARARGS|METH_KEYWORDS, "Export MBFCP definition"},
@@ -9173,6 +9780,10 @@ static void initlng (const char *path)
     Py_TPFLAGS_DEFAULT, lng_ELLIP_dealloc, lng_ELLIP_new,
     lng_ELLIP_methods, lng_ELLIP_members, lng_ELLIP_getset);
 
+  TYPEINIT (lng_SDF_TYPE, lng_SDF, "solfec.SDF",
+    Py_TPFLAGS_DEFAULT, lng_SDF_dealloc, lng_SDF_new,
+    lng_SDF_methods, lng_SDF_members, lng_SDF_getset);
+
   TYPEINIT (lng_SOLFEC_TYPE, lng_SOLFEC, "solfec.SOLFEC",
     Py_TPFLAGS_DEFAULT, lng_SOLFEC_dealloc, lng_SOLFEC_new,
     lng_SOLFEC_methods, lng_SOLFEC_members, lng_SOLFEC_getset);
@@ -9227,6 +9838,7 @@ static void initlng (const char *path)
   if (PyType_Ready (&lng_MESH_TYPE) < 0) return;
   if (PyType_Ready (&lng_SPHERE_TYPE) < 0) return;
   if (PyType_Ready (&lng_ELLIP_TYPE) < 0) return;
+  if (PyType_Ready (&lng_SDF_TYPE) < 0) return;
   if (PyType_Ready (&lng_SOLFEC_TYPE) < 0) return;
   if (PyType_Ready (&lng_FIELD_TYPE) < 0) return;
   if (PyType_Ready (&lng_SURFACE_MATERIAL_TYPE) < 0) return;
@@ -9248,6 +9860,7 @@ static void initlng (const char *path)
   Py_INCREF (&lng_MESH_TYPE);
   Py_INCREF (&lng_SPHERE_TYPE);
   Py_INCREF (&lng_ELLIP_TYPE);
+  Py_INCREF (&lng_SDF_TYPE);
   Py_INCREF (&lng_SOLFEC_TYPE);
   Py_INCREF (&lng_FIELD_TYPE);
   Py_INCREF (&lng_SURFACE_MATERIAL_TYPE);
@@ -9267,6 +9880,7 @@ static void initlng (const char *path)
   PyModule_AddObject (m, "MESH", (PyObject*)&lng_MESH_TYPE);
   PyModule_AddObject (m, "SPHERE", (PyObject*)&lng_SPHERE_TYPE);
   PyModule_AddObject (m, "ELLIP", (PyObject*)&lng_ELLIP_TYPE);
+  PyModule_AddObject (m, "SDF", (PyObject*)&lng_SDF_TYPE);
   PyModule_AddObject (m, "SOLFEC", (PyObject*)&lng_SOLFEC_TYPE);
   PyModule_AddObject (m, "FIELD", (PyObject*)&lng_FIELD_TYPE);
   PyModule_AddObject (m, "SURFACE_MATERIAL", (PyObject*)&lng_SURFACE_MATERIAL_TYPE);
@@ -9311,6 +9925,7 @@ int lng (const char *path)
                      "from solfec import ROUGH_HEX\n"
                      "from solfec import SPHERE\n"
                      "from solfec import ELLIP\n"
+                     "from solfec import SDF\n"
                      "from solfec import SOLFEC\n"
                      "from solfec import FIELD\n"
                      "from solfec import SURFACE_MATERIAL\n"
@@ -9355,14 +9970,19 @@ int lng (const char *path)
                      "from solfec import CONTACT_EXCLUDE_BODIES\n"
                      "from solfec import CONTACT_EXCLUDE_SURFACES\n"
                      "from solfec import CONTACT_SPARSIFY\n"
+                     "from solfec import CONTACT_MANIFOLD\n"
                      "from solfec import RUN\n"
                      "from solfec import OUTPUT\n"
+                     "from solfec import CHECKPOINT\n"
                      "from solfec import EXTENTS\n"
                      "from solfec import CALLBACK\n"
                      "from solfec import UNPHYSICAL_PENETRATION\n"
                      "from solfec import GEOMETRIC_EPSILON\n"
                      "from solfec import WARNINGS\n"
+                     "from solfec import REPRODUCIBLE_REDUCTIONS\n"
+                     "from solfec import MESSAGE_COMPRESSION\n"
                      "from solfec import INITIALIZE_STATE\n"
+                     "from solfec import RESTART\n"
                      "from solfec import LOCDYN_DUMP\n"
                      "from solfec import OVERLAPPING\n"
                      "from solfec import MBFCP_EXPORT\n"
@@ -162,3 +162,26 @@ void MEM_Release (MEM *pool)
   pool->lastchunk = NULL;
   pool->deadchunks = NULL;
 }
+
+void MEM_Reset (MEM *pool)
+{
+#if MEMDEBUG
+  MEM_Release (pool);
+#else
+  void *block = pool->blocks;
+  size_t n;
+
+  if (block && ((PTR*)block)->p) /* more than one block => merge them in the future */
+  {
+    for (n = 0; block; block = ((PTR*)block)->p) n ++;
+    MEM_Release (pool);
+    pool->chunksinblock *= n;
+  }
+  else if (block) /* zero used chunks and rewind */
+  {
+    memset ((char*)block + sizeof(PTR), 0, pool->freechunk - ((char*)block + sizeof(PTR)));
+    pool->freechunk = (char*)block + sizeof(PTR);
+    pool->deadchunks = NULL;
+  }
+#endif
+}
@@ -54,4 +54,9 @@ size_t MEM_Size (MEM *pool);
 /* release memory pool memory back to system */
 void MEM_Release (MEM *pool);
 
+/* make all chunks free again while keeping the memory for reuse;
+ * a pool which outgrew a single block is released and the block
+ * size is increased, so that a steady state needs no allocations */
+void MEM_Reset (MEM *pool);
+
 #endif
@@ -27,6 +27,7 @@
 #include "mrf.h"
 #include "alg.h"
 #include "scf.h"
+#include "red.h"
 
 /* constraint satisfaction merit function approximately indicates the
  * amount of spurious momentum due to constraint force inaccuracy;
@@ -35,14 +36,15 @@
 double MERIT_Function (LOCDYN *ldy, short update_U)
 {
   double step, up, uplo [2], Q [3], P [3];
+  RED_SUM sum [2];
   SOLVER_KIND solver;
   short dynamic;
   DIAB *dia;
   OFFB *blk;
   CON *con;
 
-  uplo [0] = 0.0;
-  uplo [1] = ldy->free_energy < DBL_EPSILON ? 1.0 : ldy->free_energy; /* XXX => avoid division by zero */
+  RED_Init (&sum [0], 0.0);
+  RED_Init (&sum [1], ldy->free_energy < DBL_EPSILON ? 1.0 : ldy->free_energy); /* XXX => avoid division by zero */
   dynamic = ldy->dom->dynamic;
   step = ldy->dom->step;
   solver = ldy->dom->solfec->kind;
@@ -155,14 +157,16 @@ double MERIT_Function (LOCDYN *ldy, short update_U)
     }
 
     con->merit = up; /* per-constraint merit numerator */
-    uplo [0] += up;
+    RED_Add (&sum [0], up);
   }
 
 #if MPI
-  double inp [2] = {uplo [0], uplo [1]};
-  MPI_Allreduce (inp, uplo, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD); /* sum up */
+  RED_Allreduce (sum, 2, MPI_COMM_WORLD); /* sum up */
 #endif
 
+  uplo [0] = RED_Value (&sum [0]);
+  uplo [1] = RED_Value (&sum [1]);
+
   uplo [0] *= 0.5; /* was ommited above: E = 0.5 (AU, U) */
   uplo [1] = (uplo [1] == 0 ? 1 : uplo [1]);
 
@@ -958,7 +958,7 @@ static double* col (MX *a, int j, double *w)
 	  k, l, o;
 
 #if DEBUG
-      static int j_prev = -1;
+      static __thread int j_prev = -1;
       ASSERT_DEBUG (j == (j_prev + 1), "Column retrival must be called for a sequence of js: 0, 1, 2, ..., n");
       j_prev = j;
 #endif
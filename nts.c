@@ -35,6 +35,7 @@
 #include "scf.h"
 #include "mrf.h"
 #include "lis.h"
+#include "red.h"
 #include "ext/krylov/krylov.h"
 
 #if MPI
@@ -513,19 +514,19 @@ static int DestroyVector (VECTOR *a)
 
 static double InnerProd (VECTOR *a, VECTOR *b)
 {
-  double dot = 0.0, *x, *y, *z;
+  double *x, *y, *z;
+  RED_SUM dot;
 
-  for (x = a->x, z = x + a->n, y = b->x; x < z; x ++, y ++)
+  for (RED_Init (&dot, 0.0), x = a->x, z = x + a->n, y = b->x; x < z; x ++, y ++)
   {
-    dot += (*x) * (*y);
+    RED_Add (&dot, (*x) * (*y));
   }
 
 #if MPI
-  double val = dot;
-  MPI_Allreduce (&val, &dot, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  RED_Allreduce (&dot, 1, MPI_COMM_WORLD);
 #endif
 
-  return dot;
+  return RED_Value (&dot);
 }
 
 static int CopyVector (VECTOR *a, VECTOR *b)
@@ -661,11 +662,91 @@ static int PrecondSetup (void *vdata, void *A, void *b, void *x)
   return 0;
 }
 
+/* apply the linearization row operator to an off-diagonal product w = W(i,j) R(j) */
+static void offdiag_row (CON_DATA *dat, double *w)
+{
+  double z [3];
+
+  switch (dat->con->kind)
+  {
+  case VELODIR:
+  case FIXDIR:
+  case RIGLNK:
+  {
+    w [0] = w [1] = 0.0;
+  }
+  break;
+  case SPRING:
+  {
+    w [0] = w [1] = 0.0;
+    w [2] *= dat->X[8];
+  }
+  break;
+  case CONTACT:
+  {
+    NVMUL (dat->X, w, z);
+    COPY (z, w);
+  }
+  break;
+  default:
+  break;
+  }
+}
+
+/* block-Jacobi preconditioner: each processor owns one block, approximately inverted
+ * by Gauss-Seidel sweeps over the local W adjacency (the external adjacency is skipped);
+ * constraint reactions are used as the iterate storage, as in Matvec */
+static void block_jacobi (PRIVATE *A, VECTOR *b, VECTOR *x)
+{
+  double w [3], z [3], *Q, *R;
+  CON_DATA *dat;
+  DIAB *dia;
+  OFFB *blk;
+  int k;
+
+  for (dat = A->dat; dat != A->end; dat ++)
+  {
+    R = dat->con->R;
+    SET (R, 0.0);
+  }
+
+  for (k = 0; k < A->ns->linsweeps; k ++)
+  {
+    for (dat = A->dat, Q = b->x; dat != A->end; dat ++, Q += 3)
+    {
+      dia = dat->con->dia;
+
+      SET (w, 0.0);
+      for (blk = dia->adj; blk; blk = blk->n)
+      {
+	NVADDMUL (w, blk->W, blk->dia->R, w);
+      }
+      offdiag_row (dat, w);
+
+      SUB (Q, w, z);
+      NVMUL (dat->T, z, dia->R);
+    }
+  }
+
+  for (dat = A->dat, Q = x->x; dat != A->end; dat ++, Q += 3)
+  {
+    R = dat->con->R;
+    COPY (R, Q);
+  }
+}
+
 static int Precond (void *vdata, PRIVATE *A, VECTOR *b, VECTOR *x)
 {
   double *T, *Q, *R;
   CON_DATA *dat;
 
+  if (A->ns->linprec == PQN_PREC_BLOCK_JACOBI && A->ns->locdyn == LOCDYN_ON)
+  {
+    block_jacobi (A, b, x);
+
+    return 0;
+  }
+
   for (dat = A->dat, R = x->x, Q = b->x; dat != A->end; dat ++, R += 3, Q += 3)
   {
 #if MPI
@@ -684,6 +765,7 @@ static int body_space_constraints_data (DOM *dom, PRIVATE *A)
 {
   LOCDYN *ldy = dom->ldy;
   MAP *item, *fem;
+  RED_SUM energy;
   int ndat, ret;
   CON_DATA *dat;
   double step;
@@ -694,7 +776,6 @@ static int body_space_constraints_data (DOM *dom, PRIVATE *A)
 
   ret = 0;
   fem = NULL;
-  ldy->free_energy = 0.0;
   ndat = dom->ncon;
 #if MPI
   ndat += MAP_Size (dom->conext);
@@ -822,7 +903,7 @@ static int body_space_constraints_data (DOM *dom, PRIVATE *A)
   A->end = dat;
 
   /* process diagonal blocks */
-  for (dat = A->dat; dat != A->end; dat ++)
+  for (RED_Init (&energy, 0.0), dat = A->dat; dat != A->end; dat ++)
   {
     con = dat->con;
     DIAB *dia = con->dia;
@@ -834,15 +915,15 @@ static int body_space_constraints_data (DOM *dom, PRIVATE *A)
     MX_Copy (&W, &A);
     MX_Inverse (&A, &A);
     NVMUL (A.x, B, X);
-    ldy->free_energy += DOT (X, B); /* sum up free energy */
+    RED_Add (&energy, DOT (X, B)); /* sum up free energy */
 
     /* add up prescribed velocity contribution */
     if (con->kind == VELODIR)
     {
-      ldy->free_energy += A.x[8] * VELODIR(con->Z) * VELODIR(con->Z);
+      RED_Add (&energy, A.x[8] * VELODIR(con->Z) * VELODIR(con->Z));
     }
   }
-  ldy->free_energy *= 0.5;
+  ldy->free_energy = 0.5 * RED_Value (&energy);
 
   for (item = MAP_First (fem); item; item = MAP_Next (item)) MX_Destroy (item->data);
   MAP_Free (NULL, &fem);
@@ -1286,6 +1367,8 @@ NEWTON* NEWTON_Create (double meritval, int maxiter)
   ns->locdyn = LOCDYN_ON;
   ns->linver = PQN_GMRES;
   ns->linmaxiter = 10;
+  ns->linprec = PQN_PREC_DIAG;
+  ns->linsweeps = 2;
   ns->maxmatvec = ns->linmaxiter * maxiter;
   ns->epsilon = 0.25;
   ns->delta = 0.0;
@@ -40,6 +40,10 @@ struct newton
 
   int linmaxiter; /* linear solver iterations bound */
 
+  enum {PQN_PREC_DIAG, PQN_PREC_BLOCK_JACOBI} linprec; /* GMRES preconditioner */
+
+  int linsweeps; /* Gauss-Seidel sweeps per block of the block-Jacobi preconditioner */
+
   int maxmatvec; /* matrix-vector products bound */
 
   double epsilon; /* linear solver epsilon */
@@ -29,17 +29,47 @@
 #include <string.h>
 #include "pbf.h"
 #include "pck.h"
+#include "alg.h"
 #include "err.h"
 
-/* create or open group */
-static hid_t gmake (hid_t loc_id, const char *name)
-{
-  if (H5Lexists (loc_id, name, H5P_DEFAULT))
-  {
-    return H5Gopen (loc_id, name, H5P_DEFAULT);
-  }
-  else return H5Gcreate (loc_id, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-}
+/*
+ * HDF5 file layout
+ * ----------------
+ *
+ * Each time frame is a group "/N" with the "time" attribute and 1D datasets:
+ *
+ * "i"     - ints of all parts (one part after another)
+ * "d"     - doubles of all parts
+ * "l"     - label names of all parts (NUL-terminated)
+ * "p"     - (ipos, dpos) label pairs of all parts (relative to the part)
+ * "parts" - numbers of ints, doubles, label chars and label pair ints of each part
+ *
+ * A serial file has one part. In MPI runs linked against parallel HDF5 all ranks
+ * write a single shared file collectively, one part per rank, and the root group
+ * stores the number of parts in the "ranks" attribute; otherwise each rank writes
+ * its own PATH.h5.RANK file; PBF_Merge turns these into a single file with the
+ * shared layout, which is then read instead. Frames without "parts" come from
+ * older versions: their counts are stored in "ints" and "doubles" attributes and
+ * their labels as attributes of the "LABELS" subgroup.
+ *
+ * With compression on, datasets of at least PBF_MINZIP items are chunked,
+ * shuffled and deflated. Reading a part selects a hyperslab of each dataset.
+ */
+
+#define PBF_MINZIP 1024 /* minimal size of a compressed dataset */
+
+#define PBF_CHUNK 16384 /* maximal chunk size of a compressed dataset */
+
+#define PBF_DEFLATE 4 /* deflate level */
+
+#if MPI && defined(H5_HAVE_PARALLEL)
+#define SHARED(bf) ((bf)->mode == PBF_WRITE && (bf)->parallel == PBF_ON)
+#else
+#define SHARED(bf) 0
+#endif
+
+/* current frame group or root group of a frameless file */
+#define FRAME(bf) ((bf)->top > 0 ? (bf)->stack [1] : (bf)->stack [0])
 
 /* push new frame group */
 static void new_frame (PBF *bf, int frame, double *time)
@@ -53,34 +83,178 @@ static void new_frame (PBF *bf, int frame, double *time)
   bf->frame = frame;
 }
 
+/* create 1D dataset of 'total' items and write 'count' of them starting at 'offset' (collectively in a shared file) */
+static void write_part (PBF *bf, hid_t loc, const char *name, hid_t type, hsize_t total, hsize_t offset, hsize_t count, void *data)
+{
+  hid_t dcpl, xfer, fspace, mspace, dset;
+  hsize_t chunk, one = 1;
+
+  ASSERT ((dcpl = H5Pcreate (H5P_DATASET_CREATE)) >= 0, ERR_PBF_WRITE);
+
+  if (bf->compression == PBF_ON && total >= PBF_MINZIP)
+  {
+    chunk = MIN (total, PBF_CHUNK);
+    ASSERT (H5Pset_chunk (dcpl, 1, &chunk) >= 0, ERR_PBF_WRITE);
+    ASSERT (H5Pset_shuffle (dcpl) >= 0, ERR_PBF_WRITE);
+    ASSERT (H5Pset_deflate (dcpl, PBF_DEFLATE) >= 0, ERR_PBF_WRITE);
+  }
+
+  ASSERT ((xfer = H5Pcreate (H5P_DATASET_XFER)) >= 0, ERR_PBF_WRITE);
+
+#if MPI && defined(H5_HAVE_PARALLEL)
+  if (SHARED (bf)) ASSERT (H5Pset_dxpl_mpio (xfer, H5FD_MPIO_COLLECTIVE) >= 0, ERR_PBF_WRITE);
+#endif
+
+  ASSERT ((fspace = H5Screate_simple (1, &total, NULL)) >= 0, ERR_PBF_WRITE);
+  ASSERT ((dset = H5Dcreate (loc, name, type, fspace, H5P_DEFAULT, dcpl, H5P_DEFAULT)) >= 0, ERR_PBF_WRITE);
+
+  if (count > 0)
+  {
+    H5Sselect_hyperslab (fspace, H5S_SELECT_SET, &offset, NULL, &count, NULL);
+    mspace = H5Screate_simple (1, &count, NULL);
+  }
+  else /* still take part in a collective write */
+  {
+    H5Sselect_none (fspace);
+    mspace = H5Screate_simple (1, &one, NULL);
+    H5Sselect_none (mspace);
+    data = &one;
+  }
+
+  ASSERT (H5Dwrite (dset, type, mspace, fspace, xfer, data) >= 0, ERR_PBF_WRITE);
+
+  H5Sclose (mspace);
+  H5Sclose (fspace);
+  H5Dclose (dset);
+  H5Pclose (xfer);
+  H5Pclose (dcpl);
+}
+
+/* read 'count' items of 1D dataset starting at 'offset' */
+static void read_part (hid_t loc, const char *name, hid_t type, hsize_t offset, hsize_t count, void *data)
+{
+  hid_t fspace, mspace, dset;
+
+  if (count == 0) return;
+
+  ASSERT ((dset = H5Dopen (loc, name, H5P_DEFAULT)) >= 0, ERR_PBF_READ);
+  fspace = H5Dget_space (dset);
+  ASSERT (H5Sselect_hyperslab (fspace, H5S_SELECT_SET, &offset, NULL, &count, NULL) >= 0, ERR_PBF_READ);
+  mspace = H5Screate_simple (1, &count, NULL);
+  ASSERT (H5Dread (dset, type, mspace, fspace, H5P_DEFAULT, data) >= 0, ERR_PBF_READ);
+
+  H5Sclose (mspace);
+  H5Sclose (fspace);
+  H5Dclose (dset);
+}
+
 /* read new frame */
 static void read_frame (PBF *bf, int frame, double *time)
 {
+  hid_t loc;
+
   if (frame >= 0 && frame < bf->count) /* could be a frameless file */
   {
     new_frame (bf, frame, time);
   }
 
+  loc = FRAME (bf);
+
+  MAP_Free (&bf->mapmem, &bf->labels);
+
   free (bf->i);
   bf->ipos = 0;
-  PBF_Int2 (bf, "ints", &bf->ints, 1);
-  ERRMEM (bf->i = malloc (sizeof (int [bf->ints])));
-  PBF_Int2 (bf, "i", bf->i, bf->ints);
-
   free (bf->d);
   bf->dpos = 0;
-  PBF_Int2 (bf, "doubles", &bf->doubles, 1);
-  ERRMEM (bf->d = malloc (sizeof (double [bf->doubles])));
-  PBF_Double2 (bf, "d", bf->d, bf->doubles);
+  free (bf->l);
+  free (bf->p);
+
+  if (H5Lexists (loc, "parts", H5P_DEFAULT))
+  {
+    hsize_t off [4] = {0, 0, 0, 0}, parts;
+    int *cnt, n, k;
+
+    ASSERT (H5LTget_dataset_info (loc, "parts", &parts, NULL, NULL) >= 0, ERR_PBF_READ);
+    ERRMEM (cnt = malloc (sizeof (int [parts])));
+    read_part (loc, "parts", H5T_NATIVE_INT, 0, parts, cnt);
+
+    for (n = 0; n < bf->rank && 4*n < (int) parts; n ++)
+    {
+      for (k = 0; k < 4; k ++) off [k] += cnt [4*n+k];
+    }
+
+    if (4*bf->rank < (int) parts) /* this part was written */
+    {
+      bf->ints = cnt [4*bf->rank];
+      bf->doubles = cnt [4*bf->rank+1];
+      bf->lsize = cnt [4*bf->rank+2];
+      bf->psize = cnt [4*bf->rank+3];
+    }
+    else bf->ints = bf->doubles = bf->lsize = bf->psize = 0;
+
+    free (cnt);
+
+    ERRMEM (bf->i = malloc (sizeof (int [bf->ints])));
+    ERRMEM (bf->d = malloc (sizeof (double [bf->doubles])));
+    ERRMEM (bf->l = malloc (sizeof (char [bf->lsize])));
+    ERRMEM (bf->p = malloc (sizeof (int [bf->psize])));
+    read_part (loc, "i", H5T_NATIVE_INT, off [0], bf->ints, bf->i);
+    read_part (loc, "d", H5T_NATIVE_DOUBLE, off [1], bf->doubles, bf->d);
+    read_part (loc, "l", H5T_NATIVE_CHAR, off [2], bf->lsize, bf->l);
+    read_part (loc, "p", H5T_NATIVE_INT, off [3], bf->psize, bf->p);
+    ASSERT (bf->lsize == 0 || bf->l [bf->lsize-1] == '\0', ERR_PBF_READ);
+
+    bf->legacy = 0;
+  }
+  else /* older layout */
+  {
+    PBF_Int2 (bf, "ints", &bf->ints, 1);
+    ERRMEM (bf->i = malloc (sizeof (int [bf->ints])));
+    PBF_Int2 (bf, "i", bf->i, bf->ints);
+
+    PBF_Int2 (bf, "doubles", &bf->doubles, 1);
+    ERRMEM (bf->d = malloc (sizeof (double [bf->doubles])));
+    PBF_Double2 (bf, "d", bf->d, bf->doubles);
+
+    bf->l = NULL;
+    bf->p = NULL;
+    bf->lsize = bf->psize = 0;
+    bf->legacy = 1;
+  }
 }
 
 /* write last frame data */
 static void write_frame (PBF *bf)
 {
-  PBF_Int2 (bf, "ints", &bf->ipos, 1);
-  PBF_Int2 (bf, "i", bf->i, bf->ipos);
-  PBF_Int2 (bf, "doubles", &bf->dpos, 1);
-  PBF_Double2 (bf, "d", bf->d, bf->dpos);
+  hsize_t off [4] = {0, 0, 0, 0}, tot [4] = {0, 0, 0, 0};
+  int cnt [4] = {bf->ipos, bf->dpos, bf->lpos, bf->ppos}, *all, n, k;
+  hid_t loc = FRAME (bf);
+
+  ERRMEM (all = malloc (sizeof (int [4 * bf->size])));
+
+#if MPI && defined(H5_HAVE_PARALLEL)
+  if (SHARED (bf)) MPI_Allgather (cnt, 4, MPI_INT, all, 4, MPI_INT, MPI_COMM_WORLD);
+  else
+#endif
+  memcpy (all, cnt, sizeof (int [4]));
+
+  for (n = 0; n < bf->size; n ++)
+  {
+    for (k = 0; k < 4; k ++)
+    {
+      if (n < bf->rank) off [k] += all [4*n+k];
+      tot [k] += all [4*n+k];
+    }
+  }
+
+  write_part (bf, loc, "i", H5T_NATIVE_INT, tot [0], off [0], cnt [0], bf->i);
+  write_part (bf, loc, "d", H5T_NATIVE_DOUBLE, tot [1], off [1], cnt [1], bf->d);
+  write_part (bf, loc, "l", H5T_NATIVE_CHAR, tot [2], off [2], cnt [2], bf->l);
+  write_part (bf, loc, "p", H5T_NATIVE_INT, tot [3], off [3], cnt [3], bf->p);
+  write_part (bf, loc, "parts", H5T_NATIVE_INT, 4 * bf->size, 0, bf->rank ? 0 : 4 * bf->size, all);
+
+  free (all);
+
   H5Fflush (bf->stack[0], H5F_SCOPE_GLOBAL); /* fixes Issue 55 ? */
 }
 
@@ -115,10 +289,48 @@ static void initialize_time_frames (PBF *bf)
   }
 }
 
+/* create reading structure for an open file */
+static PBF* read_init (hid_t file, PBF_FLG parallel)
+{
+  PBF *bf;
+
+  ERRMEM (bf = malloc (sizeof (PBF)));
+  bf->mode = PBF_READ;
+  bf->compression = PBF_OFF;
+  bf->parallel = parallel;
+
+  bf->times = NULL;
+  bf->time = 0.0;
+
+  bf->i = NULL;
+  bf->ipos = bf->ints = 0;
+  bf->d = NULL;
+  bf->dpos = bf->doubles = 0;
+
+  bf->l = NULL;
+  bf->lpos = bf->lsize = 0;
+  bf->p = NULL;
+  bf->ppos = bf->psize = 0;
+  MEM_Init (&bf->mapmem, sizeof (MAP), 128);
+  bf->labels = NULL;
+  bf->legacy = 0;
+
+  bf->rank = 0;
+  bf->size = 1;
+
+  bf->stack[0] = file;
+  bf->top = 0; /* set to zero before frames are initialized (while loop in new_frame) */
+
+  bf->next = NULL;
+
+  return bf;
+}
+
 /* =================== INTERFACE ==================== */
 
 PBF* PBF_Write (const char *path, PBF_FLG append, PBF_FLG parallel)
 {
+  hid_t fapl = H5P_DEFAULT;
   FILE *dat;
   char *txt;
   PBF *bf;
@@ -136,13 +348,37 @@ PBF* PBF_Write (const char *path, PBF_FLG append, PBF_FLG parallel)
   bf->d = NULL;
   bf->dpos = bf->doubles = 0;
 
+  bf->l = NULL;
+  bf->lpos = bf->lsize = 0;
+  bf->p = NULL;
+  bf->ppos = bf->psize = 0;
+  MEM_Init (&bf->mapmem, sizeof (MAP), 128);
+  bf->labels = NULL;
+  bf->legacy = 0;
+
+  bf->rank = 0;
+  bf->size = 1;
+
 #if MPI
   if (parallel == PBF_ON)
   {
     int rank;
     bf->parallel = PBF_ON;
     MPI_Comm_rank (MPI_COMM_WORLD, &rank);
+#if defined(H5_HAVE_PARALLEL)
+    bf->rank = rank;
+    MPI_Comm_size (MPI_COMM_WORLD, &bf->size);
+    ASSERT ((fapl = H5Pcreate (H5P_FILE_ACCESS)) >= 0, ERR_PBF_WRITE);
+    ASSERT (H5Pset_fapl_mpio (fapl, MPI_COMM_WORLD, MPI_INFO_NULL) >= 0, ERR_PBF_WRITE);
+    sprintf (txt, "%s.h5", path);
+#else
+    if (rank == 0) /* remove stale merged file */
+    {
+      sprintf (txt, "%s.h5", path);
+      remove (txt);
+    }
     sprintf (txt, "%s.h5.%d", path, rank);
+#endif
   }
   else
 #endif
@@ -156,7 +392,11 @@ PBF* PBF_Write (const char *path, PBF_FLG append, PBF_FLG parallel)
   if (append == PBF_ON && (dat = fopen (txt, "r")) != NULL) /* HDF5 is noisy if file does not exist */
   {
     fclose (dat);
-    if ((bf->stack[0] = H5Fopen(txt, H5F_ACC_RDWR, H5P_DEFAULT)) < 0)
+    bf->stack[0] = H5Fopen(txt, H5F_ACC_RDWR, fapl);
+
+    if (fapl != H5P_DEFAULT) H5Pclose (fapl);
+
+    if (bf->stack[0] < 0)
     {
       free (bf);
       free (txt);
@@ -169,7 +409,11 @@ PBF* PBF_Write (const char *path, PBF_FLG append, PBF_FLG parallel)
   }
   else /* write from scratch */
   {
-    if ((bf->stack[0] = H5Fcreate(txt, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+    bf->stack[0] = H5Fcreate(txt, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+
+    if (fapl != H5P_DEFAULT) H5Pclose (fapl);
+
+    if (bf->stack[0] < 0)
     {
       free (bf);
       free (txt);
@@ -180,6 +424,19 @@ PBF* PBF_Write (const char *path, PBF_FLG append, PBF_FLG parallel)
     bf->frame = 0;
   }
 
+  if (SHARED (bf)) /* store number of parts (maximal over appended runs) */
+  {
+    int ranks = bf->size, n;
+
+    if (H5LTfind_attribute (bf->stack[0], "ranks"))
+    {
+      ASSERT (H5LTget_attribute_int (bf->stack[0], ".", "ranks", &n) >= 0, ERR_PBF_WRITE);
+      if (n > ranks) ranks = n;
+    }
+
+    ASSERT (H5LTset_attribute_int (bf->stack[0], ".", "ranks", &ranks, 1) >= 0, ERR_PBF_WRITE);
+  }
+
   bf->next = NULL;
 
   free (txt);
@@ -191,61 +448,90 @@ PBF* PBF_Read (const char *path)
   PBF *bf, *out;
   FILE *dat;
   char *txt;
+  hid_t file;
   int n, m;
 
   ERRMEM (txt = malloc (strlen (path) + 64));
 
-  /* count input files */
+  /* count per-rank input files, unless they have been merged */
   m = 0;
-  do
+  sprintf (txt, "%s.h5", path);
+  if ((dat = fopen (txt, "r"))) fclose (dat);
+  else do
   {
     sprintf (txt, "%s.h5.%d", path, m);
     dat = fopen (txt, "r");
   } while (dat && fclose (dat) == 0 && ++ m); /* m incremented as last */
 
-  /* open input files */
   out = NULL;
-  n = m-1;
-  do
+
+  if (m) /* open per-rank input files */
   {
-    ERRMEM (bf = malloc (sizeof (PBF)));
-    bf->mode = PBF_READ;
-    bf->compression = PBF_OFF;
-    if (m) bf->parallel = PBF_ON;
-    else bf->parallel = PBF_OFF;
+    n = m-1;
+    do
+    {
+      sprintf (txt, "%s.h5.%d", path, n);
+
+      if ((file = H5Fopen(txt, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0)
+      {
+	PBF_Close (out);
+	free (txt);
+	return NULL;
+      }
+
+      bf = read_init (file, PBF_ON);
+
+      initialize_time_frames (bf); /* initialize frames */
+
+      bf->next = out;
+      out = bf;
+
+    } while (-- n >= 0); /* the first item in the returned list corresponds to rank 0 */
+  }
+  else /* open a single, possibly shared, file */
+  {
+    sprintf (txt, "%s.h5", path);
 
-    if (m) sprintf (txt, "%s.h5.%d", path, n);
-    else sprintf (txt, "%s.h5", path);
-    
     dat = fopen (txt, "r"); /* H5Fopen is noisy if file does not exist */
     if (!dat)
     {
-      free (bf);
       free (txt);
       return NULL;
     }
     else fclose (dat);
 
-    if ((bf->stack[0] = H5Fopen(txt, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0)
+    if ((file = H5Fopen(txt, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0)
     {
-      free (bf);
       free (txt);
       return NULL;
     }
 
-    bf->i = NULL;
-    bf->ipos = bf->ints = 0;
-    bf->d = NULL;
-    bf->dpos = bf->doubles = 0;
+    m = 0; /* "ranks" is only written in MPI runs */
+    if (H5LTfind_attribute (file, "ranks"))
+    {
+      ASSERT (H5LTget_attribute_int (file, ".", "ranks", &m) >= 0, ERR_PBF_READ);
+    }
 
-    bf->top = 0; /* set to zero before frames are initialized (while loop in new_frame) */
+    out = read_init (file, m ? PBF_ON : PBF_OFF);
 
-    initialize_time_frames (bf); /* initialize frames */
+    if (m == 0) m = 1;
 
-    bf->next = out;
-    out = bf;
+    initialize_time_frames (out); /* initialize frames once */
 
-  } while (-- n >= 0); /* the first item in the returned list corresponds to rank 0 */
+    for (n = m-1; n > 0; n --) /* the remaining parts share the file and the frame times */
+    {
+      bf = read_init (H5Freopen (file), PBF_ON);
+      bf->count = out->count;
+      ERRMEM (bf->times = malloc (sizeof (double [bf->count])));
+      memcpy (bf->times, out->times, sizeof (double [bf->count]));
+      bf->rank = n;
+      bf->size = m;
+      bf->next = out->next;
+      out->next = bf;
+    }
+
+    out->size = m;
+  }
 
   for (bf = out; bf; bf = bf->next) /* for all input files */
   {
@@ -266,6 +552,12 @@ void PBF_Close (PBF *bf)
 
     if (bf->times) free (bf->times); /* may exist in both modes (appended wrie) */
 
+    free (bf->i);
+    free (bf->d);
+    free (bf->l);
+    free (bf->p);
+    MEM_Release (&bf->mapmem);
+
     while (bf->top > 0) PBF_Pop (bf);
     H5Fclose (bf->stack[0]);
 
@@ -286,6 +578,8 @@ void PBF_Time (PBF *bf, double *time)
 
     bf->ipos = bf->dpos = 0; /* zero buffer pointers */
 
+    bf->lpos = bf->ppos = 0;
+
     bf->time = *time;
 
     bf->frame ++; /* next frame counter */
@@ -302,18 +596,23 @@ int PBF_Label (PBF *bf, const char *label)
 
   if (bf->mode == PBF_WRITE)
   {
-    hid_t g = gmake (bf->stack[1], "LABELS");
+    int len = strlen (label) + 1,
+        pos [2] = {bf->ipos, bf->dpos};
 
-    ASSERT (g >= 0, ERR_PBF_WRITE);
+    if (bf->lsize < bf->lpos + len)
+    {
+      bf->lsize = 2 * (bf->lpos + len);
+      ERRMEM (bf->l = realloc (bf->l, bf->lsize));
+    }
 
-    int data [2] = {bf->ipos, bf->dpos};
+    memcpy (&bf->l [bf->lpos], label, len);
+    bf->lpos += len;
 
-    ASSERT (H5LTset_attribute_int (g, ".", label, data, 2) >= 0, ERR_PBF_WRITE);
+    pack_ints (&bf->psize, &bf->p, &bf->ppos, pos, 2);
 
-    H5Gclose (g);
     return 1;
   }
-  else
+  else if (bf->legacy)
   {
     if (!H5Lexists (bf->stack[1], "LABELS", H5P_DEFAULT)) return 0;
 
@@ -336,6 +635,35 @@ int PBF_Label (PBF *bf, const char *label)
     H5Gclose (g);
     return 1;
   }
+  else
+  {
+    MAP *item;
+    char *name;
+    int k;
+
+    if (!bf->labels) /* map labels of the current frame */
+    {
+      for (k = 0, name = bf->l; k < bf->psize; k += 2, name += strlen (name) + 1)
+      {
+	ASSERT (name < bf->l + bf->lsize, ERR_PBF_READ);
+
+	if (!(item = MAP_Insert (&bf->mapmem, &bf->labels, name, NULL, (MAP_Compare) strcmp)))
+	{
+	  item = MAP_Find_Node (bf->labels, name, (MAP_Compare) strcmp);
+	}
+
+	item->data = (void*) (long) k; /* a repeated label overrides the previous one */
+      }
+    }
+
+    if (!(item = MAP_Find_Node (bf->labels, (void*) label, (MAP_Compare) strcmp))) return 0;
+
+    k = (int) (long) item->data;
+    bf->ipos = bf->p [k];
+    bf->dpos = bf->p [k+1];
+
+    return 1;
+  }
 }
 
 void PBF_Short (PBF *bf, short *value, int length)
@@ -469,7 +797,7 @@ void PBF_Int2 (PBF *bf, const char *name, int *value, hsize_t length)
     }
     else
     {
-      ASSERT (H5LTmake_dataset_int (bf->stack [bf->top], name, 1, &length, value) >= 0, ERR_PBF_WRITE);
+      write_part (bf, bf->stack [bf->top], name, H5T_NATIVE_INT, length, 0, bf->rank ? 0 : length, value);
     }
   }
   else
@@ -495,7 +823,7 @@ void PBF_Double2 (PBF *bf, const char *name, double *value, hsize_t length)
     }
     else
     {
-      ASSERT (H5LTmake_dataset_double (bf->stack [bf->top], name, 1, &length, value) >= 0, ERR_PBF_WRITE);
+      write_part (bf, bf->stack [bf->top], name, H5T_NATIVE_DOUBLE, length, 0, bf->rank ? 0 : length, value);
     }
   }
   else
@@ -649,8 +977,173 @@ unsigned int PBF_Span (PBF *bf, double t0, double t1)
   return 0;
 }
 
+/* copy an attribute to the 'dst' object */
+static herr_t copy_attribute (hid_t loc, const char *name, const H5A_info_t *info, void *dst)
+{
+  hid_t src, type, space, attr;
+  void *buf;
+
+  if (strcmp (name, "ranks") == 0) return 0; /* set by the caller */
+
+  ASSERT ((src = H5Aopen (loc, name, H5P_DEFAULT)) >= 0, ERR_PBF_READ);
+  type = H5Aget_type (src);
+  space = H5Aget_space (src);
+  ERRMEM (buf = malloc (H5Tget_size (type) * (H5Sget_simple_extent_npoints (space) + 1)));
+  ASSERT (H5Aread (src, type, buf) >= 0, ERR_PBF_READ);
+  ASSERT ((attr = H5Acreate2 (*(hid_t*)dst, name, type, space, H5P_DEFAULT, H5P_DEFAULT)) >= 0, ERR_PBF_WRITE);
+  ASSERT (H5Awrite (attr, type, buf) >= 0, ERR_PBF_WRITE);
+
+  H5Aclose (attr);
+  free (buf);
+  H5Sclose (space);
+  H5Tclose (type);
+  H5Aclose (src);
+
+  return 0;
+}
+
+/* copy a linked object to the 'dst' group, except for the frames and the frame data merged by the caller */
+static herr_t copy_link (hid_t loc, const char *name, const H5L_info_t *info, void *dst)
+{
+  char *data [] = {"i", "d", "l", "p", "parts", NULL}, **n;
+
+  if (name [strspn (name, "0123456789")] == '\0') return 0; /* a frame */
+
+  for (n = data; *n; n ++) if (strcmp (name, *n) == 0) return 0;
+
+  ASSERT (H5Ocopy (loc, name, *(hid_t*)dst, name, H5P_DEFAULT, H5P_DEFAULT) >= 0, ERR_PBF_WRITE);
+
+  return 0;
+}
+
+/* does a frame dataset use filters (compression) */
+static int filtered (hid_t loc, const char *name)
+{
+  hid_t dset, dcpl;
+  int n;
+
+  ASSERT ((dset = H5Dopen (loc, name, H5P_DEFAULT)) >= 0, ERR_PBF_READ);
+  dcpl = H5Dget_create_plist (dset);
+  n = H5Pget_nfilters (dcpl);
+  H5Pclose (dcpl);
+  H5Dclose (dset);
+
+  return n > 0;
+}
+
+/* merge per-rank files into a single file in the shared layout: the frame data of all ranks
+ * are concatenated as parts, while other objects are copied from rank 0 (as in a shared write) */
+int PBF_Merge (const char *path)
+{
+  char *txt, *name [4] = {"i", "d", "l", "p"};
+  hid_t type [4] = {H5T_NATIVE_INT, H5T_NATIVE_DOUBLE, H5T_NATIVE_CHAR, H5T_NATIVE_INT};
+  size_t size [4] = {sizeof (int), sizeof (double), sizeof (char), sizeof (int)};
+  hid_t *src, dst, file;
+  hsize_t tot [4], off, cnt;
+  int n, m, k, r, count, *parts;
+  char frame [128], *data;
+  PBF **in, out;
+  FILE *dat;
+
+  ERRMEM (txt = malloc (strlen (path) + 64));
+
+  /* count input files */
+  m = 0;
+  do
+  {
+    sprintf (txt, "%s.h5.%d", path, m);
+    dat = fopen (txt, "r");
+  } while (dat && fclose (dat) == 0 && ++ m); /* m incremented as last */
+
+  if (m == 0)
+  {
+    free (txt);
+    return 0;
+  }
+
+  ERRMEM (in = malloc (sizeof (PBF*) * m));
+  ERRMEM (src = malloc (sizeof (hid_t) * m));
+  ERRMEM (parts = malloc (sizeof (int [4*m])));
+
+  for (r = 0; r < m; r ++)
+  {
+    sprintf (txt, "%s.h5.%d", path, r);
+    ASSERT ((file = H5Fopen (txt, H5F_ACC_RDONLY, H5P_DEFAULT)) >= 0, ERR_FILE_OPEN);
+    in [r] = read_init (file, PBF_ON);
+  }
+
+  count = count_time_frames (in [0]);
+  for (r = 1; r < m; r ++) ASSERT (count_time_frames (in [r]) == count, ERR_FILE_FORMAT);
+
+  sprintf (txt, "%s.h5", path);
+  ASSERT ((file = H5Fcreate (txt, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) >= 0, ERR_FILE_OPEN);
+  ASSERT (H5Aiterate2 (in [0]->stack[0], H5_INDEX_NAME, H5_ITER_NATIVE, NULL, copy_attribute, &file) >= 0, ERR_PBF_WRITE);
+  ASSERT (H5Literate (in [0]->stack[0], H5_INDEX_NAME, H5_ITER_NATIVE, NULL, copy_link, &file) >= 0, ERR_PBF_WRITE);
+  ASSERT (H5LTset_attribute_int (file, ".", "ranks", &m, 1) >= 0, ERR_PBF_WRITE);
+
+  out.mode = PBF_WRITE; /* used by write_part */
+  out.parallel = PBF_OFF;
+
+  for (n = 0; n < count; n ++)
+  {
+    snprintf (frame, 128, "/%d", n);
+
+    for (r = 0; r < m; r ++)
+    {
+      ASSERT ((src [r] = H5Gopen (in [r]->stack[0], frame, H5P_DEFAULT)) >= 0, ERR_PBF_READ);
+      ASSERT (H5Lexists (src [r], "parts", H5P_DEFAULT), ERR_NOT_IMPLEMENTED); /* older layout */
+      ASSERT (H5LTget_dataset_info (src [r], "parts", &cnt, NULL, NULL) >= 0 && cnt == 4, ERR_FILE_FORMAT);
+      read_part (src [r], "parts", H5T_NATIVE_INT, 0, 4, &parts [4*r]);
+    }
+
+    ASSERT ((dst = H5Gcreate (file, frame, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0, ERR_PBF_WRITE);
+    ASSERT (H5Aiterate2 (src [0], H5_INDEX_NAME, H5_ITER_NATIVE, NULL, copy_attribute, &dst) >= 0, ERR_PBF_WRITE);
+    ASSERT (H5Literate (src [0], H5_INDEX_NAME, H5_ITER_NATIVE, NULL, copy_link, &dst) >= 0, ERR_PBF_WRITE);
+
+    for (out.compression = PBF_OFF, r = 0; r < m; r ++) /* compress if any rank did */
+    {
+      for (k = 0; k < 2; k ++) if (filtered (src [r], name [k])) out.compression = PBF_ON;
+    }
+
+    for (k = 0; k < 4; k ++)
+    {
+      for (tot [k] = 0, r = 0; r < m; r ++) tot [k] += parts [4*r+k];
+
+      ERRMEM (data = malloc (size [k] * (tot [k] + 1)));
+
+      for (off = 0, r = 0; r < m; off += parts [4*r+k], r ++)
+      {
+	read_part (src [r], name [k], type [k], 0, parts [4*r+k], data + size [k] * off);
+      }
+
+      write_part (&out, dst, name [k], type [k], tot [k], 0, tot [k], data);
+
+      free (data);
+    }
+
+    write_part (&out, dst, "parts", H5T_NATIVE_INT, 4*m, 0, 4*m, parts);
+
+    H5Gclose (dst);
+    for (r = 0; r < m; r ++) H5Gclose (src [r]);
+  }
+
+  H5Fclose (file);
+  for (r = 0; r < m; r ++) PBF_Close (in [r]);
+  free (parts);
+  free (src);
+  free (in);
+  free (txt);
+
+  return m;
+}
+
 #else /* old XDR based implementation */
 
+#if POSIX
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <limits.h>
 #include <float.h>
@@ -658,6 +1151,7 @@ unsigned int PBF_Span (PBF *bf, double t0, double t1)
 #include "pbf.h"
 #include "err.h"
 #include "alg.h"
+#include "thr.h"
 
 /* memory increment */
 #define CHUNK 1024
@@ -720,6 +1214,57 @@ unsigned int PBF_Span (PBF *bf, double t0, double t1)
  * ----------
  */
 
+/* FRM file format:
+ * ----------------
+ *  [FRAME_0]
+ *  [FRAME_1]
+ *  ...
+ *  [FRAME_N]
+ *  [FRAME_INF]
+ * ----------
+ *  FRAME_i: (fixed width FRMSIZE record)
+ * -------------------------------
+ *  [TIME] (double) {current time; DBL_MAX for FRAME_INF}
+ *  [DOFF] (uint64_t) {offest of FRAME_i in DAT file}
+ *  [IPOS] (u_int) {position of IDX_0 of FRAME_i in IDX file}
+ * ----------------------------------
+ *  The FRM file duplicates the frame markers of the IDX file, so that
+ *  the i-th marker can be read directly (or from a mapped file) without
+ *  parsing the IDX file. If the FRM file is missing (older outputs) the
+ *  markers are recovered by scanning the IDX file.
+ */
+
+/* PBF (merged) file format:
+ * -------------------------
+ *  [MAGIC] (int) {MERGED}
+ *  [M] (int) {number of merged ranks}
+ *  [HEAD_0]
+ *  [HEAD_1]
+ *  ...
+ *  [HEAD_M-1]
+ *  [DAT_0] [IDX_0] [LAB_0] [FRM_0] {verbatim copies of rank files}
+ *  [DAT_1] [IDX_1] [LAB_1] [FRM_1]
+ *  ...
+ * ----------
+ *  HEAD_i:
+ * -------------------------------
+ *  [DBASE] (uint64_t) {offset of DAT_i}
+ *  [IBASE] (uint64_t) {offset of IDX_i}
+ *  [LBASE] (uint64_t) {offset of LAB_i}
+ *  [FBASE] (uint64_t) {offset of FRM_i (end of LAB_i)}
+ *  [FEND] (uint64_t) {end of FRM_i (FEND == FBASE if FRM_i is missing)}
+ * ----------------------------------
+ */
+
+/* merged file magic number */
+#define MERGED 0x50424632
+
+/* merged file head size */
+#define HEADSIZE(m) (8 + 40 * (m))
+
+/* frame index record size */
+#define FRMSIZE 20
+
 /* write to data file */
 static u_int fileread (char **mem, u_int size, FILE *f)
 {
@@ -795,18 +1340,95 @@ static void growmem (PBF *bf, u_int nb)
   xdrmem_create (&bf->x_dat, bf->mem + bf->membase, bf->memsize - bf->membase, XDR_ENCODE);
 }
 
+/* get i-th frame marker */
+static void get_marker (PBF *bf, u_int frm, PBF_MARKER *m)
+{
+  char *rec;
+  XDR xdr;
+
+  if (bf->mtab)
+  {
+    *m = bf->mtab [frm];
+    return;
+  }
+
+#if POSIX
+  rec = bf->fmap + bf->fbase + (uint64_t) FRMSIZE * frm;
+#else
+  char buf [FRMSIZE];
+  FSEEK (bf->frm, (OFF_T) (bf->fbase + (uint64_t) FRMSIZE * frm), SEEK_SET);
+  ASSERT (fread (buf, 1, FRMSIZE, bf->frm) == FRMSIZE, ERR_PBF_INDEX_FILE_CORRUPTED);
+  rec = buf;
+#endif
+
+  xdrmem_create (&xdr, rec, FRMSIZE, XDR_DECODE);
+  ASSERT (xdr_double (&xdr, &m->time), ERR_PBF_INDEX_FILE_CORRUPTED);
+  ASSERT (xdr_uint64_t (&xdr, &m->doff), ERR_PBF_INDEX_FILE_CORRUPTED);
+  ASSERT (xdr_u_int (&xdr, &m->ipos), ERR_PBF_INDEX_FILE_CORRUPTED);
+  xdr_destroy (&xdr);
+}
+
+/* find frame at time (binary search of marker) */
+static u_int find_frame (PBF *bf, double time)
+{
+  PBF_MARKER m;
+  int l, h, i;
+
+  l = i = 0;
+  h = (int) bf->msize - 1;
+  while (l <= h)
+  {
+    i = l + (h - l) / 2;
+    get_marker (bf, i, &m);
+    if (time == m.time) break;
+    else if (time < m.time) h = i - 1;
+    else l = i + 1;
+  }
+
+  /* handle limit cases */
+  if (h < 0) i = l;
+  else if (l > (int) bf->msize - 1) i = h;
+
+  return i;
+}
+
+/* load labels up to the given index (labels are read lazily, on first use) */
+static void load_labels (PBF *bf, int index)
+{
+  while (index >= bf->lsize && ! feof (bf->lab) && (uint64_t) FTELL (bf->lab) < bf->lend)
+  {
+    if (bf->lsize >= bf->lcap)
+    {
+      bf->lcap += CHUNK;
+      ERRMEM (bf->ltab = realloc (bf->ltab, sizeof (PBF_LABEL) * bf->lcap));
+    }
+
+    bf->ltab [bf->lsize].name = NULL;
+    if (xdr_string (&bf->x_lab, &bf->ltab [bf->lsize].name, PBF_MAXSTRING))
+    {
+      bf->ltab [bf->lsize].index = bf->lsize;
+      bf->lsize ++;
+    }
+    else break;
+  }
+}
+
 /* initialize a frame to be red */
 static void initialise_frame (PBF *bf, int frm)
 {
+  PBF_MARKER cur, next;
   PBF_LABEL *l;
   int index;
 
+  get_marker (bf, frm, &cur);
+  get_marker (bf, frm+1, &next);
+
   bf->cur = frm; /* set current frame */
-  bf->time = bf->mtab [frm].time; /* and time */
+  bf->time = cur.time; /* and time */
 
   /* create new memory XDR stream for DATA chunk */
-  bf->memsize = bf->mtab [frm+1].doff - bf->mtab [frm].doff;
-  FSEEK (bf->dat, (OFF_T) bf->mtab [frm].doff, SEEK_SET);
+  bf->memsize = next.doff - cur.doff;
+  FSEEK (bf->dat, (OFF_T) (bf->dbase + cur.doff), SEEK_SET);
   bf->memsize = fileread (&bf->mem, bf->memsize, bf->dat);
   xdr_destroy (&bf->x_dat);
   xdrmem_create (&bf->x_dat, bf->mem, bf->memsize, XDR_DECODE);
@@ -814,13 +1436,14 @@ static void initialise_frame (PBF *bf, int frm)
   /* empty current labels set */
   MAP_Free (&bf->mappool, &bf->labels);
  
-  /* seek to the frame in IDX file */ 
-  ASSERT (xdr_setpos (&bf->x_idx, bf->mtab [frm].ipos), ERR_PBF_INDEX_FILE_CORRUPTED);
+  /* seek to the frame in IDX file (64-bit, as 'ibase' of a merged file can exceed XDR positions) */
+  ASSERT (FSEEK (bf->idx, (OFF_T) (bf->ibase + cur.ipos), SEEK_SET) == 0, ERR_PBF_INDEX_FILE_CORRUPTED);
 
   /* read labels */
   ASSERT (xdr_int (&bf->x_idx, &index), ERR_PBF_INDEX_FILE_CORRUPTED);
   while (index >= 0)
   {
+    if (index >= bf->lsize) load_labels (bf, index);
     ASSERT (index < bf->lsize, ERR_PBF_INDEX_FILE_CORRUPTED);
     l = &bf->ltab [index];
 
@@ -835,59 +1458,139 @@ static void initialise_frame (PBF *bf, int frm)
   }
 }
 
-/* initialise labels and time index */
+/* release frame index */
+static void close_frames (PBF *bf)
+{
+#if POSIX
+  if (bf->fmap) munmap (bf->fmap, bf->fmaplen);
+#else
+  if (bf->frm) fclose (bf->frm);
+#endif
+  bf->fmap = NULL;
+  bf->frm = NULL;
+}
+
+/* open frame index stored in [base, end) of a file (end == UINT64_MAX
+ * stands for the end of file); return 1 on success or 0 if the index
+ * is not available, in which case the IDX file needs to be scanned */
+static int open_frames (PBF *bf, const char *path, uint64_t base, uint64_t end)
+{
+  PBF_MARKER last;
+  FILE *f;
+
+  if (end == UINT64_MAX)
+  {
+    if (! (f = fopen (path, "r"))) return 0;
+    FSEEK (f, 0, SEEK_END);
+    end = (uint64_t) FTELL (f);
+    fclose (f);
+  }
+
+  if (end < base + FRMSIZE || (end - base) % FRMSIZE) return 0;
+
+#if POSIX
+  {
+    uint64_t start;
+    void *map;
+    int fd;
+
+    start = base - base % (uint64_t) sysconf (_SC_PAGESIZE); /* page aligned */
+    if ((fd = open (path, O_RDONLY)) < 0) return 0;
+    map = mmap (NULL, end - start, PROT_READ, MAP_SHARED, fd, (off_t) start);
+    close (fd);
+    if (map == MAP_FAILED) return 0;
+    bf->fmap = map;
+    bf->fmaplen = end - start;
+    bf->fbase = base - start;
+  }
+#else
+  if (! (bf->frm = fopen (path, "r"))) return 0;
+  bf->fbase = base;
+#endif
+
+  bf->msize = (end - base) / FRMSIZE - 1;
+
+  get_marker (bf, bf->msize, &last);
+  if (last.time != DBL_MAX) /* incomplete */
+  {
+    close_frames (bf);
+    bf->msize = 0;
+    return 0;
+  }
+
+  return 1;
+}
+
+/* initialise time index and read the first frame */
 static void initialise_reading (PBF *bf)
 {
   int index, num, siz;
   u_int dpos;
-  
-  /* create labels table */
-  num = 0; siz = CHUNK;
-  ERRMEM (bf->ltab = malloc (sizeof (PBF_LABEL) * siz));
-  while (! feof (bf->lab))
+
+  if (! (bf->fmap || bf->frm)) /* no frame index => scan IDX file */
   {
-    bf->ltab [num].name = NULL;
-    if (xdr_string (&bf->x_lab, &bf->ltab [num].name, PBF_MAXSTRING))
+    /* create markers table */
+    num = 0; siz = CHUNK;
+    ERRMEM (bf->mtab = malloc (sizeof (PBF_MARKER) * siz));
+    while (! feof (bf->idx))
     {
-      bf->ltab [num].index = num;
-      if (++ num >= siz) { siz += CHUNK; ERRMEM (bf->ltab = realloc (bf->ltab, sizeof (PBF_LABEL) * siz)); }
-    }
-    else break;
-  }
-  bf->ltab = realloc (bf->ltab, sizeof (PBF_LABEL) * num); /* shrink */
-  bf->lsize = num;
-  
-  /* create markers table */
-  num = 0; siz = CHUNK;
-  ERRMEM (bf->mtab = malloc (sizeof (PBF_MARKER) * siz));
-  while (! feof (bf->idx))
-  {
-    /* time and unlabeled data position */
-    ASSERT (xdr_double (&bf->x_idx, &bf->mtab [num].time), ERR_PBF_INDEX_FILE_CORRUPTED);
-    ASSERT (xdr_uint64_t (&bf->x_idx, &bf->mtab [num].doff), ERR_PBF_INDEX_FILE_CORRUPTED);
-    bf->mtab [num].ipos = xdr_getpos (&bf->x_idx);
+      /* time and unlabeled data position */
+      ASSERT (xdr_double (&bf->x_idx, &bf->mtab [num].time), ERR_PBF_INDEX_FILE_CORRUPTED);
+      ASSERT (xdr_uint64_t (&bf->x_idx, &bf->mtab [num].doff), ERR_PBF_INDEX_FILE_CORRUPTED);
+      bf->mtab [num].ipos = (u_int) ((uint64_t) FTELL (bf->idx) - bf->ibase);
+
+      /* skip labels */
+      ASSERT (xdr_int (&bf->x_idx, &index), ERR_PBF_INDEX_FILE_CORRUPTED);
+      while (index >= 0)
+      {
+	ASSERT (xdr_u_int (&bf->x_idx, &dpos), ERR_PBF_INDEX_FILE_CORRUPTED);
+	ASSERT (xdr_int (&bf->x_idx, &index), ERR_PBF_INDEX_FILE_CORRUPTED); 
+      }
 
-    /* skip labels */
-    ASSERT (xdr_int (&bf->x_idx, &index), ERR_PBF_INDEX_FILE_CORRUPTED);
-    while (index >= 0)
-    {
-      ASSERT (index < bf->lsize, ERR_PBF_INDEX_FILE_CORRUPTED);
-      ASSERT (xdr_u_int (&bf->x_idx, &dpos), ERR_PBF_INDEX_FILE_CORRUPTED);
-      ASSERT (xdr_int (&bf->x_idx, &index), ERR_PBF_INDEX_FILE_CORRUPTED); 
+      if (index == -2) break; /* infinite frame */
+      
+      if (++ num >= siz) { siz += CHUNK; ERRMEM (bf->mtab = realloc (bf->mtab, sizeof (PBF_MARKER) * siz)); }
     }
-
-    if (index == -2) break; /* infinite frame */
-    
-    if (++ num >= siz) { siz += CHUNK; ERRMEM (bf->mtab = realloc (bf->mtab, sizeof (PBF_MARKER) * siz)); }
+    ASSERT (index == -2, ERR_PBF_INDEX_FILE_CORRUPTED);
+    bf->mtab = realloc (bf->mtab, sizeof (PBF_MARKER) * (num + 1)); /* shrink (add INF frame) */
+    bf->msize = num;
   }
-  ASSERT (index == -2, ERR_PBF_INDEX_FILE_CORRUPTED);
-  bf->mtab = realloc (bf->mtab, sizeof (PBF_MARKER) * (num + 1)); /* shrink (add INF frame) */
-  bf->msize = num;
 
   /* read first frame */
   initialise_frame (bf, 0);
 }
 
+/* frame reading job */
+static void frame_job (PBF **tab, int i)
+{
+  initialise_frame (tab [i], tab [i]->pending);
+}
+
+/* index reading job */
+static void reading_job (PBF **tab, int i)
+{
+  initialise_reading (tab [i]);
+}
+
+/* run a job for all files in the list; per-rank files
+ * are independent and hence they are processed concurrently */
+static void for_all_files (PBF *bf, THREAD_Job job)
+{
+  PBF **tab, *f;
+  int n;
+
+  for (n = 0, f = bf; f; f = f->next) n ++;
+
+  if (n == 1) job (&bf, 0);
+  else
+  {
+    ERRMEM (tab = malloc (sizeof (PBF*) * n));
+    for (n = 0, f = bf; f; f = f->next) tab [n ++] = f;
+    THREAD_Loop (n, job, tab);
+    free (tab);
+  }
+}
+
 /* write last frame data */
 static void write_frame (PBF *bf)
 {
@@ -908,6 +1611,16 @@ static void write_frame (PBF *bf)
   }
 }
 
+/* write frame index record */
+static void write_marker (PBF *bf, double time, uint64_t doff)
+{
+  u_int ipos = xdr_getpos (&bf->x_idx);
+
+  ASSERT (xdr_double (&bf->x_frm, &time), ERR_PBF_WRITE);
+  ASSERT (xdr_uint64_t (&bf->x_frm, &doff), ERR_PBF_WRITE);
+  ASSERT (xdr_u_int (&bf->x_frm, &ipos), ERR_PBF_WRITE);
+}
+
 /* finalize frames after last write */
 static void finalize_frames (PBF *bf)
 {
@@ -924,6 +1637,7 @@ static void finalize_frames (PBF *bf)
     ASSERT (xdr_double (&bf->x_idx, &time), ERR_PBF_WRITE);
     doff = (uint64_t) FTELL (bf->dat);
     ASSERT (xdr_uint64_t (&bf->x_idx, &doff), ERR_PBF_WRITE);
+    write_marker (bf, time, doff);
     ASSERT (xdr_int (&bf->x_idx, &index), ERR_PBF_WRITE);
   }
 }
@@ -967,6 +1681,15 @@ PBF* PBF_Write (const char *path, PBF_FLG append, PBF_FLG parallel)
   bf->memsize = CHUNK;
   ERRMEM (bf->mem = malloc (bf->memsize));
 
+  /* remove stale merged file */
+#if MPI
+  if (rank == 0)
+#endif
+  {
+    sprintf (txt, "%s.pbf", path);
+    remove (txt);
+  }
+
   /* openin files */
 #if MPI
   sprintf (txt, "%s.dat.%d", path, rank);
@@ -995,17 +1718,34 @@ PBF* PBF_Write (const char *path, PBF_FLG append, PBF_FLG parallel)
   xdrstdio_create (&bf->x_lab, bf->lab, XDR_ENCODE);
   bf->lph = copypath (txt);
 
+#if MPI
+  sprintf (txt, "%s.frm.%d", path, rank);
+#else
+  sprintf (txt, "%s.frm", path);
+#endif
+  if (! (bf->frm = fopen (txt, "w"))) goto failure;
+  xdrstdio_create (&bf->x_frm, bf->frm, XDR_ENCODE);
+  bf->fph = copypath (txt);
+
   /* initialise the rest */
   MEM_Init (&bf->mappool, sizeof (MAP), CHUNK);
   MEM_Init (&bf->labpool, sizeof (PBF_LABEL), CHUNK);
   bf->ltab = NULL;
   bf->labels = NULL;
   bf->mtab = NULL;
+  bf->fmap = NULL;
+  bf->fmaplen = 0;
   bf->mode = PBF_WRITE;
   bf->time = 0.;
   bf->lsize = 0;
+  bf->lcap = 0;
   bf->msize = 0;
   bf->cur = 0;
+  bf->pending = 0;
+  bf->dbase = 0;
+  bf->ibase = 0;
+  bf->lend = UINT64_MAX;
+  bf->fbase = 0;
 #if MPI
   bf->parallel = PBF_ON;
 #else
@@ -1021,6 +1761,86 @@ failure:
   return NULL;
 }
 
+/* open merged file for reading; return NULL if there is no such file */
+static PBF* read_merged (const char *path)
+{
+  uint64_t head [5];
+  int magic, n, m;
+  PBF *bf, *out;
+  FILE *pbf;
+  char *txt;
+  XDR xdr;
+
+  ERRMEM (txt = malloc (strlen (path) + 16));
+  sprintf (txt, "%s.pbf", path);
+
+  if (! (pbf = fopen (txt, "r")))
+  {
+    free (txt);
+    return NULL;
+  }
+
+  xdrstdio_create (&xdr, pbf, XDR_DECODE);
+  ASSERT (xdr_int (&xdr, &magic) && magic == MERGED, ERR_FILE_FORMAT);
+  ASSERT (xdr_int (&xdr, &m) && m > 0, ERR_FILE_FORMAT);
+
+  for (out = NULL, n = m-1; n >= 0; n --) /* the first item in the returned list corresponds to rank 0 */
+  {
+    ASSERT (xdr_setpos (&xdr, HEADSIZE (n)), ERR_FILE_FORMAT);
+    ASSERT (xdr_vector (&xdr, (char*)head, 5, sizeof (uint64_t), (xdrproc_t)xdr_uint64_t), ERR_FILE_FORMAT);
+
+    ERRMEM (bf = malloc (sizeof (PBF)));
+    bf->compression = PBF_OFF;
+    bf->memsize = 0;
+    bf->membase = 0;
+    bf->mem = NULL;
+
+    /* each rank uses its own streams of the merged file */
+    ASSERT (bf->dat = fopen (txt, "r"), ERR_FILE_OPEN);
+    xdrmem_create (&bf->x_dat, bf->mem, bf->memsize, XDR_DECODE);
+    bf->dph = copypath (txt);
+    ASSERT (bf->idx = fopen (txt, "r"), ERR_FILE_OPEN);
+    FSEEK (bf->idx, (OFF_T) head [1], SEEK_SET);
+    xdrstdio_create (&bf->x_idx, bf->idx, XDR_DECODE);
+    bf->iph = copypath (txt);
+    ASSERT (bf->lab = fopen (txt, "r"), ERR_FILE_OPEN);
+    FSEEK (bf->lab, (OFF_T) head [2], SEEK_SET);
+    xdrstdio_create (&bf->x_lab, bf->lab, XDR_DECODE);
+    bf->lph = copypath (txt);
+    bf->fph = copypath (txt);
+
+    MEM_Init (&bf->mappool, sizeof (MAP), CHUNK);
+    MEM_Init (&bf->labpool, sizeof (PBF_LABEL), CHUNK);
+    bf->ltab = NULL;
+    bf->labels = NULL;
+    bf->mtab = NULL;
+    bf->frm = NULL;
+    bf->fmap = NULL;
+    bf->fmaplen = 0;
+    bf->mode = PBF_READ;
+    bf->time = 0.;
+    bf->lsize = 0;
+    bf->lcap = 0;
+    bf->msize = 0;
+    bf->cur = 0;
+    bf->pending = 0;
+    bf->dbase = head [0];
+    bf->ibase = head [1];
+    bf->lend = head [3];
+    bf->fbase = 0;
+    open_frames (bf, txt, head [3], head [4]);
+    bf->parallel = PBF_ON;
+    bf->next = out;
+    out = bf;
+  }
+
+  xdr_destroy (&xdr);
+  fclose (pbf);
+  free (txt);
+
+  return out;
+}
+
 PBF* PBF_Read (const char *path)
 {
   PBF *bf, *out;
@@ -1028,6 +1848,12 @@ PBF* PBF_Read (const char *path)
   char *txt;
   int n, m;
 
+  if ((out = read_merged (path)))
+  {
+    for_all_files (out, (THREAD_Job) reading_job);
+    return out;
+  }
+
   ERRMEM (txt = malloc (strlen (path) + 16));
 
   /* count input files */
@@ -1065,6 +1891,9 @@ PBF* PBF_Read (const char *path)
     if (! (bf->lab = fopen (txt, "r"))) goto failure;
     xdrstdio_create (&bf->x_lab, bf->lab, XDR_DECODE);
     bf->lph = copypath (txt);
+    if (m) sprintf (txt, "%s.frm.%d", path, n);
+    else sprintf (txt, "%s.frm", path);
+    bf->fph = copypath (txt);
 
     /* initialise the rest */
     MEM_Init (&bf->mappool, sizeof (MAP), CHUNK);
@@ -1073,12 +1902,21 @@ PBF* PBF_Read (const char *path)
     bf->ltab = NULL;
     bf->labels = NULL;
     bf->mtab = NULL;
+    bf->frm = NULL;
+    bf->fmap = NULL;
+    bf->fmaplen = 0;
     bf->mode = PBF_READ;
     bf->time = 0.;
     bf->lsize = 0;
+    bf->lcap = 0;
     bf->msize = 0;
     bf->cur = 0;
-    initialise_reading (bf);
+    bf->pending = 0;
+    bf->dbase = 0;
+    bf->ibase = 0;
+    bf->lend = UINT64_MAX;
+    bf->fbase = 0;
+    open_frames (bf, txt, 0, UINT64_MAX);
     if (m) bf->parallel = PBF_ON;
     else bf->parallel = PBF_OFF;
     bf->next = out;
@@ -1087,6 +1925,10 @@ PBF* PBF_Read (const char *path)
   } while (-- n >= 0); /* the first item in the returned list corresponds to rank 0 */
 
   free (txt);
+
+  /* read indices and first frames */
+  for_all_files (out, (THREAD_Job) reading_job);
+
   return out;
   
 failure: 
@@ -1118,16 +1960,25 @@ void PBF_Close (PBF *bf)
     fclose (bf->idx);
     fclose (bf->lab);
 
+    if (bf->mode == PBF_WRITE)
+    {
+      xdr_destroy (&bf->x_frm);
+      fclose (bf->frm);
+    }
+    else close_frames (bf);
+
     if (empty) /* remove empty files */
     {
       remove (bf->dph);
       remove (bf->iph);
       remove (bf->lph);
+      if (bf->mode == PBF_WRITE) remove (bf->fph);
     }
   
     free (bf->dph);
     free (bf->iph);
     free (bf->lph);
+    free (bf->fph);
     free (bf->mem);
 
     /* free labels & markers */ 
@@ -1181,6 +2032,9 @@ void PBF_Time (PBF *bf, double *time)
     ASSERT (xdr_double (&bf->x_idx, time), ERR_PBF_WRITE);
     ASSERT (xdr_uint64_t (&bf->x_idx, &doff), ERR_PBF_WRITE);
 
+    /* output frame index record */
+    write_marker (bf, *time, doff);
+
     /* set time */
     bf->time = *time;
   }
@@ -1298,12 +2152,30 @@ void PBF_String (PBF *bf, char **value)
   else ASSERT (xdr_string (&bf->x_dat, value, PBF_MAXSTRING), ERR_PBF_READ);
 }
 
+unsigned int PBF_Tell (PBF *bf)
+{
+  if (bf->mode == PBF_WRITE) return bf->membase + xdr_getpos (&bf->x_dat);
+  else return xdr_getpos (&bf->x_dat);
+}
+
+void PBF_Jump (PBF *bf, unsigned int pos)
+{
+  if (bf->mode == PBF_READ)
+  {
+    ASSERT (xdr_setpos (&bf->x_dat, pos), ERR_PBF_READ);
+  }
+}
+
 void PBF_Limits (PBF *bf, double *start, double *end)
 {
   if (bf->mode == PBF_READ)
   {
-    *start = bf->mtab [0].time;
-    *end = bf->mtab [bf->msize - 1].time;
+    PBF_MARKER m;
+
+    get_marker (bf, 0, &m);
+    *start = m.time;
+    get_marker (bf, bf->msize - 1, &m);
+    *end = m.time;
   }
 }
 
@@ -1311,27 +2183,12 @@ void PBF_Seek (PBF *bf, double time)
 {
   if (bf->mode == PBF_READ)
   {
-    for (; bf; bf = bf->next)
+    for (PBF *f = bf; f; f = f->next)
     {
-      PBF_MARKER *l, *h, *m;
-
-      /* binary search
-       * of marker */
-      l = bf->mtab;
-      h = l + bf->msize - 1;
-      while (l <= h)
-      {
-	m = l + (h - l) / 2;
-	if (time == m->time) break;
-	else if (time < m->time) h = m - 1;
-	else l = m + 1;
-      }
-
-      /* handle limit cases */
-      if (h < bf->mtab) m = l;
-      else if (l > (bf->mtab + bf->msize - 1)) m = h;
-      initialise_frame (bf, m - bf->mtab);
+      f->pending = find_frame (f, time);
     }
+
+    for_all_files (bf, (THREAD_Job) frame_job);
   }
 }
 
@@ -1341,13 +2198,15 @@ int PBF_Backward (PBF *bf, unsigned int steps)
   {
     int pos, ret;
 
-    for (; bf; bf = bf->next)
+    for (PBF *f = bf; f; f = f->next)
     {
-      if (bf->cur < steps) pos = 0, ret = 0;
-      else pos = bf->cur - steps, ret = 1;
-      initialise_frame (bf, pos);
+      if (f->cur < steps) pos = 0, ret = 0;
+      else pos = f->cur - steps, ret = 1;
+      f->pending = pos;
     }
 
+    for_all_files (bf, (THREAD_Job) frame_job);
+
     return ret;
   }
 
@@ -1360,13 +2219,15 @@ int PBF_Forward (PBF *bf, unsigned int steps)
   {
     int pos, ret;
 
-    for (; bf; bf = bf->next)
+    for (PBF *f = bf; f; f = f->next)
     {
-      if (bf->cur + steps >=  bf->msize) pos = bf->msize - 1, ret = 0;
-      else pos = bf->cur + steps, ret = 1;
-      initialise_frame (bf, pos);
+      if (f->cur + steps >=  f->msize) pos = f->msize - 1, ret = 0;
+      else pos = f->cur + steps, ret = 1;
+      f->pending = pos;
     }
 
+    for_all_files (bf, (THREAD_Job) frame_job);
+
     return ret;
   }
 
@@ -1377,45 +2238,106 @@ unsigned int PBF_Span (PBF *bf, double t0, double t1)
 {
   if (bf->mode == PBF_READ)
   {
-    PBF_MARKER *l, *h, *m0, *m1;
-
     ASSERT_DEBUG (t0 <= t1, "t0 > t1");
 
-    /* binary search
-     * of marker */
-    l = bf->mtab;
-    h = l + bf->msize - 1;
-    while (l <= h)
-    {
-      m0 = l + (h - l) / 2;
-      if (t0 == m0->time) break;
-      else if (t0 < m0->time) h = m0 - 1;
-      else l = m0 + 1;
-    }
+    return find_frame (bf, t1) - find_frame (bf, t0);
+  }
 
-    /* handle limit cases */
-    if (h < bf->mtab) m0 = l;
-    else if (l > (bf->mtab + bf->msize - 1)) m0 = h;
+  return 0;
+}
 
-    /* binary search
-     * of marker */
-    l = bf->mtab;
-    h = l + bf->msize - 1;
-    while (l <= h)
+/* file size (a missing optional file has zero size) */
+static uint64_t filesize (const char *path, int optional)
+{
+  uint64_t size;
+  FILE *f;
+
+  if (! (f = fopen (path, "r")) && optional) return 0;
+  ASSERT (f, ERR_FILE_OPEN);
+  FSEEK (f, 0, SEEK_END);
+  size = (uint64_t) FTELL (f);
+  fclose (f);
+
+  return size;
+}
+
+/* append file contents to an output (a missing optional file is skipped) */
+static void appendfile (const char *path, FILE *out, char *buf, size_t size, int optional)
+{
+  size_t n;
+  FILE *f;
+
+  if (! (f = fopen (path, "r")) && optional) return;
+  ASSERT (f, ERR_FILE_OPEN);
+  while ((n = fread (buf, 1, size, f)) > 0)
+  {
+    ASSERT (fwrite (buf, 1, n, out) == n, ERR_FILE_WRITE);
+  }
+  ASSERT (!ferror (f), ERR_FILE_READ);
+  fclose (f);
+}
+
+int PBF_Merge (const char *path)
+{
+  char *txt, *buf, *ext [4] = {"dat", "idx", "lab", "frm"};
+  uint64_t base, head [5];
+  int magic, n, m, k;
+  FILE *dat, *out;
+  XDR xdr;
+
+  ERRMEM (txt = malloc (strlen (path) + 32));
+
+  /* count input files */
+  m = 0;
+  do
+  {
+    sprintf (txt, "%s.dat.%d", path, m);
+    dat = fopen (txt, "r");
+  } while (dat && fclose (dat) == 0 && ++ m); /* m incremented as last */
+
+  if (m == 0)
+  {
+    free (txt);
+    return 0;
+  }
+
+  sprintf (txt, "%s.pbf", path);
+  ASSERT (out = fopen (txt, "w"), ERR_FILE_OPEN);
+  xdrstdio_create (&xdr, out, XDR_ENCODE);
+
+  /* write head */
+  magic = MERGED;
+  ASSERT (xdr_int (&xdr, &magic), ERR_PBF_WRITE);
+  ASSERT (xdr_int (&xdr, &m), ERR_PBF_WRITE);
+  for (base = HEADSIZE (m), n = 0; n < m; n ++)
+  {
+    for (k = 0; k < 4; k ++)
     {
-      m1 = l + (h - l) / 2;
-      if (t1 == m1->time) break;
-      else if (t1 < m1->time) h = m1 - 1;
-      else l = m1 + 1;
+      sprintf (txt, "%s.%s.%d", path, ext [k], n);
+      head [k] = base;
+      base += filesize (txt, k == 3); /* FRM files are optional */
     }
+    head [4] = base;
+    ASSERT (xdr_vector (&xdr, (char*)head, 5, sizeof (uint64_t), (xdrproc_t)xdr_uint64_t), ERR_PBF_WRITE);
+  }
+  xdr_destroy (&xdr);
+  ASSERT ((uint64_t) FTELL (out) == (uint64_t) HEADSIZE (m), ERR_PBF_WRITE);
 
-    /* handle limit cases */
-    if (h < bf->mtab) m1 = l;
-    else if (l > (bf->mtab + bf->msize - 1)) m1 = h;
-
-    return m1 - m0;
+  /* copy rank files */
+  ERRMEM (buf = malloc (CHUNK * CHUNK));
+  for (n = 0; n < m; n ++)
+  {
+    for (k = 0; k < 4; k ++)
+    {
+      sprintf (txt, "%s.%s.%d", path, ext [k], n);
+      appendfile (txt, out, buf, CHUNK * CHUNK, k == 3);
+    }
   }
 
-  return 0;
+  ASSERT (fclose (out) == 0, ERR_FILE_CLOSE);
+  free (buf);
+  free (txt);
+
+  return m;
 }
 #endif
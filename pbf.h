@@ -26,6 +26,8 @@
 
 #include <hdf5.h>
 #include <hdf5_hl.h>
+#include "map.h"
+#include "mem.h"
 
 #define PBF_MAXSTACK 128 /* maximal group stack */
 
@@ -53,6 +55,16 @@ struct pbf
   double *d; /* raw doubles space */
   int dpos, doubles; /* raw doubles position and size */
 
+  char *l; /* label names (NUL-terminated, one after another) */
+  int lpos, lsize; /* label names length and size */
+  int *p; /* label (ipos, dpos) pairs */
+  int ppos, psize; /* label pairs length and size */
+  MEM mapmem; /* labels map memory (READ) */
+  MAP *labels; /* labels mapped to pair indices (READ) */
+  short legacy; /* current frame uses the old LABELS group layout (READ) */
+
+  int rank, size; /* part index and number of parts in a shared parallel file */
+
   hid_t stack [PBF_MAXSTACK]; /* file id followed by groups stack */
   short top; /* index of the stack top item */
 
@@ -91,7 +103,8 @@ int PBF_Has_Group (PBF *bf, const char *name);
 void PBF_Push (PBF *bf, const char *name);
 void PBF_Pop (PBF *bf);
 
-/* write/read named datasets (length > 1) or attributes (length == 1) */
+/* write/read named datasets (length > 1) or attributes (length == 1);
+ * in a shared parallel file these must be written collectively with identical values */
 void PBF_Int2 (PBF *bf, const char *name, int *value, hsize_t length);
 void PBF_Double2 (PBF *bf, const char *name, double *value, hsize_t length);
 void PBF_String2 (PBF *bf, const char *name, char **value);
@@ -111,6 +124,10 @@ int PBF_Forward (PBF *bf, int steps);
 /* get number of time instants spanned by [t0, t1] */
 unsigned int PBF_Span (PBF *bf, double t0, double t1);
 
+/* merge per-rank output files into a single shared-layout file;
+ * return the number of merged files (0 if nothing was merged) */
+int PBF_Merge (const char *path);
+
 #else /* old XDR based implementation */
 
 #include <stdint.h>
@@ -172,13 +189,18 @@ struct pbf
   PBF_ACC mode; /* access mode */
   char *dph, /* data path */
        *iph, /* index path */
-       *lph; /* label path */
+       *lph, /* label path */
+       *fph; /* frame index path */
   FILE *dat, /* data file */
        *idx, /* index file */
-       *lab; /* label file */
+       *lab, /* label file */
+       *frm; /* frame index file (WRITE or non-POSIX READ) */
   XDR x_dat, /* data stream */
       x_idx, /* index stream */
-      x_lab; /* labels stream */
+      x_lab, /* labels stream */
+      x_frm; /* frame index stream (WRITE) */
+  char *fmap; /* mapped frame index (POSIX READ) */
+  size_t fmaplen; /* mapped length */
   char *mem; /* read/write memory */
   u_int membase, /* memory base */
 	memsize; /* memory size */
@@ -186,10 +208,16 @@ struct pbf
       labpool; /* labels pool */
   PBF_LABEL *ltab; /* table of labels */
   MAP *labels; /* name mapped labels */
-  PBF_MARKER *mtab; /* markers */
-  int lsize; /* free index (WRITE) or ltab size (READ) */
+  PBF_MARKER *mtab; /* markers (READ without frame index) */
+  int lsize, /* free index (WRITE) or number of loaded labels (READ) */
+      lcap; /* ltab capacity (READ) */
   u_int msize, /* mtab size (READ) */
         cur; /* index of current time frame */
+  u_int pending; /* frame to be read next (READ) */
+  uint64_t dbase, /* data offset base (merged READ) */
+	   ibase, /* index offset base (merged READ) */
+	   lend, /* end of labels (merged READ) */
+	   fbase; /* offset of frame records in 'fmap' or 'frm' (READ) */
   double time; /* current time */
   PBF_FLG compression; /* compression flag */
   PBF_FLG parallel; /* parallel flag */
@@ -231,6 +259,12 @@ void PBF_Double (PBF *bf, double *value, unsigned int length);
 /* read/write NULL-termined string */
 void PBF_String (PBF *bf, char **value);
 
+/* get current position within the time frame */
+unsigned int PBF_Tell (PBF *bf);
+
+/* jump to a position within the time frame in read mode */
+void PBF_Jump (PBF *bf, unsigned int pos);
+
 /* get time limits in read mode */
 void PBF_Limits (PBF *bf, double *start, double *end);
 
@@ -245,5 +279,9 @@ int PBF_Forward (PBF *bf, unsigned int steps);
 
 /* get number of time instants spanned by [t0, t1] */
 unsigned int PBF_Span (PBF *bf, double t0, double t1);
+
+/* merge parallel output files into a single indexed file;
+ * return the number of merged files (0 if nothing was merged) */
+int PBF_Merge (const char *path);
 #endif
 #endif
@@ -264,3 +264,9 @@ double PUT_double_max (double val)
 
   return ret;
 }
+
+/* overwrite a vector with the component-wise minimum of all calls */
+void PUT_doubles_min (int n, double *val)
+{
+  MPI_Allreduce (MPI_IN_PLACE, val, n, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+}
@@ -60,4 +60,7 @@ double PUT_double_min (double val);
 /* return maximum of all calls */
 double PUT_double_max (double val);
 
+/* overwrite a vector with the component-wise minimum of all calls */
+void PUT_doubles_min (int n, double *val);
+
 #endif
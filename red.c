@@ -0,0 +1,230 @@
+/*
+ * red.c
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * reproducible floating point reductions
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "red.h"
+#include "alg.h"
+#include "err.h"
+
+#define RED_EMIN (-1074) /* exponent of the smallest subnormal double */
+#define RED_BASE 4294967296LL /* 2^32 */
+#define RED_MASK 0xffffffffULL
+#define RED_CARRY (1 << 30) /* additions after which carries need to be propagated */
+
+short REPRODUCIBLE_REDUCTIONS = 0;
+
+/* propagate carries so that all but the top digit are within [0, 2^32) */
+static void carry (long long *digit)
+{
+  long long low;
+  int i;
+
+  for (i = 0; i < RED_DIGITS - 1; i ++)
+  {
+    low = (long long) ((unsigned long long) digit [i] & RED_MASK);
+    digit [i+1] += (digit [i] - low) / RED_BASE; /* exact division */
+    digit [i] = low;
+  }
+}
+
+/* initialize a sum with a first term */
+void RED_Init (RED_SUM *sum, double value)
+{
+  if (REPRODUCIBLE_REDUCTIONS)
+  {
+    memset (sum, 0, sizeof (RED_SUM));
+    RED_Add (sum, value);
+  }
+  else
+  {
+    sum->value = value;
+    sum->count = 0;
+  }
+}
+
+/* add a term */
+void RED_Add (RED_SUM *sum, double value)
+{
+  unsigned long long m, rest, d [3];
+  long long *digit;
+  int e, i, s;
+
+  if (!REPRODUCIBLE_REDUCTIONS)
+  {
+    sum->value += value;
+    return;
+  }
+
+  if (value == 0.0) return;
+
+  if (isnan (value)) { sum->special [2] ++; return; }
+  else if (isinf (value)) { sum->special [value > 0.0 ? 0 : 1] ++; return; }
+
+  m = (unsigned long long) ldexp (frexp (fabs (value), &e), 53); /* |value| = m 2^(e-53) exactly */
+  e -= 53;
+
+  if (e < RED_EMIN) /* subnormal: trailing bits of m are zero */
+  {
+    m >>= (RED_EMIN - e);
+    e = RED_EMIN;
+  }
+
+  s = e - RED_EMIN;
+  i = s / 32;
+  s = s % 32;
+
+  d [0] = (m << s) & RED_MASK; /* split m 2^s into three 32-bit digits */
+  rest = m >> (32 - s);
+  d [1] = rest & RED_MASK;
+  d [2] = rest >> 32;
+
+  digit = &sum->digit [i];
+
+  if (value > 0.0)
+  {
+    digit [0] += d [0];
+    digit [1] += d [1];
+    digit [2] += d [2];
+  }
+  else
+  {
+    digit [0] -= d [0];
+    digit [1] -= d [1];
+    digit [2] -= d [2];
+  }
+
+  if (++ sum->count == RED_CARRY)
+  {
+    carry (sum->digit);
+    sum->count = 0;
+  }
+}
+
+/* sum += other */
+void RED_Merge (RED_SUM *sum, RED_SUM *other)
+{
+  int i;
+
+  if (!REPRODUCIBLE_REDUCTIONS)
+  {
+    sum->value += other->value;
+    return;
+  }
+
+  for (i = 0; i < RED_DIGITS; i ++) sum->digit [i] += other->digit [i];
+  for (i = 0; i < 3; i ++) sum->special [i] += other->special [i];
+
+  sum->count += other->count + 1; /* digits are bounded by 2^32 times additions since carrying */
+
+  if (sum->count >= RED_CARRY)
+  {
+    carry (sum->digit);
+    sum->count = 0;
+  }
+}
+
+/* rounded value of a sum */
+double RED_Value (RED_SUM *sum)
+{
+  long long digit [RED_DIGITS];
+  double value;
+  int i, h, neg;
+
+  if (!REPRODUCIBLE_REDUCTIONS) return sum->value;
+
+  if (sum->special [2] || (sum->special [0] && sum->special [1])) return NAN;
+  else if (sum->special [0]) return INFINITY;
+  else if (sum->special [1]) return -INFINITY;
+
+  memcpy (digit, sum->digit, sizeof (digit));
+  carry (digit);
+
+  if ((neg = digit [RED_DIGITS-1] < 0))
+  {
+    for (i = 0; i < RED_DIGITS; i ++) digit [i] = -digit [i];
+    carry (digit);
+  }
+
+  for (h = RED_DIGITS - 1; h >= 0 && digit [h] == 0; h --);
+
+  if (h < 0) return 0.0;
+
+  for (value = 0.0, i = MAX (h - 2, 0); i <= h; i ++) /* 64 to 96 leading bits, from the least significant */
+  {
+    value += ldexp ((double) digit [i], 32*i + RED_EMIN);
+  }
+
+  return neg ? -value : value;
+}
+
+#if MPI
+/* sum up 'n' sums over all processors (collective) */
+void RED_Allreduce (RED_SUM *sum, int n, MPI_Comm comm)
+{
+  int i, j, k, ncpu;
+
+  if (!REPRODUCIBLE_REDUCTIONS)
+  {
+    double *inp, *out;
+
+    ERRMEM (inp = malloc (sizeof (double [2*n])));
+    out = inp + n;
+
+    for (i = 0; i < n; i ++) inp [i] = sum [i].value;
+
+    MPI_Allreduce (inp, out, n, MPI_DOUBLE, MPI_SUM, comm);
+
+    for (i = 0; i < n; i ++) sum [i].value = out [i];
+
+    free (inp);
+  }
+  else /* integer sums are exact and hence independent of the reduction order */
+  {
+    long long *inp, *out;
+    int size = RED_DIGITS + 3;
+
+    ERRMEM (inp = malloc (sizeof (long long [2*n*size])));
+    out = inp + n*size;
+
+    for (i = k = 0; i < n; i ++)
+    {
+      carry (sum [i].digit); /* digits within [0, 2^32) do not overflow when summed */
+      for (j = 0; j < RED_DIGITS; j ++, k ++) inp [k] = sum [i].digit [j];
+      for (j = 0; j < 3; j ++, k ++) inp [k] = sum [i].special [j];
+    }
+
+    MPI_Allreduce (inp, out, n*size, MPI_LONG_LONG, MPI_SUM, comm);
+
+    MPI_Comm_size (comm, &ncpu);
+
+    for (i = k = 0; i < n; i ++)
+    {
+      for (j = 0; j < RED_DIGITS; j ++, k ++) sum [i].digit [j] = out [k];
+      for (j = 0; j < 3; j ++, k ++) sum [i].special [j] = out [k];
+      sum [i].count = ncpu;
+    }
+
+    free (inp);
+  }
+}
+#endif
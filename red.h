@@ -0,0 +1,65 @@
+/*
+ * red.h
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * reproducible floating point reductions
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#if MPI
+#include <mpi.h>
+#endif
+
+#ifndef __red__
+#define __red__
+
+#define RED_DIGITS 67 /* 32-bit digits spanning the double exponent range plus a carry digit */
+
+typedef struct red_sum RED_SUM;
+
+/* a sum of doubles; in the reproducible mode the terms are accumulated exactly in fixed point,
+ * so that the result does not depend on their order, the number of threads or processors;
+ * otherwise this is a plain double sum in the order of additions */
+struct red_sum
+{
+  double value; /* plain sum */
+
+  long long digit [RED_DIGITS], /* digit i has weight 2^(32i-1074) */
+	    special [3]; /* counts of +inf, -inf and nan terms */
+
+  int count; /* additions since last carry propagation */
+};
+
+extern short REPRODUCIBLE_REDUCTIONS; /* reproducible mode flag */
+
+/* initialize a sum with a first term */
+void RED_Init (RED_SUM *sum, double value);
+
+/* add a term */
+void RED_Add (RED_SUM *sum, double value);
+
+/* sum += other */
+void RED_Merge (RED_SUM *sum, RED_SUM *other);
+
+/* rounded value of a sum */
+double RED_Value (RED_SUM *sum);
+
+#if MPI
+/* sum up 'n' sums over all processors (collective) */
+void RED_Allreduce (RED_SUM *sum, int n, MPI_Comm comm);
+#endif
+
+#endif
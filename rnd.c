@@ -831,6 +831,7 @@ static BODY_DATA* create_body_data (BODY *bod, int wireframe)
 	data->ellips [j] = eli;
       }
       break;
+    case SHAPE_SDF: break;
     }
   }
 
@@ -916,6 +917,7 @@ static BODY_DATA* create_body_data (BODY *bod, int wireframe)
 	break;
       case SHAPE_SPHERE: break;
       case SHAPE_ELLIP: break;
+      case SHAPE_SDF: break;
       }
     }
 
@@ -1040,6 +1042,7 @@ static BODY_DATA* create_body_data (BODY *bod, int wireframe)
 	break;
       case SHAPE_SPHERE: break;
       case SHAPE_ELLIP: break;
+      case SHAPE_SDF: break;
       }
     }
 
@@ -15,7 +15,7 @@ BASIC_PARAMS = 'CX CY CZ DX DY DZ VX VY VZ SX SY SZ SXY SXZ SYZ MISES'.split()
 ENERGY_PARAMS = 'KINETIC INTERNAL EXTERNAL CONTACT FRICTION'.split()
 CONTACT_PARAMS = 'GAP R U CR CU'.split()
 TIMING_PARAMS = 'TIMINT CONUPD CONDET LOCDYN CONSOL PARBAL'.split()
-SOLVER_PARAMS = 'STEP CONS BODS DELBODS NEWBODS GISITERS CSCOLORS GSBOT GSMID GSTOP GSINN GSINIT GSRUN GSCOM GSMCOM MERIT NTITERS'.split()
+SOLVER_PARAMS = 'STEP CONS BODS DELBODS NEWBODS GISITERS CSCOLORS GSBOT GSMID GSTOP GSINN GSINIT GSRUN GSCOM GSMCOM GSWAIT MERIT NTITERS'.split()
 
 def str_to_vec(str_vector):
     """ converts the string str_vector to a 3-float (x, y, z) """
@@ -0,0 +1,786 @@
+/*
+ * sdf.c
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * signed distance fields
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#include <string.h>
+#include <float.h>
+#include "sol.h"
+#include "sdf.h"
+#include "msh.h"
+#include "sph.h"
+#include "eli.h"
+#include "gjk.h"
+#include "alg.h"
+#include "pck.h"
+#include "err.h"
+
+#define MARGIN 2 /* grid margin around the shape (in grid spacings) */
+#define BAND 2.0 /* exact distances are computed within this band around each object (in grid spacings) */
+
+enum {FIXED = 0, OUTSIDE, INSIDE}; /* node states during field construction */
+
+/* grid node index */
+#define NODE(n, i, j, k) (((k)*(n)[1] + (j))*(n)[0] + (i))
+
+/* compute current grid axes */
+static void grid_rot (SDF *sdf)
+{
+  double *rot = sdf->cur_rot;
+
+  for (int i = 0; i < 3; i ++)
+  {
+    SUB (sdf->cur_point [i], sdf->cur_corner, rot + 3*i);
+    NORMALIZE (rot + 3*i);
+  }
+}
+
+/* list all geometrical objects of a shape, including the interior elements of meshes */
+static SGP* objects (SHAPE *shp, int *nobj)
+{
+  SGP *sgp, *ptr;
+  int n = 0;
+
+  for (SHAPE *shq = shp; shq; shq = shq->next)
+  {
+    switch (shq->kind)
+    {
+      case SHAPE_MESH:
+      {
+	MESH *msh = shq->data;
+	n += msh->surfeles_count + msh->bulkeles_count;
+      }
+      break;
+      case SHAPE_CONVEX:
+      {
+	for (CONVEX *cvx = shq->data; cvx; cvx = cvx->next) n ++;
+      }
+      break;
+      case SHAPE_SPHERE:
+      case SHAPE_ELLIP:
+      {
+	n ++;
+      }
+      break;
+      case SHAPE_SDF:
+      {
+	ASSERT_TEXT (0, "A signed distance field can not be created from another signed distance field");
+      }
+      break;
+    }
+  }
+
+  ERRMEM (ptr = sgp = MEM_CALLOC (n * sizeof (SGP)));
+  *nobj = n;
+
+  for (SHAPE *shq = shp; shq; shq = shq->next)
+  {
+    switch (shq->kind)
+    {
+      case SHAPE_MESH:
+      {
+	MESH *msh = shq->data;
+	for (ELEMENT *ele = msh->surfeles; ele; ele = ele->next, ptr ++)
+	  ptr->shp = shq, ptr->gobj = ele, ptr->kind = GOBJ_ELEMENT;
+	for (ELEMENT *ele = msh->bulkeles; ele; ele = ele->next, ptr ++)
+	  ptr->shp = shq, ptr->gobj = ele, ptr->kind = GOBJ_ELEMENT;
+      }
+      break;
+      case SHAPE_CONVEX:
+      {
+	for (CONVEX *cvx = shq->data; cvx; cvx = cvx->next, ptr ++)
+	  ptr->shp = shq, ptr->gobj = cvx, ptr->kind = GOBJ_CONVEX;
+      }
+      break;
+      case SHAPE_SPHERE:
+      {
+	ptr->shp = shq, ptr->gobj = shq->data, ptr->kind = GOBJ_SPHERE;
+	ptr ++;
+      }
+      break;
+      case SHAPE_ELLIP:
+      {
+	ptr->shp = shq, ptr->gobj = shq->data, ptr->kind = GOBJ_ELLIP;
+	ptr ++;
+      }
+      break;
+      case SHAPE_SDF: break;
+    }
+  }
+
+  return sgp;
+}
+
+/* extents of an object */
+static void object_extents (SGP *sgp, double *extents)
+{
+  switch (sgp->kind)
+  {
+  case GOBJ_ELEMENT: ELEMENT_Extents (sgp->shp->data, sgp->gobj, extents); break;
+  case GOBJ_CONVEX: CONVEX_Extents (NULL, sgp->gobj, extents); break;
+  case GOBJ_SPHERE: SPHERE_Extents (NULL, sgp->gobj, extents); break;
+  case GOBJ_ELLIP: ELLIP_Extents (NULL, sgp->gobj, extents); break;
+  default: break;
+  }
+}
+
+/* unsigned distance between a point and an object (zero inside) */
+static double object_distance (SGP *sgp, double *point)
+{
+  double q [3], d;
+
+  switch (sgp->kind)
+  {
+  case GOBJ_ELEMENT: return ELEMENT_Spatial_Point_Distance (sgp->shp->data, sgp->gobj, point);
+  case GOBJ_CONVEX:
+  {
+    CONVEX *cvx = sgp->gobj;
+    return gjk_convex_point (cvx->cur, cvx->nver, point, q);
+  }
+  case GOBJ_SPHERE:
+  {
+    SPHERE *sph = sgp->gobj;
+    SUB (point, sph->cur_center, q);
+    d = LEN (q) - sph->cur_radius;
+    return MAX (d, 0.0);
+  }
+  case GOBJ_ELLIP:
+  {
+    ELLIP *eli = sgp->gobj;
+    return gjk_ellip_point (eli->cur_center, eli->cur_sca, eli->cur_rot, point, q);
+  }
+  default: break;
+  }
+
+  return DBL_MAX;
+}
+
+/* upwind solution of |grad u| = 1 at a node with the smallest neighbour values a, b, c along the axes */
+static double eikonal (double a, double b, double c, double h)
+{
+  double t, s, q, u;
+
+  if (a > b) t = a, a = b, b = t;
+  if (b > c) t = b, b = c, c = t;
+  if (a > b) t = a, a = b, b = t;
+
+  if (a == DBL_MAX) return DBL_MAX;
+
+  u = a + h;
+  if (u <= b) return u;
+
+  s = a + b;
+  q = s*s - 2.0*(a*a + b*b - h*h);
+  u = 0.5*(s + sqrt (MAX (q, 0.0)));
+  if (u <= c) return u;
+
+  s = a + b + c;
+  q = s*s - 3.0*(a*a + b*b + c*c - h*h);
+  u = (s + sqrt (MAX (q, 0.0))) / 3.0;
+
+  return u;
+}
+
+/* value of a neighbour as seen from a node being updated: the inside is
+ * solved for the depth below the surface, with the exact outside distances
+ * entering as negative depths; the outside ignores the inside nodes */
+inline static double neighbour (double *u, char *state, int node, char side)
+{
+  if (side == INSIDE) return state [node] == INSIDE ? u [node] : -u [node];
+  else return state [node] == INSIDE ? DBL_MAX : u [node];
+}
+
+/* fast sweeping over all nodes in the 'side' state */
+static void sweep (int *n, double h, double *u, char *state, char side)
+{
+  int i, j, k, s, node, di, dj, dk, i0, j0, k0;
+  double a, b, c, x, y, v;
+
+  for (s = 0; s < 16; s ++) /* eight orderings, twice */
+  {
+    di = s & 1 ? -1 : 1;
+    dj = s & 2 ? -1 : 1;
+    dk = s & 4 ? -1 : 1;
+    i0 = di > 0 ? 0 : n[0]-1;
+    j0 = dj > 0 ? 0 : n[1]-1;
+    k0 = dk > 0 ? 0 : n[2]-1;
+
+    for (k = k0; k >= 0 && k < n[2]; k += dk)
+    for (j = j0; j >= 0 && j < n[1]; j += dj)
+    for (i = i0; i >= 0 && i < n[0]; i += di)
+    {
+      node = NODE (n, i, j, k);
+
+      if (state [node] != side) continue;
+
+      x = i > 0 ? neighbour (u, state, node - 1, side) : DBL_MAX;
+      y = i < n[0]-1 ? neighbour (u, state, node + 1, side) : DBL_MAX;
+      a = MIN (x, y);
+      x = j > 0 ? neighbour (u, state, node - n[0], side) : DBL_MAX;
+      y = j < n[1]-1 ? neighbour (u, state, node + n[0], side) : DBL_MAX;
+      b = MIN (x, y);
+      x = k > 0 ? neighbour (u, state, node - n[0]*n[1], side) : DBL_MAX;
+      y = k < n[2]-1 ? neighbour (u, state, node + n[0]*n[1], side) : DBL_MAX;
+      c = MIN (x, y);
+
+      v = eikonal (a, b, c, h);
+      if (v < u [node]) u [node] = v;
+    }
+  }
+}
+
+/* grid corners */
+static void corners (SDF *sdf, double (*x) [3])
+{
+  double *rot = sdf->cur_rot, y [3];
+  int i;
+
+  for (i = 0; i < 8; i ++)
+  {
+    y [0] = i & 1 ? (sdf->n[0]-1) * sdf->spacing : 0.0;
+    y [1] = i & 2 ? (sdf->n[1]-1) * sdf->spacing : 0.0;
+    y [2] = i & 4 ? (sdf->n[2]-1) * sdf->spacing : 0.0;
+    NVADDMUL (sdf->cur_corner, rot, y, x[i]);
+  }
+}
+
+/* create a signed distance field of a shape */
+SDF* SDF_Create (SHAPE *shp, double spacing, int surface, int volume)
+{
+  double e [6], x [3], d, h, band, *u;
+  int i, j, k, l, lo [3], hi [3], nobj, node, total;
+  char *state;
+  SGP *sgp;
+  SDF *sdf;
+
+  ASSERT_TEXT (spacing > 0.0, "Signed distance field spacing must be positive");
+
+  ERRMEM (sdf = MEM_CALLOC (sizeof (SDF)));
+
+  SHAPE_Extents (shp, e);
+  h = spacing;
+
+  for (k = 0; k < 3; k ++)
+  {
+    sdf->ref_corner [k] = e[k] - MARGIN*h;
+    sdf->n [k] = (int) ceil ((e[k+3] - e[k]) / h) + 2*MARGIN + 1;
+  }
+
+  for (k = 0; k < 3; k ++)
+  {
+    COPY (sdf->ref_corner, sdf->ref_point [k]);
+    sdf->ref_point [k][k] += 1.0;
+  }
+
+  COPY (sdf->ref_corner, sdf->cur_corner);
+  for (k = 0; k < 3; k ++) { COPY (sdf->ref_point [k], sdf->cur_point [k]); }
+  grid_rot (sdf);
+
+  sdf->spacing = h;
+  sdf->surface = surface;
+  sdf->volume = volume;
+  sdf->mat = NULL;
+
+  total = sdf->n[0] * sdf->n[1] * sdf->n[2];
+  ERRMEM (sdf->phi = malloc (sizeof (double [total])));
+  ERRMEM (state = malloc (total));
+  u = sdf->phi;
+
+  for (node = 0; node < total; node ++) u [node] = DBL_MAX, state [node] = OUTSIDE;
+
+  /* exact distances near each object */
+  sgp = objects (shp, &nobj);
+  band = BAND * h;
+
+  for (l = 0; l < nobj; l ++)
+  {
+    object_extents (&sgp[l], e);
+
+    for (k = 0; k < 3; k ++)
+    {
+      lo [k] = (int) floor ((e[k] - band - sdf->ref_corner[k]) / h);
+      hi [k] = (int) ceil ((e[k+3] + band - sdf->ref_corner[k]) / h);
+      lo [k] = MAX (lo [k], 0);
+      hi [k] = MIN (hi [k], sdf->n[k]-1);
+    }
+
+    for (k = lo[2]; k <= hi[2]; k ++)
+    for (j = lo[1]; j <= hi[1]; j ++)
+    for (i = lo[0]; i <= hi[0]; i ++)
+    {
+      node = NODE (sdf->n, i, j, k);
+
+      if (state [node] == INSIDE) continue;
+
+      x [0] = sdf->ref_corner [0] + i*h;
+      x [1] = sdf->ref_corner [1] + j*h;
+      x [2] = sdf->ref_corner [2] + k*h;
+
+      d = object_distance (&sgp[l], x);
+
+      if (d < GEOMETRIC_EPSILON) state [node] = INSIDE, u [node] = DBL_MAX;
+      else if (d <= band && d < u [node]) state [node] = FIXED, u [node] = d;
+    }
+  }
+
+  free (sgp);
+
+  /* the remaining outside distances and the inside depths */
+  sweep (sdf->n, h, u, state, OUTSIDE);
+  sweep (sdf->n, h, u, state, INSIDE);
+
+  for (node = 0; node < total; node ++)
+  {
+    if (state [node] == INSIDE) u [node] = -u [node];
+  }
+
+  free (state);
+
+  return sdf;
+}
+
+/* create a copy of a signed distance field */
+SDF* SDF_Copy (SDF *sdf)
+{
+  int total = sdf->n[0] * sdf->n[1] * sdf->n[2];
+  SDF *twin;
+
+  ERRMEM (twin = malloc (sizeof (SDF)));
+  memcpy (twin, sdf, sizeof (SDF));
+  ERRMEM (twin->phi = malloc (sizeof (double [total])));
+  memcpy (twin->phi, sdf->phi, sizeof (double [total]));
+
+  return twin;
+}
+
+/* scaling of a signed distance field */
+void SDF_Scale (SDF *sdf, double *vector)
+{
+  double s = vector [0], *phi, *end;
+
+  WARNING_DEBUG (vector [0] == vector [1] && vector [0] == vector [2], "Signed distance fields are scaled uniformly by vector [0]");
+
+  for (int i = 0; i < 3; i ++)
+  {
+    SUB (sdf->cur_point [i], sdf->cur_corner, sdf->ref_point [i]);
+  }
+
+  SCALE (sdf->cur_corner, s);
+  COPY (sdf->cur_corner, sdf->ref_corner);
+
+  for (int i = 0; i < 3; i ++)
+  {
+    ADD (sdf->cur_corner, sdf->ref_point [i], sdf->cur_point [i]);
+    COPY (sdf->cur_point [i], sdf->ref_point [i]);
+  }
+
+  sdf->spacing *= s;
+
+  for (phi = sdf->phi, end = phi + sdf->n[0] * sdf->n[1] * sdf->n[2]; phi < end; phi ++) *phi *= s;
+}
+
+/* translation of a signed distance field */
+void SDF_Translate (SDF *sdf, double *vector)
+{
+  ADD (sdf->cur_corner, vector, sdf->cur_corner);
+  COPY (sdf->cur_corner, sdf->ref_corner);
+
+  for (int i = 0; i < 3; i ++)
+  {
+    ADD (sdf->cur_point [i], vector, sdf->cur_point [i]);
+    COPY (sdf->cur_point [i], sdf->ref_point [i]);
+  }
+}
+
+/* rotation of a signed distance field */
+void SDF_Rotate (SDF *sdf, double *point, double *vector, double angle)
+{
+  double R [9], omega [3];
+
+  angle *=  ALG_PI / 180.0;
+  COPY (vector, omega);
+  NORMALIZE (omega);
+  SCALE (omega, angle);
+  EXPMAP (omega, R);
+  SUB (sdf->cur_corner, point, omega);
+  NVADDMUL (point, R, omega, sdf->cur_corner);
+  COPY (sdf->cur_corner, sdf->ref_corner);
+
+  for (int i = 0; i < 3; i ++)
+  {
+    SUB (sdf->cur_point [i], point, omega);
+    NVADDMUL (point, R, omega, sdf->cur_point [i]);
+    COPY (sdf->cur_point [i], sdf->ref_point [i]);
+  }
+
+  grid_rot (sdf);
+}
+
+/* cut through a signed distance field with a plane; return triangulated cross-section; vertices in the
+ * triangles point to the memory allocated after the triangles memory; adjacency is not maintained */
+TRI* SDF_Cut (SDF *sdf, double *point, double *normal, int *m)
+{
+  /* TODO */
+  WARNING_DEBUG (0, "Signed distance field cutting has not been implemented yet!");
+  *m = 0;
+  return NULL;
+}
+
+/* split a signed distance field in two with plane defined by (point, normal); surfid corresponds to the new surface;
+ * topoadj != 0 implies cutting from the point and through the topological adjacency only */
+void SDF_Split (SDF *sdf, double *point, double *normal, short topoadj, int surfid[2], CONVEX **one, CONVEX **two)
+{
+  /* TODO */
+  WARNING_DEBUG (0, "Signed distance field splitting has not been implemented yet!");
+  *one = *two = NULL;
+}
+
+/* compute partial characteristic: 'vo'lume and static momenta
+ * 'sx', 'sy, 'sz' and 'eul'er tensor; assume that all input data is initially zero; */
+void SDF_Char_Partial (SDF *sdf, int ref, double *vo, double *sx, double *sy, double *sz, double *eul)
+{
+  double h = sdf->spacing, *phi = sdf->phi, *corner, rot [9], y [3], a [3], v, w, e;
+  int i, j, k, *n = sdf->n, n0 = n[0], n01 = n[0]*n[1];
+
+  if (ref)
+  {
+    corner = sdf->ref_corner;
+    for (i = 0; i < 3; i ++)
+    {
+      SUB (sdf->ref_point [i], corner, rot + 3*i);
+      NORMALIZE (rot + 3*i);
+    }
+  }
+  else
+  {
+    corner = sdf->cur_corner;
+    NNCOPY (sdf->cur_rot, rot);
+  }
+
+  e = h*h*h*h*h / 12.0; /* diagonal of the Euler tensor of a cell about its center */
+
+  /* each cell contributes the fraction of its volume estimated
+   * from the interpolated distance at its center */
+  for (k = 0; k < n[2]-1; k ++)
+  for (j = 0; j < n[1]-1; j ++)
+  for (i = 0; i < n[0]-1; i ++)
+  {
+    double *p = &phi [NODE (n, i, j, k)];
+
+    w = 0.125 * (p[0] + p[1] + p[n0] + p[n0+1] + p[n01] + p[n01+1] + p[n01+n0] + p[n01+n0+1]);
+    w = 0.5 - w / h;
+    if (w <= 0.0) continue;
+    if (w > 1.0) w = 1.0;
+
+    v = w*h*h*h;
+    y [0] = (i + 0.5)*h;
+    y [1] = (j + 0.5)*h;
+    y [2] = (k + 0.5)*h;
+    NVADDMUL (corner, rot, y, a);
+
+    *vo += v;
+    *sx += v * a [0];
+    *sy += v * a [1];
+    *sz += v * a [2];
+    eul [0] += v*a[0]*a[0] + w*e;
+    eul [1] += v*a[1]*a[0];
+    eul [2] += v*a[2]*a[0];
+    eul [3] += v*a[0]*a[1];
+    eul [4] += v*a[1]*a[1] + w*e;
+    eul [5] += v*a[2]*a[1];
+    eul [6] += v*a[0]*a[2];
+    eul [7] += v*a[1]*a[2];
+    eul [8] += v*a[2]*a[2] + w*e;
+  }
+}
+
+/* get characteristics of a signed distance field: volume, mass center, and Euler tensor (centered) */
+void SDF_Char (SDF *sdf, int ref, double *volume, double *center, double *euler)
+{
+  double vo, sx, sy, sz, cen [3], eul [9];
+
+  vo = sx = sy = sz = 0.0;
+  SET9 (eul, 0.0);
+
+  SDF_Char_Partial (sdf, ref, &vo, &sx, &sy, &sz, eul);
+
+  cen [0] = sx / vo;
+  cen [1] = sy / vo;
+  cen [2] = sz / vo;
+
+  eul [0] -= (2*sx - cen[0]*vo)*cen[0];
+  eul [4] -= (2*sy - cen[1]*vo)*cen[1];
+  eul [8] -= (2*sz - cen[2]*vo)*cen[2];
+  eul [3] -= cen[0]*sy + cen[1]*sx - cen[0]*cen[1]*vo;
+  eul [6] -= cen[0]*sz + cen[2]*sx - cen[0]*cen[2]*vo;
+  eul [7] -= cen[1]*sz + cen[2]*sy - cen[1]*cen[2]*vo;
+  eul [1] = eul[3];
+  eul [2] = eul[6];
+  eul [5] = eul[7];
+
+  if (volume) *volume = vo;
+  if (center) COPY (cen, center);
+  if (euler) NNCOPY (eul, euler);
+}
+
+/* update extents of an individual signed distance field */
+void SDF_Extents (void *data, SDF *sdf, double *extents)
+{
+  double x [8][3];
+  int i;
+
+  corners (sdf, x);
+
+  extents [0] = extents [1] = extents [2] =  DBL_MAX;
+  extents [3] = extents [4] = extents [5] = -DBL_MAX;
+
+  for (i = 0; i < 8; i ++)
+  {
+    if (x[i][0] < extents [0]) extents [0] = x[i][0];
+    if (x[i][1] < extents [1]) extents [1] = x[i][1];
+    if (x[i][2] < extents [2]) extents [2] = x[i][2];
+    if (x[i][0] > extents [3]) extents [3] = x[i][0];
+    if (x[i][1] > extents [4]) extents [4] = x[i][1];
+    if (x[i][2] > extents [5]) extents [5] = x[i][2];
+  }
+
+  extents [0] -= GEOMETRIC_EPSILON;
+  extents [1] -= GEOMETRIC_EPSILON;
+  extents [2] -= GEOMETRIC_EPSILON;
+  extents [3] += GEOMETRIC_EPSILON;
+  extents [4] += GEOMETRIC_EPSILON;
+  extents [5] += GEOMETRIC_EPSILON;
+}
+
+/* compute extents of a signed distance field */
+void SDF_Extents_2 (SDF *sdf, double *extents)
+{
+  SDF_Extents (NULL, sdf, extents);
+}
+
+/* compute oriented extents of a signed distance field */
+void SDF_Oriented_Extents (SDF *sdf, double *vx, double *vy, double *vz, double *extents)
+{
+  double x [8][3], e [3];
+  int i;
+
+  corners (sdf, x);
+
+  extents [0] = extents [1] = extents [2] =  DBL_MAX;
+  extents [3] = extents [4] = extents [5] = -DBL_MAX;
+
+  for (i = 0; i < 8; i ++)
+  {
+    e [0] = DOT (x[i], vx);
+    e [1] = DOT (x[i], vy);
+    e [2] = DOT (x[i], vz);
+
+    if (e [0] < extents [0]) extents [0] = e [0];
+    if (e [1] < extents [1]) extents [1] = e [1];
+    if (e [2] < extents [2]) extents [2] = e [2];
+    if (e [0] > extents [3]) extents [3] = e [0];
+    if (e [1] > extents [4]) extents [4] = e [1];
+    if (e [2] > extents [5]) extents [5] = e [2];
+  }
+}
+
+/* return first not NULL bulk material for a signed distance field */
+void* SDF_First_Bulk_Material (SDF *sdf)
+{
+  return sdf->mat;
+}
+
+/* return signed distance field containing a spatial point */
+SDF* SDF_Containing_Point (SDF *sdf, double *point)
+{
+  double g [3];
+
+  if (SDF_Distance (sdf, point, g) <= GEOMETRIC_EPSILON) return sdf;
+  else return NULL;
+}
+
+/* does this signed distance field contain the point? */
+int SDF_Contains_Point (void *dummy, SDF *sdf, double *point)
+{
+  double g [3];
+
+  return SDF_Distance (sdf, point, g) <= GEOMETRIC_EPSILON;
+}
+
+/* return distance of a spatial point to the signed distance field */
+double SDF_Spatial_Point_Distance (void *dummy, SDF *sdf, double *point)
+{
+  double g [3], d;
+
+  d = SDF_Distance (sdf, point, g);
+  return MAX (d, 0.0);
+}
+
+/* return signed distance at a spatial point and output its spatial gradient */
+double SDF_Distance (SDF *sdf, double *point, double *gradient)
+{
+  double d [3], y [3], f [3], o [3], g [3], *p, h = sdf->spacing, out, val,
+	 a00, a10, a01, a11, b0, b1, x00, x10, x01, x11, c0, c1, c;
+  int i [3], k, *n = sdf->n, n0 = n[0], n01 = n[0]*n[1];
+
+  SUB (point, sdf->cur_corner, d);
+  TVMUL (sdf->cur_rot, d, y);
+
+  /* clamp to the grid and split into cells and local coordinates */
+  for (k = 0; k < 3; k ++)
+  {
+    c = y [k] / h;
+    o [k] = 0.0;
+    if (c < 0.0) { o [k] = y [k]; c = 0.0; }
+    else if (c > n[k]-1) { c = n[k]-1; o [k] = y [k] - c * h; }
+    i [k] = (int) c;
+    if (i [k] > n[k]-2) i [k] = n[k]-2;
+    f [k] = c - i [k];
+  }
+
+  p = &sdf->phi [NODE (n, i[0], i[1], i[2])];
+
+  /* trilinear interpolation and its derivatives */
+  a00 = p[0] + f[0]*(p[1] - p[0]);
+  a10 = p[n0] + f[0]*(p[n0+1] - p[n0]);
+  a01 = p[n01] + f[0]*(p[n01+1] - p[n01]);
+  a11 = p[n01+n0] + f[0]*(p[n01+n0+1] - p[n01+n0]);
+  b0 = a00 + f[1]*(a10 - a00);
+  b1 = a01 + f[1]*(a11 - a01);
+  val = b0 + f[2]*(b1 - b0);
+
+  x00 = p[1] - p[0];
+  x10 = p[n0+1] - p[n0];
+  x01 = p[n01+1] - p[n01];
+  x11 = p[n01+n0+1] - p[n01+n0];
+  c0 = x00 + f[1]*(x10 - x00);
+  c1 = x01 + f[1]*(x11 - x01);
+
+  out = LEN (o);
+
+  if (out > 0.0) /* outside of the grid */
+  {
+    val += out;
+    DIV (o, out, g);
+  }
+  else
+  {
+    g [0] = (c0 + f[2]*(c1 - c0)) / h;
+    g [1] = ((a10 - a00)*(1.0 - f[2]) + (a11 - a01)*f[2]) / h;
+    g [2] = (b1 - b0) / h;
+  }
+
+  NVMUL (sdf->cur_rot, g, gradient);
+
+  return val;
+}
+
+/* update signed distance field according to the given motion */
+void SDF_Update (SDF *sdf, void *body, void *shp, MOTION motion)
+{
+  SGP sgp = {shp, sdf, GOBJ_SDF, NULL};
+  double *ref = sdf->ref_corner,
+	 (*ref_pnt) [3] = sdf->ref_point,
+	 *cur = sdf->cur_corner,
+	 (*cur_pnt) [3] = sdf->cur_point;
+
+  if (motion)
+  {
+    motion (body, &sgp, ref, cur);
+    motion (body, &sgp, ref_pnt [0], cur_pnt [0]);
+    motion (body, &sgp, ref_pnt [1], cur_pnt [1]);
+    motion (body, &sgp, ref_pnt [2], cur_pnt [2]);
+  }
+  else
+  {
+    COPY (ref, cur);
+    COPY (ref_pnt [0], cur_pnt [0]);
+    COPY (ref_pnt [1], cur_pnt [1]);
+    COPY (ref_pnt [2], cur_pnt [2]);
+  }
+
+  grid_rot (sdf);
+}
+
+/* free signed distance field */
+void SDF_Destroy (SDF *sdf)
+{
+  free (sdf->phi);
+  free (sdf);
+}
+
+/* pack signed distance field into double and integer buffers (d and i buffers are of initial
+ * dsize and isize, while the final numberof of doubles and ints is packed) */
+void SDF_Pack (SDF *sdf, int *dsize, double **d, int *doubles, int *isize, int **i, int *ints)
+{
+  pack_int (isize, i, ints, sdf->surface);
+  pack_int (isize, i, ints, sdf->volume);
+  pack_ints (isize, i, ints, sdf->n, 3);
+
+  pack_doubles (dsize, d, doubles, sdf->cur_corner, 3);
+  pack_doubles (dsize, d, doubles, (double*)sdf->cur_point, 9);
+
+  pack_doubles (dsize, d, doubles, sdf->ref_corner, 3);
+  pack_doubles (dsize, d, doubles, (double*)sdf->ref_point, 9);
+
+  pack_double  (dsize, d, doubles, sdf->spacing);
+  pack_doubles (dsize, d, doubles, sdf->phi, sdf->n[0] * sdf->n[1] * sdf->n[2]);
+
+  pack_int (isize, i, ints, sdf->mat ? 1 : 0); /* pack material existence flag */
+  if (sdf->mat) pack_string (isize, i, ints, sdf->mat->label);
+}
+
+/* unpack signed distance field from double and integer buffers (unpacking starts at dpos and ipos in
+ * d and i and no more than a specific number of doubles and ints can be red) */
+SDF* SDF_Unpack (void *solfec, int *dpos, double *d, int doubles, int *ipos, int *i, int ints)
+{
+  SDF *sdf;
+  int j;
+
+  ERRMEM (sdf = MEM_CALLOC (sizeof (SDF)));
+
+  sdf->surface = unpack_int (ipos, i, ints);
+  sdf->volume = unpack_int (ipos, i, ints);
+  unpack_ints (ipos, i, ints, sdf->n, 3);
+
+  unpack_doubles (dpos, d, doubles, sdf->cur_corner, 3);
+  unpack_doubles (dpos, d, doubles, (double*)sdf->cur_point, 9);
+
+  unpack_doubles (dpos, d, doubles, sdf->ref_corner, 3);
+  unpack_doubles (dpos, d, doubles, (double*)sdf->ref_point, 9);
+
+  sdf->spacing = unpack_double (dpos, d, doubles);
+  j = sdf->n[0] * sdf->n[1] * sdf->n[2];
+  ERRMEM (sdf->phi = malloc (sizeof (double [j])));
+  unpack_doubles (dpos, d, doubles, sdf->phi, j);
+
+  j = unpack_int (ipos, i, ints); /* unpack material existence flag */
+
+  if (j)
+  {
+    SOLFEC *sol = solfec;
+    char *label = unpack_string (ipos, i, ints);
+    ASSERT_DEBUG_EXT (sdf->mat = MATSET_Find (sol->mat, label), "Failed to find material when unpacking a signed distance field");
+    free (label);
+  }
+
+  grid_rot (sdf);
+
+  return sdf;
+}
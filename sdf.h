@@ -0,0 +1,127 @@
+/*
+ * sdf.h
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * signed distance fields
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#include "mat.h"
+#include "mot.h"
+#include "tri.h"
+#include "cvx.h"
+#include "shp.h"
+
+#ifndef __sdf__
+#define __sdf__
+
+typedef struct sdf SDF;
+
+/* signed distance field sampled at the nodes of a regular grid; it replaces
+ * a complex static shape (e.g. a large obstacle made of many convices or
+ * elements) so that point and sphere queries against it take constant time */
+struct sdf
+{
+  double ref_corner [3], /* grid origin */
+	 ref_point [3][3]; /* ref_point [i] - ref_corner is the unit i-th grid axis */
+
+  double cur_corner [3],
+	 cur_point [3][3], /* current images of referential points */
+	 cur_rot [9]; /* current grid axes stored column-wise */
+
+  double spacing; /* grid spacing */
+
+  int n [3]; /* numbers of nodes along the grid axes */
+
+  double *phi; /* nodal signed distances, negative inside; the first axis index runs fastest */
+
+  int surface, /* surface identifier */
+      volume; /* volume identifier */
+
+  BULK_MATERIAL *mat;
+};
+
+/* create a signed distance field of a shape sampled with the given grid spacing;
+ * the grid is aligned with the global axes and surrounds the shape with a margin */
+SDF* SDF_Create (SHAPE *shp, double spacing, int surface, int volume);
+
+/* create a copy of a signed distance field */
+SDF* SDF_Copy (SDF *sdf);
+
+/* scaling of a signed distance field; the scaling is uniform: x *= vector [0]; (set ref = cur) */
+void SDF_Scale (SDF *sdf, double *vector);
+
+/* translation of a signed distance field */
+void SDF_Translate (SDF *sdf, double *vector);
+
+/* rotation of a signed distance field */
+void SDF_Rotate (SDF *sdf, double *point, double *vector, double angle);
+
+/* cut through a signed distance field with a plane; return triangulated cross-section; vertices in the
+ * triangles point to the memory allocated after the triangles memory; adjacency is not maintained */
+TRI* SDF_Cut (SDF *sdf, double *point, double *normal, int *m);
+
+/* split a signed distance field in two with plane defined by (point, normal); surfid corresponds to the new surface;
+ * topoadj != 0 implies cutting from the point and through the topological adjacency only */
+void SDF_Split (SDF *sdf, double *point, double *normal, short topoadj, int surfid[2], CONVEX **one, CONVEX **two);
+
+/* compute partial characteristic: 'vo'lume and static momenta
+ * 'sx', 'sy, 'sz' and 'eul'er tensor; assume that all input data is initially zero; */
+void SDF_Char_Partial (SDF *sdf, int ref, double *vo, double *sx, double *sy, double *sz, double *eul);
+
+/* get characteristics of the signed distance field: volume, mass center, and Euler tensor (centered) */
+void SDF_Char (SDF *sdf, int ref, double *volume, double *center, double *euler);
+
+/* update extents of an individual signed distance field */
+void SDF_Extents (void *data, SDF *sdf, double *extents);
+
+/* compute extents of a signed distance field */
+void SDF_Extents_2 (SDF *sdf, double *extents);
+
+/* compute oriented extents of a signed distance field */
+void SDF_Oriented_Extents (SDF *sdf, double *vx, double *vy, double *vz, double *extents);
+
+/* return first not NULL bulk material for a signed distance field */
+void* SDF_First_Bulk_Material (SDF *sdf);
+
+/* return signed distance field containing a spatial point */
+SDF* SDF_Containing_Point (SDF *sdf, double *point);
+
+/* does this signed distance field contain the spatial point? */
+int SDF_Contains_Point (void *dummy, SDF *sdf, double *point);
+
+/* return distance of a spatial point to the signed distance field */
+double SDF_Spatial_Point_Distance (void *dummy, SDF *sdf, double *point);
+
+/* return signed distance at a spatial point and output its spatial gradient (not normalized);
+ * the field is interpolated trilinearly and extended outside of the grid by the distance to it */
+double SDF_Distance (SDF *sdf, double *point, double *gradient);
+
+/* update signed distance field according to the given motion */
+void SDF_Update (SDF *sdf, void *body, void *shp, MOTION motion);
+
+/* free signed distance field */
+void SDF_Destroy (SDF *sdf);
+
+/* pack signed distance field into double and integer buffers (d and i buffers are of initial
+ * dsize and isize, while the final numberof of doubles and ints is packed) */
+void SDF_Pack (SDF *sdf, int *dsize, double **d, int *doubles, int *isize, int **i, int *ints);
+
+/* unpack signed distance field from double and integer buffers (unpacking starts at dpos and ipos in
+ * d and i and no more than a specific number of doubles and ints can be red) */
+SDF* SDF_Unpack (void *solfec, int *dpos, double *d, int doubles, int *ipos, int *i, int ints);
+
+#endif
@@ -0,0 +1,377 @@
+/*
+ * sfc.c
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * space filling curve partitioning
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "sfc.h"
+#include "alg.h"
+#include "err.h"
+
+#define SFC_SAMPLES 128 /* maximal number of key samples per rank */
+#define SFC_CELLS (1u << SFC_BITS) /* cells per direction */
+#define SFC_KEYMAX (~((SFC_KEY) 0)) /* upper bound of all keys */
+
+typedef struct sfc_item ITEM;
+
+/* weighted key */
+struct sfc_item
+{
+  SFC_KEY key;
+  double weight;
+  int index;
+};
+
+/* weighted keys comparison */
+static int item_compare (ITEM *a, ITEM *b)
+{
+  if (a->key < b->key) return -1;
+  else if (a->key > b->key) return 1;
+  else if (a->weight < b->weight) return -1;
+  else if (a->weight > b->weight) return 1;
+  else return 0;
+}
+
+/* Morton key of integer coordinates: interleaved bits */
+static SFC_KEY morton (unsigned int *c)
+{
+  SFC_KEY key = 0;
+  int b;
+
+  for (b = SFC_BITS - 1; b >= 0; b --)
+  {
+    key = (key << 3) | ((c [0] >> b) & 1) << 2 | ((c [1] >> b) & 1) << 1 | ((c [2] >> b) & 1);
+  }
+
+  return key;
+}
+
+/* Hilbert key of integer coordinates: J. Skilling, Programming the Hilbert
+ * curve, AIP Conf. Proc. 707, 2004 (axes to transposed index, then interleaving) */
+static SFC_KEY hilbert (unsigned int *c)
+{
+  unsigned int X [3] = {c [0], c [1], c [2]}, M, P, Q, t;
+  int i;
+
+  M = 1u << (SFC_BITS - 1);
+
+  for (Q = M; Q > 1; Q >>= 1) /* inverse undo */
+  {
+    P = Q - 1;
+
+    for (i = 0; i < 3; i ++)
+    {
+      if (X [i] & Q) X [0] ^= P; /* invert */
+      else /* exchange */
+      {
+	t = (X [0] ^ X [i]) & P;
+	X [0] ^= t;
+	X [i] ^= t;
+      }
+    }
+  }
+
+  for (i = 1; i < 3; i ++) X [i] ^= X [i-1]; /* Gray encode */
+
+  for (t = 0, Q = M; Q > 1; Q >>= 1)
+  {
+    if (X [2] & Q) t ^= Q - 1;
+  }
+
+  for (i = 0; i < 3; i ++) X [i] ^= t;
+
+  return morton (X);
+}
+
+/* curve key of integer coordinates */
+static SFC_KEY key_of_cell (SFC *sfc, unsigned int *c)
+{
+  return sfc->curve == SFC_HILBERT ? hilbert (c) : morton (c);
+}
+
+/* integer coordinates of a point */
+static void point_to_cell (SFC *sfc, double *point, unsigned int *c)
+{
+  double x;
+  int i;
+
+  for (i = 0; i < 3; i ++)
+  {
+    x = (point [i] - sfc->extents [i]) * sfc->scale [i];
+
+    if (x <= 0.0) c [i] = 0;
+    else if (x >= (double) (SFC_CELLS - 1)) c [i] = SFC_CELLS - 1;
+    else c [i] = (unsigned int) x;
+  }
+}
+
+/* rank owning a key */
+static int key_to_rank (SFC *sfc, SFC_KEY key)
+{
+  int lo = 0, hi = sfc->ncpu - 1, mid;
+
+  while (lo < hi) /* last rank with cuts [rank] <= key */
+  {
+    mid = (lo + hi + 1) / 2;
+
+    if (sfc->cuts [mid] <= key) lo = mid;
+    else hi = mid - 1;
+  }
+
+  return lo;
+}
+
+/* mark non-empty ranks in [r0, r1] */
+static void mark_ranks (SFC *sfc, int r0, int r1, char *flags)
+{
+  for (; r0 <= r1; r0 ++)
+  {
+    if (sfc->cuts [r0] < sfc->cuts [r0+1]) flags [r0] = 1;
+  }
+}
+
+/* descend the octree of curve cells overlapping the [lo, hi] box of integer coordinates;
+ * every aligned cell of size 2^level covers a contiguous range of 8^level keys, hence
+ * only cells crossed by cuts need to be subdivided */
+static void box_assign (SFC *sfc, unsigned int *lo, unsigned int *hi, unsigned int *corner, int level, char *flags)
+{
+  unsigned int size = 1u << level, half, child [3];
+  SFC_KEY first, last;
+  int r0, r1, i;
+
+  first = key_of_cell (sfc, corner);
+  if (level)
+  {
+    first &= ~((((SFC_KEY) 1) << (3 * level)) - 1);
+    last = first + ((((SFC_KEY) 1) << (3 * level)) - 1);
+  }
+  else last = first;
+
+  r0 = key_to_rank (sfc, first);
+  r1 = key_to_rank (sfc, last);
+
+  if (r0 == r1 ||
+     (lo [0] <= corner [0] && corner [0] + size - 1 <= hi [0] && /* cell inside of the box */
+      lo [1] <= corner [1] && corner [1] + size - 1 <= hi [1] &&
+      lo [2] <= corner [2] && corner [2] + size - 1 <= hi [2]))
+  {
+    mark_ranks (sfc, r0, r1, flags);
+    return;
+  }
+
+  half = size >> 1;
+
+  for (i = 0; i < 8; i ++)
+  {
+    child [0] = corner [0] + (i & 4 ? half : 0);
+    child [1] = corner [1] + (i & 2 ? half : 0);
+    child [2] = corner [2] + (i & 1 ? half : 0);
+
+    if (child [0] <= hi [0] && child [0] + half - 1 >= lo [0] &&
+	child [1] <= hi [1] && child [1] + half - 1 >= lo [1] &&
+	child [2] <= hi [2] && child [2] + half - 1 >= lo [2])
+    {
+      box_assign (sfc, lo, hi, child, level - 1, flags);
+    }
+  }
+}
+
+/* create partitioner (initially rank 0 owns everything) */
+SFC* SFC_Create (MPI_Comm comm, SFC_CURVE curve)
+{
+  SFC *sfc;
+  int i;
+
+  ERRMEM (sfc = malloc (sizeof (SFC)));
+  sfc->comm = comm;
+  MPI_Comm_rank (comm, &sfc->rank);
+  MPI_Comm_size (comm, &sfc->ncpu);
+  sfc->curve = curve;
+
+  SET6 (sfc->extents, 0.0);
+  SET (sfc->extents + 3, 1.0);
+  SET (sfc->scale, (double) SFC_CELLS);
+
+  ERRMEM (sfc->cuts = malloc (sizeof (SFC_KEY [sfc->ncpu + 1])));
+  sfc->cuts [0] = 0;
+  for (i = 1; i <= sfc->ncpu; i ++) sfc->cuts [i] = SFC_KEYMAX;
+
+  return sfc;
+}
+
+/* curve key of a point (points outside of the quantisation box are clamped to it) */
+SFC_KEY SFC_Key (SFC *sfc, double *point)
+{
+  unsigned int c [3];
+
+  point_to_cell (sfc, point, c);
+
+  return key_of_cell (sfc, c);
+}
+
+/* partition 'n' weighted points (collective); the quantisation box becomes the bounding box of
+ * all points clipped by 'extents'; cuts balance the weights of a sample of sorted keys;
+ * on exit 'ranks [i]' is the new rank of the i-th point */
+void SFC_Balance (SFC *sfc, double *extents, int n, double *points, double *weights, int *ranks)
+{
+  int i, j, k, nsam, *counts, *displs, total;
+  SFC_KEY *keys, *allkeys;
+  double e [6], *w, *allw, sum, target, cum;
+  ITEM *items, *all;
+
+  /* bounding box of all points */
+  SET (e, DBL_MAX);
+  SET (e + 3, DBL_MAX);
+  for (i = 0; i < n; i ++)
+  {
+    double *p = &points [3*i];
+
+    for (j = 0; j < 3; j ++)
+    {
+      e [j] = MIN (e [j], p [j]);
+      e [3+j] = MIN (e [3+j], -p [j]); /* negated maxima: a single MPI_MIN reduction */
+    }
+  }
+
+  MPI_Allreduce (MPI_IN_PLACE, e, 6, MPI_DOUBLE, MPI_MIN, sfc->comm);
+
+  for (j = 0; j < 3; j ++)
+  {
+    e [3+j] = -e [3+j];
+    e [j] = MAX (e [j], extents [j]);
+    e [3+j] = MIN (e [3+j], extents [3+j]);
+    if (e [j] > e [3+j]) e [j] = e [3+j] = 0.0; /* no points */
+
+    sfc->extents [j] = e [j];
+    sfc->extents [3+j] = e [3+j];
+    sfc->scale [j] = e [3+j] > e [j] ? (double) SFC_CELLS / (e [3+j] - e [j]) : 0.0;
+  }
+
+  /* sorted local keys */
+  ERRMEM (items = malloc (sizeof (ITEM [n + 1])));
+  for (i = 0; i < n; i ++)
+  {
+    items [i].key = SFC_Key (sfc, &points [3*i]);
+    items [i].weight = weights [i];
+    items [i].index = i;
+  }
+  qsort (items, n, sizeof (ITEM), (int (*) (const void*, const void*)) item_compare);
+
+  /* regular sample: the last key of each of 'nsam' segments carries the segment weight */
+  nsam = MIN (n, SFC_SAMPLES);
+  ERRMEM (keys = malloc (sizeof (SFC_KEY [nsam + 1])));
+  ERRMEM (w = malloc (sizeof (double [nsam + 1])));
+  for (k = i = 0; k < nsam; k ++)
+  {
+    j = (int) (((long long) (k + 1) * n) / nsam);
+
+    for (w [k] = 0.0; i < j; i ++) w [k] += items [i].weight;
+
+    keys [k] = items [j-1].key;
+  }
+
+  /* gather all samples on all ranks */
+  ERRMEM (counts = malloc (sizeof (int [sfc->ncpu])));
+  ERRMEM (displs = malloc (sizeof (int [sfc->ncpu])));
+  MPI_Allgather (&nsam, 1, MPI_INT, counts, 1, MPI_INT, sfc->comm);
+  for (total = i = 0; i < sfc->ncpu; i ++) displs [i] = total, total += counts [i];
+  ERRMEM (allkeys = malloc (sizeof (SFC_KEY [total + 1])));
+  ERRMEM (allw = malloc (sizeof (double [total + 1])));
+  MPI_Allgatherv (keys, nsam, MPI_UNSIGNED_LONG_LONG, allkeys, counts, displs, MPI_UNSIGNED_LONG_LONG, sfc->comm);
+  MPI_Allgatherv (w, nsam, MPI_DOUBLE, allw, counts, displs, MPI_DOUBLE, sfc->comm);
+
+  /* sort samples (identically on all ranks) */
+  ERRMEM (all = malloc (sizeof (ITEM [total + 1])));
+  for (sum = 0.0, i = 0; i < total; i ++)
+  {
+    all [i].key = allkeys [i];
+    all [i].weight = allw [i];
+    all [i].index = i;
+    sum += allw [i];
+  }
+  qsort (all, total, sizeof (ITEM), (int (*) (const void*, const void*)) item_compare);
+
+  /* weight balancing cuts: rank k starts after the sample where the cumulative weight reaches k * sum / ncpu */
+  sfc->cuts [0] = 0;
+  for (cum = 0.0, i = 0, k = 1; k < sfc->ncpu; k ++)
+  {
+    target = sum * (double) k / (double) sfc->ncpu;
+
+    while (i < total && cum + all [i].weight < target) cum += all [i ++].weight;
+
+    if (i < total)
+    {
+      sfc->cuts [k] = all [i].key + 1;
+      cum += all [i ++].weight;
+    }
+    else sfc->cuts [k] = SFC_KEYMAX;
+
+    sfc->cuts [k] = MAX (sfc->cuts [k], sfc->cuts [k-1]);
+  }
+  sfc->cuts [sfc->ncpu] = SFC_KEYMAX;
+
+  /* new ranks */
+  for (i = 0; i < n; i ++) ranks [items [i].index] = key_to_rank (sfc, items [i].key);
+
+  free (items);
+  free (keys);
+  free (w);
+  free (counts);
+  free (displs);
+  free (allkeys);
+  free (allw);
+  free (all);
+}
+
+/* rank owning a point */
+int SFC_Point_Assign (SFC *sfc, double *point)
+{
+  return key_to_rank (sfc, SFC_Key (sfc, point));
+}
+
+/* ranks whose partitions overlap a box; 'procs' needs to have the communicator size */
+void SFC_Box_Assign (SFC *sfc, double *extents, int *procs, int *numprocs)
+{
+  unsigned int lo [3], hi [3], root [3] = {0, 0, 0};
+  char *flags;
+  int i;
+
+  point_to_cell (sfc, extents, lo);
+  point_to_cell (sfc, extents + 3, hi);
+
+  ERRMEM (flags = calloc (sfc->ncpu, 1));
+
+  box_assign (sfc, lo, hi, root, SFC_BITS, flags);
+
+  for (*numprocs = i = 0; i < sfc->ncpu; i ++)
+  {
+    if (flags [i]) procs [(*numprocs) ++] = i;
+  }
+
+  free (flags);
+}
+
+/* destroy partitioner */
+void SFC_Destroy (SFC *sfc)
+{
+  free (sfc->cuts);
+  free (sfc);
+}
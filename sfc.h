@@ -0,0 +1,73 @@
+/*
+ * sfc.h
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * space filling curve partitioning
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#include <mpi.h>
+
+#ifndef __sfc__
+#define __sfc__
+
+#define SFC_BITS 21 /* bits per coordinate of curve keys (3 * SFC_BITS bit keys) */
+
+typedef unsigned long long SFC_KEY;
+
+typedef enum {SFC_MORTON, SFC_HILBERT} SFC_CURVE;
+
+typedef struct sfc SFC;
+
+/* space filling curve partitioning: the curve traverses a grid of 2^SFC_BITS cells
+ * along each direction of the quantisation box and each rank owns a contiguous
+ * range of curve keys; the cuts are replicated on all ranks */
+struct sfc
+{
+  MPI_Comm comm;
+
+  int rank,
+      ncpu;
+
+  SFC_CURVE curve;
+
+  double extents [6], /* quantisation box */
+	 scale [3]; /* cells per unit length */
+
+  SFC_KEY *cuts; /* rank i owns keys in [cuts [i], cuts [i+1]) */
+};
+
+/* create partitioner (initially rank 0 owns everything) */
+SFC* SFC_Create (MPI_Comm comm, SFC_CURVE curve);
+
+/* curve key of a point (points outside of the quantisation box are clamped to it) */
+SFC_KEY SFC_Key (SFC *sfc, double *point);
+
+/* partition 'n' weighted points (collective); the quantisation box becomes the bounding box of
+ * all points clipped by 'extents'; cuts balance the weights of a sample of sorted keys;
+ * on exit 'ranks [i]' is the new rank of the i-th point */
+void SFC_Balance (SFC *sfc, double *extents, int n, double *points, double *weights, int *ranks);
+
+/* rank owning a point */
+int SFC_Point_Assign (SFC *sfc, double *point);
+
+/* ranks whose partitions overlap a box; 'procs' needs to have the communicator size */
+void SFC_Box_Assign (SFC *sfc, double *extents, int *procs, int *numprocs);
+
+/* destroy partitioner */
+void SFC_Destroy (SFC *sfc);
+
+#endif
@@ -28,6 +28,7 @@
 #include "cvx.h"
 #include "sph.h"
 #include "eli.h"
+#include "sdf.h"
 #include "err.h"
 #include "tri.h"
 #include "pck.h"
@@ -37,99 +38,115 @@ typedef void* (*copy_func) (void*);
 static copy_func copy [] = {(copy_func)MESH_Copy,
                             (copy_func)CONVEX_Copy,
 			    (copy_func)SPHERE_Copy,
-			    (copy_func)ELLIP_Copy};
+			    (copy_func)ELLIP_Copy,
+			    (copy_func)SDF_Copy};
 
 typedef void (*scale_func) (void*, double*);
 static scale_func scale [] = {(scale_func)MESH_Scale,
                               (scale_func)CONVEX_Scale,
 			      (scale_func)SPHERE_Scale,
-			      (scale_func)ELLIP_Scale};
+			      (scale_func)ELLIP_Scale,
+			      (scale_func)SDF_Scale};
 
 typedef void (*translate_func) (void*, double*);
 static translate_func translate [] = {(translate_func)MESH_Translate,
                                       (translate_func)CONVEX_Translate,
 				      (translate_func)SPHERE_Translate,
-				      (translate_func)ELLIP_Translate};
+				      (translate_func)ELLIP_Translate,
+				      (translate_func)SDF_Translate};
 
 typedef void (*rotate_func) (void*, double*, double*, double);
 static rotate_func rotate [] = {(rotate_func)MESH_Rotate,
                                 (rotate_func)CONVEX_Rotate,
 				(rotate_func)SPHERE_Rotate,
-				(rotate_func)ELLIP_Rotate};
+				(rotate_func)ELLIP_Rotate,
+				(rotate_func)SDF_Rotate};
 
 typedef TRI* (*cut_func) (void*, double*, double*, int*);
 static cut_func cut [] = {(cut_func)MESH_Cut,
                           (cut_func)CONVEX_Cut,
 			  (cut_func)SPHERE_Cut,
-			  (cut_func)ELLIP_Cut};
+			  (cut_func)ELLIP_Cut,
+			  (cut_func)SDF_Cut};
 
 typedef void (*gcha_func) (void*, int, double*, double*, double*, double*, double*);
 static gcha_func gcha [] = {(gcha_func)MESH_Char_Partial,
                             (gcha_func)CONVEX_Char_Partial,
 			    (gcha_func)SPHERE_Char_Partial,
-			    (gcha_func)ELLIP_Char_Partial};
+			    (gcha_func)ELLIP_Char_Partial,
+			    (gcha_func)SDF_Char_Partial};
 
 typedef void* (*gobj_func) (void*, double*);
 static gobj_func gobj [] = {(gobj_func)MESH_Element_Containing_Spatial_Point,
                             (gobj_func)CONVEX_Containing_Point,
 			    (gobj_func)SPHERE_Containing_Point,
-			    (gobj_func)ELLIP_Containing_Point};
+			    (gobj_func)ELLIP_Containing_Point,
+			    (gobj_func)SDF_Containing_Point};
 
 
 typedef int (*gobjs_func) (void*, void*, double*);
 static gobjs_func gobjs [] = {(gobjs_func)ELEMENT_Contains_Spatial_Point,
                               (gobjs_func)CONVEX_Contains_Point,
 			      (gobjs_func)SPHERE_Contains_Point,
-			      (gobjs_func)ELLIP_Contains_Point};
+			      (gobjs_func)ELLIP_Contains_Point,
+			      (gobjs_func)SDF_Contains_Point};
 
 typedef double (*gobjdst_func) (void*, void*, double*);
 static gobjdst_func gobjdst [] = {(gobjdst_func)ELEMENT_Spatial_Point_Distance,
                                   (gobjdst_func)CONVEX_Spatial_Point_Distance,
 				  (gobjdst_func)SPHERE_Spatial_Point_Distance,
-				  (gobjdst_func)ELLIP_Spatial_Point_Distance};
+				  (gobjdst_func)ELLIP_Spatial_Point_Distance,
+				  (gobjdst_func)SDF_Spatial_Point_Distance};
 
 typedef void (*update_func) (void*, void*, void*, MOTION);
 static update_func update [] = {(update_func)MESH_Update,
                                 (update_func)CONVEX_Update,
 				(update_func)SPHERE_Update,
-				(update_func)ELLIP_Update};
+				(update_func)ELLIP_Update,
+				(update_func)SDF_Update};
 
 typedef void (*extents_func) (void*, double*);
 static extents_func objextents [] = {(extents_func)MESH_Extents,
                                      (extents_func)CONVEX_List_Extents,
 				     (extents_func)SPHERE_Extents_2,
-				     (extents_func)ELLIP_Extents_2};
+				     (extents_func)ELLIP_Extents_2,
+				     (extents_func)SDF_Extents_2};
 
 typedef void (*oextents_func) (void*, double*, double*, double*, double*);
 static oextents_func objorientedextents [] = {(oextents_func)MESH_Oriented_Extents,
                                               (oextents_func)CONVEX_List_Oriented_Extents,
 					      (oextents_func)SPHERE_Oriented_Extents,
-					      (oextents_func)ELLIP_Oriented_Extents};
+					      (oextents_func)ELLIP_Oriented_Extents,
+					      (oextents_func)SDF_Oriented_Extents};
 
 typedef void* (*first_bulk_func) (void*);
 static first_bulk_func firstbulk [] = {(first_bulk_func)MESH_First_Bulk_Material,
                                        (first_bulk_func)CONVEX_First_Bulk_Material,
 				       (first_bulk_func)SPHERE_First_Bulk_Material,
-				       (first_bulk_func)ELLIP_First_Bulk_Material};
+				       (first_bulk_func)ELLIP_First_Bulk_Material,
+				       (first_bulk_func)SDF_First_Bulk_Material};
 
 typedef void (*destroy_func) (void*);
 static destroy_func destroy [] = {(destroy_func)MESH_Destroy,
                                   (destroy_func)CONVEX_Destroy,
 				  (destroy_func)SPHERE_Destroy,
-				  (destroy_func)ELLIP_Destroy};
+				  (destroy_func)ELLIP_Destroy,
+				  (destroy_func)SDF_Destroy};
 
 typedef void (*pack_func) (void*, int*, double**, int*, int*, int**, int*);
 static pack_func pack [] = {(pack_func)MESH_Pack,
                             (pack_func)CONVEX_Pack,
 			    (pack_func)SPHERE_Pack,
-			    (pack_func)ELLIP_Pack};
+			    (pack_func)ELLIP_Pack,
+			    (pack_func)SDF_Pack};
 
 
 typedef void* (*unpack_func) (void*, int*, double*, int, int*, int*, int);
 static unpack_func unpack [] = {(unpack_func)MESH_Unpack,
                                 (unpack_func)CONVEX_Unpack,
 				(unpack_func)SPHERE_Unpack,
-				(unpack_func)ELLIP_Unpack};
+				(unpack_func)ELLIP_Unpack,
+				(unpack_func)SDF_Unpack};
 
 /* append shape */
 static SHAPE* append (SHAPE *list, short kind, void *data)
@@ -180,6 +197,7 @@ SGP* SGP_Create (SHAPE *shp, int *nsgp)
       break;
       case SHAPE_SPHERE:
       case SHAPE_ELLIP:
+      case SHAPE_SDF:
       {
 	n ++;
       }
@@ -225,6 +243,14 @@ SGP* SGP_Create (SHAPE *shp, int *nsgp)
 	ptr ++;
       }
       break;
+      case SHAPE_SDF:
+      {
+	ptr->shp = shq;
+	ptr->gobj = shq->data;
+	ptr->kind = GOBJ_SDF;
+	ptr ++;
+      }
+      break;
     }
   }
 
@@ -240,6 +266,7 @@ GOBJ SHAPE_2_GOBJ (SHAPE *shp)
   case SHAPE_CONVEX: return GOBJ_CONVEX;
   case SHAPE_SPHERE: return GOBJ_SPHERE;
   case SHAPE_ELLIP: return GOBJ_ELLIP;
+  case SHAPE_SDF: return GOBJ_SDF;
   }
 
   ASSERT_TEXT (0, "Unknown shape kind");
@@ -280,7 +307,8 @@ SHAPE* SHAPE_Glue (SHAPE *shp, SHAPE *shq)
     case SHAPE_MESH:
     case SHAPE_SPHERE:
     case SHAPE_ELLIP:
-      shp->next = out; /* meshes, spheres, ellipsoids are copied */
+    case SHAPE_SDF:
+      shp->next = out; /* meshes, spheres, ellipsoids, distance fields are copied */
       out = shp;
       break;
     case SHAPE_CONVEX:
@@ -299,7 +327,8 @@ SHAPE* SHAPE_Glue (SHAPE *shp, SHAPE *shq)
     case SHAPE_MESH:
     case SHAPE_SPHERE:
     case SHAPE_ELLIP:
-      shq->next = out; /* meshes, spheres, ellipsoids are copied */
+    case SHAPE_SDF:
+      shq->next = out; /* meshes, spheres, ellipsoids, distance fields are copied */
       out = shq;
       break;
     case SHAPE_CONVEX:
@@ -530,6 +559,13 @@ void SHAPE_Split (SHAPE *shp, double *point, double *normal, short topoadj, int
       else if (two) front = SHAPE_Glue (SHAPE_Create (SHAPE_ELLIP, two), front);
     }
     break;
+    case SHAPE_SDF:
+    {
+      CONVEX *one = NULL, *two = NULL;
+
+      SDF_Split (shq->data, point, normal, topoadj, surfid, &one, &two);
+    }
+    break;
     case SHAPE_MESH:
     {
       MESH *one = NULL, *two = NULL;
@@ -854,6 +890,16 @@ void SHAPE_Limits_Along_Line (SHAPE *shp, double *point, double *direction, doub
     ASSERT (0, ERR_NOT_IMPLEMENTED); /* TODO */
   }
   break;
+  case SHAPE_SDF:
+  {
+    double e [6];
+
+    SDF_Oriented_Extents (shp->data, direction, direction, direction, e); /* grid bounds */
+    dot = DOT (point, direction);
+    limits [0] = e [0] - dot;
+    limits [1] = e [3] - dot;
+  }
+  break;
   }
 }
 
@@ -962,6 +1008,9 @@ void SHAPE_2_MBFCP (SHAPE *shp, FILE *out)
       /* TODO => Ellipsoid MBFCP export */
       ASSERT (0, ERR_NOT_IMPLEMENTED); /* FIXME => ELLIP */
       break;
+    case SHAPE_SDF:
+      ASSERT (0, ERR_NOT_IMPLEMENTED); /* FIXME => SDF */
+      break;
     }
   }
 
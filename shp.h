@@ -41,7 +41,7 @@ enum gobj
   GOBJ_ELEMENT = 0x01, /* XXX: never edit these without looking into box.h: e.g. AABB_ELEMENT_ELEMENT, etc. */
   GOBJ_CONVEX  = 0x02,
   GOBJ_SPHERE  = 0x04,
-              /* 0x08, */  /* XXX: unallocated gobj flag => see box.h (used to be mesh node) */
+  GOBJ_SDF     = 0x08, /* signed distance field (0x08 used to be mesh node) */
   GOBJ_ELLIP   = 0x10 /* ellipsoid */
 };
 
@@ -53,7 +53,8 @@ struct shape
   enum {SHAPE_MESH = 0,
         SHAPE_CONVEX,
         SHAPE_SPHERE,
-        SHAPE_ELLIP} kind; /* kind of shape */
+        SHAPE_ELLIP,
+        SHAPE_SDF} kind; /* kind of shape */
 
   void *data; /* representation */
 
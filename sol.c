@@ -37,6 +37,7 @@
 #include "err.h"
 #include "tmr.h"
 #include "mrf.h"
+#include "red.h"
 
 /* defulat initial amoung of boxes */
 #define DEFSIZE 1024
@@ -49,6 +50,10 @@ static void clean_timers (SOLFEC *sol)
     TIMING *t = item->data;
     t->total = 0.0;
   }
+
+#if MPI
+  DOM_Timers_Reset (sol->dom);
+#endif
 }
 
 /* turn on verbosity */
@@ -180,6 +185,7 @@ static void write_state (SOLFEC *sol, void *solver, SOLVER_KIND kind)
 #if HDF5
   /* open and append */
   if (!(sol->bf = writeoutpath (sol->outpath, PBF_ON))) THROW (ERR_FILE_OPEN);
+  sol->bf->compression = sol->output_compression;
 #endif
 
   /* write time */
@@ -313,6 +319,10 @@ static void read_timers (SOLFEC *sol)
   }
   ASSERT (found, ERR_FILE_FORMAT); /* the former root file should have this section */
 #endif
+
+#if MPI
+  DOM_Timers_Reset (sol->dom);
+#endif
 }
 
 /* input state */
@@ -452,10 +462,25 @@ static void statsout (SOLFEC *sol)
       fprintf (sta, "%13s: SUM = %8d     MIN = %8d     AVG = %8d     MAX = %8d\n", dom->stats [i].name, dom->stats [i].sum, dom->stats [i].min, dom->stats [i].avg, dom->stats [i].max);
       printf ("%13s: SUM = %8d     MIN = %8d     AVG = %8d     MAX = %8d\n", dom->stats [i].name, dom->stats [i].sum, dom->stats [i].min, dom->stats [i].avg, dom->stats [i].max); 
     }
+
+    fprintf (sta, "%13s:", "IMBALANCE");
+    printf ("%13s:", "IMBALANCE");
+    for (i = 0; i < dom->nstats; i ++)
+    {
+      if (dom->stats [i].imbalance && dom->stats [i].avg > 0) /* MAX/AVG ratio of per-phase loads */
+      {
+	fprintf (sta, " %.6s %.2f", dom->stats [i].name, (double) dom->stats [i].max / (double) dom->stats [i].avg);
+	printf (" %.6s %.2f", dom->stats [i].name, (double) dom->stats [i].max / (double) dom->stats [i].avg);
+      }
+    }
+    fprintf (sta, "\n");
+    printf ("\n");
+    fprintf (sta, "%13s: COUNT = %8d     LOSS = %8d     COST = %8d     BYTES = %8d\n", "REPARTITION", dom->repartitions, (int) dom->imbloss, (int) dom->repcost, dom->repbytes);
+    printf ("%13s: COUNT = %8d     LOSS = %8d     COST = %8d     BYTES = %8d\n", "REPARTITION", dom->repartitions, (int) dom->imbloss, (int) dom->repcost, dom->repbytes);
 #else
-    int val [] = {dom->nbod, dom->aabb->boxnum, dom->ncon, dom->nspa};
-    char *name [] = {"BODIES", "BOXES", "CONSTRAINTS", "SPARSIFIED"};
-    for (i = 0; i < 4; i ++)
+    int val [] = {dom->nbod, dom->aabb->boxnum, dom->ncon, dom->nspa, dom->nsepaxis, dom->nsepgjk, dom->nsepcvi};
+    char *name [] = {"BODIES", "BOXES", "CONSTRAINTS", "SPARSIFIED", "AXIS REJECT", "GJK REJECT", "CVI CALLS"};
+    for (i = 0; i < 7; i ++)
     {
       fprintf (sta, "%11s: %8d\n", name [i], val [i]);
       printf ("%11s: %8d\n", name [i], val [i]);
@@ -525,6 +550,9 @@ SOLFEC* SOLFEC_Create (short dynamic, double step, char *outpath)
   sol->outpath = copyoutpath (outpath);
   sol->output_interval = 0;
   sol->output_time = 0;
+  sol->output_compression = PBF_OFF;
+  sol->checkpoint_interval = 0;
+  sol->checkpoint_time = DBL_MAX;
 #if !MPI
   if (!WRITE_MODE_FLAG() && (sol->bf = readoutpath (sol->outpath))) sol->mode = SOLFEC_READ;
   else
@@ -653,11 +681,12 @@ void SOLFEC_Run (SOLFEC *sol, SOLVER_KIND kind, void *solver, double duration)
     sol->output_interval = PUT_double_min (sol->output_interval);
     sol->callback_time = PUT_double_min (sol->callback_time);
     sol->output_time = PUT_double_min (sol->output_time);
+    sol->checkpoint_time = PUT_double_min (sol->checkpoint_time);
     sol->duration = PUT_double_min (sol->duration);
     /* TODO: make this more efficient by using a single call */
 
 #endif
-    if (sol->dom->time == 0.0)
+    if (sol->dom->time == 0.0 || sol->iover < 0) /* initial or restarted state */
     {
       DOM_Initialize (sol->dom);
 
@@ -709,12 +738,26 @@ void SOLFEC_Run (SOLFEC *sol, SOLVER_KIND kind, void *solver, double duration)
 	lastwrite = 1;
       }
 
+      /* write restart checkpoint if needed */
+      if (sol->dom->time >= sol->checkpoint_time)
+      {
+	char *path = SOLFEC_Alloc_File_Name (sol, 16);
+
+	sol->checkpoint_time += sol->checkpoint_interval;
+	strcat (path, ".chk");
+	DOM_Write_Checkpoint (sol->dom, path);
+	free (path);
+      }
+
       /* execute callback if needed */
       if (sol->callback && sol->dom->time >= sol->callback_time)
       {
 	int ret;
 
 	sol->callback_time += sol->callback_interval;
+#if MPI && LOCAL_BODIES
+	DOM_Update_Children (sol->dom); /* ghosts serving user queries hold mid-step states */
+#endif
 	ret = sol->callback (sol, sol->data, sol->call);
 #if MPI
 	ret = PUT_int_min (ret);
@@ -726,6 +769,10 @@ void SOLFEC_Run (SOLFEC *sol, SOLVER_KIND kind, void *solver, double duration)
       if (stopfile (sol)) break;
     }
 
+#if MPI && LOCAL_BODIES
+    DOM_Update_Children (sol->dom); /* the same before returning to user queries */
+#endif
+
     if (!lastwrite) /* record last state if out of sync */
     {
       write_state (sol, solver, kind);
@@ -746,7 +793,17 @@ void SOLFEC_Output (SOLFEC *sol, double interval, PBF_FLG compression)
 {
   sol->output_interval = interval;
   sol->output_time = sol->dom->time + interval;
+  sol->output_compression = compression;
+#if !HDF5
   sol->bf->compression = compression;
+#endif
+}
+
+/* set restart checkpoint interval */
+void SOLFEC_Checkpoint (SOLFEC *sol, double interval)
+{
+  sol->checkpoint_interval = interval;
+  sol->checkpoint_time = sol->dom->time + interval;
 }
 
 /* the next time minus the current time */
@@ -805,6 +862,20 @@ void SOLFEC_Seek_To (SOLFEC *sol, double time)
   }
 }
 
+/* seek to specific time in READ mode and read a subset of bodies */
+int SOLFEC_Seek_Bodies (SOLFEC *sol, double time, SET *subset, double *box, MEM *setmem, SET **out)
+{
+  if (sol->mode == SOLFEC_READ)
+  {
+    init (sol);
+    PBF_Seek (sol->bf, time);
+    PBF_Time (sol->bf, &sol->dom->time);
+    return DOM_Read_Bodies (sol->dom, sol->bf, subset, box, setmem, out);
+  }
+
+  return 0;
+}
+
 /* step backward in READ modes */
 int SOLFEC_Backward (SOLFEC *sol, int steps)
 {
@@ -895,6 +966,8 @@ double* SOLFEC_History (SOLFEC *sol, SHI *shi, int nshi, double t0, double t1, i
   if (sol->mode == SOLFEC_WRITE) return NULL;
 
   double save, *time;
+  SET *subset = NULL;
+  MEM setmem;
   int cur, i,
       dodel = 0,
       timers = 0,
@@ -910,16 +983,26 @@ double* SOLFEC_History (SOLFEC *sol, SHI *shi, int nshi, double t0, double t1, i
   ERRMEM (time = MEM_CALLOC (sizeof (double [(*size) + 4]))); /* safeguard */
   time [cur] = sol->dom->time;
 
+  MEM_Init (&setmem, sizeof (SET), 128);
+
   for (i = 0; i < nshi; i ++)
   {
     ERRMEM (shi[i].history = MEM_CALLOC (sizeof (double [(*size) + 4])));
 
     switch (shi [i].item)
     {
-      case BODY_ENTITY:
-      case ENERGY_VALUE: full_read = 1; break;
+      case BODY_ENTITY: SET_Insert (&setmem, &subset, shi[i].bod, NULL); break; /* read only this body */
+      case ENERGY_VALUE:
+      {
+	if (shi [i].bodies) /* read only these bodies */
+	{
+	  for (SET *item = SET_First (shi[i].bodies); item; item = SET_Next (item)) SET_Insert (&setmem, &subset, item->data, NULL);
+	}
+	else full_read = 1;
+      }
+      break;
       case TIMING_VALUE: timers = 1; break;
-      case CONSTRAINT_VALUE: full_read = 1; break;
+      case CONSTRAINT_VALUE: full_read = 1; break; /* constraints are attached to bodies during a complete read */
       case LABELED_INT:
       case LABELED_DOUBLE: labeled = 1; break;
     }
@@ -940,21 +1023,27 @@ double* SOLFEC_History (SOLFEC *sol, SHI *shi, int nshi, double t0, double t1, i
 	break;
       case ENERGY_VALUE:
 	{
+	  RED_SUM energy;
+
+	  RED_Init (&energy, shi[i].history [cur]);
+
 	  if (shi [i].bodies)
 	  {
 	    for (SET *item = SET_First (shi[i].bodies); item; item = SET_Next (item))
 	    {
 	      BODY *bod = item->data;
-	      shi[i].history [cur] += bod->energy [shi[i].index];
+	      RED_Add (&energy, bod->energy [shi[i].index]);
 	    }
 	  }
 	  else
 	  {
 	    for (BODY *bod = sol->dom->bod; bod; bod = bod->next)
 	    {
-	      shi[i].history [cur] += bod->energy [shi[i].index];
+	      RED_Add (&energy, bod->energy [shi[i].index]);
 	    }
 	  }
+
+	  shi[i].history [cur] = RED_Value (&energy);
 	}
 	break;
       case TIMING_VALUE:
@@ -1103,6 +1192,7 @@ double* SOLFEC_History (SOLFEC *sol, SHI *shi, int nshi, double t0, double t1, i
       PBF_Time (sol->bf, &sol->dom->time); /* read time */
 
       if (labeled) read_state (sol); /* read whole domain */
+      else if (subset) DOM_Read_Bodies (sol->dom, sol->bf, subset, NULL, NULL, NULL); /* read selected bodies */
 
       if (timers) read_timers (sol); /* read timers */
     }
@@ -1118,6 +1208,8 @@ double* SOLFEC_History (SOLFEC *sol, SHI *shi, int nshi, double t0, double t1, i
 
   SOLFEC_Seek_To (sol, save); /* restore initial time frame */
 
+  MEM_Release (&setmem);
+
   if (skip < 0) printf ("\n"); /* progress end */
 
   return time;
@@ -1148,3 +1240,29 @@ int SOLFEC_Initialize_State (SOLFEC *sol, char *path, double time)
 
   return ret;
 }
+
+/* restart from the last checkpoint written into the 'path' output directory; return 1 on success, 0 otherwise */
+int SOLFEC_Restart (SOLFEC *sol, char *path)
+{
+  char *name;
+  int ret;
+
+  WARNING (sol->dom->time == 0.0, "Restart is only possible before the analysis has started.");
+  if (sol->dom->time > 0.0) return 0;
+
+  name = getpath (path);
+  strcat (name, ".chk"); /* getpath leaves enough room */
+
+  WARNING (ret = DOM_Read_Checkpoint (sol->dom, name), "Opening of the checkpoint file has failed.");
+
+  free (name);
+
+  if (ret) /* schedule output relative to the restart time */
+  {
+    sol->output_time = sol->dom->time + sol->output_interval;
+    if (sol->callback) sol->callback_time = sol->dom->time + sol->callback_interval;
+    if (sol->checkpoint_interval > 0.0) sol->checkpoint_time = sol->dom->time + sol->checkpoint_interval;
+  }
+
+  return ret;
+}
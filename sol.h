@@ -93,9 +93,14 @@ struct solfec
   int iover; /* input-output version */
   double output_interval,
 	 output_time;
+  PBF_FLG output_compression;
   char *outpath;
   PBF *bf;  
 
+  /* restart checkpoints */
+  double checkpoint_interval,
+	 checkpoint_time;
+
   /* callback data */
   double callback_interval,
 	 callback_time;
@@ -148,6 +153,9 @@ void SOLFEC_Run (SOLFEC *sol, SOLVER_KIND kind, void *solver, double duration);
 /* set results output interval */
 void SOLFEC_Output (SOLFEC *sol, double interval, PBF_FLG compression);
 
+/* set restart checkpoint interval */
+void SOLFEC_Checkpoint (SOLFEC *sol, double interval);
+
 /* set up callback function */
 void SOLFEC_Set_Callback (SOLFEC *sol, double interval, void *data, void *call, SOLFEC_Callback callback);
 
@@ -160,6 +168,11 @@ void SOLFEC_Time_Limits (SOLFEC *sol, double *start, double *end);
 /* seek to specific time in READ mode */
 void SOLFEC_Seek_To (SOLFEC *sol, double time);
 
+/* seek to specific time in READ mode and read only the states of bodies from the 'subset' or,
+ * if 'subset' is NULL, of those overlapping the 'box'; read bodies are inserted into 'out'
+ * (unless NULL); return the number of read bodies */
+int SOLFEC_Seek_Bodies (SOLFEC *sol, double time, SET *subset, double *box, MEM *setmem, SET **out);
+
 /* step backward in READ modes */
 int SOLFEC_Backward (SOLFEC *sol, int steps);
 
@@ -206,4 +219,7 @@ void SOLFEC_2_MBFCP (SOLFEC *sol, FILE *out);
 /* initialize state from the ouput; return 1 on success, 0 otherwise */
 int SOLFEC_Initialize_State (SOLFEC *sol, char *path, double time);
 
+/* restart from the last checkpoint written into the 'path' output directory; return 1 on success, 0 otherwise */
+int SOLFEC_Restart (SOLFEC *sol, char *path);
+
 #endif
@@ -24,6 +24,7 @@
 #endif
 
 #include <signal.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include "glv.h"
@@ -31,6 +32,7 @@
 #include "lng.h"
 #include "sol.h"
 #include "err.h"
+#include "thr.h"
 #include "ext/predicates.h"
 
 /* global list of created SOLFEC objects */
@@ -104,6 +106,9 @@ char** NON_SOLFEC_ARGV (int *argc)
 static int WIDTH = 512, HEIGHT = 512; /* initial width and height of the viewer window */
 #endif
 
+/* number of threads per process (0 if not specified) */
+static int THREADS = 0;
+
 #if MPI_VERSION >= 2
 /* error handler callback */
 static void MPI_error_handling (MPI_Comm *comm, int *err, ...)
@@ -177,6 +182,13 @@ static char* getfile (int argc, char **argv)
       }
     }
 #endif
+    else if (strcmp (argv [n], "-t") == 0)
+    {
+      if (++ n < argc)
+      {
+	THREADS = atoi (argv [n]); /* set number of threads */
+      }
+    }
     else if (strcmp (argv [n], "-v") == 0) continue;
     else if (strcmp (argv [n], "-w") == 0) WRITEMODEFLAG = 1;
     else if (strcmp (argv [n], "-f") == 0) WIREFRAMEFLAG = 1;
@@ -228,8 +240,9 @@ int main (int argc, char **argv)
 
 #if MPI
   float version;
+  int provided;
 
-  MPI_Init (&argc, &argv);
+  MPI_Init_thread (&argc, &argv, MPI_THREAD_FUNNELED, &provided); /* only the master thread of the pool communicates */
   ASSERT (Zoltan_Initialize (argc, argv, &version) == ZOLTAN_OK, ERR_ZOLTAN_INIT);
 
 #if MPI_VERSION >= 2
@@ -243,13 +256,20 @@ int main (int argc, char **argv)
 
 #if OPENGL
     if (vieweron (argc, argv)) RND_Switch_On (); /* make renderer aware of viewer before calling interpreter */
-    #define synopsis "SYNOPSIS: solfec [-v] [-w] [-f] [-g WIDTHxHEIGHT] [-s sub-directory] path\n"
+    #define synopsis "SYNOPSIS: solfec [-v] [-w] [-f] [-g WIDTHxHEIGHT] [-s sub-directory] [-t threads] path\n"
 #else
-    #define synopsis "SYNOPSIS: solfec [-s sub-directory] path\n"
+    #define synopsis "SYNOPSIS: solfec [-s sub-directory] [-t threads] path\n"
 #endif
 
     char *path = getfile (argc, argv); /* parse input */
 
+#if MPI
+    if (provided < MPI_THREAD_FUNNELED) THREADS = 1; /* MPI library does not support threads */
+    else if (!THREADS && !getenv ("SOLFEC_THREADS")) THREADS = 1; /* one thread per process unless a hybrid run was requested */
+#endif
+
+    if (THREADS > 0) THREAD_Set_Count (THREADS);
+
     if (!path) printf (synopsis); /* print info */
     else lngerr = lng (path); /* call interpreter */
 
@@ -26,7 +26,9 @@ enum
 {
   TAG_GAUSS_SEIDEL_BOTTOM,
   TAG_GAUSS_SEIDEL_TOP,
+  TAG_GAUSS_SEIDEL_MIDDLE,
   TAG_NEWTON,
+  TAG_NEIGHBOURS,
   TAG_LAST
 };
 
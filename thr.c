@@ -0,0 +1,265 @@
+/*
+ * thr.c
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * shared memory thread pool
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#if POSIX
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include <stdlib.h>
+#include "thr.h"
+#include "err.h"
+
+#if POSIX
+
+/* maximal number of threads */
+#define MAXTHREADS 256
+
+/* the pool */
+static struct
+{
+  pthread_t thread [MAXTHREADS]; /* workers */
+
+  int count; /* number of threads including master (0 before initialization) */
+
+  pthread_mutex_t lock;
+
+  pthread_cond_t start, /* workers wait for a new job */
+		 done; /* master waits for workers to finish */
+
+  THREAD_Job job; /* current job */
+
+  void *data; /* current job data */
+
+  int n, /* number of items */
+      next, /* next free item */
+      chunk, /* number of items taken at once */
+      busy, /* number of busy workers */
+      error, /* first error thrown by a job */
+      quit; /* termination flag */
+
+  unsigned int generation; /* job counter */
+} pool;
+
+/* index of the current thread */
+static __thread int thread_index = 0;
+
+/* nested call flag */
+static __thread int inside = 0;
+
+/* process items of the current job */
+static void process (void)
+{
+  int i, j, error;
+
+  inside = 1;
+
+  for (;;)
+  {
+    pthread_mutex_lock (&pool.lock);
+    i = pool.next;
+    pool.next += pool.chunk;
+    pthread_mutex_unlock (&pool.lock);
+
+    if (i >= pool.n) break;
+
+    j = i + pool.chunk;
+    if (j > pool.n) j = pool.n;
+
+    TRY ()
+    {
+      for (; i < j; i ++) pool.job (pool.data, i);
+    }
+    CATCHANY (error)
+    {
+      pthread_mutex_lock (&pool.lock);
+      if (!pool.error) pool.error = error;
+      pool.next = pool.n; /* stop others */
+      pthread_mutex_unlock (&pool.lock);
+    }
+    ENDTRY ()
+  }
+
+  inside = 0;
+}
+
+/* worker thread */
+static void* worker (void *arg)
+{
+  unsigned int generation = 0;
+
+  thread_index = (int) (long) arg;
+
+  for (;;)
+  {
+    pthread_mutex_lock (&pool.lock);
+    while (generation == pool.generation && !pool.quit) pthread_cond_wait (&pool.start, &pool.lock);
+    if (pool.quit) { pthread_mutex_unlock (&pool.lock); break; }
+    generation = pool.generation;
+    pthread_mutex_unlock (&pool.lock);
+
+    process ();
+
+    pthread_mutex_lock (&pool.lock);
+    if (-- pool.busy == 0) pthread_cond_signal (&pool.done);
+    pthread_mutex_unlock (&pool.lock);
+  }
+
+  return NULL;
+}
+
+/* stop workers */
+static void finalize (void)
+{
+  int i;
+
+  if (pool.count > 1)
+  {
+    pthread_mutex_lock (&pool.lock);
+    pool.quit = 1;
+    pthread_cond_broadcast (&pool.start);
+    pthread_mutex_unlock (&pool.lock);
+
+    for (i = 1; i < pool.count; i ++) pthread_join (pool.thread [i], NULL);
+  }
+
+  pool.count = 0;
+}
+
+/* start workers */
+static void initialize (int count)
+{
+  static int registered = 0;
+  int i;
+
+  if (count <= 0)
+  {
+    char *env = getenv ("SOLFEC_THREADS");
+
+    if (env) count = atoi (env);
+
+    if (count <= 0) count = (int) sysconf (_SC_NPROCESSORS_ONLN);
+  }
+
+  if (count < 1) count = 1;
+  else if (count > MAXTHREADS) count = MAXTHREADS;
+
+  pthread_mutex_init (&pool.lock, NULL);
+  pthread_cond_init (&pool.start, NULL);
+  pthread_cond_init (&pool.done, NULL);
+  pool.generation = 0;
+  pool.quit = 0;
+  pool.busy = 0;
+
+  for (i = 1; i < count; i ++)
+  {
+    if (pthread_create (&pool.thread [i], NULL, worker, (void*) (long) i) != 0) break;
+  }
+
+  pool.count = i;
+
+  if (!registered)
+  {
+    atexit (finalize);
+    registered = 1;
+  }
+}
+
+int THREAD_Count (void)
+{
+  if (pool.count == 0) initialize (0);
+
+  return pool.count;
+}
+
+void THREAD_Set_Count (int count)
+{
+  finalize ();
+
+  initialize (count);
+}
+
+int THREAD_Index (void)
+{
+  return thread_index;
+}
+
+void THREAD_Loop (int n, THREAD_Job job, void *data)
+{
+  int i, error;
+
+  if (n <= 0) return;
+
+  if (pool.count == 0) initialize (0);
+
+  if (inside || pool.count == 1 || n == 1) /* sequential */
+  {
+    for (i = 0; i < n; i ++) job (data, i);
+
+    return;
+  }
+
+  pthread_mutex_lock (&pool.lock);
+  pool.job = job;
+  pool.data = data;
+  pool.n = n;
+  pool.next = 0;
+  pool.chunk = n / (4 * pool.count);
+  if (pool.chunk < 1) pool.chunk = 1;
+  pool.error = 0;
+  pool.busy = pool.count - 1;
+  pool.generation ++;
+  pthread_cond_broadcast (&pool.start);
+  pthread_mutex_unlock (&pool.lock);
+
+  process (); /* master works too */
+
+  pthread_mutex_lock (&pool.lock);
+  while (pool.busy > 0) pthread_cond_wait (&pool.done, &pool.lock);
+  error = pool.error;
+  pthread_mutex_unlock (&pool.lock);
+
+  if (error) THROW (error);
+}
+
+#else
+
+int THREAD_Count (void)
+{
+  return 1;
+}
+
+void THREAD_Set_Count (int count)
+{
+}
+
+int THREAD_Index (void)
+{
+  return 0;
+}
+
+void THREAD_Loop (int n, THREAD_Job job, void *data)
+{
+  int i;
+
+  for (i = 0; i < n; i ++) job (data, i);
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * thr.h
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * ---------------------------------------------------------------
+ * shared memory thread pool
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef __thr__
+#define __thr__
+
+/* loop job: process item 'i' of 'data' */
+typedef void (*THREAD_Job) (void *data, int i);
+
+/* get number of threads used by the pool (including the calling thread) */
+int THREAD_Count (void);
+
+/* set number of threads used by the pool; 0 selects the number of online processors */
+void THREAD_Set_Count (int count);
+
+/* get index of the calling thread in [0, THREAD_Count ()); 0 for the calling (master) thread */
+int THREAD_Index (void);
+
+/* execute job (data, i) for i in [0, n) concurrently; an error thrown
+ * by any job is re-thrown in the calling thread after all jobs finish;
+ * nested calls from within jobs are executed sequentially */
+void THREAD_Loop (int n, THREAD_Job job, void *data);
+
+#endif
@@ -218,25 +218,30 @@ TMS* TMS_Derivative (TMS *ts)
 double TMS_Value (TMS *ts, double time)
 {
   double lo, hi;
+  int marker;
 
   if (ts->size == 0) return ts->value;
 
   if (time < ts->points[0][0]) return ts->points[0][1];
   else if (time > ts->points[ts->size-1][0]) return ts->points[ts->size-1][1];
 
-  lo = ts->points[ts->marker > 0 ? ts->marker - 1 : ts->marker][0];
-  hi = ts->points[ts->marker < ts->size - 1 ? ts->marker + 1 : ts->marker][0];
+  marker = ts->marker; /* work on a local copy, so that concurrent calls (e.g. from body threads) do not interfere */
+
+  lo = ts->points[marker > 0 ? marker - 1 : marker][0];
+  hi = ts->points[marker < ts->size - 1 ? marker + 1 : marker][0];
 
   if (time < lo || time > hi)
   {
-    ts->marker = findmarker (ts->points, ts->points + ts->size - 1, time);
+    marker = findmarker (ts->points, ts->points + ts->size - 1, time);
   }
-  else if (time >= lo && ts->marker &&
-	   time < ts->points[ts->marker][0]) ts->marker --;
-  else if (time >= ts->points[ts->marker+1][0] &&
-	   time < hi && ts->marker < ts->size - 1) ts->marker ++;
+  else if (time >= lo && marker &&
+	   time < ts->points[marker][0]) marker --;
+  else if (time >= ts->points[marker+1][0] &&
+	   time < hi && marker < ts->size - 1) marker ++;
+
+  ts->marker = marker;
 
-  return linterp (&ts->points[ts->marker], time);
+  return linterp (&ts->points[marker], time);
 }
 
 void TMS_Output (TMS *ts, char *path, double step)
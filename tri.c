@@ -349,16 +349,33 @@ TRI* TRI_Topoadj (TRI *tri, int n, double *point, int *m)
 
 /* compute polar polyhedron of (tri, n) */
 PFV* TRI_Polarise (TRI *tri, int n, int *m)
+{
+  PFV *pfv, *out;
+  size_t size;
+  MEM mem;
+
+  MEM_Init (&mem, sizeof (MAP), n * 3);
+  pfv = NULL;
+  size = 0;
+
+  if (!(out = TRI_Polarise_Ext (tri, n, &mem, &pfv, &size, m))) free (pfv);
+
+  MEM_Release (&mem);
+
+  return out;
+}
+
+/* compute polar polyhedron of (tri, n) reusing memory */
+PFV* TRI_Polarise_Ext (TRI *tri, int n, MEM *mem, PFV **buf, size_t *size, int *m)
 {
   int pfvcnt; /* number of vertices of all polar faces */
   PFV *pfv, *p, *q; /* first 'pfcnt' entries are polar face vertex list heads, the rest is list memory of size (pfvcnt - pfcnt); and iterator 'p' */
   MAP *vm, *im; /* map of visited vertices of (tri, n) (polar faces); iterator 'im' */
-  MEM mem; /* memory for map items */
   TRI *t, *s, *e; /* triangle iterators 't' and 's', and table end 'e' */
   double *v, *w, d, x;
+  size_t need;
   int i, j;
 
-  MEM_Init (&mem, sizeof (MAP), n * 3);
   e = tri + n;
   pfvcnt = 0;
   vm = NULL;
@@ -381,13 +398,20 @@ PFV* TRI_Polarise (TRI *tri, int n, int *m)
 	if (!s || j >= n) goto error;
 #endif
 
-	MAP_Insert (&mem, &vm, v, t, NULL); /* map vertex 'v' to triangle 't' */
+	MAP_Insert (mem, &vm, v, t, NULL); /* map vertex 'v' to triangle 't' */
       }
     }
   }
 
-  /* alloc output memory => PFVs and 'n' vertices */
-  ERRMEM (pfv = malloc (sizeof (PFV) * pfvcnt + sizeof (double [3]) * n));
+  /* output memory => PFVs and 'n' vertices */
+  need = sizeof (PFV) * pfvcnt + sizeof (double [3]) * n;
+  if (need > *size)
+  {
+    free (*buf);
+    *size = (*size ? 2 * need : need);
+    ERRMEM (*buf = malloc (*size));
+  }
+  pfv = *buf;
   w = (double*) (pfv + pfvcnt);
 
   /* compute coordinates */
@@ -434,12 +458,11 @@ PFV* TRI_Polarise (TRI *tri, int n, int *m)
 #ifndef GEOMDEBUG
 error:
 #endif
-  if (pfv) free (pfv);
   pfv = NULL;
   i = 0;
 
 done:
-  MEM_Release (&mem);
+  MEM_Reset (mem);
 
   (*m) = i;
   return pfv;
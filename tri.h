@@ -19,6 +19,7 @@
  * You should have received a copy of the GNU Lesser General Public
  * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
 
+#include "mem.h"
 #include "kdt.h"
 
 #ifndef __tri__
@@ -82,6 +83,11 @@ TRI* TRI_Topoadj (TRI *tri, int n, double *point, int *m);
  * members in 'tri'; 'coord's point within the returned block */
 PFV* TRI_Polarise (TRI *tri, int n, int *m);
 
+/* as above, but map items come from 'mem' (reset on return) and the output is written into
+ * the '*size' bytes long block '*buf', which is reallocated when too small; NULL is returned
+ * on failure, while the block stays with the caller in any case */
+PFV* TRI_Polarise_Ext (TRI *tri, int n, MEM *mem, PFV **buf, size_t *size, int *m);
+
 /* extract vertices of triangulation (tri, n)
  * into a table of size (double [3]) x m */
 double* TRI_Vertices (TRI *tri, int n, int *m);
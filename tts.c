@@ -32,6 +32,7 @@
 #include "err.h"
 #include "scf.h"
 #include "mrf.h"
+#include "red.h"
 #include "ext/krylov/krylov.h"
 
 typedef struct con_data CON_DATA;
@@ -146,19 +147,19 @@ static int DestroyVector (VECTOR *a)
 
 static double InnerProd (VECTOR *a, VECTOR *b)
 {
-  double dot = 0.0, *x, *y, *z;
+  double *x, *y, *z;
+  RED_SUM dot;
 
-  for (x = a->x, z = x + a->n, y = b->x; x < z; x ++, y ++)
+  for (RED_Init (&dot, 0.0), x = a->x, z = x + a->n, y = b->x; x < z; x ++, y ++)
   {
-    dot += (*x) * (*y);
+    RED_Add (&dot, (*x) * (*y));
   }
 
 #if MPI
-  double val = dot;
-  MPI_Allreduce (&val, &dot, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  RED_Allreduce (&dot, 1, MPI_COMM_WORLD);
 #endif
 
-  return dot;
+  return RED_Value (&dot);
 }
 
 static int CopyVector (VECTOR *a, VECTOR *b)
@@ -0,0 +1,78 @@
+/*
+ * pbfmerge.c
+ * Copyright (C) 2026, Tomasz Koziara (t.koziara AT gmail.com)
+ * --------------------------------------------------------------
+ * merge parallel output files into a single indexed file
+ */
+
+/* This file is part of Solfec.
+ * Solfec is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Solfec is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Solfec. If not, see <http://www.gnu.org/licenses/>. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "pbf.h"
+#include "err.h"
+
+/* get file path from output directory path (as in sol.c) */
+static char *getpath (char *outpath)
+{
+  int l, k;
+  char *path;
+
+  l = strlen (outpath);
+  while (l > 1 && outpath [l-1] == '/') outpath [-- l] = '\0';
+  for (k = l; k > 0 && outpath [k-1] != '/'; k --);
+
+  ERRMEM (path = malloc (2 * l + 8));
+  sprintf (path, "%s/%s", outpath, &outpath [k]);
+
+  return path;
+}
+
+int main (int argc, char **argv)
+{
+  char *path;
+  int m;
+
+  if (argc < 2)
+  {
+    printf ("SYNOPSIS: pbfmerge output-directory\n");
+    return 0;
+  }
+
+  path = getpath (argv [1]);
+
+  TRY ()
+  {
+    m = PBF_Merge (path);
+
+#if HDF5
+    if (m) printf ("Merged %d rank files into %s.h5\n", m, path);
+#else
+    if (m) printf ("Merged %d rank files into %s.pbf\n", m, path);
+#endif
+    else printf ("No parallel output files found at %s\n", path);
+  }
+  CATCHANY (m)
+  {
+    fprintf (stderr, "Error: %s\n", errstring (m));
+    free (path);
+    return 1;
+  }
+  ENDTRY ()
+
+  free (path);
+  return 0;
+}